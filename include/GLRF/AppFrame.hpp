@@ -3,12 +3,18 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/common.hpp>
+#include <memory>
 
+#include <GLRF/DynamicResolution.hpp>
+#include <GLRF/GLExtensions.hpp>
+#include <GLRF/GLStateCache.hpp>
+#include <GLRF/HeadlessContext.hpp>
 #include <GLRF/Shader.hpp>
 #include <GLRF/Scene.hpp>
 
 namespace GLRF {
     class Mouse;
+    enum class AppFrameMode;
     class AppFrame;
     class App;
 }
@@ -35,19 +41,69 @@ public:
     glm::vec2 getOffset();
 };
 
+/**
+ * @brief Selects where an AppFrame renders to.
+ * 
+ * WINDOW opens a GLFW window and presents every frame.
+ * HEADLESS creates a HeadlessContext and renders into an offscreen FrameBuffer, for batch rendering and benchmarks.
+ */
+enum class GLRF::AppFrameMode {
+    WINDOW, HEADLESS
+};
+
 class GLRF::AppFrame
 {
 private:
     ScreenResolution resolution;
-    GLFWwindow * window;
+    GLFWwindow * window = nullptr;
     App * app;
+    std::unique_ptr<HeadlessContext> headless_context;
+    std::unique_ptr<FrameBuffer> output;
+    std::unique_ptr<DynamicResolution> dynamic_resolution;
+    // the scaled render target of the app, upscaled into the window after every frame
+    std::unique_ptr<FrameBuffer> scaled_output;
 
+    void releaseDynamicResolution();
     void processInput(GLFWwindow * window);
 public:
-    AppFrame(ScreenResolution resolution, App * app);
+    AppFrame(ScreenResolution resolution, App * app, AppFrameMode mode = AppFrameMode::WINDOW);
     ~AppFrame();
 
+    /**
+     * @brief Runs the app in the window until it is closed.
+     * 
+     */
     bool render();
+
+    /**
+     * @brief Updates and renders a fixed number of frames into the output, without a swap chain (HEADLESS mode only).
+     * 
+     * @param frame_count the number of frames
+     * @param on_frame optionally receives the RGBA8 pixels of every frame, in the order they were rendered
+     * 
+     * App::configure() is called with nullptr and no user input is processed.
+     * The output is bound with the full viewport before every App::render(), so apps that draw to the bound framebuffer work unchanged.
+     * The frames are read back asynchronously and handed to the callback by the end of this call at the latest.
+     */
+    void renderFrames(unsigned int frame_count, FrameBuffer::ReadbackCallback on_frame = nullptr);
+
+    /**
+     * @brief Lets the app render at a lower resolution whenever the GPU frame time exceeds a target (WINDOW mode only).
+     * 
+     * @param target_frame_time the GPU time of a frame in milliseconds that should be reached
+     * @param min_scale the smallest scale of the width and height
+     * 
+     * The app renders into its output, which is bound with the scaled viewport before App::render() is called,
+     * and the rendered region is upscaled into the window afterwards. Apps that render through their own targets
+     * restrict them with the DynamicResolution passed to them, e.g. with DeferredRenderer::setRenderResolution().
+     */
+    void enableDynamicResolution(float target_frame_time = 16.0f, float min_scale = 0.5f);
+
+    /**
+     * @brief Returns the offscreen FrameBuffer that replaces the window in HEADLESS mode.
+     * 
+     */
+    FrameBuffer & getOutput();
     static void framebufferSizeCallback(GLFWwindow * window, int width, int height);
     static void mouse_callback(GLFWwindow * window, double x, double y);
 };
@@ -57,6 +113,10 @@ class GLRF::App
 private:
 protected:
     Scene * activeScene = nullptr;
+    // the target of the final image in HEADLESS mode or with dynamic resolution, nullptr if the default framebuffer is presented
+    FrameBuffer * output = nullptr;
+    // scales the viewport of the output, nullptr if dynamic resolution is disabled
+    DynamicResolution * dynamic_resolution = nullptr;
     std::map<std::string, Shader> shaders;
 public:
     virtual ~App() {};
@@ -67,6 +127,12 @@ public:
     virtual void setActiveScene(Scene * scene) {
         this->activeScene = scene;
     }
+    virtual void setOutput(FrameBuffer * output) {
+        this->output = output;
+    }
+    virtual void setDynamicResolution(DynamicResolution * dynamic_resolution) {
+        this->dynamic_resolution = dynamic_resolution;
+    }
     virtual void forwardUserInputToScene(GLFWwindow * window, glm::vec2 mouse_offset) {
         this->activeScene->processMouse(mouse_offset.x, mouse_offset.y);
         this->activeScene->processInput(window);
@@ -0,0 +1,165 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GLRF/ImageData.hpp>
+#include <GLRF/SceneObject.hpp>
+#include <GLRF/VertexFormat.hpp>
+
+namespace fs = std::filesystem;
+
+namespace GLRF {
+	enum class AssetType : std::uint32_t;
+	struct AssetArchiveEntry;
+	class AssetArchive;
+	class AssetArchiveWriter;
+}
+
+/**
+ * @brief The kind of data stored inside an archive entry.
+ *
+ */
+enum class GLRF::AssetType : std::uint32_t {
+	TEXTURE = 1,	// a GPU-ready image with all mip levels
+	MESH = 2		// VertexFormat vertices followed by 32 bit indices
+};
+
+/**
+ * @brief An entry of the table of contents of an archive.
+ *
+ */
+struct GLRF::AssetArchiveEntry {
+	std::string name;
+	AssetType type = AssetType::TEXTURE;
+	std::uint64_t content_hash = 0;
+	std::uint64_t offset = 0;
+	std::uint64_t size = 0;
+};
+
+/**
+ * @brief Read-only access to a packed asset archive created by glrf-bake.
+ *
+ * The whole archive is memory mapped once. Images returned by the archive reference the mapping directly,
+ * so loading a texture only costs the upload to the GPU.
+ * Entries are addressed by their path relative to the baked asset directory (e.g. 'tiles_marble/albedo.png').
+ * All load functions may be called from worker threads.
+ */
+class GLRF::AssetArchive {
+public:
+	static const char MAGIC[8];
+	static const std::uint32_t VERSION;
+
+	/**
+	 * @brief Opens and maps an archive.
+	 *
+	 * @param path the path to the archive file
+	 *
+	 * Throws std::runtime_error if the file cannot be mapped or is not a valid archive.
+	 */
+	AssetArchive(fs::path path);
+	~AssetArchive();
+	AssetArchive(const AssetArchive &) = delete;
+	AssetArchive & operator=(const AssetArchive &) = delete;
+
+	/**
+	 * @brief Returns the entry with the given name, nullptr if the archive does not contain it.
+	 *
+	 */
+	const AssetArchiveEntry * findEntry(const std::string & name) const;
+
+	/**
+	 * @brief Returns the name under which an asset is stored (a normalized relative path with forward slashes).
+	 *
+	 */
+	static std::string normalizeName(const std::string & name);
+
+	const std::vector<AssetArchiveEntry> & getEntries() const;
+
+	/**
+	 * @brief Returns the raw bytes of an entry inside the mapping.
+	 *
+	 */
+	const unsigned char * getData(const AssetArchiveEntry & entry) const;
+
+	/**
+	 * @brief Returns a baked texture without copying its texels.
+	 *
+	 * @param name the name of the entry
+	 * @param srgb whether the texture is expected to be stored in sRGB space
+	 * @return ImageData the image, empty if the archive does not contain a matching texture
+	 *
+	 * RGBA8, BC1, BC3 and BC7 textures baked in the other colour space are returned with the sRGB or linear variant
+	 * of their format, which stores the same bits. Other formats can not be converted, so no image is returned.
+	 */
+	ImageData loadImage(const std::string & name, bool srgb) const;
+
+	/**
+	 * @brief Returns a baked mesh.
+	 *
+	 * @param name the name of the entry
+	 * @return std::shared_ptr<MeshData<VertexFormat>> the mesh, nullptr if the archive does not contain it
+	 */
+	std::shared_ptr<MeshData<VertexFormat>> loadMesh(const std::string & name) const;
+
+	fs::path getPath() const;
+private:
+	struct Mapping;
+
+	fs::path path;
+	std::shared_ptr<Mapping> mapping;
+	std::vector<AssetArchiveEntry> entries;
+	std::unordered_map<std::string, size_t> entry_indices;
+};
+
+/**
+ * @brief Serializes assets into a packed archive.
+ *
+ */
+class GLRF::AssetArchiveWriter {
+public:
+	/**
+	 * @brief Adds an image with all of its levels.
+	 *
+	 * @param name the name of the entry
+	 * @param image the GPU-ready image
+	 * @param content_hash the hash of the source and bake parameters, used to skip unchanged inputs
+	 */
+	void addTexture(const std::string & name, const ImageData & image, std::uint64_t content_hash);
+
+	/**
+	 * @brief Adds an indexed triangle mesh.
+	 *
+	 */
+	void addMesh(const std::string & name, const MeshData<VertexFormat> & mesh, std::uint64_t content_hash);
+
+	/**
+	 * @brief Adds an already serialized entry, e.g. one that was copied from a previous archive.
+	 *
+	 */
+	void addBlob(const std::string & name, AssetType type, std::uint64_t content_hash, const unsigned char * data, size_t size);
+
+	/**
+	 * @brief Writes all entries to disk.
+	 *
+	 * @param path the path to the archive file
+	 * @return bool whether the archive was written
+	 *
+	 * The archive is written to a temporary file first and then renamed, so readers never see a partial archive.
+	 */
+	bool write(fs::path path);
+private:
+	struct Blob {
+		std::string name;
+		AssetType type;
+		std::uint64_t content_hash;
+		std::vector<unsigned char> data;
+	};
+
+	std::vector<Blob> blobs;
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GLRF/FrameBuffer.hpp>
+#include <GLRF/Scene.hpp>
+
+namespace GLRF {
+	class DeferredRenderer;
+}
+
+/**
+ * @brief Renders a Scene into a G-buffer and lights it per screen tile with a compute shader.
+ *
+ * The G-buffer is packed to keep the bandwidth low (16 bytes per pixel plus depth):
+ * - ALBEDO (RGBA8): the albedo
+ * - NORMAL (RG16): the world space normal, octahedral encoded
+ * - ORM (RGBA8): ambient occlusion, roughness and metallic
+ * - LIGHTING (R11G11B10F): the accumulated light, the geometry pass writes the emission and ambient light
+ *
+ * Geometry shaders include 'glrf/gbuffer.glsl' (see getGLSLInterface()) and call writeGBuffer().
+ * The lighting pass divides the screen into tiles of TILE_SIZE pixels, culls the point lights of the
+ * FrameUniformBuffer against the depth bounds of every tile and adds the direct light of the remaining lights
+ * to LIGHTING. Each light therefore costs the screen area it covers instead of objects * lights.
+ */
+class GLRF::DeferredRenderer
+{
+public:
+	static const GLuint ALBEDO = 0;
+	static const GLuint NORMAL = 1;
+	static const GLuint ORM = 2;
+	static const GLuint LIGHTING = 3;
+
+	static const GLuint TILE_SIZE = 16;
+
+	/**
+	 * @brief Creates the G-buffer and compiles the lighting pass.
+	 *
+	 * @param resolution the resolution of the G-buffer
+	 */
+	DeferredRenderer(ScreenResolution resolution);
+	~DeferredRenderer();
+
+	/**
+	 * @brief Restricts both passes to the region of the G-buffer from (0, 0) to the given resolution.
+	 *
+	 * Used with a DynamicResolution (setRenderResolution(dynamic_resolution.getScaledResolution()) once per frame),
+	 * the positions are reconstructed relative to the region. The resolution is clamped to the G-buffer and
+	 * defaults to all of it.
+	 */
+	void setRenderResolution(ScreenResolution render_resolution);
+	ScreenResolution getRenderResolution();
+
+	/**
+	 * @brief Returns the configuration of the G-buffer.
+	 *
+	 */
+	static FrameBufferConfiguration getGBufferConfiguration();
+
+	/**
+	 * @brief Returns the GLSL outputs of the G-buffer and the function writeGBuffer() for fragment shaders.
+	 *
+	 */
+	static std::string getGLSLInterface();
+
+	/**
+	 * @brief Clears the G-buffer and draws the objects of the given shaders into it.
+	 *
+	 * Scene::prepareDraw() has to be called before, the lighting pass reads the lights of the frame it writes.
+	 * A depth pre-pass of the scene is used if it is enabled.
+	 */
+	void drawGeometryPass(Scene & scene, ShaderConfiguration * configuration, const std::vector<GLuint> & shader_ids);
+
+	/**
+	 * @brief Adds the direct light of all lights to the LIGHTING buffer.
+	 *
+	 * @param projection the projection matrix of the geometry pass, the positions are reconstructed from the depth
+	 */
+	void drawLightingPass(const glm::mat4 & projection);
+
+	FrameBuffer & getGBuffer();
+
+	/**
+	 * @brief Returns the texture with the lit image, valid after drawLightingPass().
+	 *
+	 */
+	GLuint getLightingTexture();
+private:
+	ScreenResolution resolution;
+	// the rendered region of the G-buffer
+	ScreenResolution render_resolution;
+	std::unique_ptr<FrameBuffer> gbuffer;
+	GLuint lighting_program = 0;
+	GLint inverse_projection_location = -1;
+	GLint render_size_location = -1;
+
+	DeferredRenderer(const DeferredRenderer&);
+	DeferredRenderer& operator = (const DeferredRenderer&);
+};
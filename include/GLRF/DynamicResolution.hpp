@@ -0,0 +1,105 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+
+#include <GLRF/FrameBuffer.hpp>
+
+namespace GLRF {
+	class DynamicResolution;
+}
+
+/**
+ * @brief Scales the rendered region of the scene framebuffers so that the GPU frame time meets a target.
+ *
+ * The GPU time of every frame is measured with GL_TIME_ELAPSED queries between beginFrame() and endFrame().
+ * Results are read a few frames later when they are available, so measuring never stalls the pipeline.
+ * The render targets are allocated once at the maximum resolution, only the viewport shrinks, and
+ * blitToScreen() upscales the rendered region to the window.
+ *
+ * Shaders that sample a scaled target have to multiply their texture coordinates by getScale().
+ */
+class GLRF::DynamicResolution
+{
+public:
+	// queries in flight, results are usually available two or three frames later
+	static const size_t QUERY_COUNT = 4;
+
+	/**
+	 * @brief Creates the timer queries.
+	 *
+	 * @param max_resolution the resolution of the render targets, i.e. the resolution at scale 1
+	 * @param target_frame_time the GPU time of a frame in milliseconds that should be reached
+	 * @param min_scale the smallest scale of the width and height
+	 */
+	DynamicResolution(ScreenResolution max_resolution, float target_frame_time = 16.0f, float min_scale = 0.5f);
+	~DynamicResolution();
+
+	/**
+	 * @brief Starts measuring a frame and evaluates the results of earlier frames.
+	 *
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Stops measuring the frame.
+	 *
+	 */
+	void endFrame();
+
+	/**
+	 * @brief Binds the framebuffer and sets the viewport to its scaled region.
+	 *
+	 */
+	void use(FrameBuffer & frame_buffer);
+
+	/**
+	 * @brief Upscales the rendered region of the first color buffer into the default framebuffer.
+	 *
+	 * @param output the resolution of the default framebuffer
+	 */
+	void blitToScreen(FrameBuffer & frame_buffer, ScreenResolution output);
+
+	float getScale();
+	ScreenResolution getScaledResolution();
+
+	/**
+	 * @brief Returns the smoothed GPU frame time in milliseconds, or 0 if no frame was measured yet.
+	 *
+	 */
+	float getFrameTime();
+
+	void setTargetFrameTime(float target_frame_time);
+
+	/**
+	 * @brief Computes the scale of the next frame.
+	 *
+	 * The frame time grows with the number of pixels, i.e. with the square of the scale. Deviations of less than
+	 * 5 percent are ignored to keep the resolution steady, and the scale changes by at most 10 percent per step.
+	 *
+	 * @param scale the current scale
+	 * @param frame_time the measured frame time in milliseconds
+	 * @param target_frame_time the target frame time in milliseconds
+	 * @param min_scale the smallest scale
+	 */
+	static float computeScale(float scale, float frame_time, float target_frame_time, float min_scale);
+private:
+	struct TimerQuery {
+		GLuint ID = 0;
+		bool pending = false;
+	};
+
+	ScreenResolution max_resolution;
+	float target_frame_time;
+	float min_scale;
+	float scale = 1.0f;
+	float frame_time = 0.0f;
+
+	std::array<TimerQuery, QUERY_COUNT> queries;
+	size_t current_query = 0;
+	bool measuring = false;
+
+	DynamicResolution(const DynamicResolution&);
+	DynamicResolution& operator = (const DynamicResolution&);
+
+	void collectResults();
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace GLRF {
+	struct CubeMapData;
+	class EnvironmentBaker;
+}
+
+/**
+ * @brief RGB floating point texels of the six faces of a cube map (and optionally its mip chain) on the CPU.
+ *
+ * The faces are stored in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z), level after level.
+ */
+struct GLRF::CubeMapData {
+	GLsizei size = 0;
+	GLuint levels = 0;
+	std::vector<float> texels;
+
+	CubeMapData();
+
+	/**
+	 * @brief Construct a new CubeMapData object and allocates storage for the requested levels.
+	 *
+	 * @param size the edge length of the faces of the base level
+	 * @param levels the number of levels, starting at the base level
+	 */
+	CubeMapData(GLsizei size, GLuint levels);
+
+	bool isEmpty() const;
+	GLsizei getLevelSize(GLuint level) const;
+
+	/**
+	 * @brief Returns the offset of a face inside the texels, in floats.
+	 *
+	 */
+	size_t getOffset(GLuint level, GLuint face) const;
+	const float * getFace(GLuint level, GLuint face) const;
+	float * getFace(GLuint level, GLuint face);
+};
+
+/**
+ * @brief Precomputes the image based lighting terms of an environment on the CPU.
+ *
+ * Diffuse lighting is stored as the first 9 spherical harmonics coefficients of the irradiance,
+ * specular lighting as a cube map whose mip levels are prefiltered with the GGX distribution of increasing roughness
+ * (split sum approximation) together with a lookup table of the environment BRDF.
+ * The GGX integrals are importance sampled, and samples of rough levels read from the mip chain of the environment
+ * to avoid aliasing with few samples. Faces and rows are distributed across the ThreadPool and the sample
+ * transformation uses AVX2 if the CPU supports it.
+ */
+class GLRF::EnvironmentBaker {
+public:
+	static const GLuint SH_COEFFICIENTS = 9;
+	typedef std::array<float, 3 * SH_COEFFICIENTS> IrradianceSH;
+
+	/**
+	 * @brief Construct a new EnvironmentBaker object.
+	 *
+	 * @param sample_count the number of importance samples per texel of the prefiltered levels and the lookup table
+	 */
+	EnvironmentBaker(GLuint sample_count = 512);
+
+	/**
+	 * @brief Resamples an equirectangular (latitude-longitude) image into the base level of a cube map.
+	 *
+	 * @param pixels the RGB texels of the image, starting at the top row
+	 * @param width the width of the image
+	 * @param height the height of the image
+	 * @param size the edge length of the cube map faces
+	 * @return CubeMapData a cube map with a single level
+	 */
+	CubeMapData convertEquirectangular(const float * pixels, int width, int height, GLsizei size);
+
+	/**
+	 * @brief Fills all levels below the base level with 2x2 averages of the previous level.
+	 *
+	 * @param cube a cube map with a power of two size, levels that do not exist yet are allocated
+	 */
+	void generateMips(CubeMapData & cube);
+
+	/**
+	 * @brief Projects the irradiance of an environment onto spherical harmonics.
+	 *
+	 * @param cube the environment including its mip chain
+	 * @return IrradianceSH the coefficients, scaled so that evaluateIrradiance returns the irradiance divided by pi
+	 */
+	IrradianceSH projectIrradiance(const CubeMapData & cube);
+
+	/**
+	 * @brief Prefilters an environment for the specular lobe of each roughness.
+	 *
+	 * @param cube the environment including its mip chain
+	 * @param size the edge length of the base level of the result
+	 * @param levels the number of levels of the result, level i has the roughness getLevelRoughness(i, levels)
+	 * @return CubeMapData the prefiltered cube map
+	 */
+	CubeMapData prefilterSpecular(const CubeMapData & cube, GLsizei size, GLuint levels);
+
+	/**
+	 * @brief Integrates the scale and bias that are applied to F0 by the environment BRDF.
+	 *
+	 * @param size the edge length of the lookup table
+	 * @return std::vector<float> RG texels, n dot v along the x-axis and the roughness along the y-axis
+	 */
+	std::vector<float> integrateBRDF(GLsizei size);
+
+	/**
+	 * @brief Applies the clamped cosine convolution to projected radiance coefficients.
+	 *
+	 * @param radiance the coefficients of the radiance (e.g. summed up on the GPU)
+	 * @return IrradianceSH the coefficients that projectIrradiance returns for the same environment
+	 */
+	static IrradianceSH convolveIrradiance(const std::array<double, 3 * SH_COEFFICIENTS> & radiance);
+
+	/**
+	 * @brief Evaluates the irradiance coefficients for a normalized direction.
+	 *
+	 * @param sh the coefficients
+	 * @param direction the direction (x, y, z)
+	 * @param rgb the irradiance divided by pi, i.e. the diffuse lighting of a white surface
+	 */
+	static void evaluateIrradiance(const IrradianceSH & sh, const float * direction, float * rgb);
+
+	/**
+	 * @brief Returns the roughness that a level of the prefiltered cube map represents.
+	 *
+	 */
+	static float getLevelRoughness(GLuint level, GLuint levels);
+private:
+	GLuint sample_count;
+};
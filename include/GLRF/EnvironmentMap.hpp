@@ -0,0 +1,121 @@
+#pragma once
+#include <glad/glad.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <GLRF/EnvironmentBaker.hpp>
+#include <GLRF/MaterialTable.hpp>
+#include <GLRF/Shader.hpp>
+
+namespace fs = std::filesystem;
+
+namespace GLRF {
+	enum class EnvironmentBakeMode;
+	struct EnvironmentConfiguration;
+	class EnvironmentMap;
+}
+
+/**
+ * @brief Where the image based lighting terms of an environment are computed if they are not cached yet.
+ *
+ */
+enum class GLRF::EnvironmentBakeMode {
+	CPU,		// EnvironmentBaker on the ThreadPool
+	COMPUTE		// compute shaders on the GPU (OpenGL 4.3), falls back to the CPU if they are not available
+};
+
+/**
+ * @brief The resolution and quality of the image based lighting terms.
+ *
+ */
+struct GLRF::EnvironmentConfiguration
+{
+	GLsizei cube_size = 512;
+	GLsizei specular_size = 128;
+	GLuint specular_levels = 6;
+	GLuint sample_count = 512;
+	GLsizei brdf_lut_size = 128;
+	EnvironmentBakeMode mode = EnvironmentBakeMode::CPU;
+	fs::path cache_directory = fs::path(".glrf_cache") / "ibl";
+};
+
+/**
+ * @brief The image based lighting of an equirectangular HDR environment for the PBR rendering mode.
+ *
+ * The environment is converted into a cube map, its irradiance is projected onto spherical harmonics,
+ * the specular lobe is prefiltered into the mip levels of a second cube map and the environment BRDF is stored
+ * in a lookup table. All results are cached on disk, keyed by the hash of the source file and the configuration,
+ * so they are only computed once: later runs only read and upload them.
+ * The shader side is returned by getGLSLInterface().
+ */
+class GLRF::EnvironmentMap {
+public:
+	// radiance, specular and the BRDF lookup table
+	static const GLuint NUM_TEXTURE_UNITS = 3;
+
+	/**
+	 * @brief Returns the first of the texture units of the environment, they follow the units of the MaterialTable.
+	 *
+	 */
+	static GLuint getTextureUnitsBegin();
+
+	/**
+	 * @brief Construct a new EnvironmentMap object from an equirectangular image.
+	 *
+	 * @param path the path to the image (e.g. a .hdr file)
+	 * @param config the resolution and quality of the baked terms
+	 *
+	 * Throws a std::runtime_error if the image can not be read.
+	 */
+	EnvironmentMap(const std::string & path, EnvironmentConfiguration config = EnvironmentConfiguration());
+	~EnvironmentMap();
+
+	/**
+	 * @brief Binds the textures and sets the uniforms that getGLSLInterface() declares.
+	 *
+	 * @param configuration the configuration of the frame
+	 */
+	void bind(ShaderConfiguration * configuration);
+
+	/**
+	 * @brief Returns the GLSL declarations of the environment and the functions that evaluate it.
+	 *
+	 */
+	static std::string getGLSLInterface();
+
+	GLuint getEnvironmentID();
+	GLuint getSpecularID();
+	GLuint getBRDFLookupID();
+	const EnvironmentBaker::IrradianceSH & getIrradianceSH();
+
+	/**
+	 * @brief Returns whether the baked terms were read from the cache instead of being computed.
+	 *
+	 */
+	bool isCached();
+private:
+	EnvironmentConfiguration config;
+	EnvironmentBaker::IrradianceSH irradiance_sh = {};
+	GLuint environment = 0;
+	GLuint specular = 0;
+	GLuint brdf_lut = 0;
+	bool cached = false;
+
+	EnvironmentMap(const EnvironmentMap&);
+	EnvironmentMap& operator = (const EnvironmentMap&);
+
+	std::string getParameters();
+	bool loadCache(const fs::path & file, CubeMapData & environment_data, CubeMapData & specular_data);
+	void saveCache(const fs::path & file, const CubeMapData & environment_data, const CubeMapData & specular_data);
+	bool loadBRDFCache(const fs::path & file, std::vector<float> & lut);
+	void saveBRDFCache(const fs::path & file, const std::vector<float> & lut);
+
+	void bakeCPU(const float * pixels, int width, int height, CubeMapData & environment_data, CubeMapData & specular_data);
+	void bakeCompute(const float * pixels, int width, int height, CubeMapData & environment_data, CubeMapData & specular_data);
+	std::vector<float> integrateBRDFCompute();
+
+	void createTextures();
+	void uploadCube(GLuint texture, const CubeMapData & data);
+	void readCube(GLuint texture, CubeMapData & data);
+};
@@ -4,6 +4,8 @@
 #include <optional>
 #include <iostream>
 #include <vector>
+#include <array>
+#include <functional>
 
 namespace GLRF {
     struct ScreenResolution;
@@ -33,24 +35,81 @@ struct GLRF::FrameBufferConfiguration
     GLenum color_type = GL_RGB;
     GLenum data_type = GL_UNSIGNED_BYTE;
     bool use_depth_buffer = true;
+    // stores the depth buffer in a texture instead of a renderbuffer, so later passes can sample it
+    bool sample_depth_buffer = false;
     GLuint num_color_buffers = 1;
+    // the sized formats of the color buffers (e.g. a G-buffer), replaces the formats and number above if not empty
+    std::vector<GLenum> color_formats;
 };
 
 
 class GLRF::FrameBuffer
 {
 public:
+    /**
+     * @brief Receives the pixels of a readback, rows are tightly packed from the bottom to the top.
+     * 
+     * The pixels are only valid during the call, so they have to be copied to be handed to another thread (e.g. an encoder).
+     */
+    typedef std::function<void(const void * pixels, size_t size, GLsizei width, GLsizei height)> ReadbackCallback;
+
+    // readbacks in flight, the results are usually available two or three frames later
+    static const size_t READBACK_SLOTS = 3;
+
     FrameBuffer(FrameBufferConfiguration & config, ScreenResolution & screen_res);
     ~FrameBuffer();
 
     void use();
     GLuint getID();
     GLuint getColorBufferID(size_t idx);
+    ScreenResolution getResolution();
+
+    /**
+     * @brief Returns the depth texture, if the configuration enabled sample_depth_buffer.
+     * 
+     */
+    std::optional<GLuint> getDepthBufferID();
     void setDebugName(const std::string name);
     std::string getDebugName();
+
+    /**
+     * @brief Copies a color buffer into a pixel pack buffer without waiting for the GPU.
+     * 
+     * @param idx the index of the color buffer
+     * @param format the format of the pixels, e.g. GL_RGBA
+     * @param type the type of the components, e.g. GL_UNSIGNED_BYTE
+     * @param callback receives the pixels from pollReadbacks() once the copy has finished
+     * 
+     * The copies go into a ring of READBACK_SLOTS buffers, completion is signaled by a fence.
+     * Only if all slots are in flight, the oldest readback is waited for.
+     */
+    void readColorBufferAsync(size_t idx, GLenum format, GLenum type, ReadbackCallback callback);
+
+    /**
+     * @brief Hands the finished readbacks to their callbacks, in the order they were requested.
+     * 
+     * @param wait whether to wait for all readbacks in flight, e.g. before the application exits
+     */
+    void pollReadbacks(bool wait = false);
 private:
+    struct ReadbackSlot {
+        GLuint PBO = 0;
+        GLsizeiptr capacity = 0;
+        GLsizeiptr size = 0;
+        GLsync fence = nullptr;
+        ReadbackCallback callback;
+    };
+
     GLuint ID;
+    ScreenResolution resolution;
     std::vector<GLuint> texture_color_buffer_IDs;
     std::optional<GLuint> RBO = std::nullopt;
+    std::optional<GLuint> depth_texture_ID = std::nullopt;
     std::string debug_name;
+
+    std::array<ReadbackSlot, READBACK_SLOTS> readback_slots;
+    // the slot of the next readback, which is also the oldest one in flight
+    size_t next_readback = 0;
+
+    bool completeReadback(ReadbackSlot & slot, bool wait);
 };
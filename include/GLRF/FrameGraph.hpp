@@ -0,0 +1,290 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace GLRF {
+	struct FrameGraphTextureDesc;
+	struct FrameGraphResource;
+	class FrameGraphBuilder;
+	class FrameGraphPassContext;
+	class FrameGraph;
+
+	/**
+	 * @brief How a pass accesses a resource.
+	 *
+	 */
+	enum class FrameGraphAccess {
+		// as color or depth attachment of the framebuffer of the pass
+		ATTACHMENT,
+		// with a sampler
+		SAMPLED,
+		// as image with imageLoad / imageStore
+		STORAGE
+	};
+}
+
+/**
+ * @brief The description of a render target, transient targets with equal descriptions can share their memory.
+ *
+ */
+struct GLRF::FrameGraphTextureDesc {
+	GLsizei width = 0;
+	GLsizei height = 0;
+	GLenum internal_format = GL_RGBA8;
+	// renderbuffers can only be attached, e.g. depth buffers that are never sampled
+	bool renderbuffer = false;
+
+	bool operator==(const FrameGraphTextureDesc & other) const {
+		return this->width == other.width && this->height == other.height
+			&& this->internal_format == other.internal_format && this->renderbuffer == other.renderbuffer;
+	}
+};
+
+/**
+ * @brief A handle to a version of a resource of a FrameGraph.
+ *
+ * Every write creates a new version, so a pass that reads a handle depends on the pass that wrote it.
+ */
+struct GLRF::FrameGraphResource {
+	static const size_t INVALID = SIZE_MAX;
+	size_t node = INVALID;
+
+	bool isValid() const { return this->node != INVALID; }
+};
+
+/**
+ * @brief Declares the resources of a pass, see FrameGraph::addPass.
+ *
+ */
+class GLRF::FrameGraphBuilder
+{
+public:
+	/**
+	 * @brief Creates a transient render target that only lives while passes use it.
+	 *
+	 */
+	FrameGraphResource create(const std::string & name, const FrameGraphTextureDesc & desc);
+
+	/**
+	 * @brief Declares that the pass reads the resource.
+	 *
+	 */
+	FrameGraphResource read(FrameGraphResource resource, FrameGraphAccess access = FrameGraphAccess::SAMPLED);
+
+	/**
+	 * @brief Declares that the pass writes the resource.
+	 *
+	 * @return FrameGraphResource the new version of the resource, later passes have to use it
+	 *
+	 * The previous content is kept, so writing a resource that was written before also reads it.
+	 */
+	FrameGraphResource write(FrameGraphResource resource, FrameGraphAccess access = FrameGraphAccess::ATTACHMENT);
+
+	/**
+	 * @brief Keeps the pass even if nothing reads its results (e.g. a pass that reads back data).
+	 *
+	 */
+	void setSideEffect();
+private:
+	friend class FrameGraph;
+
+	FrameGraph & graph;
+	size_t pass;
+
+	FrameGraphBuilder(FrameGraph & graph, size_t pass);
+};
+
+/**
+ * @brief Gives a pass access to the physical resources while it is executed.
+ *
+ */
+class GLRF::FrameGraphPassContext
+{
+public:
+	/**
+	 * @brief Returns the texture (or renderbuffer) that the resource is assigned to in this frame.
+	 *
+	 */
+	GLuint getTexture(FrameGraphResource resource) const;
+
+	/**
+	 * @brief Returns the framebuffer with the attachments of the pass, it is bound before the pass is executed.
+	 *
+	 */
+	GLuint getFramebuffer() const;
+private:
+	friend class FrameGraph;
+
+	const FrameGraph & graph;
+	GLuint framebuffer;
+
+	FrameGraphPassContext(const FrameGraph & graph, GLuint framebuffer);
+};
+
+/**
+ * @brief Orders and executes render passes that declare which resources they read and write.
+ *
+ * Passes are declared every frame with addPass, compiled and executed. compile() culls all passes whose results
+ * are never used and assigns the transient resources to physical textures: resources with equal descriptions
+ * whose lifetimes do not overlap share a texture. The textures are pooled across frames, so a steady graph
+ * allocates nothing after the first frame, and unused textures are deleted after a few frames.
+ *
+ * Passes execute in the order they were added, which is a valid order since a pass can only use the handles of
+ * earlier passes. Framebuffers are created per combination of attachments and bound before a pass executes.
+ * Memory barriers are only needed after image stores, since GL synchronizes attachments and samplers itself.
+ * They are issued before the first pass that reads a resource written with FrameGraphAccess::STORAGE.
+ */
+class GLRF::FrameGraph
+{
+public:
+	typedef std::function<void(FrameGraphBuilder &)> SetupFunction;
+	typedef std::function<void(const FrameGraphPassContext &)> ExecuteFunction;
+
+	// pooled textures that were not used for this number of frames are deleted
+	static const unsigned int POOL_RETENTION_FRAMES = 3;
+
+	FrameGraph();
+	~FrameGraph();
+
+	/**
+	 * @brief Imports a texture that lives outside of the graph, passes writing it are never culled.
+	 *
+	 */
+	FrameGraphResource importTexture(const std::string & name, GLuint texture, const FrameGraphTextureDesc & desc);
+
+	/**
+	 * @brief Imports the default framebuffer, passes writing it are never culled.
+	 *
+	 * A pass that writes the backbuffer can not write other attachments.
+	 */
+	FrameGraphResource importBackbuffer(const std::string & name, GLsizei width, GLsizei height);
+
+	/**
+	 * @brief Adds a pass.
+	 *
+	 * @param setup called immediately to declare the resources of the pass
+	 * @param execute called by execute() if the pass was not culled
+	 */
+	void addPass(const std::string & name, SetupFunction setup, ExecuteFunction execute);
+
+	/**
+	 * @brief Culls unused passes and assigns the transient resources to physical resources.
+	 *
+	 * Does not call OpenGL, the physical resources are allocated by execute().
+	 */
+	void compile();
+
+	/**
+	 * @brief Executes the passes that were not culled, compiles the graph first if needed.
+	 *
+	 */
+	void execute();
+
+	/**
+	 * @brief Removes all passes and resources to declare the next frame, the pooled textures are kept.
+	 *
+	 * Framebuffers that attach imported objects are deleted, since the imported objects may be deleted
+	 * and their names reused before the next frame.
+	 */
+	void reset();
+
+	/**
+	 * @brief Deletes all pooled textures, renderbuffers and framebuffers.
+	 *
+	 */
+	void releasePool();
+
+	bool isCulled(const std::string & pass_name) const;
+
+	/**
+	 * @brief Returns the number of physical textures and renderbuffers that the transient resources are assigned to.
+	 *
+	 */
+	size_t getPhysicalResourceCount() const;
+
+	/**
+	 * @brief Returns the number of transient resources that were created.
+	 *
+	 */
+	size_t getTransientResourceCount() const;
+
+	/**
+	 * @brief Returns the estimated size of all pooled textures and renderbuffers in bytes.
+	 *
+	 */
+	size_t getPooledBytes() const;
+private:
+	friend class FrameGraphBuilder;
+	friend class FrameGraphPassContext;
+
+	struct Resource {
+		std::string name;
+		FrameGraphTextureDesc desc;
+		bool imported = false;
+		bool backbuffer = false;
+		GLuint imported_texture = 0;
+		// the first and last pass that uses the resource, and the physical resource it is assigned to
+		size_t first_pass = SIZE_MAX;
+		size_t last_pass = 0;
+		size_t physical = SIZE_MAX;
+	};
+
+	struct Node {
+		size_t resource;
+		size_t producer = SIZE_MAX;
+		FrameGraphAccess access = FrameGraphAccess::ATTACHMENT;
+		unsigned int ref_count = 0;
+	};
+
+	struct Access {
+		size_t node;
+		FrameGraphAccess access;
+	};
+
+	struct Pass {
+		std::string name;
+		ExecuteFunction execute;
+		std::vector<Access> reads;
+		std::vector<Access> writes;
+		bool side_effect = false;
+		bool culled = false;
+		unsigned int ref_count = 0;
+		GLbitfield barriers = 0;
+	};
+
+	struct PooledObject {
+		FrameGraphTextureDesc desc;
+		GLuint object = 0;
+		bool in_use = false;
+		unsigned int unused_frames = 0;
+	};
+
+	std::vector<Resource> resources;
+	std::vector<Node> nodes;
+	std::vector<Pass> passes;
+	bool compiled = false;
+
+	// the descriptions of the physical resources of the compiled graph and their objects in the current frame
+	std::vector<FrameGraphTextureDesc> physical_descs;
+	std::vector<GLuint> physical_objects;
+
+	std::vector<PooledObject> pool;
+	// framebuffers by their attachments, each as attachment point, object and whether it is a renderbuffer
+	std::map<std::vector<GLuint>, GLuint> framebuffers;
+	// framebuffers that attach imported objects, only kept until the next reset
+	std::map<std::vector<GLuint>, GLuint> imported_framebuffers;
+
+	FrameGraph(const FrameGraph&);
+	FrameGraph& operator = (const FrameGraph&);
+
+	size_t addResource(Resource resource);
+	GLuint acquire(const FrameGraphTextureDesc & desc);
+	void releaseUnusedPoolObjects();
+	void releaseImportedFramebuffers();
+	GLuint getFramebuffer(const Pass & pass);
+	GLuint getObject(FrameGraphResource resource) const;
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+
+namespace GLRF {
+	struct FrameUniforms;
+	class FrameUniformBuffer;
+
+	/**
+	 * @brief Returns the offset of a std140 member that follows a member ending at 'previous_end'.
+	 *
+	 * @param previous_end the offset of the previous member plus its size in the std140 layout
+	 * @param alignment the base alignment of the member (4 for scalars, 8 for vec2, 16 for vec3, vec4, matrices and arrays)
+	 */
+	constexpr size_t std140Offset(size_t previous_end, size_t alignment) {
+		return (previous_end + alignment - 1) / alignment * alignment;
+	}
+}
+
+/**
+ * @brief The camera and light data of a frame, laid out like the std140 uniform block of getGLSLInterface().
+ *
+ * std140 aligns vec3 to 16 bytes and gives every array element a stride of 16 bytes,
+ * the padding members fill these gaps. The layout is checked at compile time below the struct.
+ */
+struct GLRF::FrameUniforms {
+	static const GLuint MAX_POINT_LIGHTS = 32;
+
+	// an element of a vec3 array
+	struct Vec3Element {
+		glm::vec3 value;
+		float padding;
+	};
+
+	// an element of a float array
+	struct FloatElement {
+		float value;
+		float padding[3];
+	};
+
+	glm::mat4 view;
+	glm::vec3 camera_position;
+	float padding0;
+	glm::vec3 camera_view_dir;
+	float padding1;
+	glm::vec3 directional_light_direction;
+	float directional_light_power;
+	GLuint point_light_count;
+	GLuint use_directional_light;
+	GLuint padding2[2];
+	Vec3Element point_light_position[MAX_POINT_LIGHTS];
+	Vec3Element point_light_color[MAX_POINT_LIGHTS];
+	FloatElement point_light_power[MAX_POINT_LIGHTS];
+};
+
+// the offsets of the members in the std140 block, derived from the GLSL declaration
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::mat4) == 64, "glm types must be tightly packed");
+static_assert(offsetof(GLRF::FrameUniforms, view) == 0,
+	"std140 layout of 'view'");
+static_assert(offsetof(GLRF::FrameUniforms, camera_position) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, view) + 64, 16),
+	"std140 layout of 'camera_position'");
+static_assert(offsetof(GLRF::FrameUniforms, camera_view_dir) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, camera_position) + 12, 16),
+	"std140 layout of 'camera_view_dir'");
+static_assert(offsetof(GLRF::FrameUniforms, directional_light_direction) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, camera_view_dir) + 12, 16),
+	"std140 layout of 'directionalLight_direction'");
+static_assert(offsetof(GLRF::FrameUniforms, directional_light_power) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, directional_light_direction) + 12, 4),
+	"std140 layout of 'directionalLight_power'");
+static_assert(offsetof(GLRF::FrameUniforms, point_light_count) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, directional_light_power) + 4, 4),
+	"std140 layout of 'pointLight_count'");
+static_assert(offsetof(GLRF::FrameUniforms, use_directional_light) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, point_light_count) + 4, 4),
+	"std140 layout of 'useDirectionalLight'");
+static_assert(offsetof(GLRF::FrameUniforms, point_light_position) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, use_directional_light) + 4, 16),
+	"std140 layout of 'pointLight_position'");
+static_assert(offsetof(GLRF::FrameUniforms, point_light_color) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, point_light_position) + 16 * GLRF::FrameUniforms::MAX_POINT_LIGHTS, 16),
+	"std140 layout of 'pointLight_color'");
+static_assert(offsetof(GLRF::FrameUniforms, point_light_power) == GLRF::std140Offset(offsetof(GLRF::FrameUniforms, point_light_color) + 16 * GLRF::FrameUniforms::MAX_POINT_LIGHTS, 16),
+	"std140 layout of 'pointLight_power'");
+static_assert(sizeof(GLRF::FrameUniforms) == offsetof(GLRF::FrameUniforms, point_light_power) + 16 * GLRF::FrameUniforms::MAX_POINT_LIGHTS,
+	"std140 size of 'FrameUniforms'");
+
+/**
+ * @brief The uniform buffer that shares the FrameUniforms with all shaders.
+ *
+ * The buffer is written once per frame (Scene::draw does this) and stays bound at UNIFORM_BUFFER_BINDING,
+ * so the camera and light data does not have to be set in every shader.
+ * The GLSL side of the block is returned by getGLSLInterface().
+ */
+class GLRF::FrameUniformBuffer
+{
+public:
+	static const GLuint UNIFORM_BUFFER_BINDING = 0;
+	static constexpr const char * BLOCK_NAME = "FrameUniforms";
+
+	static FrameUniformBuffer& getInstance() {
+		static FrameUniformBuffer instance;
+		return instance;
+	}
+
+	~FrameUniformBuffer();
+
+	/**
+	 * @brief Uploads the uniforms of the current frame and binds the buffer.
+	 *
+	 * @param uniforms the camera and light data of the frame
+	 */
+	void update(const FrameUniforms & uniforms);
+
+	/**
+	 * @brief Returns the GLSL declaration of the uniform block.
+	 *
+	 * The block members keep the names of the former plain uniforms ('view', 'camera_position',
+	 * 'pointLight_position[i]', ...), so shaders only have to replace their declarations with the block.
+	 */
+	static std::string getGLSLInterface();
+
+	/**
+	 * @brief Returns the GLSL function 'vec3 shade(vec3 albedo, float roughness, float metallic, vec3 n, vec3 v, vec3 l, vec3 radiance)'.
+	 *
+	 * It evaluates the Cook-Torrance GGX BRDF for the light arriving from the direction l, the renderers of the
+	 * framework share it so their results match.
+	 */
+	static std::string getGLSLLighting();
+
+	/**
+	 * @brief Releases the buffer. Must be called while the OpenGL context is still alive.
+	 *
+	 */
+	void clear();
+private:
+	GLuint UBO = 0;
+
+	FrameUniformBuffer();
+	FrameUniformBuffer(const FrameUniformBuffer&);
+	FrameUniformBuffer& operator = (const FrameUniformBuffer&);
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <glad/glad.h>
+#include <set>
+#include <string>
+
+// The glad loader of this project is generated for the core profile without extensions,
+// so the few extension entry points that GLRF uses are declared and loaded here.
+#ifndef APIENTRYP
+#define APIENTRYP APIENTRY *
+#endif
+
+typedef GLuint64 (APIENTRYP PFNGLRFGETTEXTURESAMPLERHANDLEARBPROC)(GLuint texture, GLuint sampler);
+typedef void (APIENTRYP PFNGLRFMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLRFMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLRFMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace GLRF {
+	class GLExtensions;
+}
+
+/**
+ * @brief Detects OpenGL extensions of the current context and loads their entry points.
+ *
+ * Must be loaded once after the context has been created (AppFrame does this).
+ */
+class GLRF::GLExtensions
+{
+public:
+	static GLExtensions& getInstance() {
+		static GLExtensions instance;
+		return instance;
+	}
+
+	~GLExtensions();
+
+	/**
+	 * @brief Queries the extensions of the current context and loads the supported entry points.
+	 *
+	 * @param loader the function that resolves OpenGL entry points (e.g. glfwGetProcAddress)
+	 */
+	void load(GLADloadproc loader);
+
+	/**
+	 * @brief Returns whether the current context exposes the specified extension.
+	 *
+	 * @param name the name of the extension (e.g. 'GL_ARB_bindless_texture')
+	 */
+	bool isSupported(const std::string & name);
+
+	/**
+	 * @brief Returns whether bindless textures are supported and were loaded.
+	 *
+	 */
+	bool hasBindlessTextures();
+
+	/**
+	 * @brief Returns whether the driver compiles shaders in the background (GL_KHR_parallel_shader_compile),
+	 * so GL_COMPLETION_STATUS_KHR can be polled without waiting.
+	 *
+	 */
+	bool hasParallelShaderCompile();
+
+	/**
+	 * @brief Returns whether objects are created and modified with direct state access (OpenGL 4.5),
+	 * i.e. without binding them.
+	 *
+	 */
+	bool hasDirectStateAccess();
+
+	/**
+	 * @brief Enables or disables direct state access, it is only enabled if the context supports it.
+	 *
+	 * Must be called before any object is created (e.g. to test the fallback path).
+	 */
+	void setDirectStateAccessEnabled(bool enabled);
+
+	// === GL_ARB_bindless_texture ===
+	PFNGLRFGETTEXTURESAMPLERHANDLEARBPROC getTextureSamplerHandleARB = nullptr;
+	PFNGLRFMAKETEXTUREHANDLERESIDENTARBPROC makeTextureHandleResidentARB = nullptr;
+	PFNGLRFMAKETEXTUREHANDLENONRESIDENTARBPROC makeTextureHandleNonResidentARB = nullptr;
+
+	// === GL_KHR_parallel_shader_compile ===
+	PFNGLRFMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreadsKHR = nullptr;
+private:
+	std::set<std::string> extensions;
+	bool bindless_textures = false;
+	bool parallel_shader_compile = false;
+	bool direct_state_access_supported = false;
+	bool direct_state_access = false;
+
+	GLExtensions();
+	GLExtensions(const GLExtensions&);
+	GLExtensions& operator = (const GLExtensions&);
+};
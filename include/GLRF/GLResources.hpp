@@ -0,0 +1,94 @@
+#pragma once
+#include <glad/glad.h>
+
+namespace GLRF {
+	class GLResources;
+}
+
+/**
+ * @brief Creates and modifies buffers, textures, vertex arrays and framebuffers without disturbing the bound state.
+ *
+ * With direct state access (OpenGL 4.5, see GLExtensions::hasDirectStateAccess) objects are modified by name.
+ * The fallback binds them through the GLStateCache instead: buffers to GL_COPY_WRITE_BUFFER, textures to
+ * the active texture unit and framebuffers temporarily, so the bindings used for drawing are kept.
+ */
+class GLRF::GLResources
+{
+public:
+	/**
+	 * @brief Returns whether the direct state access path is used.
+	 *
+	 */
+	static bool usesDirectStateAccess();
+
+	// === buffers ===
+	static GLuint createBuffer();
+
+	/**
+	 * @brief Allocates immutable storage for a buffer.
+	 *
+	 * @param flags the storage flags, e.g. GL_DYNAMIC_STORAGE_BIT to allow bufferSubData()
+	 *
+	 * Without OpenGL 4.4 mutable storage with a matching usage is allocated instead.
+	 */
+	static void bufferStorage(GLuint buffer, GLsizeiptr size, const void * data, GLbitfield flags);
+
+	/**
+	 * @brief Allocates mutable storage for a buffer, for buffers that are resized.
+	 *
+	 */
+	static void bufferData(GLuint buffer, GLsizeiptr size, const void * data, GLenum usage);
+	static void bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void * data);
+	static void getBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, void * data);
+	static void * mapBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	static void unmapBuffer(GLuint buffer);
+
+	// === textures ===
+	static GLuint createTexture(GLenum target);
+	static void textureStorage2D(GLuint texture, GLenum target, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height);
+	static void textureStorage3D(GLuint texture, GLenum target, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height, GLsizei depth);
+	static void textureParameteri(GLuint texture, GLenum target, GLenum name, GLint value);
+	static void textureParameteriv(GLuint texture, GLenum target, GLenum name, const GLint * values);
+
+	/**
+	 * @brief Replaces a region of a texture level.
+	 *
+	 * @param target the target of the texture, or a face of a cube map (e.g. GL_TEXTURE_CUBE_MAP_POSITIVE_X)
+	 */
+	static void textureSubImage2D(GLuint texture, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void * pixels);
+	static void compressedTextureSubImage2D(GLuint texture, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLsizei size, const void * data);
+	static void generateMipmap(GLuint texture, GLenum target);
+
+	/**
+	 * @brief Reads a texture level.
+	 *
+	 * @param target the target of the texture, or a face of a cube map (e.g. GL_TEXTURE_CUBE_MAP_POSITIVE_X)
+	 * @param size the size of the destination in bytes
+	 */
+	static void getTextureImage(GLuint texture, GLenum target, GLint level, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, GLsizei size, void * pixels);
+
+	// === vertex arrays ===
+	static GLuint createVertexArray();
+
+	// === framebuffers ===
+	static GLuint createFramebuffer();
+	static void framebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level);
+	static void framebufferRenderbuffer(GLuint framebuffer, GLenum attachment, GLuint renderbuffer);
+	static void framebufferDrawBuffers(GLuint framebuffer, GLsizei count, const GLenum * buffers);
+	static GLenum checkFramebufferStatus(GLuint framebuffer);
+
+	/**
+	 * @brief Copies a region of one framebuffer into a region of another, scaling it if the sizes differ.
+	 *
+	 * The fallback binds the destination through the GLStateCache, so it stays bound afterwards.
+	 */
+	static void blitFramebuffer(GLuint source, GLuint destination, GLint source_x0, GLint source_y0, GLint source_x1, GLint source_y1,
+		GLint destination_x0, GLint destination_y0, GLint destination_x1, GLint destination_y1, GLbitfield mask, GLenum filter);
+	static GLuint createRenderbuffer();
+	static void renderbufferStorage(GLuint renderbuffer, GLenum internal_format, GLsizei width, GLsizei height);
+private:
+	GLResources();
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace GLRF {
+	struct StateChangeStats;
+	class GLStateCache;
+}
+
+/**
+ * @brief Counts the state changes that were issued to the driver and the ones that were filtered.
+ *
+ */
+struct GLRF::StateChangeStats {
+	size_t issued = 0;
+	size_t skipped = 0;
+};
+
+/**
+ * @brief A shadow copy of the OpenGL state that GLRF changes, so redundant state changes are never issued.
+ *
+ * The cache never queries the driver (no glGet* on the hot path). Every state starts unknown and is known after
+ * it was set through the cache once, so all GLRF modules have to change these states through the cache.
+ * Code outside of GLRF that changes them directly has to call invalidate() afterwards.
+ * Objects have to be deleted through the cache as well, since GL may reuse their names for new objects.
+ *
+ * The element array buffer binding is part of the vertex array object and is therefore not cached.
+ */
+class GLRF::GLStateCache
+{
+public:
+	static GLStateCache& getInstance() {
+		static GLStateCache instance;
+		return instance;
+	}
+
+	// the texture units whose bindings are cached, units beyond are always bound
+	static const GLuint MAX_TEXTURE_UNITS = 32;
+	// the indexed buffer binding points whose bindings are cached, indices beyond are always bound
+	static const GLuint MAX_BUFFER_INDICES = 16;
+
+	~GLStateCache();
+
+	/**
+	 * @brief Forgets all cached states, so every state is set again by its next change.
+	 *
+	 * Needed after code outside of GLRF changed the state or a new context was made current.
+	 */
+	void invalidate();
+
+	// === bindings ===
+	void bindFramebuffer(GLuint framebuffer);
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertex_array);
+
+	/**
+	 * @brief Binds a texture to a texture unit, the active texture unit is only changed if the binding changes.
+	 *
+	 * @param unit the index of the texture unit (not GL_TEXTURE0 + index)
+	 * @param target the texture target, e.g. GL_TEXTURE_2D
+	 * @param texture the texture
+	 */
+	void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	/**
+	 * @brief Binds a texture to the active texture unit, e.g. to specify its storage.
+	 *
+	 */
+	void bindTexture(GLenum target, GLuint texture);
+
+	void bindSampler(GLuint unit, GLuint sampler);
+
+	/**
+	 * @brief Binds a buffer to a generic binding point, e.g. GL_ARRAY_BUFFER.
+	 *
+	 * GL_ELEMENT_ARRAY_BUFFER is passed through, since it belongs to the bound vertex array.
+	 */
+	void bindBuffer(GLenum target, GLuint buffer);
+
+	/**
+	 * @brief Binds a buffer to an indexed binding point, e.g. GL_UNIFORM_BUFFER, and to its generic binding point.
+	 *
+	 */
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	// === fixed function state ===
+	void setCapability(GLenum capability, bool enabled);
+	void setBlendFunc(GLenum source_factor, GLenum destination_factor);
+	void setDepthFunc(GLenum function);
+	void setDepthMask(bool write);
+	void setColorMask(bool write);
+	void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void setPointSize(GLfloat size);
+	void setLineWidth(GLfloat width);
+	void setPatchVertices(GLint vertices);
+
+	// === deletion ===
+	void deleteFramebuffers(GLsizei count, const GLuint * framebuffers);
+	void deleteProgram(GLuint program);
+	void deleteVertexArrays(GLsizei count, const GLuint * vertex_arrays);
+	void deleteTextures(GLsizei count, const GLuint * textures);
+	void deleteSamplers(GLsizei count, const GLuint * samplers);
+	void deleteBuffers(GLsizei count, const GLuint * buffers);
+
+	/**
+	 * @brief Returns the cached framebuffer binding, or std::nullopt if it is unknown.
+	 *
+	 */
+	std::optional<GLuint> getFramebuffer();
+
+	/**
+	 * @brief Returns the cached program, or std::nullopt if it is unknown.
+	 *
+	 */
+	std::optional<GLuint> getProgram();
+
+	StateChangeStats getStats();
+	void resetStats();
+private:
+	static const size_t NUM_TEXTURE_TARGETS = 3;
+	static const size_t NUM_BUFFER_TARGETS = 9;
+	static const size_t NUM_INDEXED_BUFFER_TARGETS = 2;
+
+	struct TextureUnit {
+		std::array<std::optional<GLuint>, NUM_TEXTURE_TARGETS> textures;
+		std::optional<GLuint> sampler;
+	};
+
+	std::optional<GLuint> framebuffer;
+	std::optional<GLuint> program;
+	std::optional<GLuint> vertex_array;
+	std::optional<GLuint> active_texture_unit;
+	std::array<TextureUnit, MAX_TEXTURE_UNITS> texture_units;
+	std::array<std::optional<GLuint>, NUM_BUFFER_TARGETS> buffers;
+	std::array<std::array<std::optional<GLuint>, MAX_BUFFER_INDICES>, NUM_INDEXED_BUFFER_TARGETS> indexed_buffers;
+
+	std::unordered_map<GLenum, bool> capabilities;
+	std::optional<std::pair<GLenum, GLenum>> blend_func;
+	std::optional<GLenum> depth_func;
+	std::optional<bool> depth_mask;
+	std::optional<bool> color_mask;
+	std::optional<std::array<GLint, 4>> viewport;
+	std::optional<GLfloat> point_size;
+	std::optional<GLfloat> line_width;
+	std::optional<GLint> patch_vertices;
+
+	StateChangeStats stats;
+
+	GLStateCache();
+	GLStateCache(const GLStateCache&);
+	GLStateCache& operator = (const GLStateCache&);
+
+	/**
+	 * @brief Returns whether the cached value differs from the new value and stores the new value if it does.
+	 *
+	 */
+	template <typename T, typename U>
+	bool change(std::optional<T> & cached, const U & value) {
+		if (cached == value) {
+			++this->stats.skipped;
+			return false;
+		}
+		cached = value;
+		++this->stats.issued;
+		return true;
+	}
+
+	void activateTextureUnit(GLuint unit);
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace GLRF {
+	constexpr std::uint64_t FNV_OFFSET_BASIS_64 = 14695981039346656037ull;
+	constexpr std::uint64_t FNV_PRIME_64 = 1099511628211ull;
+
+	/**
+	 * 64 bit FNV-1a hash of a byte sequence.
+	 * Stable across platforms and runs, so it can be used for persisted cache keys.
+	 * Pass a previous result as 'hash' to continue hashing over multiple sequences.
+	 * Named differently from the std::string overload, so fnv1a64("literal", hash) can not pass the hash as the length.
+	 */
+	constexpr std::uint64_t fnv1a64Bytes(const char * data, size_t length, std::uint64_t hash = FNV_OFFSET_BASIS_64) {
+		for (size_t i = 0; i < length; ++i) {
+			hash ^= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i]));
+			hash *= FNV_PRIME_64;
+		}
+		return hash;
+	}
+
+	inline std::uint64_t fnv1a64(const std::string & data, std::uint64_t hash = FNV_OFFSET_BASIS_64) {
+		return fnv1a64Bytes(data.data(), data.size(), hash);
+	}
+
+	/**
+	 * Formats a hash as a fixed-width hexadecimal string (e.g. for file names).
+	 */
+	inline std::string toHexString(std::uint64_t hash) {
+		static const char digits[] = "0123456789abcdef";
+		std::string result(16, '0');
+		for (int i = 15; i >= 0; --i) {
+			result[i] = digits[hash & 0xF];
+			hash >>= 4;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+
+#include <GLRF/FrameBuffer.hpp>
+
+namespace GLRF {
+	class HeadlessContext;
+}
+
+/**
+ * @brief An OpenGL context without a window, for render nodes and benchmarks on machines without a display.
+ *
+ * The backend is chosen when GLRF is built (GLRF_HEADLESS_BACKEND = EGL or OSMESA):
+ * - EGL creates a surfaceless context (EGL_MESA_platform_surfaceless), which works with the GPU drivers of Mesa
+ *   and NVIDIA as well as with the llvmpipe software rasterizer.
+ * - OSMesa renders in software into a buffer in client memory.
+ *
+ * There is no default framebuffer that can be presented (surfaceless contexts have none at all),
+ * so everything has to be rendered into FrameBuffer objects.
+ */
+class GLRF::HeadlessContext
+{
+public:
+	/**
+	 * @brief Creates a core profile context (4.3 or newer) and makes it current.
+	 *
+	 * @param resolution the size of the OSMesa buffer, ignored by EGL
+	 *
+	 * Throws a std::runtime_error if GLRF was built without a headless backend or no context can be created.
+	 */
+	HeadlessContext(ScreenResolution resolution);
+	~HeadlessContext();
+
+	/**
+	 * @brief Returns whether GLRF was built with a headless backend.
+	 *
+	 */
+	static bool isAvailable();
+
+	/**
+	 * @brief Returns the function that resolves OpenGL entry points in this context, to load glad and the GLExtensions.
+	 *
+	 */
+	GLADloadproc getLoader();
+private:
+	// the handles of the backend, kept opaque so its headers are only needed by the implementation
+	void * display = nullptr;
+	void * context = nullptr;
+	// the color buffer of OSMesa
+	std::vector<unsigned char> buffer;
+
+	HeadlessContext(const HeadlessContext&);
+	HeadlessContext& operator = (const HeadlessContext&);
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include <GLRF/ImageData.hpp>
+
+namespace fs = std::filesystem;
+
+namespace GLRF {
+	struct ImageCacheStats;
+	class ImageCache;
+}
+
+/**
+ * @brief Counters of the ImageCache since the start (or the last call of resetStats).
+ *
+ */
+struct GLRF::ImageCacheStats {
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t stores = 0;
+	size_t evictions = 0;
+	size_t bytes_read = 0;
+	size_t bytes_written = 0;
+	// the current content of the cache directory
+	size_t entry_count = 0;
+	size_t total_size = 0;
+};
+
+/**
+ * @brief A persistent cache of decoded images including their mip chain.
+ *
+ * Entries are keyed by the path, modification time and size of the source file together with the parameters
+ * that were used to load it, so edited sources are decoded again automatically. Every entry is a single-texture
+ * AssetArchive, i.e. hits are memory mapped and uploaded without copying the texels.
+ * If the cache grows beyond its maximum size, the least recently used entries are deleted. The access order is
+ * kept in the modification time of the entry files, so it survives restarts.
+ * All functions may be called from worker threads.
+ */
+class GLRF::ImageCache
+{
+public:
+	static ImageCache& getInstance() {
+		static ImageCache instance;
+		return instance;
+	}
+
+	~ImageCache();
+
+	/**
+	 * @brief Returns the cached image of a source file.
+	 *
+	 * @param path the path to the source file
+	 * @param parameters a description of all settings that change the decoded result
+	 * @param srgb whether the color channels of the image are stored in sRGB space
+	 * @return ImageData the cached image, empty if the cache does not contain an up to date entry
+	 */
+	ImageData load(const std::string & path, const std::string & parameters, bool srgb);
+
+	/**
+	 * @brief Adds the decoded image of a source file to the cache.
+	 *
+	 * @param path the path to the source file
+	 * @param parameters a description of all settings that change the decoded result
+	 * @param image the decoded image
+	 */
+	void store(const std::string & path, const std::string & parameters, const ImageData & image);
+
+	/**
+	 * @brief Deletes all entries.
+	 *
+	 */
+	void clear();
+
+	void setEnabled(bool enabled);
+	bool isEnabled();
+
+	/**
+	 * @brief Sets the directory of the cache, the entries of the previous directory are kept on disk.
+	 *
+	 */
+	void setDirectory(fs::path directory);
+	fs::path getDirectory();
+
+	/**
+	 * @brief Sets the maximum number of bytes that all entries may use together.
+	 *
+	 */
+	void setMaxSize(size_t bytes);
+	size_t getMaxSize();
+
+	ImageCacheStats getStats();
+	void resetStats();
+private:
+	struct Entry {
+		size_t size = 0;
+		fs::file_time_type last_access;
+	};
+
+	std::mutex mutex;
+	bool enabled = true;
+	fs::path directory = fs::path(".glrf_cache") / "images";
+	size_t max_size = static_cast<size_t>(1) << 30;
+	bool scanned = false;
+	std::unordered_map<std::string, Entry> entries;
+	std::set<std::string> pending;
+	size_t total_size = 0;
+	ImageCacheStats stats;
+
+	ImageCache();
+	ImageCache(const ImageCache&);
+	ImageCache& operator = (const ImageCache&);
+
+	bool createKey(const std::string & path, const std::string & parameters, std::string & key);
+	fs::path getEntryFile(const std::string & key);
+	void scanDirectory();
+	void removeEntry(const std::string & key);
+	void evict(const std::string & keep);
+};
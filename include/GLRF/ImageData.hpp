@@ -0,0 +1,175 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GLRF {
+	enum class TextureSourceType;
+	struct TextureFormat;
+	struct ImageLevel;
+	class ImageData;
+}
+
+/**
+ * @brief The precision class of the texels inside an image file.
+ *
+ */
+enum class GLRF::TextureSourceType {
+	LDR,	// 8 bit per channel (png, jpg, tga, ...)
+	LDR16,	// 16 bit per channel (16 bit png)
+	HDR		// floating point (hdr)
+};
+
+/**
+ * @brief Describes how texels are stored on the CPU and which OpenGL storage they map to.
+ *
+ */
+struct GLRF::TextureFormat {
+	GLenum internal_format = GL_RGBA8;
+	GLenum pixel_format = GL_RGBA;
+	GLenum data_type = GL_UNSIGNED_BYTE;
+	GLuint channels = 4;
+	GLuint bytes_per_channel = 1;
+	bool is_srgb = false;
+
+	/**
+	 * @brief The size in bytes of a 4x4 texel block, 0 for uncompressed formats.
+	 *
+	 */
+	GLuint block_size = 0;
+
+	/**
+	 * @brief Returns whether the texels are stored in 4x4 compressed blocks.
+	 *
+	 */
+	bool isCompressed() const;
+
+	/**
+	 * @brief Returns the size of a single texel in bytes on the CPU side.
+	 *
+	 */
+	size_t getTexelSize() const;
+
+	/**
+	 * @brief Returns the size of a single texel in bytes inside the OpenGL storage.
+	 *
+	 */
+	size_t getStorageTexelSize() const;
+
+	/**
+	 * @brief Returns the size in bytes of a level with the given dimensions on the CPU side.
+	 *
+	 */
+	size_t calculateLevelSize(GLsizei width, GLsizei height) const;
+
+	/**
+	 * @brief Returns the size in bytes of a level with the given dimensions inside the OpenGL storage.
+	 *
+	 */
+	size_t calculateStorageSize(GLsizei width, GLsizei height) const;
+
+	/**
+	 * @brief Returns the swizzle mask that makes the format behave like the former RGBA expansion.
+	 *
+	 * Single channel images are sampled as (r, r, r, 1), two channel images as (r, r, r, g).
+	 */
+	void getSwizzleMask(GLint * mask) const;
+
+	/**
+	 * @brief Selects the tightest format that can represent the source without loss.
+	 *
+	 * @param source_type the precision of the image file
+	 * @param source_channels the number of channels inside the image file
+	 * @param srgb whether the color channels are stored in sRGB space
+	 * @return TextureFormat the selected format
+	 *
+	 * sRGB images are always expanded to four channels, since OpenGL offers no sRGB format with fewer channels.
+	 * Floating point images are stored as RGBA16F.
+	 */
+	static TextureFormat select(TextureSourceType source_type, int source_channels, bool srgb);
+
+	friend bool operator==(const TextureFormat & f1, const TextureFormat & f2) {
+		return f1.internal_format == f2.internal_format && f1.pixel_format == f2.pixel_format
+			&& f1.data_type == f2.data_type && f1.channels == f2.channels && f1.block_size == f2.block_size;
+	}
+
+	friend bool operator!=(const TextureFormat & f1, const TextureFormat & f2) {
+		return !(f1 == f2);
+	}
+};
+
+/**
+ * @brief A single mip level inside the storage of an ImageData object.
+ *
+ */
+struct GLRF::ImageLevel {
+	GLsizei width = 0;
+	GLsizei height = 0;
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+/**
+ * @brief Decoded texel data of an image (and optionally its mip chain) on the CPU.
+ *
+ * The texel storage is reference counted, so copies of an ImageData object are cheap.
+ */
+class GLRF::ImageData {
+public:
+	/**
+	 * @brief Construct an empty ImageData object.
+	 *
+	 */
+	ImageData();
+
+	/**
+	 * @brief Construct a new ImageData object and allocates storage for the requested levels.
+	 *
+	 * @param width the width of the base level
+	 * @param height the height of the base level
+	 * @param format the format of all levels
+	 * @param num_levels the number of levels, starting at the base level
+	 */
+	ImageData(GLsizei width, GLsizei height, TextureFormat format, GLuint num_levels = 1);
+
+	/**
+	 * @brief Construct a new ImageData object on top of existing storage (e.g. a memory mapped archive).
+	 *
+	 * @param format the format of all levels
+	 * @param levels the levels, with offsets relative to the storage
+	 * @param storage the texel storage, which is kept alive as long as the ImageData object
+	 * @param storage_size the size of the storage in bytes
+	 */
+	ImageData(TextureFormat format, std::vector<ImageLevel> levels, std::shared_ptr<unsigned char> storage, size_t storage_size);
+
+	/**
+	 * @brief Decodes an image file.
+	 *
+	 * @param path the path to the image file
+	 * @param srgb whether the color channels are stored in sRGB space
+	 * @return ImageData the decoded base level, empty if the file could not be decoded
+	 */
+	static ImageData decode(const std::string & path, bool srgb);
+
+	/**
+	 * @brief Returns the number of mip levels of a full chain for the given size.
+	 *
+	 */
+	static GLuint calculateMipCount(GLsizei width, GLsizei height);
+
+	bool isEmpty() const;
+	GLsizei getWidth() const;
+	GLsizei getHeight() const;
+	const TextureFormat & getFormat() const;
+	GLuint getLevelCount() const;
+	const ImageLevel & getLevel(GLuint level) const;
+	const unsigned char * getLevelData(GLuint level) const;
+	unsigned char * getLevelData(GLuint level);
+	size_t getStorageSize() const;
+private:
+	TextureFormat format;
+	std::vector<ImageLevel> levels;
+	std::shared_ptr<unsigned char> storage;
+	size_t storage_size = 0;
+};
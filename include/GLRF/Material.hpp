@@ -10,6 +10,7 @@
 
 namespace GLRF {
 	template <typename T> class MaterialProperty;
+	struct MaterialTextureOptions;
 	class Material;
 }
 
@@ -56,10 +57,12 @@ public:
 	 * @param separator separates the properties from the name of the image (e.g. '_')
 	 * @param property_name the name of the property (e.g. 'albedo')
 	 * @param fileType the type (e.g. '.png') of the file
+	 * @param config the storage and sampling options of the texture
 	 * 
 	 * The specified example would evaluate to the image at the path '../textures/tiles_marble_albedo.png'
 	 */
-	void loadTexture(std::string library, std::string texture_name, std::string separator, std::string property_name, std::string fileType);
+	void loadTexture(std::string library, std::string texture_name, std::string separator, std::string property_name, std::string fileType,
+		TextureConfiguration config = TextureConfiguration());
 
 	/**
 	 * @brief Loads a texture into memory that will be used for this property.
@@ -68,17 +71,46 @@ public:
 	 * @param separator separates the properties from the name of the image (e.g. '_')
 	 * @param property_name the name of the property (e.g. 'albedo')
 	 * @param fileType the type (e.g. '.png') of the file
+	 * @param config the storage and sampling options of the texture
 	 * 
 	 * The specified example would evaluate to the image at the path '${DEFAULT_LIB_PATH}/tiles_marble_albedo.png'
 	 */
-	void loadTexture(std::string texture_name, std::string separator, std::string property_name, std::string fileType);
+	void loadTexture(std::string texture_name, std::string separator, std::string property_name, std::string fileType,
+		TextureConfiguration config = TextureConfiguration());
 private:
 	static const char period = '.';
 };
 
+/**
+ * @brief Options for all textures of a material, see Material::getTextureConfiguration.
+ * 
+ */
+struct GLRF::MaterialTextureOptions
+{
+	/**
+	 * @brief Whether only the coarse mip tail is loaded at first and finer levels are streamed in on demand.
+	 * 
+	 */
+	bool streamed = false;
+
+	/**
+	 * @brief Whether the images are decoded on the ThreadPool, see TextureConfiguration::async.
+	 * 
+	 */
+	bool async = false;
+
+	/**
+	 * @brief The alpha test threshold of the opacity texture, its mip levels preserve the coverage.
+	 * 
+	 */
+	float alpha_cutoff = 0.5f;
+	SamplerConfiguration sampler;
+};
+
 /**
  * @brief A collection of properties that define the characteristics of the corresponding objects inside the Scene.
  * 
+ * The properties can be edited at any time, the MaterialTable compares them with its entry once per frame.
  */
 class GLRF::Material {
 public:
@@ -112,9 +144,12 @@ public:
 	 * @param property_name the name of the property (e.g. 'albedo')
 	 * @param fileType the type (e.g. '.png') of the file
 	 * 
+	 * @param options the options of the textures
+	 * 
 	 * The specified example would evaluate to the image at the path '${DEFAULT_LIB_PATH}/tiles_marble_albedo.png'
 	 */
-	void loadTextures(std::string library, std::string name, std::string separator, std::string fileType);
+	void loadTextures(std::string library, std::string name, std::string separator, std::string fileType,
+		MaterialTextureOptions options = MaterialTextureOptions());
 
 	/**
 	 * @brief Loads all textures into memory that will be used for this material.
@@ -124,9 +159,23 @@ public:
 	 * @param property_name the name of the property (e.g. 'albedo')
 	 * @param fileType the type (e.g. '.png') of the file
 	 * 
+	 * @param options the options of the textures
+	 * 
 	 * The specified example would evaluate to the image at the path '${DEFAULT_LIB_PATH}/tiles_marble_albedo.png'
 	 */
-	void loadTextures(std::string name, std::string separator, std::string fileType);
+	void loadTextures(std::string name, std::string separator, std::string fileType,
+		MaterialTextureOptions options = MaterialTextureOptions());
+
+	/**
+	 * @brief Returns the configuration of the texture of a property.
+	 * 
+	 * @param property_name the name of the property (e.g. 'albedo')
+	 * @param options the options of all textures of the material
+	 * 
+	 * Albedo is stored in sRGB space, normal maps are renormalized when their mips are filtered and the mips of
+	 * opacity preserve the alpha coverage, the other properties are linear data.
+	 */
+	static TextureConfiguration getTextureConfiguration(const std::string & property_name, const MaterialTextureOptions & options);
 	
 	/**
 	 * @brief Binds all textures to OpenGL texture units.
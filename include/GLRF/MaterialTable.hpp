@@ -0,0 +1,208 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <GLRF/Material.hpp>
+
+namespace GLRF {
+	class MaterialTable;
+}
+
+/**
+ * @brief Packs the textures and values of all registered materials into a single GPU table.
+ *
+ * Each material is assigned a small index. The table (a shader storage buffer) holds one entry per material
+ * with the default values of its properties, which references its textures either as ARB_bindless_texture handles or,
+ * where bindless textures are not available, as slices of GL_TEXTURE_2D_ARRAY objects that group textures of the same
+ * size and format. Textures in an array become views of their slice, so their texels are only stored once.
+ * Shaders only need the material index, so neither textures nor material uniforms have to be set
+ * per draw and draws with different materials can be merged.
+ * Only the entries of new or changed materials are uploaded, so the cost per frame depends on the number of
+ * changed materials instead of the number of draws.
+ * The table neither keeps materials nor textures alive: the slot of a destroyed material is reused
+ * and a destroyed texture releases its handle or array slice itself.
+ *
+ * The GLSL side of the table is returned by getGLSLInterface().
+ */
+class GLRF::MaterialTable
+{
+public:
+	static const GLuint NUM_TEXTURE_SLOTS = 7;
+	// the upper bound of getMaxTextureArrays()
+	static const GLuint MAX_TEXTURE_ARRAYS = 16;
+	static const GLuint SHADER_STORAGE_BINDING = 2;
+	static const GLuint TEXTURE_UNITS_BEGIN = NUM_TEXTURE_SLOTS;
+
+	static MaterialTable& getInstance() {
+		static MaterialTable instance;
+		return instance;
+	}
+
+	~MaterialTable();
+
+	/**
+	 * @brief Returns the index of the material inside the table, adding it if necessary.
+	 *
+	 * @param material the material
+	 * @return std::optional<GLuint> the index or std::nullopt if the material can not be represented by the table
+	 *
+	 * Materials with streamed textures are not supported, since their storage changes over time.
+	 */
+	std::optional<GLuint> getIndex(std::shared_ptr<Material> material);
+
+	/**
+	 * @brief Rebuilds the entry of a material immediately.
+	 *
+	 * Edited properties are also detected by bind() (at the latest in the next frame),
+	 * this is only needed if the entry has to be current before that.
+	 */
+	void invalidate(std::shared_ptr<Material> material);
+
+	/**
+	 * @brief Releases the handle or array slice of a texture whose storage is about to be replaced or deleted.
+	 *
+	 * Called by the Texture itself (e.g. when an asynchronous load finishes, the streamer reallocates it or it is destroyed),
+	 * the entries of the materials that use it are rebuilt with the next update.
+	 */
+	void invalidateTexture(Texture * texture);
+
+	/**
+	 * @brief Returns how many texture arrays can be bound, starting at TEXTURE_UNITS_BEGIN.
+	 *
+	 * The arrays share GL_MAX_TEXTURE_IMAGE_UNITS with the material units before and the units of the
+	 * EnvironmentMap after them, so the GL minimum of 16 units leaves 6 arrays.
+	 */
+	GLuint getMaxTextureArrays();
+
+	/**
+	 * @brief Returns the first texture unit after the texture arrays.
+	 *
+	 */
+	GLuint getTextureUnitsEnd();
+
+	/**
+	 * @brief Collects the changed and destroyed materials, uploads all pending changes and binds the table and the texture arrays.
+	 *
+	 * Must be called on the render thread before drawing with a shader that uses the table (Scene::draw does this once per frame).
+	 */
+	void bind();
+
+	/**
+	 * @brief Uploads and rebinds the table only if materials were added, changed or released since the last upload.
+	 *
+	 */
+	void update();
+
+	/**
+	 * @brief Returns whether textures are referenced through bindless handles.
+	 *
+	 */
+	bool usesBindlessTextures();
+
+	/**
+	 * @brief Returns the number of live materials in the table.
+	 *
+	 */
+	size_t getMaterialCount();
+
+	/**
+	 * @brief Returns the GLSL declarations that give shaders access to the table.
+	 *
+	 * Defines the function 'vec4 sampleMaterialTexture(uint material_index, uint slot, vec2 uv)',
+	 * 'bool hasMaterialTexture(uint material_index, uint slot)', 'vec4 getMaterialValue(uint material_index, uint slot)',
+	 * which returns the default value of a property, 'vec4 sampleMaterial(uint material_index, uint slot, vec2 uv)',
+	 * which returns the texture if the property has one and the default value otherwise,
+	 * and 'float getMaterialHeightScale(uint material_index)'. The slots follow the texture units of Material::bindTextures.
+	 * In bindless mode the returned source starts with an #extension directive,
+	 * so it has to be placed directly after the #version directive.
+	 */
+	std::string getGLSLInterface();
+
+	/**
+	 * @brief Releases all GPU resources. Must be called while the OpenGL context is still alive.
+	 *
+	 */
+	void clear();
+private:
+	// (width, height, internal format, levels, sampler)
+	typedef std::tuple<GLsizei, GLsizei, GLenum, GLuint, GLuint> ArrayKey;
+
+	struct TextureArray {
+		ArrayKey key;
+		GLuint ID = 0;
+		GLsizei capacity = 0;
+		// nullptr marks a free layer
+		std::vector<Texture *> layers;
+		// the layers whose textures are not copied into the array yet
+		std::vector<GLsizei> pending_layers;
+	};
+
+	struct TextureReference {
+		GLuint x = 0;
+		GLuint y = 0;
+	};
+
+	// mirrors the std430 layout of 'MaterialEntry' in the GLSL interface
+	struct Entry {
+		TextureReference textures[NUM_TEXTURE_SLOTS];
+		GLuint flags = 0;
+		GLuint padding = 0;
+		float albedo[4] = {};
+		float normal[4] = {};
+		float roughness = 0.f;
+		float metallic = 0.f;
+		float ao = 0.f;
+		float height = 0.f;
+		float opacity = 0.f;
+		float height_scale = 0.f;
+		float padding_values[2] = {};
+	};
+	static_assert(sizeof(Entry) == 128, "std430 layout of 'MaterialEntry'");
+
+	struct Slot {
+		std::weak_ptr<Material> material;
+		bool used = false;
+		// the textures the entry was built from, to detect replaced textures
+		std::array<Texture *, NUM_TEXTURE_SLOTS> textures = {};
+	};
+
+	std::map<std::weak_ptr<Material>, GLuint, std::owner_less<>> indices;
+	std::vector<Slot> slots;
+	// the slots of destroyed materials, reused by getIndex
+	std::vector<GLuint> free_slots;
+	std::vector<Entry> entries;
+	std::vector<TextureArray> arrays;
+	std::map<Texture *, std::pair<GLuint, GLuint>> texture_locations;
+	std::map<Texture *, GLuint64> texture_handles;
+	// the entries whose material or textures changed, rebuilt with the next update
+	std::set<size_t> stale_entries;
+	GLuint max_texture_arrays = 0;
+	GLuint SSBO = 0;
+	GLsizeiptr buffer_capacity = 0;
+	bool is_dirty = false;
+	// the range of entries that changed since the last upload
+	size_t dirty_begin = 0;
+	size_t dirty_end = 0;
+
+	MaterialTable();
+	MaterialTable(const MaterialTable&);
+	MaterialTable& operator = (const MaterialTable&);
+
+	std::array<Texture *, NUM_TEXTURE_SLOTS> getTextures(Material * material);
+	std::optional<TextureReference> addTexture(Texture * texture);
+	void writeValues(Material * material, Entry * entry);
+	bool buildEntry(Material * material, Entry * entry);
+	void markDirty(size_t index);
+	void collectChanges();
+	void rebuildStaleEntries();
+	void releaseSlot(size_t index);
+	void uploadArrays();
+	void bindResources();
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <GLRF/ImageData.hpp>
+
+namespace GLRF {
+	enum class MipFilter;
+	struct MipConfiguration;
+	class MipGenerator;
+}
+
+/**
+ * @brief The reconstruction filter that is used to downsample a mip level.
+ *
+ */
+enum class GLRF::MipFilter {
+	BOX,	// 2x2 average
+	KAISER	// Kaiser windowed sinc, sharper than the box filter without visible ringing
+};
+
+/**
+ * @brief Options that control how mip levels are derived from the base level.
+ *
+ */
+struct GLRF::MipConfiguration
+{
+	MipFilter filter = MipFilter::KAISER;
+
+	/**
+	 * @brief Whether the image stores tangent space normals in its color channels.
+	 *
+	 * Filtered normals are renormalized, otherwise distant surfaces lose their shading detail.
+	 */
+	bool normal_map = false;
+
+	/**
+	 * @brief The alpha test threshold of the image, 0 to disable coverage preservation.
+	 *
+	 * If set, the alpha channel of every level is scaled so that the same fraction of texels passes the test
+	 * as in the base level, otherwise alpha tested geometry (e.g. foliage) thins out in the distance.
+	 */
+	float alpha_cutoff = 0.f;
+};
+
+/**
+ * @brief A generator for complete mip chains on the CPU.
+ *
+ * Levels are filtered in linear space, i.e. sRGB images are converted to linear before and back to sRGB after
+ * filtering. Rows are distributed across the ThreadPool and the filter kernels use AVX2 if the CPU supports it.
+ * Block compressed images are not supported.
+ */
+class GLRF::MipGenerator {
+public:
+	MipGenerator(MipConfiguration config = MipConfiguration());
+
+	/**
+	 * @brief Creates the full mip chain for the base level of an image.
+	 *
+	 * @param image the image whose base level will be filtered
+	 * @return ImageData a new image that contains the base level and all mip levels
+	 */
+	ImageData generate(const ImageData & image);
+
+	/**
+	 * @brief Returns whether the AVX2 kernels are used on this CPU.
+	 *
+	 */
+	static bool usesAVX2();
+private:
+	MipConfiguration config;
+
+	void downsample(ImageData & chain, GLuint level);
+	void preserveAlphaCoverage(ImageData & chain, GLuint level, float coverage);
+	float calculateAlphaCoverage(const ImageData & chain, GLuint level);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace GLRF {
+	class ProgramBinaryCache;
+}
+
+/**
+ * @brief A persistent cache of linked shader programs.
+ *
+ * Programs are stored with glGetProgramBinary and keyed by the hash of their sources together with the vendor,
+ * renderer and version of the driver, since binaries are only valid for the driver that created them.
+ * If the driver rejects a cached binary anyway (e.g. after an update that kept the version string),
+ * load() fails and the program has to be compiled again.
+ */
+class GLRF::ProgramBinaryCache
+{
+public:
+	static ProgramBinaryCache& getInstance() {
+		static ProgramBinaryCache instance;
+		return instance;
+	}
+
+	~ProgramBinaryCache();
+
+	/**
+	 * @brief Loads the cached binary into a program.
+	 *
+	 * @param program a program without attached shaders
+	 * @param source_hash the hash of all sources (including defines) of the program
+	 * @return true if the program was linked from the cache
+	 */
+	bool load(GLuint program, std::uint64_t source_hash);
+
+	/**
+	 * @brief Adds a linked program to the cache.
+	 *
+	 * @param program the linked program, the binary should have been requested with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	 * @param source_hash the hash of all sources (including defines) of the program
+	 */
+	void store(GLuint program, std::uint64_t source_hash);
+
+	/**
+	 * @brief Returns whether the driver supports program binaries and the cache is enabled.
+	 *
+	 */
+	bool isAvailable();
+
+	void setEnabled(bool enabled);
+	void setDirectory(fs::path directory);
+	fs::path getDirectory();
+
+	/**
+	 * @brief Deletes all cached programs.
+	 *
+	 */
+	void clear();
+private:
+	bool enabled = true;
+	fs::path directory = fs::path(".glrf_cache") / "programs";
+	// the hash of the driver description, queried with the first program
+	std::uint64_t driver_hash = 0;
+	bool driver_queried = false;
+	bool binaries_supported = false;
+
+	ProgramBinaryCache();
+	ProgramBinaryCache(const ProgramBinaryCache&);
+	ProgramBinaryCache& operator = (const ProgramBinaryCache&);
+
+	void queryDriver();
+	fs::path getEntryFile(std::uint64_t source_hash);
+};
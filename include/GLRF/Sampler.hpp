@@ -0,0 +1,67 @@
+#pragma once
+#include <glad/glad.h>
+#include <map>
+#include <tuple>
+
+namespace GLRF {
+	struct SamplerConfiguration;
+	class SamplerManager;
+}
+
+/**
+ * @brief The sampling state of a texture, shared between all textures with the same configuration.
+ *
+ */
+struct GLRF::SamplerConfiguration {
+	GLenum wrap_s = GL_REPEAT;
+	GLenum wrap_t = GL_REPEAT;
+	GLenum min_filter = GL_LINEAR_MIPMAP_LINEAR;
+	GLenum mag_filter = GL_LINEAR;
+	GLfloat max_anisotropy = 1.f;
+
+	friend bool operator<(const SamplerConfiguration & c1, const SamplerConfiguration & c2) {
+		return std::tie(c1.wrap_s, c1.wrap_t, c1.min_filter, c1.mag_filter, c1.max_anisotropy)
+			< std::tie(c2.wrap_s, c2.wrap_t, c2.min_filter, c2.mag_filter, c2.max_anisotropy);
+	}
+};
+
+/**
+ * @brief Owns all OpenGL sampler objects and hands out one sampler per distinct configuration.
+ *
+ */
+class GLRF::SamplerManager
+{
+public:
+	static SamplerManager& getInstance() {
+		static SamplerManager instance;
+		return instance;
+	}
+
+	~SamplerManager();
+
+	/**
+	 * @brief Returns the sampler object for the given configuration, creating it on first use.
+	 *
+	 * @param configuration the sampling state
+	 * @return GLuint the OpenGL sampler object
+	 */
+	GLuint getSampler(const SamplerConfiguration & configuration);
+
+	/**
+	 * @brief Returns the sampler that is used by textures that do not specify a configuration.
+	 *
+	 */
+	GLuint getDefaultSampler();
+
+	/**
+	 * @brief Deletes all sampler objects. Must be called while the OpenGL context is still alive.
+	 *
+	 */
+	void clear();
+private:
+	std::map<SamplerConfiguration, GLuint> samplers;
+
+	SamplerManager();
+	SamplerManager(const SamplerManager&);
+	SamplerManager& operator = (const SamplerManager&);
+};
@@ -10,8 +10,11 @@
 
 #include <GLRF/Shader.hpp>
 #include <GLRF/Camera.hpp>
+#include <GLRF/EnvironmentMap.hpp>
+#include <GLRF/FrameUniforms.hpp>
 #include <GLRF/SceneObject.hpp>
 #include <GLRF/SceneLight.hpp>
+#include <GLRF/TextureStreamer.hpp>
 #include <GLRF/VectorMath.hpp>
 
 namespace GLRF {
@@ -81,13 +84,62 @@ public:
 	 */
 	void setActiveCamera(std::shared_ptr<Camera> camera);
 
+	/**
+	 * @brief Sets the image based lighting of the scene.
+	 * 
+	 * @param environment the environment, or nullptr to disable image based lighting
+	 * 
+	 * Shaders that include EnvironmentMap::getGLSLInterface() receive the environment while the scene is drawn.
+	 */
+	void setEnvironment(std::shared_ptr<EnvironmentMap> environment);
+	std::shared_ptr<EnvironmentMap> getEnvironment();
+
+	const std::vector<std::shared_ptr<SceneNode<SceneObject>>> & getObjects();
+
 	/**
 	 * @brief Draws all objects of the scene with the given shader.
 	 * 
 	 * @param shader the shader to draw the scenes objects with
+	 * 
+	 * The camera and the lights are written once into the FrameUniformBuffer,
+	 * shaders receive them by including FrameUniformBuffer::getGLSLInterface().
 	 */
 	void draw(ShaderConfiguration * configuration, std::map<GLuint, FrameBuffer*> & map_shader_fbs);
 
+	/**
+	 * @brief Updates the per-frame state (frame uniforms, material table, environment) before objects are drawn.
+	 * 
+	 * Passes of a FrameGraph call this once and drawObjects() for every shader.
+	 */
+	void prepareDraw(ShaderConfiguration * configuration);
+
+	/**
+	 * @brief Draws the objects that use the given shader into the bound framebuffer.
+	 * 
+	 * @param shader_id the ID of the shader whose objects are drawn
+	 */
+	void drawObjects(ShaderConfiguration * configuration, GLuint shader_id);
+
+	/**
+	 * @brief Enables a depth pre-pass in draw().
+	 * 
+	 * @param depth_shader a registered shader that only transforms the positions (attribute 0) with 'model' and the
+	 * camera of the frame, or nullptr to disable the pre-pass
+	 * 
+	 * Opaque objects are drawn front to back into the depth buffer first and then shaded with GL_EQUAL and without
+	 * depth writes, so every visible fragment is shaded once. The vertex shaders of the shading shaders should declare
+	 * gl_Position as invariant, so their depths match the pre-pass exactly. FrameBuffers configured with
+	 * sample_depth_buffer keep the depth in a texture for later passes.
+	 */
+	void setDepthPrePass(Shader * depth_shader);
+
+	/**
+	 * @brief Draws the opaque objects of the given shaders into the depth buffer of the bound framebuffer.
+	 * 
+	 * Does nothing without a depth pre-pass shader. drawObjects() afterwards shades these objects with GL_EQUAL.
+	 */
+	void drawDepthPrePass(ShaderConfiguration * configuration, const std::vector<GLuint> & shader_ids);
+
 	/**
 	 * @brief Processes keyboard inputs for the scene.
 	 * 
@@ -108,4 +160,12 @@ private:
 	std::vector<std::shared_ptr<SceneNode<DirectionalLight>>> directionalLights;
 	std::vector<std::shared_ptr<Camera>> cameras;
 	std::shared_ptr<Camera> activeCamera;
+	std::shared_ptr<EnvironmentMap> environment;
+	// the values of the object that is drawn, reused for all objects
+	ShaderConfiguration object_configuration;
+	Shader * depth_pre_pass_shader = nullptr;
+	// the distances and indices of the objects in the pre-pass, reused every frame
+	std::vector<std::pair<float, size_t>> depth_pre_pass_order;
+
+	void setObjectConfiguration(size_t index);
 };
\ No newline at end of file
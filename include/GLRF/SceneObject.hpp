@@ -3,6 +3,8 @@
 #include <memory>
 #include <algorithm>
 #include <stdexcept>
+#include <cmath>
+#include <type_traits>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -10,9 +12,12 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <GLRF/VertexFormat.hpp>
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
 #include <GLRF/Material.hpp>
 #include <GLRF/IdManager.hpp>
 #include <GLRF/Shader.hpp>
+#include <GLRF/ShaderVariants.hpp>
 
 namespace GLRF {
 	template <typename T> class MeshData;
@@ -63,6 +68,29 @@ public:
 			}
 		}
 	}
+
+	/**
+	 * @brief Calculates how many uv units are mapped onto a single world unit of the surface.
+	 *
+	 * @return float the average uv density of all triangles, 0 if the mesh has no surface area
+	 *
+	 * Assumes that the data describes GL_TRIANGLES.
+	 */
+	float calculateUVDensity() const {
+		float world_area = 0.f;
+		float uv_area = 0.f;
+		size_t num_corners = this->indices.has_value() ? this->indices.value().size() : this->vertices.size();
+		for (size_t i = 0; i + 2 < num_corners; i += 3) {
+			const T & v0 = this->vertices[this->indices.has_value() ? this->indices.value()[i] : i];
+			const T & v1 = this->vertices[this->indices.has_value() ? this->indices.value()[i + 1] : i + 1];
+			const T & v2 = this->vertices[this->indices.has_value() ? this->indices.value()[i + 2] : i + 2];
+			world_area += 0.5f * glm::length(glm::cross(v1.position - v0.position, v2.position - v0.position));
+			glm::vec2 e1 = v1.uv - v0.uv;
+			glm::vec2 e2 = v2.uv - v0.uv;
+			uv_area += 0.5f * std::abs(e1.x * e2.y - e1.y * e2.x);
+		}
+		return (world_area > 0.f) ? std::sqrt(uv_area / world_area) : 0.f;
+	}
 private:
 };
 
@@ -94,10 +122,37 @@ public:
 		return this->ID;
 	}
 
+	/**
+	 * @brief Draws the object with the variant of its material instead of a single shader.
+	 * 
+	 * @param variants the variants to draw with, or nullptr to draw with the shader ID again
+	 * @param features the features of the variant besides the textures of the material (e.g. the lights)
+	 * 
+	 * The shader ID becomes the ID of the variant without texture features, the Scene groups the objects by it.
+	 */
+	void setShaderVariants(ShaderVariants * variants, ShaderFeatures features = 0)
+	{
+		this->shader_variants = variants;
+		this->shader_features = features;
+		if (variants) this->ID = variants->getVariant(features)->getID();
+	}
+
+	/**
+	 * @brief Returns the ID of the shader the object is drawn with, the variant of its material if variants are set.
+	 * 
+	 */
+	GLuint getDrawShaderID()
+	{
+		if (!this->shader_variants) return this->ID;
+		ShaderFeatures features = this->shader_features;
+		std::shared_ptr<Material> material = getMaterial();
+		if (material) features |= ShaderVariants::getMaterialFeatures(*material);
+		return this->shader_variants->getVariant(features)->getID();
+	}
 
 	void configureShader(ShaderConfiguration* scene_configuration, ShaderConfiguration* object_configuration)
 	{
-		GLuint shader_id = this->getShaderID();
+		GLuint shader_id = this->getDrawShaderID();
 		ShaderManager& shader_manager = ShaderManager::getInstance();
 		shader_manager.useShader(shader_id);
 		shader_manager.configureShader(scene_configuration, shader_id, false);
@@ -110,6 +165,28 @@ public:
 	 */
 	virtual void draw(ShaderConfiguration* scene_configuration, ShaderConfiguration* object_configuration) = 0;
 
+	/**
+	 * @brief Returns whether the object is opaque and drawGeometry() produces the same depth as draw().
+	 * 
+	 * Only these objects are drawn in a depth pre-pass, see Scene::setDepthPrePass.
+	 */
+	virtual bool supportsDepthPrePass() { return false; }
+
+	/**
+	 * @brief Draws only the geometry of the object with the shader in use, without configuring it.
+	 * 
+	 */
+	virtual void drawGeometry() {}
+
+	/**
+	 * @brief Appends the triangles of the object to shared vertex and index lists.
+	 * 
+	 * @return bool false if the object does not consist of triangles in the VertexFormat (the default)
+	 * 
+	 * The appended indices start at 0, they are relative to the first appended vertex.
+	 */
+	virtual bool appendTriangles(std::vector<VertexFormat> &, std::vector<GLuint> &) { return false; }
+
 	/**
 	 * @brief Returns the Material object.
 	 * 
@@ -124,9 +201,18 @@ public:
 	 */
 	virtual void setMaterial(std::shared_ptr<Material> material) { this->material = material; }
 
+	/**
+	 * @brief Returns how many uv units are mapped onto a single world unit of the surface.
+	 *
+	 * Used to estimate which mip levels of the material textures are needed. 0 disables streaming requests.
+	 */
+	virtual float getUVDensity() { return 0.f; }
+
 private:
 	std::shared_ptr<Material> material;
 	GLuint ID = 0;
+	ShaderVariants * shader_variants = nullptr;
+	ShaderFeatures shader_features = 0;
 	std::string debug_name = "MISSING_NAME";
 };
 
@@ -151,35 +237,42 @@ public:
 	SceneMesh(std::shared_ptr<MeshData<T>> data, GLenum draw_type, GLenum geometry_type = GL_TRIANGLES,
 		std::shared_ptr<Material> material = std::shared_ptr<Material>(new Material()))
 	{
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
+		VAO = GLResources::createVertexArray();
+		VBO = GLResources::createBuffer();
+		EBO = GLResources::createBuffer();
 
 		this->draw_type = draw_type;
 		this->geometry_type = geometry_type;
 		this->data = data;
 		setMaterial(material);
 
-		glBindVertexArray(VAO);
-
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(T) * this->data->vertices.size(), &this->data->vertices[0], draw_type);
-
+		GLResources::bufferData(VBO, sizeof(T) * this->data->vertices.size(), &this->data->vertices[0], draw_type);
 		if (this->data->indices.has_value()) {
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * this->data->indices.value().size(), &this->data->indices.value()[0], draw_type);
+			GLResources::bufferData(EBO, sizeof(GLuint) * this->data->indices.value().size(), &this->data->indices.value()[0], draw_type);
 		}
 
-		vertex_format_t::registerFormat();
+		// the buffers stay attached to the VAO, so updates never have to bind it
+		if (GLResources::usesDirectStateAccess()) {
+			glVertexArrayElementBuffer(VAO, EBO);
+			vertex_format_t::registerFormat(VAO, VBO);
+		} else {
+			GLStateCache & state = GLStateCache::getInstance();
+			state.bindVertexArray(VAO);
+			state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			vertex_format_t::registerFormat();
+			state.bindVertexArray(0);
+		}
 
-		glBindVertexArray(0);
+		this->uv_density = (geometry_type == GL_TRIANGLES) ? this->data->calculateUVDensity() : 0.f;
 	}
 
 	~SceneMesh()
 	{
-		glDeleteVertexArrays(1, &VAO);
-		glDeleteBuffers(1, &VBO);
-		glDeleteBuffers(1, &EBO);
+		GLStateCache & state = GLStateCache::getInstance();
+		state.deleteVertexArrays(1, &VAO);
+		state.deleteBuffers(1, &VBO);
+		state.deleteBuffers(1, &EBO);
 	}
 
 	/**
@@ -194,18 +287,14 @@ public:
 		this->draw_type = draw_type;
 		this->geometry_type = geometry_type;
 
-		glBindVertexArray(VAO);
-
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(T) * this->data->vertices.size(), NULL, draw_type);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(T) * this->data->vertices.size(), this->data->vertices.data(), draw_type);
+		GLResources::bufferData(VBO, sizeof(T) * this->data->vertices.size(), NULL, draw_type);
+		GLResources::bufferData(VBO, sizeof(T) * this->data->vertices.size(), this->data->vertices.data(), draw_type);
 
 		bool has_indices = data->indices.has_value();
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, has_indices ? sizeof(GLuint) * this->data->indices.value().size() : 0,
+		GLResources::bufferData(EBO, has_indices ? sizeof(GLuint) * this->data->indices.value().size() : 0,
 			has_indices ? &this->data->indices.value()[0] : NULL, draw_type);
 
-		glBindVertexArray(0);
+		this->uv_density = (geometry_type == GL_TRIANGLES) ? this->data->calculateUVDensity() : 0.f;
 	}
 
 	/**
@@ -218,6 +307,10 @@ public:
 		SceneMesh::update(data, this->draw_type, this->geometry_type);
 	}
 
+	float getUVDensity() override {
+		return this->uv_density;
+	}
+
 	/**
 	 * @brief Draws the mesh with the current shader.
 	 * 
@@ -226,22 +319,53 @@ public:
 	{
 		object_configuration->setMaterial("material", getMaterial());
 		configureShader(scene_configuration, object_configuration);
+		if (this->geometry_type == GL_PATCHES) GLStateCache::getInstance().setPatchVertices(scene_configuration->getPatchVertices());
+		drawGeometry();
+	}
 
-		glBindVertexArray(VAO);
+	/**
+	 * @brief Returns true for opaque meshes that are not tessellated, since tessellation may move the vertices.
+	 * 
+	 */
+	bool supportsDepthPrePass() override
+	{
+		std::shared_ptr<Material> material = getMaterial();
+		const bool opaque = !material || (material->opacity.value_default >= 1.f && !material->opacity.texture.has_value());
+		return opaque && this->geometry_type != GL_PATCHES;
+	}
+
+	bool appendTriangles(std::vector<VertexFormat> & vertices, std::vector<GLuint> & indices) override
+	{
+		if constexpr (std::is_same<T, VertexFormat>::value) {
+			if (this->geometry_type != GL_TRIANGLES) return false;
+			vertices.insert(vertices.end(), this->data->vertices.begin(), this->data->vertices.end());
+			if (this->data->indices.has_value()) {
+				indices.insert(indices.end(), this->data->indices.value().begin(), this->data->indices.value().end());
+			} else {
+				for (GLuint i = 0; i < this->data->vertices.size(); ++i) indices.push_back(i);
+			}
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	void drawGeometry() override
+	{
+		// the VAO stays bound, the next draw only rebinds it if it draws another mesh
+		GLStateCache & state = GLStateCache::getInstance();
+		state.bindVertexArray(VAO);
 
 		switch (this->geometry_type)
 		{
 		case GL_POINTS:
-			glPointSize(8.f);
+			state.setPointSize(8.f);
 			break;
 		case GL_LINES:
 		case GL_LINE_STRIP:
 		case GL_LINES_ADJACENCY:
 		case GL_LINE_STRIP_ADJACENCY:
-			glLineWidth(3.f);
-			break;
-		case GL_PATCHES:
-			glPatchParameteri(GL_PATCH_VERTICES, scene_configuration->getPatchVertices());
+			state.setLineWidth(3.f);
 			break;
 		default:
 			break;
@@ -253,8 +377,6 @@ public:
 		else {
 			glDrawArrays(this->geometry_type, 0, static_cast<GLsizei>(data->vertices.size()));
 		}
-
-		glBindVertexArray(0);
 	}
 
 private:
@@ -262,6 +384,7 @@ private:
 	GLenum draw_type;
 	GLenum geometry_type;
 	std::shared_ptr<MeshData<T>> data;
+	float uv_density = 0.f;
 };
 
 /**
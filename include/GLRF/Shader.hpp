@@ -6,13 +6,17 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+#include <GLRF/Hash.hpp>
 #include <GLRF/Material.hpp>
+#include <GLRF/MaterialTable.hpp>
 #include <GLRF/FrameBuffer.hpp>
+#include <GLRF/ShaderPreprocessor.hpp>
 
 namespace GLRF {
 	/**
@@ -24,54 +28,166 @@ namespace GLRF {
 		PBR,		// 内置PBR材质
 		Total	
 	};
+	/**
+	 * @brief Whether a Shader waits for the driver to compile and link it.
+	 */
+	enum class ShaderCompileMode {
+		SYNCHRONOUS,	// the constructor returns a linked program
+		ASYNCHRONOUS	// the constructor only issues the compilation, see Shader::isReady
+	};
 	struct ShaderOptions;
+	struct UniformLocation;
+	struct UniformName;
+	struct UniformUploadStats;
 	class ShaderConfiguration;
 	class Shader;
 	class ShaderManager;
 }
 
+/**
+ * @brief A pre-resolved location of a uniform inside a Shader, see Shader::getUniformLocation.
+ *
+ * Values set at an invalid location are ignored, like OpenGL does for the location -1.
+ */
+struct GLRF::UniformLocation {
+	GLint value = -1;
+
+	bool isValid() const {
+		return this->value >= 0;
+	}
+};
+
+/**
+ * @brief Counts the uniform values a Shader was asked to set since the last reset.
+ *
+ */
+struct GLRF::UniformUploadStats {
+	// values that differed from the current value of the program and were uploaded
+	size_t uploads = 0;
+	// values that were equal to the current value and skipped
+	size_t skipped = 0;
+};
+
+/**
+ * @brief The name of a uniform, interned to its 64 bit FNV-1a hash.
+ *
+ * Literal names are hashed at compile time with the _uniform suffix (e.g. "model"_uniform),
+ * names that are built at runtime (e.g. array elements) are hashed when they are converted.
+ */
+struct GLRF::UniformName {
+	std::uint64_t hash;
+
+	constexpr explicit UniformName(std::uint64_t hash) : hash(hash) { }
+	constexpr UniformName(const char * name, size_t length) : hash(fnv1a64Bytes(name, length)) { }
+	UniformName(const char * name) : hash(fnv1a64Bytes(name, std::char_traits<char>::length(name))) { }
+	UniformName(const std::string & name) : hash(fnv1a64(name)) { }
+
+	/**
+	 * @brief Returns the name of an element of this array (e.g. 'pointLight_color[2]') without building the string.
+	 *
+	 */
+	UniformName element(unsigned int index) const {
+		char digits[16];
+		int count = 0;
+		do {
+			digits[count++] = static_cast<char>('0' + index % 10);
+			index /= 10;
+		} while (index > 0);
+		char text[18];
+		int length = 0;
+		text[length++] = '[';
+		while (count > 0) text[length++] = digits[--count];
+		text[length++] = ']';
+		return UniformName(fnv1a64Bytes(text, static_cast<size_t>(length), this->hash));
+	}
+};
+
+namespace GLRF {
+	constexpr UniformName operator""_uniform(const char * name, size_t length) {
+		return UniformName(name, length);
+	}
+}
+
+/**
+ * @brief A flat block of uniform values that is loaded into a Shader.
+ *
+ * Every value is stored with its hashed name and type in a single list, the components of all values are
+ * stored contiguously. The locations of the uniforms are resolved once for the Shader the block is loaded into,
+ * as long as the block is loaded into the same Shader, it is uploaded in a single pass over the values.
+ * Clearing a block keeps its memory, so a block that is refilled every frame does not allocate.
+ */
 class GLRF::ShaderConfiguration {
 public:
 	ShaderConfiguration();
 	~ShaderConfiguration();
 
+	/**
+	 * @brief Sets all values of this block in the specified shader, which has to be in use.
+	 *
+	 * @param shader the shader the block is bound to
+	 */
 	void loadIntoShader(Shader * shader) const;
 
-	void setBool(const std::string& name, bool value);
-	void setInt(const std::string& name, GLint value);
-	void setUInt(const std::string& name, GLuint value);
-	void setFloat(const std::string& name, float value);
-	void setMat4(const std::string& name, glm::mat4 value);
-	void setMat3(const std::string& name, glm::mat3 value);
-	void setVec4(const std::string& name, glm::vec4 value);
-	void setVec3(const std::string& name, glm::vec3 value);
-	void setVec2(const std::string& name, glm::vec2 value);
+	/**
+	 * @brief Removes all values, the memory of the block is kept for the next values.
+	 *
+	 */
+	void clear();
+
+	void setBool(UniformName name, bool value);
+	void setInt(UniformName name, GLint value);
+	void setUInt(UniformName name, GLuint value);
+	void setFloat(UniformName name, float value);
+	void setMat4(UniformName name, const glm::mat4 & value);
+	void setMat3(UniformName name, const glm::mat3 & value);
+	void setVec4(UniformName name, const glm::vec4 & value);
+	void setVec3(UniformName name, const glm::vec3 & value);
+	void setVec2(UniformName name, const glm::vec2 & value);
 	void setMaterial(const std::string& name, std::shared_ptr<Material> material);
 	void setPatchVertices(GLint patchVertices);
 
-	bool getBool(const std::string& name);
-	GLint getInt(const std::string& name);
-	GLuint getUInt(const std::string& name);
-	float getFloat(const std::string& name);
-	glm::mat4 getMat4(const std::string& name);
-	glm::mat3 getMat3(const std::string& name);
-	glm::vec4 getVec4(const std::string& name);
-	glm::vec3 getVec3(const std::string& name);
-	glm::vec2 getVec2(const std::string& name);
+	bool getBool(UniformName name);
+	GLint getInt(UniformName name);
+	GLuint getUInt(UniformName name);
+	float getFloat(UniformName name);
+	glm::mat4 getMat4(UniformName name);
+	glm::mat3 getMat3(UniformName name);
+	glm::vec4 getVec4(UniformName name);
+	glm::vec3 getVec3(UniformName name);
+	glm::vec2 getVec2(UniformName name);
 	std::shared_ptr<Material> getMaterial(const std::string& name);
 	GLint getPatchVertices();
 private:
-	std::map<std::string, bool>			v_bool;
-	std::map<std::string, int>			v_int;
-	std::map<std::string, unsigned int> v_uint;
-	std::map<std::string, float>		v_float;
-	std::map<std::string, glm::mat4>	v_mat4;
-	std::map<std::string, glm::mat3>	v_mat3;
-	std::map<std::string, glm::vec4>	v_vec4;
-	std::map<std::string, glm::vec3>	v_vec3;
-	std::map<std::string, glm::vec2>	v_vec2;
-	std::map<std::string, std::shared_ptr<Material>> v_material;
-	GLint v_patchVertices;
+	enum class ValueType : std::uint32_t {
+		Bool, Int, UInt, Float, Mat4, Mat3, Vec4, Vec3, Vec2
+	};
+
+	struct Value {
+		std::uint64_t hash;
+		ValueType type;
+		// the index of the first component in 'components'
+		std::uint32_t offset;
+	};
+
+	struct MaterialValue {
+		std::string name;
+		std::shared_ptr<Material> material;
+	};
+
+	std::vector<Value> values;
+	std::vector<float> components;
+	std::vector<MaterialValue> materials;
+	GLint v_patchVertices = 0;
+
+	// the locations of 'values' in the shader the block was loaded into last
+	mutable const Shader * bound_shader = nullptr;
+	mutable std::vector<GLint> bound_locations;
+
+	template <typename T>
+	void setValue(UniformName name, ValueType type, const T & value);
+
+	template <typename T>
+	T getValue(UniformName name, ValueType type, T fallback);
 };
 
 /**
@@ -90,16 +206,57 @@ public:
 	 * @param geometry_path the relative path to the GLSL geometry shader
 	 * @param fragment_path the relative path to the GLSL fragment shader
 	 * @param shader_options the options that modify the behaviour of the shader
+	 * @param compile_mode whether the constructor waits until the program is linked
+	 * @param defines the macros that are defined in all stages (e.g. 'GLRF_ALBEDO_TEXTURE' or 'MAX_LIGHTS 4')
 	 * 
 	 * Creates a new Shader from the specified library path and sub-paths to the vertex and fragment shader files.
 	 * Takes shader options as input to configure itself.
+	 * The sources are processed by a ShaderPreprocessor that searches includes in the shader library and provides
+	 * the GLSL interfaces of the framework as 'glrf/frame_uniforms.glsl', 'glrf/lighting.glsl', 'glrf/material_table.glsl',
+	 * 'glrf/environment.glsl', 'glrf/gbuffer.glsl' and 'glrf/material.glsl'.
+	 * The rendering mode is defined as GLRF_RENDERING_MODE_NONE, GLRF_RENDERING_MODE_PHONG or GLRF_RENDERING_MODE_PBR.
+	 * Synchronous shaders throw a std::runtime_error if a stage does not compile or the program does not link,
+	 * asynchronous shaders throw it from isReady() or finish().
 	 */
 	Shader(const std::string shader_lib, const std::string vertex_path,
 		std::optional<const std::string> tessellation_control_path,
 		std::optional<const std::string> tessellation_evaluation_path,
 		std::optional<const std::string> geometry_path,
 		const std::string fragment_path,
-		enum ShaderRenderingMode mode = ShaderRenderingMode::PBR);
+		enum ShaderRenderingMode mode = ShaderRenderingMode::PBR,
+		ShaderCompileMode compile_mode = ShaderCompileMode::SYNCHRONOUS,
+		const std::vector<std::string> & defines = {});
+
+	/**
+	 * @brief Unregisters the shader from the ShaderManager and deletes its program.
+	 * 
+	 */
+	~Shader();
+
+	/**
+	 * @brief Continues the hash of the sources of a program (the key of the ProgramBinaryCache) with one stage.
+	 * 
+	 * @param stage the name of the stage, it is hashed before the source so identical sources in other stages differ
+	 * @param source the preprocessed source of the stage
+	 * @param hash the hash of the previous stages
+	 */
+	static std::uint64_t hashStageSource(const std::string & stage, const std::string & source, std::uint64_t hash = FNV_OFFSET_BASIS_64);
+
+	/**
+	 * @brief Returns whether the program is linked and can be used, without waiting for the driver.
+	 * 
+	 * With GL_KHR_parallel_shader_compile the driver compiles in the background and this only polls
+	 * GL_COMPLETION_STATUS. Without the extension the first call waits for the driver.
+	 * Throws a std::runtime_error if the compilation failed.
+	 */
+	bool isReady();
+
+	/**
+	 * @brief Waits until the program is linked.
+	 * 
+	 * Throws a std::runtime_error if the compilation failed.
+	 */
+	void finish();
 
 	/**
 	 * @brief Returns the shader-program identifier.
@@ -107,6 +264,17 @@ public:
 	 */
 	unsigned int getID();
 
+	/**
+	 * @brief Returns the location of the specified, named uniform in this Shader.
+	 *
+	 * @param name the name of the uniform (e.g. 'material.albedo.texture' or 'pointLight_position[2]')
+	 * @return UniformLocation the location, invalid if the shader has no active uniform with this name
+	 *
+	 * All active uniforms are queried once after linking, so this is a hash table lookup without any OpenGL call.
+	 * Resolve locations once and pass them to the setters instead of names in code that runs every frame.
+	 */
+	UniformLocation getUniformLocation(UniformName name) const;
+
 	// === utility uniform functions ===
 
 	/**
@@ -189,71 +357,143 @@ public:
 	 */
 	void setMaterial(const std::string &name, std::shared_ptr<Material> material);
 
+	/**
+	 * @brief Sets whether materials are read from the MaterialTable.
+	 *
+	 * @param use_material_table true if the shader includes MaterialTable::getGLSLInterface()
+	 *
+	 * If enabled, setMaterial only sets '<name>.index' and '<name>.use_table', the shader reads the textures and values
+	 * of the material from the table. Materials that can not be represented by the table fall back to bound textures
+	 * and material uniforms with '<name>.use_table' set to false.
+	 */
+	void setUseMaterialTable(bool use_material_table);
+
+	// === uniform functions with pre-resolved locations ===
+
+	void setBool(UniformLocation location, bool value) const;
+	void setInt(UniformLocation location, GLint value) const;
+	void setUInt(UniformLocation location, GLuint value) const;
+	void setFloat(UniformLocation location, float value) const;
+	void setMat4(UniformLocation location, const glm::mat4 & value) const;
+	void setMat3(UniformLocation location, const glm::mat3 & value) const;
+	void setVec4(UniformLocation location, const glm::vec4 & value) const;
+	void setVec3(UniformLocation location, const glm::vec3 & value) const;
+	void setVec2(UniformLocation location, const glm::vec2 & value) const;
+
+	/**
+	 * @brief Returns how many uniform values were uploaded and skipped.
+	 * 
+	 * Every uniform keeps a CPU-side copy of its current value, values that equal it are not uploaded again.
+	 */
+	UniformUploadStats getUploadStats() const;
+	void resetUploadStats();
+
 	void setDebugName(const std::string name);
 	std::string getDebugName();
 
 private:
+	// uploads its values through the shadow of the uniforms
+	friend class ShaderConfiguration;
+
+	// the shader owns its program and is registered by its address
+	Shader(const Shader&);
+	Shader& operator = (const Shader&);
+
 	static const char period = '.';
 	const std::string value_default = "value_default";
 	const std::string use_texture = "use_texture";
 	const std::string texture = "texture";
 	ShaderRenderingMode shader_render_mode;
+	bool use_material_table = false;
 	GLuint ID;
 	std::string debug_name;
-
-	unsigned int createShader(GLenum shader_type, const GLchar* shader_source, std::string shader_name);
+	bool ready = false;
+	std::uint64_t source_hash = 0;
+	// the compiled stages (and their names) until the program is linked
+	std::vector<std::pair<GLuint, std::string>> pending_stages;
 
 	/**
-	 * @brief Sets the specified material property for the specified, named variable in this Shader.
-	 *
-	 * @param name the name of the material property that will be set
-	 * @param material_property the new material property for the variable
+	 * @brief The locations of the uniforms of a single material property.
 	 *
-	 * The 4-dimensional property will be set directly.
 	 */
-	void setMaterialProperty(const std::string& name, MaterialProperty<glm::vec4> material_property, GLuint texture_unit);
+	struct MaterialPropertyLocations {
+		UniformLocation value_default;
+		UniformLocation use_texture;
+		UniformLocation texture;
+	};
 
 	/**
-	 * @brief Sets the specified material property for the specified, named variable in this Shader.
+	 * @brief The locations of all uniforms of a material, resolved once per material name.
 	 *
-	 * @param name the name of the material property that will be set
-	 * @param material_property the new material property for the variable
-	 *
-	 * The 3-dimensional property will be set as 4-dimensional with an additional value of 1 at the end.
 	 */
-	void setMaterialProperty(const std::string& name, MaterialProperty<glm::vec3> material_property, GLuint texture_unit);
+	struct MaterialLocations {
+		MaterialPropertyLocations albedo, normal, roughness, metallic, ao, height, opacity;
+		UniformLocation height_scale;
+		UniformLocation use_table;
+		UniformLocation index;
+	};
+
+	// the current value of a uniform in the program, indexed by its location
+	struct UniformShadow {
+		bool valid = false;
+		std::uint32_t size = 0;
+		float data[16];
+	};
+
+	// keyed by the hash of the name, see UniformName
+	std::unordered_map<std::uint64_t, GLint> uniform_locations;
+	mutable std::vector<UniformShadow> uniform_shadows;
+	mutable UniformUploadStats upload_stats;
+	std::unordered_map<std::string, MaterialLocations> material_locations;
 
 	/**
-	 * @brief Sets the specified material property for the specified, named variable in this Shader.
+	 * @brief Queries the names and locations of all active uniforms of the linked program.
 	 *
-	 * @param name the name of the material property that will be set
-	 * @param material_property the new material property for the variable
+	 * Arrays of basic types are registered with their name, the name of the first element and every element.
+	 */
+	void introspectUniforms();
+
+	/**
+	 * @brief Compares a value with the shadow of the uniform and updates the shadow.
 	 *
-	 * The 2-dimensional property will be set as 4-dimensional with two additional values of 1 at the end.
+	 * @return true if the value differs and has to be uploaded
 	 */
-	void setMaterialProperty(const std::string& name, MaterialProperty<glm::vec2> material_property, GLuint texture_unit);
+	bool updateShadow(GLint location, const void * value, size_t size) const;
+	const MaterialLocations & getMaterialLocations(const std::string & name);
+	MaterialPropertyLocations getMaterialPropertyLocations(const std::string & name) const;
+
+	unsigned int createShader(GLenum shader_type, const GLchar* shader_source);
 
 	/**
-	 * @brief Sets the specified material property for the specified, named variable in this Shader.
+	 * @brief Checks the results of the compilation and prepares the linked program for use.
+	 * 
+	 */
+	void completeLinking();
+
+	/**
+	 * @brief Sets the specified material property at the resolved locations.
 	 *
-	 * @param name the name of the material property that will be set
+	 * @param locations the locations of the uniforms of the material property
 	 * @param material_property the new material property for the variable
+	 * @param texture_unit the texture unit the texture of the property is bound to
 	 *
-	 * The 1-dimensional property will be copied to a 3-dimensional value and set as 4-dimensional
-	 * with an additional value of 1 at the end.
+	 * Properties with fewer than 4 dimensions are set with the type of the uniform in the shader.
 	 */
-	void setMaterialProperty(const std::string& name, MaterialProperty<float> material_property, GLuint texture_unit);
+	void setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec4> & material_property, GLuint texture_unit);
+	void setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec3> & material_property, GLuint texture_unit);
+	void setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec2> & material_property, GLuint texture_unit);
+	void setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<float> & material_property, GLuint texture_unit);
 
 	/**
 	 * @brief Sets common aspects of material properties.
 	 */
 	template <typename T>
-	void setMaterialPropertyCommons(const std::string& name, MaterialProperty<T> material_property, GLuint texture_unit) {
-		setBool(name + period + use_texture, material_property.texture.has_value());
-		setInt(name + period + texture, texture_unit);
+	void setMaterialPropertyCommons(const MaterialPropertyLocations & locations, const MaterialProperty<T> & material_property, GLuint texture_unit) {
+		setBool(locations.use_texture, material_property.texture.has_value());
+		setInt(locations.texture, texture_unit);
 	}
 
-	void loadShaderFile(const std::string shader_path, std::string * out);
+	void loadShaderFile(ShaderPreprocessor & preprocessor, const std::string shader_path, std::string * out);
 };
 
 class GLRF::ShaderManager
@@ -268,17 +508,45 @@ public:
 
 	void registerShader(Shader * shader);
 
+	/**
+	 * @brief Removes a shader that is deleted, it is no longer used as fallback shader either.
+	 * 
+	 */
+	void unregisterShader(Shader * shader);
+
 	void useShader(GLuint ID);
 
 	void configureShader(const ShaderConfiguration * configuration, GLuint ID, bool force);
 
+	/**
+	 * @brief Sets the shader that is used in place of asynchronous shaders that are not linked yet.
+	 * 
+	 * @param shader a cheap, synchronously compiled shader, or nullptr to wait for unfinished shaders instead
+	 */
+	void setFallbackShader(Shader * shader);
+
+	/**
+	 * @brief Returns the shader that is used when the specified shader is requested.
+	 * 
+	 * @param ID the identifier of a registered shader
+	 * @return Shader* the shader itself if it is linked, otherwise the fallback shader
+	 */
+	Shader * resolveShader(GLuint ID);
+
+	/**
+	 * @brief Returns the sum of the upload counters of all registered shaders, see Shader::getUploadStats.
+	 * 
+	 */
+	UniformUploadStats getUploadStats();
+	void resetUploadStats();
+
 	void clearDrawConfigurations();
 
 	Shader * getShader(GLuint ID);
 private:
 	std::map<GLuint, Shader *> registered_shaders;
 	std::set<GLuint> configured_shaders;
-	GLuint activeShaderID = 0;
+	Shader * fallback_shader = nullptr;
 
 	ShaderManager();
 	ShaderManager(const ShaderManager&);
@@ -0,0 +1,84 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace GLRF {
+	class ShaderPreprocessor;
+}
+
+/**
+ * @brief Resolves #include directives in GLSL sources and injects #define directives.
+ *
+ * Includes are written as '#include "file"' or '#include <file>' and are searched among the virtual files,
+ * next to the including file and in the include directories, in this order. Every file is included at most once,
+ * so headers need no include guards and cyclic includes end. #line directives keep the line numbers of
+ * compile errors, their source string number is the index of the file in getIncludedFiles().
+ * The defines are placed directly after the #version directive.
+ */
+class GLRF::ShaderPreprocessor
+{
+public:
+	ShaderPreprocessor();
+	~ShaderPreprocessor();
+
+	/**
+	 * @brief Adds a directory that is searched for included files.
+	 *
+	 */
+	void addIncludeDirectory(const fs::path & directory);
+
+	/**
+	 * @brief Adds a file that only exists in memory, e.g. a generated GLSL interface.
+	 *
+	 * @param name the name that is used in the #include directive (e.g. 'glrf/frame_uniforms.glsl')
+	 * @param source the content of the file
+	 */
+	void addVirtualFile(const std::string & name, const std::string & source);
+
+	/**
+	 * @brief Defines a macro in all processed sources.
+	 *
+	 * @param name the name of the macro
+	 * @param value the optional value of the macro
+	 */
+	void setDefine(const std::string & name, const std::string & value = "");
+
+	/**
+	 * @brief Reads a GLSL file and resolves its includes.
+	 *
+	 * @param path the path to the file
+	 * @return std::string the processed source
+	 *
+	 * Throws a std::runtime_error if the file or one of its includes can not be read.
+	 */
+	std::string process(const fs::path & path);
+
+	/**
+	 * @brief Resolves the includes of a GLSL source.
+	 *
+	 * @param source the source
+	 * @param directory the directory that relative includes are searched in first
+	 * @return std::string the processed source
+	 *
+	 * Throws a std::runtime_error if one of the includes can not be read.
+	 */
+	std::string processSource(const std::string & source, const fs::path & directory);
+
+	/**
+	 * @brief Returns the names of all files of the last processed source, starting with the source itself.
+	 *
+	 */
+	const std::vector<std::string> & getIncludedFiles();
+private:
+	std::vector<fs::path> include_directories;
+	std::map<std::string, std::string> virtual_files;
+	std::vector<std::pair<std::string, std::string>> defines;
+	std::vector<std::string> included_files;
+
+	void processFile(const std::string & source, const fs::path & directory, bool is_root, std::string & out);
+	bool findInclude(const std::string & name, const fs::path & directory, std::string & key, std::string & source);
+};
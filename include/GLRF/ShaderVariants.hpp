@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GLRF/Material.hpp>
+#include <GLRF/Shader.hpp>
+
+namespace GLRF {
+	/**
+	 * @brief The features that a specialized shader variant is compiled for.
+	 *
+	 * Every feature is defined as 'GLRF_<NAME>' in the variant, so the GLSL code can use #ifdef instead of
+	 * branching on uniforms (e.g. '#ifdef GLRF_ALBEDO_TEXTURE' instead of 'if (material.albedo.use_texture)').
+	 */
+	enum ShaderFeature : std::uint32_t {
+		SHADER_FEATURE_ALBEDO_TEXTURE		= 1u << 0,
+		SHADER_FEATURE_NORMAL_TEXTURE		= 1u << 1,
+		SHADER_FEATURE_ROUGHNESS_TEXTURE	= 1u << 2,
+		SHADER_FEATURE_METALLIC_TEXTURE		= 1u << 3,
+		SHADER_FEATURE_AO_TEXTURE			= 1u << 4,
+		SHADER_FEATURE_HEIGHT_TEXTURE		= 1u << 5,
+		SHADER_FEATURE_OPACITY_TEXTURE		= 1u << 6,
+		SHADER_FEATURE_POINT_LIGHTS			= 1u << 7,
+		SHADER_FEATURE_DIRECTIONAL_LIGHT	= 1u << 8,
+		SHADER_FEATURE_TESSELLATION			= 1u << 9,
+		SHADER_FEATURE_INSTANCING			= 1u << 10
+	};
+	typedef std::uint32_t ShaderFeatures;
+
+	class ShaderVariants;
+}
+
+/**
+ * @brief Lazily compiles one specialized Shader per combination of features from the same sources.
+ *
+ * A variant is compiled the first time it is requested, so only the combinations that are actually drawn
+ * are compiled. Together with the ProgramBinaryCache later runs load them without compiling.
+ * SceneObject::setShaderVariants() lets the Scene draw every object with the variant of its material.
+ */
+class GLRF::ShaderVariants
+{
+public:
+	/**
+	 * @brief Construct a new ShaderVariants object, no variant is compiled yet.
+	 *
+	 * @param tessellation_control_path the tessellation control shader, only used by variants with SHADER_FEATURE_TESSELLATION
+	 * @param tessellation_evaluation_path the tessellation evaluation shader, only used by variants with SHADER_FEATURE_TESSELLATION
+	 *
+	 * The other parameters are passed to every Shader, see Shader::Shader.
+	 */
+	ShaderVariants(const std::string shader_lib, const std::string vertex_path,
+		std::optional<const std::string> tessellation_control_path,
+		std::optional<const std::string> tessellation_evaluation_path,
+		std::optional<const std::string> geometry_path,
+		const std::string fragment_path,
+		ShaderRenderingMode mode = ShaderRenderingMode::PBR,
+		ShaderCompileMode compile_mode = ShaderCompileMode::SYNCHRONOUS);
+	~ShaderVariants();
+
+	/**
+	 * @brief Returns the variant for the specified features, compiling it on first use.
+	 *
+	 * @param features a combination of ShaderFeature flags
+	 *
+	 * Throws a std::runtime_error if the variant does not compile.
+	 */
+	Shader * getVariant(ShaderFeatures features);
+
+	/**
+	 * @brief Returns the number of variants that were compiled so far.
+	 *
+	 */
+	size_t getVariantCount();
+
+	/**
+	 * @brief Returns the defines of the specified features.
+	 *
+	 */
+	static std::vector<std::string> getDefines(ShaderFeatures features);
+
+	/**
+	 * @brief Returns the texture features of a material, i.e. a flag for every property that uses a texture.
+	 *
+	 */
+	static ShaderFeatures getMaterialFeatures(const Material & material);
+
+	/**
+	 * @brief Returns the GLSL code of the 'material' uniform with one accessor per property.
+	 *
+	 * The accessors sample the texture only if the feature of the property is defined (e.g. GLRF_ALBEDO_TEXTURE)
+	 * and return the default value otherwise, so a variant contains no branch on 'use_texture'.
+	 * Shaders include it as 'glrf/material.glsl'.
+	 */
+	static std::string getGLSLInterface();
+private:
+	std::string shader_lib;
+	std::string vertex_path;
+	std::optional<std::string> tessellation_control_path;
+	std::optional<std::string> tessellation_evaluation_path;
+	std::optional<std::string> geometry_path;
+	std::string fragment_path;
+	ShaderRenderingMode mode;
+	ShaderCompileMode compile_mode;
+	std::unordered_map<ShaderFeatures, std::unique_ptr<Shader>> variants;
+
+	ShaderVariants(const ShaderVariants&);
+	ShaderVariants& operator = (const ShaderVariants&);
+};
@@ -3,70 +3,220 @@
 #include <string>
 #include <iostream>
 
+#include <memory>
+
+#include <GLRF/ImageData.hpp>
+#include <GLRF/MipGenerator.hpp>
+#include <GLRF/Sampler.hpp>
+
 namespace GLRF {
 	static std::string defaultLibrary = "./textures/";
 	static std::string defaultRelativePath = "missingTexture.png";
 
+	struct TextureConfiguration;
 	class Texture;
+	class AssetArchive;
 }
 
+/**
+ * @brief Options that control how an image is stored and sampled.
+ *
+ */
+struct GLRF::TextureConfiguration
+{
+	/**
+	 * @brief Whether the color channels of the image are stored in sRGB space (e.g. albedo maps).
+	 *
+	 */
+	bool srgb = false;
+
+	/**
+	 * @brief Whether only the coarse mip tail is loaded at first and finer levels are streamed in on demand.
+	 *
+	 * @see TextureStreamer
+	 */
+	bool streamed = false;
+
+	/**
+	 * @brief Whether the image is decoded and filtered on the ThreadPool instead of the calling thread.
+	 *
+	 * The texture is uploaded by TextureStreamer::update once the job has finished
+	 * and is not loaded successfully until then.
+	 */
+	bool async = false;
+	MipConfiguration mips;
+	SamplerConfiguration sampler;
+};
+
 /**
  * @brief An image that can be bound to an OpenGL texture unit.
- * 
+ *
+ * The internal format is chosen from the source image (R8, RG8, RGBA8, SRGB8_ALPHA8, R16, RG16, RGBA16, RGBA16F)
+ * and the storage is immutable with a complete mip chain, which is filtered on the CPU (see MipGenerator).
+ * Sampling state is not stored per texture, but shared through the SamplerManager.
  */
 class GLRF::Texture {
 public:
 	/**
 	 * @brief Construct a new Texture object.
-	 * 
+	 *
 	 * @param library the relative path to multiple textures
 	 * @param relativePath the relative path to a single texture inside the library
-	 * 
+	 * @param config the storage and sampling options
+	 *
 	 * Loads a texture from the specified library path and following relative path.
 	 */
-	Texture(std::string library, std::string relativePath);
+	Texture(std::string library, std::string relativePath, TextureConfiguration config = TextureConfiguration());
 
 	/**
 	 * @brief Construct a new Texture object.
-	 * 
+	 *
 	 * @param relativePath the relative path to a single texture inside the library
-	 * 
+	 * @param config the storage and sampling options
+	 *
 	 * Loads a texture from the default library path and following relative path.
 	 */
-	Texture(std::string relativePath);
+	Texture(std::string relativePath, TextureConfiguration config = TextureConfiguration());
 
 	/**
 	 * @brief Construct a new Texture object.
-	 * 
+	 *
 	 * Loads a default texture.
 	 */
 	Texture();
 
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture & operator = (const Texture&) = delete;
+
 	/**
 	 * @brief Loads a texture from a previously specified path.
-	 * 
+	 *
 	 */
 	void load();
 
+	/**
+	 * @brief Uploads the result of a load and marks the texture as loaded.
+	 *
+	 * @param image the complete mip chain, or an empty image if the load failed
+	 */
+	void finishLoad(const ImageData & image);
+
+	/**
+	 * @brief Reads the complete mip chain of an image, may be called from worker threads.
+	 *
+	 * @param path the path to the source file
+	 * @param name the name of the baked entry inside the archive
+	 * @param archive the archive that contains the baked image, or nullptr
+	 * @param config the options of the texture
+	 * @return ImageData the mip chain, empty if the image could not be loaded
+	 *
+	 * Baked images are returned as they are, source files are decoded and filtered with the MipGenerator
+	 * unless the ImageCache contains their mip chain already.
+	 */
+	static ImageData readImage(const std::string & path, const std::string & name, std::shared_ptr<AssetArchive> archive, const TextureConfiguration & config);
+
+	/**
+	 * @brief Replaces the storage of the texture with the given image.
+	 *
+	 * @param image the decoded image
+	 * @param first_level the finest mip level that will be allocated and uploaded
+	 *
+	 * Missing mip levels are generated on the GPU, or on the CPU if the base level is not uploaded.
+	 * Images loaded through load() always contain the complete chain.
+	 */
+	void upload(const ImageData & image, GLuint first_level = 0);
+
+	/**
+	 * @brief Moves the texture into new storage that starts at the specified mip level.
+	 *
+	 * @param storage_level the finest mip level that the new storage can hold
+	 *
+	 * Levels that are resident in both the old and the new storage are copied on the GPU.
+	 * Used by the TextureStreamer to grow the storage before streaming and to shrink it on eviction.
+	 */
+	void reallocateStorage(GLuint storage_level);
+
+	/**
+	 * @brief Replaces the storage of the texture with a view of a layer of an array texture.
+	 *
+	 * @param array a GL_TEXTURE_2D_ARRAY with the size, format and levels of the texture
+	 * @param layer the layer that holds the texels of the texture
+	 *
+	 * Used by the MaterialTable, so textures that it copied into its arrays are not stored twice.
+	 */
+	void useArrayLayer(GLuint array, GLuint layer);
+
+	/**
+	 * @brief Uploads the next finer mip level and makes it available for sampling.
+	 *
+	 * @param level the mip level, must be one finer than the current resident level
+	 * @param chain the complete mip chain of the image
+	 */
+	void uploadLevel(GLuint level, const ImageData & chain);
+
 	/**
 	 * @brief Binds the current texture to an OpenGL texture unit.
-	 * 
+	 *
 	 * @param textureUnit the texture unit to bind the texture to
 	 */
 	void bind(GLenum textureUnit);
 
 	/**
 	 * @brief Returns whether the texture was loaded into memory successfully.
-	 * 
+	 *
 	 * @return true if the texture was loaded successfully
 	 * @return false else
 	 */
 	bool isSuccessfullyLoaded();
+
+	GLuint getID();
+	GLuint getSampler();
+	GLsizei getWidth();
+	GLsizei getHeight();
+	GLuint getLevelCount();
+	const TextureFormat & getFormat();
+	const TextureConfiguration & getConfiguration();
+	std::string getPath();
+	std::string getRelativePath();
+
+	/**
+	 * @brief Returns the finest mip level that can currently be sampled.
+	 *
+	 */
+	GLuint getResidentLevel();
+
+	/**
+	 * @brief Returns the finest mip level that the current storage can hold.
+	 *
+	 */
+	GLuint getStorageLevel();
+
+	/**
+	 * @brief Returns the size in bytes of a single mip level inside the OpenGL storage.
+	 *
+	 */
+	size_t getLevelSize(GLuint level);
+
+	/**
+	 * @brief Returns the size in bytes of the currently allocated OpenGL storage.
+	 *
+	 */
+	size_t getAllocatedSize();
 private:
-	GLuint ID;
-	int width, height, nrChannels;
-	unsigned char * data;
+	GLuint ID = 0;
+	GLuint sampler = 0;
+	GLsizei width = 0, height = 0;
+	GLuint levels = 0;
+	GLuint storage_level = 0;
+	GLuint resident_level = 0;
+	TextureFormat format;
+	TextureConfiguration config;
 	std::string library, relativePath;
 	bool successfullyLoaded = false;
-	void create(std::string library, std::string relativePath);
+	void create(std::string library, std::string relativePath, TextureConfiguration config);
+	GLuint createStorage(GLuint storage_level);
+	void uploadImageLevel(GLuint target_level, const ImageData & image, GLuint level);
+	void updateBaseLevel();
 };
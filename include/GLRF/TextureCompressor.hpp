@@ -0,0 +1,49 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <GLRF/ImageData.hpp>
+
+// S3TC is not part of the core profile that the glad loader was generated for,
+// but is exposed by all desktop drivers through GL_EXT_texture_compression_s3tc.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace GLRF {
+	class TextureCompressor;
+}
+
+/**
+ * @brief Encodes 8 bit images into GPU block compressed formats.
+ *
+ * RGBA images become BC1 (opaque) or BC3 (with alpha), single channel images BC4 and two channel images BC5.
+ * 16 bit and floating point images are not compressed.
+ */
+class GLRF::TextureCompressor {
+public:
+	/**
+	 * @brief Returns whether images of the given format can be compressed.
+	 *
+	 */
+	static bool isSupported(const TextureFormat & format);
+
+	/**
+	 * @brief Compresses all levels of an image.
+	 *
+	 * @param image the uncompressed image, usually with a complete mip chain
+	 * @return ImageData the compressed image, or the input if its format is not supported
+	 */
+	ImageData compress(const ImageData & image);
+private:
+	static void encodeBC1(const unsigned char * rgba, unsigned char * block);
+	static void encodeBC4(const unsigned char * values, size_t stride, unsigned char * block);
+};
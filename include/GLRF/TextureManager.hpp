@@ -3,22 +3,52 @@
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
+#include <unordered_map>
 #include <filesystem>
+#include <chrono>
 #include <iostream>
 
+#include <GLRF/AssetArchive.hpp>
+
 namespace fs = std::filesystem;
 
 typedef unsigned long long TextureSpaceSize;
 
+/**
+ * @brief Resolves texture names to paths inside registered asset sources.
+ *
+ * Every registered source is indexed once (including nested directories) and the index is persisted to disk,
+ * so later runs only have to compare directory modification times instead of scanning the whole tree.
+ * Lookups are served from a hash map.
+ * Packed archives created by glrf-bake can be registered as well, their entries are preferred over source files.
+ */
 class TextureManager {
 private:
-    std::set<fs::path> registered_paths;
-    std::map<std::string, fs::path> cached_paths;
+    struct AssetSource {
+        fs::path root;
+        // relative directory -> modification time at the last scan
+        std::map<fs::path, long long> directories;
+        // relative directory -> names of all files and directories inside it
+        std::map<fs::path, std::vector<std::string>> entries;
+    };
+
+    std::vector<AssetSource> sources;
+    std::vector<std::shared_ptr<GLRF::AssetArchive>> archives;
+    std::unordered_map<std::string, fs::path> cached_paths;
+    fs::path index_directory = fs::path(".glrf_cache") / "asset_index";
+    std::chrono::steady_clock::time_point last_refresh;
     TextureSpaceSize next_texture_id;
     TextureManager();
     TextureManager(const TextureManager&);
     TextureManager & operator = (const TextureManager &);
-    bool findPathLocally(fs::directory_entry dir, std::string filename, fs::path * target);
+
+    void scanDirectory(AssetSource & source, const fs::path & relative_dir);
+    bool refreshSource(AssetSource & source);
+    void rebuildLookup();
+    fs::path getIndexFile(const AssetSource & source);
+    bool loadIndex(AssetSource & source);
+    void saveIndex(const AssetSource & source);
 public:
     static TextureManager& getInstance() {
         static TextureManager instance;
@@ -27,6 +57,52 @@ public:
 
     ~TextureManager();
 
+    /**
+     * @brief Registers a directory that contains textures and indexes it.
+     *
+     * @param path the root directory of the source
+     *
+     * Sources registered earlier take precedence if multiple sources contain the same name.
+     */
     void registerSource(fs::path path);
+
+    /**
+     * @brief Returns the path of the file or directory with the given name.
+     *
+     * @param name the file name (e.g. 'tiles_marble_albedo.png') or directory name
+     * @return fs::path the path or an empty path if no registered source contains the name
+     *
+     * On a miss, the sources are refreshed once to pick up new files.
+     */
     fs::path findTexturePath(std::string name);
-};
\ No newline at end of file
+
+    /**
+     * @brief Rescans all directories whose modification time has changed and persists the updated indices.
+     *
+     */
+    void refresh();
+
+    /**
+     * @brief Sets the directory that stores the persisted indices.
+     *
+     */
+    void setIndexDirectory(fs::path path);
+
+    /**
+     * @brief Maps a packed asset archive.
+     *
+     * @param path the path to the archive file
+     * @return bool whether the archive could be opened
+     *
+     * Archives registered earlier take precedence if multiple archives contain the same entry.
+     */
+    bool registerArchive(fs::path path);
+
+    /**
+     * @brief Returns the first registered archive that contains an entry with the given name.
+     *
+     * @param name the name of the entry, i.e. the path relative to the baked asset directory
+     * @return std::shared_ptr<GLRF::AssetArchive> the archive or nullptr if no archive contains the entry
+     */
+    std::shared_ptr<GLRF::AssetArchive> findArchive(const std::string & name);
+};
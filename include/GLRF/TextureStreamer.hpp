@@ -0,0 +1,152 @@
+#pragma once
+#include <glad/glad.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+
+#include <GLRF/ImageData.hpp>
+
+namespace GLRF {
+	class Texture;
+	class Material;
+	class TextureStreamer;
+}
+
+/**
+ * @brief Streams the fine mip levels of textures in and out depending on their on-screen size.
+ *
+ * Streamed textures (see TextureConfiguration::streamed) start with their coarse mip tail only.
+ * Every frame, the required mip level of each texture is estimated from the distance and the uv density
+ * of the objects that use it. Missing levels are decoded on the ThreadPool and uploaded from coarse to fine,
+ * while GL_TEXTURE_BASE_LEVEL keeps sampling restricted to levels that are already resident.
+ * If the allocated storage exceeds the memory budget, the finest levels of the least needed textures are evicted.
+ *
+ * Textures that are loaded asynchronously (see TextureConfiguration::async) are uploaded here as well,
+ * once their job on the ThreadPool has finished.
+ */
+class GLRF::TextureStreamer
+{
+public:
+	static TextureStreamer& getInstance() {
+		static TextureStreamer instance;
+		return instance;
+	}
+
+	~TextureStreamer();
+
+	void registerTexture(Texture * texture);
+	void unregisterTexture(Texture * texture);
+
+	/**
+	 * @brief Uploads the image to the texture once the job has finished.
+	 *
+	 * @param texture the texture that is loaded
+	 * @param image the result of the job that reads the complete mip chain
+	 */
+	void loadAsync(Texture * texture, std::future<ImageData> image);
+	void cancelLoad(Texture * texture);
+	bool isLoading(Texture * texture);
+
+	/**
+	 * @brief Sets the maximum number of bytes that all streamed textures may allocate together.
+	 *
+	 */
+	void setMemoryBudget(size_t bytes);
+	size_t getMemoryBudget();
+
+	/**
+	 * @brief Returns the number of bytes that are currently allocated by all streamed textures.
+	 *
+	 */
+	size_t getAllocatedMemory();
+
+	/**
+	 * @brief Sets the maximum number of bytes that will be uploaded per frame.
+	 *
+	 * At least one mip level is uploaded per frame, even if it exceeds the budget.
+	 */
+	void setUploadBudget(size_t bytes);
+
+	/**
+	 * @brief Sets the size (in texels) below which mip levels are always resident.
+	 *
+	 */
+	void setTailSize(GLsizei size);
+
+	/**
+	 * @brief Sets the height of the viewport in pixels that is used to estimate the screen-space texel density.
+	 *
+	 */
+	void setViewportHeight(float height);
+
+	/**
+	 * @brief Sets the vertical field of view in radians that is used to estimate the screen-space texel density.
+	 *
+	 */
+	void setFieldOfView(float fov_y);
+
+	/**
+	 * @brief Returns the finest mip level that is always resident for an image of the given size.
+	 *
+	 */
+	GLuint calculateTailLevel(GLsizei width, GLsizei height);
+
+	/**
+	 * @brief Estimates the mip level that is sampled when the texture is seen from the given distance.
+	 *
+	 * @param texture the texture
+	 * @param distance the distance between the camera and the object in world units
+	 * @param uv_density the uv units per world unit on the surface of the object
+	 * @return float the fractional mip level
+	 */
+	float calculateRequiredLevel(Texture * texture, float distance, float uv_density);
+
+	/**
+	 * @brief Requests a mip level for a texture during the current frame.
+	 *
+	 * The finest level that is requested during a frame wins.
+	 */
+	void requestLevel(Texture * texture, float level);
+
+	/**
+	 * @brief Requests the mip levels for all streamed textures of a material.
+	 *
+	 * @param material the material of an object that is drawn this frame
+	 * @param distance the distance between the camera and the object in world units
+	 * @param uv_density the uv units per world unit on the surface of the object
+	 */
+	void requestMaterial(std::shared_ptr<Material> material, float distance, float uv_density);
+
+	/**
+	 * @brief Uploads finished loads and levels, schedules new loads and evicts levels to meet the memory budget.
+	 *
+	 * Must be called once per frame on the render thread. Consumes the requests of the previous frame.
+	 */
+	void update();
+private:
+	struct StreamingState {
+		GLuint requested_level;
+		unsigned long long last_request_frame = 0;
+		std::optional<std::future<ImageData>> pending;
+		std::optional<ImageData> chain;
+	};
+
+	std::map<Texture *, StreamingState> textures;
+	std::map<Texture *, std::future<ImageData>> loads;
+	size_t memory_budget = 256ull * 1024ull * 1024ull;
+	size_t upload_budget = 4ull * 1024ull * 1024ull;
+	GLsizei tail_size = 64;
+	float viewport_height = 600.f;
+	float fov_y = 0.785398f;
+	unsigned long long frame = 1;
+
+	TextureStreamer();
+	TextureStreamer(const TextureStreamer&);
+	TextureStreamer& operator = (const TextureStreamer&);
+
+	void finishLoads();
+	void uploadPendingLevels();
+	void scheduleLoads();
+	void evict();
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace GLRF {
+	class ThreadPool;
+}
+
+/**
+ * @brief A fixed set of worker threads that execute background jobs (decoding, mip generation, baking).
+ *
+ * Jobs must not call OpenGL functions, since the context is only current on the render thread.
+ */
+class GLRF::ThreadPool
+{
+public:
+	static ThreadPool& getInstance() {
+		static ThreadPool instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Construct a new ThreadPool object.
+	 *
+	 * @param num_threads the number of workers, 0 selects one less than the number of hardware threads
+	 */
+	ThreadPool(unsigned int num_threads = 0);
+	~ThreadPool();
+
+	/**
+	 * @brief Queues a job for execution on a worker thread.
+	 *
+	 * @param job the callable that will be executed
+	 * @return std::future the result of the job
+	 */
+	template <typename F>
+	auto submit(F && job) -> std::future<typename std::invoke_result<F>::type> {
+		using result_t = typename std::invoke_result<F>::type;
+		auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(job));
+		std::future<result_t> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->jobs.push([task]() { (*task)(); });
+		}
+		this->condition.notify_one();
+		return result;
+	}
+
+	/**
+	 * @brief Executes the function for all indices in [begin, end) on the workers and the calling thread.
+	 *
+	 * @param begin the first index
+	 * @param end the index after the last index
+	 * @param function the function that is called once per index
+	 *
+	 * Returns after all indices have been processed.
+	 */
+	void parallelFor(size_t begin, size_t end, const std::function<void(size_t)> & function);
+
+	/**
+	 * @brief Returns the number of worker threads.
+	 *
+	 */
+	unsigned int getThreadCount();
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator = (const ThreadPool&);
+
+	void work();
+	bool runPendingJob();
+};
@@ -28,5 +28,15 @@ public:
 	VertexFormat(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &uv, const glm::vec3 &tangent);
 	~VertexFormat();
 
+	/**
+	 * @brief Specifies the attributes of the bound vertex array, reading from the bound GL_ARRAY_BUFFER.
+	 *
+	 */
 	static void registerFormat();
+
+	/**
+	 * @brief Specifies the attributes of a vertex array with direct state access, reading from the specified buffer.
+	 *
+	 */
+	static void registerFormat(GLuint vertex_array, GLuint vertex_buffer);
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <GLRF/FrameBuffer.hpp>
+#include <GLRF/Scene.hpp>
+
+namespace GLRF {
+	class VisibilityBuffer;
+}
+
+/**
+ * @brief Renders a Scene by rasterizing only triangle and instance IDs and shading every pixel once afterwards.
+ *
+ * The visibility pass writes encode(instance, triangle) into a 32 bit target, so its fragment work does not depend
+ * on the material. A full-screen pass then fetches the triangle of every pixel from shader storage buffers
+ * (vertex pulling), reconstructs its perspective-correct barycentrics, interpolates position, normal and uv and
+ * shades it with the material of the MaterialTable and the lights of the FrameUniformBuffer. Dense meshes with tiny
+ * triangles therefore no longer shade the helper pixels of partially covered quads.
+ *
+ * The triangles of all objects are copied once into shared buffers, invalidateGeometry() has to be called after
+ * meshes were updated. Only opaque triangle meshes in the VertexFormat whose material is in the MaterialTable are
+ * drawn, other objects have to be drawn forward. Texture derivatives are taken across the pixels of a quad, which
+ * may belong to different triangles, so the mip level can be too detailed along triangle edges.
+ */
+class GLRF::VisibilityBuffer
+{
+public:
+	static const GLuint TRIANGLE_BITS = 22;
+	static const GLuint MAX_TRIANGLES = 1u << TRIANGLE_BITS;
+	// the last instance is reserved, so no ID equals EMPTY
+	static const GLuint MAX_INSTANCES = (1u << (32 - TRIANGLE_BITS)) - 1;
+	static const GLuint EMPTY = 0xFFFFFFFFu;
+
+	static const GLuint VERTEX_STORAGE_BINDING = 3;
+	static const GLuint INDEX_STORAGE_BINDING = 4;
+	static const GLuint INSTANCE_STORAGE_BINDING = 5;
+
+	/**
+	 * @brief Creates the visibility and output targets and compiles the passes.
+	 *
+	 * @param resolution the resolution of the targets
+	 */
+	VisibilityBuffer(ScreenResolution resolution);
+	~VisibilityBuffer();
+
+	static GLuint encode(GLuint instance, GLuint triangle);
+	static GLuint getInstanceIndex(GLuint id);
+	static GLuint getTriangleIndex(GLuint id);
+
+	/**
+	 * @brief Draws the visibility pass and shades it into the output.
+	 *
+	 * @param projection the projection matrix of the camera
+	 *
+	 * Scene::prepareDraw() has to be called before, it writes the lights and binds the MaterialTable.
+	 */
+	void draw(Scene & scene, const glm::mat4 & projection);
+
+	/**
+	 * @brief Copies the triangles of all objects again with the next draw().
+	 *
+	 */
+	void invalidateGeometry();
+
+	FrameBuffer & getVisibilityTarget();
+	FrameBuffer & getOutput();
+private:
+	// mirrors the std430 layout of 'Instance' in the resolve pass
+	struct InstanceEntry {
+		glm::mat4 model;
+		glm::mat4 normal_matrix;
+		GLuint first_index;
+		GLuint base_vertex;
+		GLuint material_index;
+		GLuint padding;
+	};
+	static_assert(sizeof(InstanceEntry) == 144, "std430 layout of 'Instance'");
+
+	struct GeometryRange {
+		GLuint first_index = 0;
+		GLuint base_vertex = 0;
+		bool supported = false;
+	};
+
+	ScreenResolution resolution;
+	std::unique_ptr<FrameBuffer> visibility_target;
+	std::unique_ptr<FrameBuffer> output;
+	GLuint visibility_program = 0;
+	GLuint resolve_program = 0;
+	GLint visibility_projection_location = -1;
+	GLint visibility_model_location = -1;
+	GLint visibility_instance_location = -1;
+	GLint resolve_projection_location = -1;
+	GLuint empty_vertex_array = 0;
+
+	std::map<SceneObject *, GeometryRange> geometry;
+	std::vector<VertexFormat> vertices;
+	std::vector<GLuint> indices;
+	bool geometry_dirty = true;
+	GLuint vertex_buffer = 0;
+	GLuint index_buffer = 0;
+
+	std::vector<InstanceEntry> instances;
+	// the objects of the instances, in the same order
+	std::vector<SceneObject *> instance_objects;
+	GLuint instance_buffer = 0;
+
+	VisibilityBuffer(const VisibilityBuffer&);
+	VisibilityBuffer& operator = (const VisibilityBuffer&);
+
+	void updateGeometry(Scene & scene);
+	void updateInstances(Scene & scene);
+};
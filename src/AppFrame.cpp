@@ -29,8 +29,25 @@ glm::vec2 Mouse::getOffset() {
     return glm::vec2(this->pos  - this->pos_old);
 }
 
-AppFrame::AppFrame(ScreenResolution resolution, App * app) {
+AppFrame::AppFrame(ScreenResolution resolution, App * app, AppFrameMode mode) {
     this->resolution = resolution;
+    this->app = app;
+    if (mode == AppFrameMode::HEADLESS) {
+        this->headless_context = std::make_unique<HeadlessContext>(resolution);
+        if (!gladLoadGLLoader(this->headless_context->getLoader())) {
+            throw std::runtime_error("Failed to initialize GLAD!");
+        }
+        GLExtensions::getInstance().load(this->headless_context->getLoader());
+        GLStateCache::getInstance().setViewport(0, 0, resolution.width, resolution.height);
+        TextureStreamer::getInstance().setViewportHeight(static_cast<float>(resolution.height));
+
+        FrameBufferConfiguration config = {};
+        config.color_formats = { GL_RGBA8 };
+        this->output = std::make_unique<FrameBuffer>(config, this->resolution);
+        this->app->setOutput(this->output.get());
+        return;
+    }
+
     Mouse::getInstance().setPosition(static_cast<double>(resolution.width) / 2.0, static_cast<double>(resolution.height) / 2.0);
     this->window = glfwCreateWindow(resolution.width, resolution.height, "OpenGL", NULL, NULL);
     if (!this->window) {
@@ -43,17 +60,39 @@ AppFrame::AppFrame(ScreenResolution resolution, App * app) {
         glfwTerminate();
         throw std::runtime_error("Failed to initialize GLAD!");
     }
+    GLExtensions::getInstance().load((GLADloadproc)glfwGetProcAddress);
     glfwSetFramebufferSizeCallback(this->window, &AppFrame::framebufferSizeCallback);
-
-    this->app = app;
+    TextureStreamer::getInstance().setViewportHeight(static_cast<float>(resolution.height));
 }
 
 AppFrame::~AppFrame() {
+    // the output has to be deleted while the context is still current
+    this->output.reset();
+}
 
+void AppFrame::enableDynamicResolution(float target_frame_time, float min_scale) {
+    if (!this->window) {
+        throw std::invalid_argument("Dynamic resolution upscales into the window, a headless AppFrame has none!");
+    }
+    FrameBufferConfiguration config = {};
+    config.color_formats = { GL_RGBA8 };
+    this->scaled_output = std::make_unique<FrameBuffer>(config, this->resolution);
+    this->dynamic_resolution = std::make_unique<DynamicResolution>(this->resolution, target_frame_time, min_scale);
+    this->app->setOutput(this->scaled_output.get());
+    this->app->setDynamicResolution(this->dynamic_resolution.get());
+}
+
+void AppFrame::releaseDynamicResolution() {
+    if (!this->dynamic_resolution) return;
+    this->app->setOutput(nullptr);
+    this->app->setDynamicResolution(nullptr);
+    this->dynamic_resolution.reset();
+    this->scaled_output.reset();
 }
 
 void AppFrame::framebufferSizeCallback(GLFWwindow * window, int width, int height) {
-    glViewport(0, 0, width, height);
+    GLStateCache::getInstance().setViewport(0, 0, width, height);
+    TextureStreamer::getInstance().setViewportHeight(static_cast<float>(height));
 }
 
 void AppFrame::processInput(GLFWwindow * window) {
@@ -67,14 +106,58 @@ void AppFrame::mouse_callback(GLFWwindow * window, double x, double y) {
 }
 
 bool AppFrame::render() {
+    if (!this->window) {
+        throw std::invalid_argument("A headless AppFrame has no window, use renderFrames()!");
+    }
     this->app->configure(this->window);
     while(!glfwWindowShouldClose(this->window)) {
         glfwSetCursorPosCallback(this->window, mouse_callback);
         this->app->processUserInput(this->window, Mouse::getInstance().getOffset());
         this->app->updateScene();
+        if (this->dynamic_resolution) {
+            this->dynamic_resolution->beginFrame();
+            this->dynamic_resolution->use(*this->scaled_output);
+        }
         this->app->render();
+        if (this->dynamic_resolution) {
+            this->dynamic_resolution->endFrame();
+            int width, height;
+            glfwGetFramebufferSize(this->window, &width, &height);
+            this->dynamic_resolution->blitToScreen(*this->scaled_output, ScreenResolution(width, height));
+        }
         glfwSwapBuffers(this->window);
     }
+    // the queries and the target have to be deleted before the context is destroyed
+    releaseDynamicResolution();
     glfwTerminate();
     return 0;
+}
+
+void AppFrame::renderFrames(unsigned int frame_count, FrameBuffer::ReadbackCallback on_frame) {
+    if (!this->output) {
+        throw std::invalid_argument("Only a headless AppFrame renders offscreen, use render()!");
+    }
+    this->app->configure(nullptr);
+    for (unsigned int frame = 0; frame < frame_count; frame++) {
+        this->app->updateScene();
+        // there is no default framebuffer, apps that render to the bound framebuffer draw into the output
+        this->output->use();
+        GLStateCache::getInstance().setViewport(0, 0, this->resolution.width, this->resolution.height);
+        this->app->render();
+        if (on_frame) {
+            this->output->readColorBufferAsync(0, GL_RGBA, GL_UNSIGNED_BYTE, on_frame);
+            this->output->pollReadbacks();
+        }
+    }
+    if (on_frame) {
+        this->output->pollReadbacks(true);
+    }
+    glFinish();
+}
+
+FrameBuffer & AppFrame::getOutput() {
+    if (!this->output) {
+        throw std::invalid_argument("Only a headless AppFrame renders offscreen!");
+    }
+    return *this->output;
 }
\ No newline at end of file
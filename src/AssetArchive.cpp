@@ -0,0 +1,456 @@
+#include <GLRF/AssetArchive.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <GLRF/TextureCompressor.hpp>
+
+using namespace GLRF;
+
+const char AssetArchive::MAGIC[8] = { 'G', 'L', 'R', 'F', 'P', 'A', 'K', '\0' };
+const std::uint32_t AssetArchive::VERSION = 1;
+
+namespace {
+	// all records are little endian and naturally aligned, blobs start at 16 byte boundaries
+	const std::uint64_t BLOB_ALIGNMENT = 16;
+
+	struct FileHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t entry_count;
+		std::uint64_t toc_offset;
+		std::uint64_t names_offset;
+		std::uint64_t names_size;
+	};
+
+	struct TocRecord {
+		std::uint64_t content_hash;
+		std::uint64_t offset;
+		std::uint64_t size;
+		std::uint32_t type;
+		std::uint32_t name_offset;
+		std::uint32_t name_length;
+		std::uint32_t reserved;
+	};
+
+	struct TextureHeader {
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levels;
+		std::uint32_t internal_format;
+		std::uint32_t pixel_format;
+		std::uint32_t data_type;
+		std::uint32_t channels;
+		std::uint32_t bytes_per_channel;
+		std::uint32_t is_srgb;
+		std::uint32_t block_size;
+		std::uint32_t reserved[2];
+	};
+
+	struct LevelRecord {
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	struct MeshHeader {
+		std::uint32_t vertex_count;
+		std::uint32_t index_count;
+		std::uint32_t vertex_stride;
+		std::uint32_t reserved;
+	};
+
+	const std::uint32_t FLOATS_PER_VERTEX = 11;
+
+	std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// (linear, sRGB) formats that store the same bits and only differ in how the GPU decodes them
+	const GLenum COLOUR_SPACE_VARIANTS[][2] = {
+		{ GL_RGBA8, GL_SRGB8_ALPHA8 },
+		{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT },
+		{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT },
+		{ GL_COMPRESSED_RGBA_BPTC_UNORM, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM }
+	};
+
+	// returns 0 if the format has no variant in the other colour space
+	GLenum getColourSpaceVariant(GLenum internal_format, bool srgb)
+	{
+		for (const GLenum (&variant)[2] : COLOUR_SPACE_VARIANTS)
+		{
+			if (variant[srgb ? 0 : 1] == internal_format) return variant[srgb ? 1 : 0];
+		}
+		return 0;
+	}
+
+	template <typename T>
+	void append(std::vector<unsigned char> & data, const T & value)
+	{
+		const unsigned char * bytes = reinterpret_cast<const unsigned char *>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+}
+
+struct AssetArchive::Mapping {
+	const unsigned char * data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE view = NULL;
+#endif
+
+	~Mapping()
+	{
+#ifdef _WIN32
+		if (this->data) UnmapViewOfFile(this->data);
+		if (this->view) CloseHandle(this->view);
+		if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+#else
+		if (this->data) munmap(const_cast<unsigned char *>(this->data), this->size);
+#endif
+	}
+};
+
+AssetArchive::AssetArchive(fs::path path)
+{
+	this->path = path;
+	this->mapping = std::make_shared<Mapping>();
+	Mapping & map = *(this->mapping);
+
+#ifdef _WIN32
+	map.file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER file_size;
+	if (map.file == INVALID_HANDLE_VALUE || !GetFileSizeEx(map.file, &file_size)) {
+		throw std::runtime_error("Could not open asset archive '" + path.generic_string() + "'");
+	}
+	map.size = static_cast<size_t>(file_size.QuadPart);
+	map.view = CreateFileMappingW(map.file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (map.view) map.data = static_cast<const unsigned char *>(MapViewOfFile(map.view, FILE_MAP_READ, 0, 0, 0));
+	if (!map.data) {
+		throw std::runtime_error("Could not map asset archive '" + path.generic_string() + "'");
+	}
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if (file < 0 || fstat(file, &file_stat) != 0) {
+		if (file >= 0) close(file);
+		throw std::runtime_error("Could not open asset archive '" + path.generic_string() + "'");
+	}
+	map.size = static_cast<size_t>(file_stat.st_size);
+	void * data = (map.size > 0) ? mmap(nullptr, map.size, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+	close(file);
+	if (data == MAP_FAILED) {
+		throw std::runtime_error("Could not map asset archive '" + path.generic_string() + "'");
+	}
+	map.data = static_cast<const unsigned char *>(data);
+#endif
+
+	FileHeader header;
+	if (map.size < sizeof(FileHeader)) {
+		throw std::runtime_error("The asset archive '" + path.generic_string() + "' is truncated");
+	}
+	std::memcpy(&header, map.data, sizeof(FileHeader));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+		throw std::runtime_error("The file '" + path.generic_string() + "' is not a supported asset archive");
+	}
+	if (header.toc_offset + static_cast<std::uint64_t>(header.entry_count) * sizeof(TocRecord) > map.size
+		|| header.names_offset + header.names_size > map.size)
+	{
+		throw std::runtime_error("The asset archive '" + path.generic_string() + "' is truncated");
+	}
+
+	const char * names = reinterpret_cast<const char *>(map.data + header.names_offset);
+	this->entries.reserve(header.entry_count);
+	for (std::uint32_t i = 0; i < header.entry_count; ++i)
+	{
+		TocRecord record;
+		std::memcpy(&record, map.data + header.toc_offset + i * sizeof(TocRecord), sizeof(TocRecord));
+		if (record.offset + record.size > map.size || static_cast<std::uint64_t>(record.name_offset) + record.name_length > header.names_size) {
+			throw std::runtime_error("The asset archive '" + path.generic_string() + "' contains an invalid entry");
+		}
+
+		AssetArchiveEntry entry;
+		entry.name = std::string(names + record.name_offset, record.name_length);
+		entry.type = static_cast<AssetType>(record.type);
+		entry.content_hash = record.content_hash;
+		entry.offset = record.offset;
+		entry.size = record.size;
+		this->entry_indices.emplace(entry.name, this->entries.size());
+		this->entries.push_back(entry);
+	}
+}
+
+AssetArchive::~AssetArchive()
+{
+
+}
+
+const AssetArchiveEntry * AssetArchive::findEntry(const std::string & name) const
+{
+	auto it = this->entry_indices.find(normalizeName(name));
+	return (it != this->entry_indices.end()) ? &(this->entries[it->second]) : nullptr;
+}
+
+std::string AssetArchive::normalizeName(const std::string & name)
+{
+	return fs::path(name).lexically_normal().generic_string();
+}
+
+const std::vector<AssetArchiveEntry> & AssetArchive::getEntries() const
+{
+	return this->entries;
+}
+
+const unsigned char * AssetArchive::getData(const AssetArchiveEntry & entry) const
+{
+	return this->mapping->data + entry.offset;
+}
+
+ImageData AssetArchive::loadImage(const std::string & name, bool srgb) const
+{
+	const AssetArchiveEntry * entry = findEntry(name);
+	if (!entry || entry->type != AssetType::TEXTURE || entry->size < sizeof(TextureHeader)) return ImageData();
+
+	const unsigned char * data = getData(*entry);
+	TextureHeader header;
+	std::memcpy(&header, data, sizeof(TextureHeader));
+	if ((header.is_srgb != 0) != srgb) {
+		// the baker decided the colour space from the name, the bits can be reinterpreted if the format has a variant in the requested one
+		const GLenum variant = getColourSpaceVariant(header.internal_format, srgb);
+		if (variant == 0) return ImageData();
+		header.internal_format = variant;
+		header.is_srgb = srgb ? 1 : 0;
+	}
+
+	const std::uint64_t data_offset = alignUp(sizeof(TextureHeader) + header.levels * sizeof(LevelRecord), BLOB_ALIGNMENT);
+	if (header.levels == 0 || data_offset > entry->size) return ImageData();
+
+	TextureFormat format;
+	format.internal_format = header.internal_format;
+	format.pixel_format = header.pixel_format;
+	format.data_type = header.data_type;
+	format.channels = header.channels;
+	format.bytes_per_channel = header.bytes_per_channel;
+	format.is_srgb = header.is_srgb != 0;
+	format.block_size = header.block_size;
+
+	std::vector<ImageLevel> levels(header.levels);
+	for (std::uint32_t l = 0; l < header.levels; ++l)
+	{
+		LevelRecord record;
+		std::memcpy(&record, data + sizeof(TextureHeader) + l * sizeof(LevelRecord), sizeof(LevelRecord));
+		if (data_offset + record.offset + record.size > entry->size) return ImageData();
+		levels[l].width = static_cast<GLsizei>(record.width);
+		levels[l].height = static_cast<GLsizei>(record.height);
+		levels[l].offset = static_cast<size_t>(record.offset);
+		levels[l].size = static_cast<size_t>(record.size);
+	}
+
+	// the image shares ownership of the mapping instead of copying the texels
+	std::shared_ptr<unsigned char> storage(this->mapping, const_cast<unsigned char *>(data + data_offset));
+	return ImageData(format, levels, storage, static_cast<size_t>(entry->size - data_offset));
+}
+
+std::shared_ptr<MeshData<VertexFormat>> AssetArchive::loadMesh(const std::string & name) const
+{
+	const AssetArchiveEntry * entry = findEntry(name);
+	if (!entry || entry->type != AssetType::MESH || entry->size < sizeof(MeshHeader)) return nullptr;
+
+	const unsigned char * data = getData(*entry);
+	MeshHeader header;
+	std::memcpy(&header, data, sizeof(MeshHeader));
+	const std::uint64_t vertex_bytes = static_cast<std::uint64_t>(header.vertex_count) * header.vertex_stride;
+	const std::uint64_t index_bytes = static_cast<std::uint64_t>(header.index_count) * sizeof(std::uint32_t);
+	if (header.vertex_stride != FLOATS_PER_VERTEX * sizeof(float) || sizeof(MeshHeader) + vertex_bytes + index_bytes > entry->size) {
+		std::cout << "The mesh '" << name << "' inside '" << this->path.generic_string() << "' has an unsupported layout." << std::endl;
+		return nullptr;
+	}
+
+	auto mesh = std::make_shared<MeshData<VertexFormat>>();
+	mesh->vertices.reserve(header.vertex_count);
+	const unsigned char * vertices = data + sizeof(MeshHeader);
+	float v[FLOATS_PER_VERTEX];
+	for (std::uint32_t i = 0; i < header.vertex_count; ++i)
+	{
+		std::memcpy(v, vertices + static_cast<size_t>(i) * header.vertex_stride, sizeof(v));
+		mesh->vertices.push_back(VertexFormat(glm::vec3(v[0], v[1], v[2]), glm::vec3(v[3], v[4], v[5]), glm::vec2(v[6], v[7]), glm::vec3(v[8], v[9], v[10])));
+	}
+	std::vector<GLuint> indices(header.index_count);
+	std::memcpy(indices.data(), vertices + vertex_bytes, static_cast<size_t>(index_bytes));
+	mesh->indices = std::move(indices);
+	return mesh;
+}
+
+fs::path AssetArchive::getPath() const
+{
+	return this->path;
+}
+
+void AssetArchiveWriter::addTexture(const std::string & name, const ImageData & image, std::uint64_t content_hash)
+{
+	const TextureFormat & format = image.getFormat();
+	TextureHeader header = {};
+	header.width = static_cast<std::uint32_t>(image.getWidth());
+	header.height = static_cast<std::uint32_t>(image.getHeight());
+	header.levels = image.getLevelCount();
+	header.internal_format = format.internal_format;
+	header.pixel_format = format.pixel_format;
+	header.data_type = format.data_type;
+	header.channels = format.channels;
+	header.bytes_per_channel = format.bytes_per_channel;
+	header.is_srgb = format.is_srgb ? 1 : 0;
+	header.block_size = format.block_size;
+
+	std::vector<unsigned char> data;
+	append(data, header);
+	std::uint64_t offset = 0;
+	for (GLuint l = 0; l < image.getLevelCount(); ++l)
+	{
+		const ImageLevel & level = image.getLevel(l);
+		LevelRecord record = { static_cast<std::uint32_t>(level.width), static_cast<std::uint32_t>(level.height), offset, level.size };
+		append(data, record);
+		offset = alignUp(offset + level.size, BLOB_ALIGNMENT);
+	}
+	data.resize(static_cast<size_t>(alignUp(data.size(), BLOB_ALIGNMENT)), 0);
+	const size_t data_offset = data.size();
+	data.resize(data_offset + static_cast<size_t>(offset), 0);
+
+	offset = 0;
+	for (GLuint l = 0; l < image.getLevelCount(); ++l)
+	{
+		const ImageLevel & level = image.getLevel(l);
+		std::memcpy(data.data() + data_offset + offset, image.getLevelData(l), level.size);
+		offset = alignUp(offset + level.size, BLOB_ALIGNMENT);
+	}
+	this->blobs.push_back({ name, AssetType::TEXTURE, content_hash, std::move(data) });
+}
+
+void AssetArchiveWriter::addMesh(const std::string & name, const MeshData<VertexFormat> & mesh, std::uint64_t content_hash)
+{
+	std::vector<GLuint> sequential;
+	const std::vector<GLuint> * indices = &sequential;
+	if (mesh.indices.has_value()) {
+		indices = &(mesh.indices.value());
+	} else {
+		sequential.resize(mesh.vertices.size());
+		for (size_t i = 0; i < sequential.size(); ++i) sequential[i] = static_cast<GLuint>(i);
+	}
+
+	MeshHeader header = {};
+	header.vertex_count = static_cast<std::uint32_t>(mesh.vertices.size());
+	header.index_count = static_cast<std::uint32_t>(indices->size());
+	header.vertex_stride = FLOATS_PER_VERTEX * sizeof(float);
+
+	std::vector<unsigned char> data;
+	data.reserve(sizeof(MeshHeader) + mesh.vertices.size() * header.vertex_stride + indices->size() * sizeof(std::uint32_t));
+	append(data, header);
+	for (const VertexFormat & vertex : mesh.vertices)
+	{
+		const float v[FLOATS_PER_VERTEX] = {
+			vertex.position.x, vertex.position.y, vertex.position.z,
+			vertex.normal.x, vertex.normal.y, vertex.normal.z,
+			vertex.uv.x, vertex.uv.y,
+			vertex.tangent.x, vertex.tangent.y, vertex.tangent.z
+		};
+		append(data, v);
+	}
+	for (GLuint index : *indices)
+	{
+		append(data, static_cast<std::uint32_t>(index));
+	}
+	this->blobs.push_back({ name, AssetType::MESH, content_hash, std::move(data) });
+}
+
+void AssetArchiveWriter::addBlob(const std::string & name, AssetType type, std::uint64_t content_hash, const unsigned char * data, size_t size)
+{
+	this->blobs.push_back({ name, type, content_hash, std::vector<unsigned char>(data, data + size) });
+}
+
+bool AssetArchiveWriter::write(fs::path path)
+{
+	fs::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			std::cout << "Could not write asset archive '" << temporary.generic_string() << "'." << std::endl;
+			return false;
+		}
+
+		std::vector<TocRecord> toc;
+		std::string names;
+		std::uint64_t offset = alignUp(sizeof(FileHeader), BLOB_ALIGNMENT);
+		for (const Blob & blob : this->blobs)
+		{
+			TocRecord record = {};
+			record.content_hash = blob.content_hash;
+			record.offset = offset;
+			record.size = blob.data.size();
+			record.type = static_cast<std::uint32_t>(blob.type);
+			record.name_offset = static_cast<std::uint32_t>(names.size());
+			record.name_length = static_cast<std::uint32_t>(blob.name.size());
+			toc.push_back(record);
+			names += blob.name;
+			offset = alignUp(offset + blob.data.size(), BLOB_ALIGNMENT);
+		}
+
+		FileHeader header = {};
+		std::memcpy(header.magic, AssetArchive::MAGIC, sizeof(header.magic));
+		header.version = AssetArchive::VERSION;
+		header.entry_count = static_cast<std::uint32_t>(toc.size());
+		header.toc_offset = offset;
+		header.names_offset = offset + toc.size() * sizeof(TocRecord);
+		header.names_size = names.size();
+
+		const char padding[BLOB_ALIGNMENT] = {};
+		std::uint64_t position = 0;
+		auto pad = [&](std::uint64_t target) {
+			file.write(padding, static_cast<std::streamsize>(target - position));
+			position = target;
+		};
+		file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+		position = sizeof(FileHeader);
+		for (size_t i = 0; i < this->blobs.size(); ++i)
+		{
+			pad(toc[i].offset);
+			file.write(reinterpret_cast<const char *>(this->blobs[i].data.data()), static_cast<std::streamsize>(this->blobs[i].data.size()));
+			position += this->blobs[i].data.size();
+		}
+		pad(header.toc_offset);
+		file.write(reinterpret_cast<const char *>(toc.data()), static_cast<std::streamsize>(toc.size() * sizeof(TocRecord)));
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+		if (!file.good()) {
+			std::cout << "Could not write asset archive '" << temporary.generic_string() << "'." << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(temporary, path, error);
+	if (error) {
+		// rename does not replace existing files on every platform
+		fs::remove(path, error);
+		fs::rename(temporary, path, error);
+	}
+	if (error) {
+		std::cout << "Could not replace asset archive '" << path.generic_string() << "': " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,276 @@
+#include <GLRF/DeferredRenderer.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <GLRF/FrameUniforms.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// the texture units of the G-buffer in the lighting pass
+	const GLuint DEPTH_TEXTURE_UNIT = 4;
+
+	// culls one tile per work group, every invocation shades one pixel
+	const char * LIGHTING_SOURCE = R"(
+layout(binding = 0) uniform sampler2D gbuffer_albedo;
+layout(binding = 1) uniform sampler2D gbuffer_normal;
+layout(binding = 2) uniform sampler2D gbuffer_orm;
+layout(binding = 4) uniform sampler2D gbuffer_depth;
+layout(binding = 0, r11f_g11f_b10f) uniform image2D lighting;
+uniform mat4 inverse_projection;
+// the rendered region of the G-buffer, smaller than the images with dynamic resolution
+uniform ivec2 render_size;
+
+// the radiance below which a point light is ignored, defines the radius of the lights
+const float LIGHT_CUTOFF = 0.01;
+
+shared uint tile_min_depth;
+shared uint tile_max_depth;
+shared uint tile_light_count;
+shared uint tile_lights[MAX_POINT_LIGHTS];
+
+vec3 decodeOctahedral(vec2 encoded) {
+	vec2 e = encoded * 2.0 - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 ndc, float depth) {
+	vec4 position = inverse_projection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+	return position.xyz / position.w;
+}
+
+void main() {
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 size = render_size;
+	bool inside = all(lessThan(pixel, size));
+	float depth = inside ? texelFetch(gbuffer_depth, pixel, 0).r : 1.0;
+
+	if (gl_LocalInvocationIndex == 0u) {
+		tile_min_depth = 0xFFFFFFFFu;
+		tile_max_depth = 0u;
+		tile_light_count = 0u;
+	}
+	barrier();
+	// positive floats keep their order as bits
+	if (depth < 1.0) {
+		atomicMin(tile_min_depth, floatBitsToUint(depth));
+		atomicMax(tile_max_depth, floatBitsToUint(depth));
+	}
+	barrier();
+
+	if (tile_min_depth <= tile_max_depth) {
+		// the view space bounds of the tile between its nearest and farthest pixel
+		vec2 tile_min = vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) / vec2(size) * 2.0 - 1.0;
+		vec2 tile_max = vec2((gl_WorkGroupID.xy + 1u) * gl_WorkGroupSize.xy) / vec2(size) * 2.0 - 1.0;
+		vec3 bounds_min = vec3(1e30);
+		vec3 bounds_max = vec3(-1e30);
+		for (int i = 0; i < 8; ++i) {
+			vec2 ndc = vec2((i & 1) != 0 ? tile_max.x : tile_min.x, (i & 2) != 0 ? tile_max.y : tile_min.y);
+			vec3 corner = reconstructPosition(ndc, uintBitsToFloat((i & 4) != 0 ? tile_max_depth : tile_min_depth));
+			bounds_min = min(bounds_min, corner);
+			bounds_max = max(bounds_max, corner);
+		}
+
+		uint light_count = min(pointLight_count, uint(MAX_POINT_LIGHTS));
+		for (uint i = gl_LocalInvocationIndex; i < light_count; i += TILE_SIZE * TILE_SIZE) {
+			vec3 center = (view * vec4(pointLight_position[i], 1.0)).xyz;
+			vec3 color = pointLight_color[i];
+			float radius_squared = pointLight_power[i] * max(color.r, max(color.g, color.b)) / LIGHT_CUTOFF;
+			vec3 closest = clamp(center, bounds_min, bounds_max);
+			if (dot(closest - center, closest - center) <= radius_squared) {
+				tile_lights[atomicAdd(tile_light_count, 1u)] = i;
+			}
+		}
+	}
+	barrier();
+	if (!inside || depth >= 1.0) return;
+
+	// lights are evaluated in view space, so only the inverse projection is needed
+	vec3 position = reconstructPosition((vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0, depth);
+	vec3 n = normalize(mat3(view) * decodeOctahedral(texelFetch(gbuffer_normal, pixel, 0).rg));
+	vec3 v = normalize(-position);
+	vec3 albedo = texelFetch(gbuffer_albedo, pixel, 0).rgb;
+	vec3 orm = texelFetch(gbuffer_orm, pixel, 0).rgb;
+	float roughness = max(orm.g, 0.04);
+	float metallic = orm.b;
+
+	vec3 radiance = vec3(0.0);
+	for (uint i = 0u; i < tile_light_count; ++i) {
+		uint light = tile_lights[i];
+		vec3 to_light = (view * vec4(pointLight_position[light], 1.0)).xyz - position;
+		float distance_squared = max(dot(to_light, to_light), 1e-4);
+		radiance += shade(albedo, roughness, metallic, n, v, to_light * inversesqrt(distance_squared),
+			pointLight_color[light] * pointLight_power[light] / distance_squared);
+	}
+	if (useDirectionalLight) {
+		vec3 l = normalize(mat3(view) * -directionalLight_direction);
+		radiance += shade(albedo, roughness, metallic, n, v, l, vec3(directionalLight_power));
+	}
+	imageStore(lighting, pixel, vec4(imageLoad(lighting, pixel).rgb + radiance, 1.0));
+}
+)";
+
+	GLuint createLightingProgram()
+	{
+		std::stringstream source;
+		source << "#version 430\n"
+			<< "#define TILE_SIZE " << DeferredRenderer::TILE_SIZE << "u\n"
+			<< "#define MAX_POINT_LIGHTS " << FrameUniforms::MAX_POINT_LIGHTS << "\n"
+			<< "layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE, local_size_z = 1) in;\n"
+			<< FrameUniformBuffer::getGLSLInterface()
+			<< FrameUniformBuffer::getGLSLLighting()
+			<< LIGHTING_SOURCE;
+		const std::string source_string = source.str();
+		const char * source_pointer = source_string.c_str();
+
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 1, &source_pointer, NULL);
+		glCompileShader(shader);
+
+		int success;
+		char info_log[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 512, NULL, info_log);
+			glDeleteShader(shader);
+			std::cout << "ERROR::SHADER::DEFERRED_LIGHTING::COMPILATION_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("deferred lighting shader could not be compiled");
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glDeleteShader(shader);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(program, 512, NULL, info_log);
+			glDeleteProgram(program);
+			std::cout << "ERROR::SHADER::DEFERRED_LIGHTING::LINKING_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("deferred lighting shader could not be linked");
+		}
+		return program;
+	}
+}
+
+DeferredRenderer::DeferredRenderer(ScreenResolution resolution) : resolution(resolution), render_resolution(resolution)
+{
+	FrameBufferConfiguration config = getGBufferConfiguration();
+	this->gbuffer = std::make_unique<FrameBuffer>(config, resolution);
+	this->gbuffer->setDebugName("G-buffer");
+	this->lighting_program = createLightingProgram();
+	this->inverse_projection_location = glGetUniformLocation(this->lighting_program, "inverse_projection");
+	this->render_size_location = glGetUniformLocation(this->lighting_program, "render_size");
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+	if (this->lighting_program != 0) GLStateCache::getInstance().deleteProgram(this->lighting_program);
+}
+
+void DeferredRenderer::setRenderResolution(ScreenResolution render_resolution)
+{
+	this->render_resolution = ScreenResolution(
+		std::clamp(render_resolution.width, 1u, this->resolution.width),
+		std::clamp(render_resolution.height, 1u, this->resolution.height));
+}
+
+ScreenResolution DeferredRenderer::getRenderResolution()
+{
+	return this->render_resolution;
+}
+
+FrameBufferConfiguration DeferredRenderer::getGBufferConfiguration()
+{
+	FrameBufferConfiguration config;
+	config.color_formats = { GL_RGBA8, GL_RG16, GL_RGBA8, GL_R11F_G11F_B10F };
+	config.use_depth_buffer = true;
+	config.sample_depth_buffer = true;
+	return config;
+}
+
+std::string DeferredRenderer::getGLSLInterface()
+{
+	std::stringstream glsl;
+	glsl << "layout(location = " << ALBEDO << ") out vec4 gbuffer_albedo;\n"
+		<< "layout(location = " << NORMAL << ") out vec2 gbuffer_normal;\n"
+		<< "layout(location = " << ORM << ") out vec4 gbuffer_orm;\n"
+		<< "layout(location = " << LIGHTING << ") out vec3 gbuffer_lighting;\n"
+		<< "\n"
+		<< "vec2 encodeOctahedral(vec3 n) {\n"
+		<< "\tn /= abs(n.x) + abs(n.y) + abs(n.z);\n"
+		<< "\tvec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);\n"
+		<< "\treturn e * 0.5 + 0.5;\n"
+		<< "}\n"
+		<< "\n"
+		<< "// normal in world space, emission includes the ambient light of the surface\n"
+		<< "void writeGBuffer(vec3 albedo, vec3 normal, float ao, float roughness, float metallic, vec3 emission) {\n"
+		<< "\tgbuffer_albedo = vec4(albedo, 1.0);\n"
+		<< "\tgbuffer_normal = encodeOctahedral(normalize(normal));\n"
+		<< "\tgbuffer_orm = vec4(ao, roughness, metallic, 1.0);\n"
+		<< "\tgbuffer_lighting = emission;\n"
+		<< "}\n";
+	return glsl.str();
+}
+
+void DeferredRenderer::drawGeometryPass(Scene & scene, ShaderConfiguration * configuration, const std::vector<GLuint> & shader_ids)
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	this->gbuffer->use();
+	state.setViewport(0, 0, this->render_resolution.width, this->render_resolution.height);
+	state.setDepthMask(true);
+	state.setColorMask(true);
+
+	const GLfloat zero[4] = { 0.f, 0.f, 0.f, 0.f };
+	const GLfloat far_depth = 1.f;
+	for (GLint i = 0; i <= static_cast<GLint>(LIGHTING); ++i)
+	{
+		glClearBufferfv(GL_COLOR, i, zero);
+	}
+	glClearBufferfv(GL_DEPTH, 0, &far_depth);
+
+	scene.drawDepthPrePass(configuration, shader_ids);
+	for (GLuint shader_id : shader_ids)
+	{
+		scene.drawObjects(configuration, shader_id);
+	}
+}
+
+void DeferredRenderer::drawLightingPass(const glm::mat4 & projection)
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	state.useProgram(this->lighting_program);
+	glUniformMatrix4fv(this->inverse_projection_location, 1, GL_FALSE, glm::value_ptr(glm::inverse(projection)));
+	glUniform2i(this->render_size_location, static_cast<GLint>(this->render_resolution.width), static_cast<GLint>(this->render_resolution.height));
+
+	for (GLuint unit : { ALBEDO, NORMAL, ORM })
+	{
+		state.bindTexture(unit, GL_TEXTURE_2D, this->gbuffer->getColorBufferID(unit));
+	}
+	state.bindTexture(DEPTH_TEXTURE_UNIT, GL_TEXTURE_2D, this->gbuffer->getDepthBufferID().value());
+	glBindImageTexture(0, getLightingTexture(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_R11F_G11F_B10F);
+
+	glDispatchCompute((this->render_resolution.width + TILE_SIZE - 1) / TILE_SIZE, (this->render_resolution.height + TILE_SIZE - 1) / TILE_SIZE, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+FrameBuffer & DeferredRenderer::getGBuffer()
+{
+	return *this->gbuffer;
+}
+
+GLuint DeferredRenderer::getLightingTexture()
+{
+	return this->gbuffer->getColorBufferID(LIGHTING);
+}
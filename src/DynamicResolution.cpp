@@ -0,0 +1,126 @@
+#include <GLRF/DynamicResolution.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// weight of a new measurement in the smoothed frame time
+	const float SMOOTHING = 0.2f;
+	const float TOLERANCE = 0.05f;
+	const float MAX_STEP = 0.1f;
+}
+
+DynamicResolution::DynamicResolution(ScreenResolution max_resolution, float target_frame_time, float min_scale)
+	: max_resolution(max_resolution), target_frame_time(target_frame_time), min_scale(min_scale)
+{
+	for (TimerQuery & query : this->queries)
+	{
+		glGenQueries(1, &(query.ID));
+	}
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	for (TimerQuery & query : this->queries)
+	{
+		glDeleteQueries(1, &(query.ID));
+	}
+}
+
+void DynamicResolution::beginFrame()
+{
+	collectResults();
+	// all queries are in flight, this frame is not measured instead of waiting for a result
+	if (this->queries[this->current_query].pending) return;
+	glBeginQuery(GL_TIME_ELAPSED, this->queries[this->current_query].ID);
+	this->measuring = true;
+}
+
+void DynamicResolution::endFrame()
+{
+	if (!this->measuring) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	this->queries[this->current_query].pending = true;
+	this->current_query = (this->current_query + 1) % QUERY_COUNT;
+	this->measuring = false;
+}
+
+void DynamicResolution::collectResults()
+{
+	// results become available in the order the queries were issued, starting at the oldest one
+	float newest = -1.0f;
+	for (size_t i = 0; i < QUERY_COUNT; ++i)
+	{
+		TimerQuery & query = this->queries[(this->current_query + i) % QUERY_COUNT];
+		if (!query.pending) continue;
+
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(query.ID, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) break;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.ID, GL_QUERY_RESULT, &nanoseconds);
+		query.pending = false;
+
+		newest = static_cast<float>(nanoseconds) / 1000000.0f;
+	}
+	if (newest < 0.0f) return;
+
+	// several results can arrive in one frame, but the scale only changes once per frame, based on the newest one
+	this->frame_time = this->frame_time > 0.0f ? this->frame_time + SMOOTHING * (newest - this->frame_time) : newest;
+	this->scale = computeScale(this->scale, this->frame_time, this->target_frame_time, this->min_scale);
+}
+
+float DynamicResolution::computeScale(float scale, float frame_time, float target_frame_time, float min_scale)
+{
+	if (frame_time <= 0.0f || target_frame_time <= 0.0f) return scale;
+	const float ratio = target_frame_time / frame_time;
+	if (std::abs(ratio - 1.0f) < TOLERANCE) return scale;
+
+	float next = scale * std::sqrt(ratio);
+	next = std::clamp(next, scale * (1.0f - MAX_STEP), scale * (1.0f + MAX_STEP));
+	return std::clamp(next, min_scale, 1.0f);
+}
+
+void DynamicResolution::use(FrameBuffer & frame_buffer)
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	state.bindFramebuffer(frame_buffer.getID());
+	const ScreenResolution scaled = getScaledResolution();
+	state.setViewport(0, 0, scaled.width, scaled.height);
+}
+
+void DynamicResolution::blitToScreen(FrameBuffer & frame_buffer, ScreenResolution output)
+{
+	const ScreenResolution scaled = getScaledResolution();
+	GLResources::blitFramebuffer(frame_buffer.getID(), 0, 0, 0, scaled.width, scaled.height,
+		0, 0, output.width, output.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	GLStateCache::getInstance().setViewport(0, 0, output.width, output.height);
+}
+
+float DynamicResolution::getScale()
+{
+	return this->scale;
+}
+
+ScreenResolution DynamicResolution::getScaledResolution()
+{
+	return ScreenResolution(
+		std::max(1u, static_cast<unsigned int>(std::lround(this->max_resolution.width * this->scale))),
+		std::max(1u, static_cast<unsigned int>(std::lround(this->max_resolution.height * this->scale))));
+}
+
+float DynamicResolution::getFrameTime()
+{
+	return this->frame_time;
+}
+
+void DynamicResolution::setTargetFrameTime(float target_frame_time)
+{
+	this->target_frame_time = target_frame_time;
+}
@@ -0,0 +1,572 @@
+#include <GLRF/EnvironmentBaker.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <GLRF/MipGenerator.hpp>
+#include <GLRF/ThreadPool.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GLRF_IBL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GLRF_IBL_TARGET_AVX2
+#else
+#define GLRF_IBL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+using namespace GLRF;
+
+namespace {
+	const double PI = 3.14159265358979323846;
+	// irradiance only contains low frequencies, so it is projected from a coarse level
+	const GLsizei IRRADIANCE_SIZE = 64;
+
+	// the direction of the face coordinates s, t in [-1, 1] is N + s * U + t * V, rows grow along t
+	const float FACE_BASIS[6][3][3] = {
+		{ {  1.f,  0.f,  0.f }, {  0.f, 0.f, -1.f }, { 0.f, -1.f,  0.f } },
+		{ { -1.f,  0.f,  0.f }, {  0.f, 0.f,  1.f }, { 0.f, -1.f,  0.f } },
+		{ {  0.f,  1.f,  0.f }, {  1.f, 0.f,  0.f }, { 0.f,  0.f,  1.f } },
+		{ {  0.f, -1.f,  0.f }, {  1.f, 0.f,  0.f }, { 0.f,  0.f, -1.f } },
+		{ {  0.f,  0.f,  1.f }, {  1.f, 0.f,  0.f }, { 0.f, -1.f,  0.f } },
+		{ {  0.f,  0.f, -1.f }, { -1.f, 0.f,  0.f }, { 0.f, -1.f,  0.f } }
+	};
+
+	/**
+	 * Importance samples of the GGX lobe around the z-axis, stored as separate arrays for the SIMD kernel.
+	 */
+	struct SampleSet {
+		std::vector<float> x, y, z;
+		std::vector<float> weight;
+		std::vector<float> lod;
+	};
+
+	void faceDirection(GLuint face, float s, float t, float * direction)
+	{
+		const float (*basis)[3] = FACE_BASIS[face];
+		float length_sq = 0.f;
+		for (int c = 0; c < 3; ++c)
+		{
+			direction[c] = basis[0][c] + s * basis[1][c] + t * basis[2][c];
+			length_sq += direction[c] * direction[c];
+		}
+		const float inv_length = 1.f / std::sqrt(length_sq);
+		for (int c = 0; c < 3; ++c) direction[c] *= inv_length;
+	}
+
+	/**
+	 * Selects the face of a direction and its texture coordinates in [0, 1] like the OpenGL cube map lookup does.
+	 */
+	void projectDirection(float x, float y, float z, int & face, float & u, float & v)
+	{
+		const float ax = std::abs(x), ay = std::abs(y), az = std::abs(z);
+		float sc, tc, ma;
+		if (ax >= ay && ax >= az) {
+			face = (x >= 0.f) ? 0 : 1;
+			sc = (x >= 0.f) ? -z : z;
+			tc = -y;
+			ma = ax;
+		} else if (ay >= az) {
+			face = (y >= 0.f) ? 2 : 3;
+			sc = x;
+			tc = (y >= 0.f) ? z : -z;
+			ma = ay;
+		} else {
+			face = (z >= 0.f) ? 4 : 5;
+			sc = (z >= 0.f) ? x : -x;
+			tc = -y;
+			ma = az;
+		}
+		const float scale = 0.5f / ma;
+		u = sc * scale + 0.5f;
+		v = tc * scale + 0.5f;
+	}
+
+	void sampleFace(const float * texels, GLsizei size, float u, float v, float weight, float * rgb)
+	{
+		const float max_coordinate = static_cast<float>(size - 1);
+		const float fx = std::min(std::max(u * size - 0.5f, 0.f), max_coordinate);
+		const float fy = std::min(std::max(v * size - 0.5f, 0.f), max_coordinate);
+		const GLsizei x0 = static_cast<GLsizei>(fx), y0 = static_cast<GLsizei>(fy);
+		const GLsizei x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+		const float wx = fx - x0, wy = fy - y0;
+		const float * t00 = texels + 3 * (static_cast<size_t>(y0) * size + x0);
+		const float * t10 = texels + 3 * (static_cast<size_t>(y0) * size + x1);
+		const float * t01 = texels + 3 * (static_cast<size_t>(y1) * size + x0);
+		const float * t11 = texels + 3 * (static_cast<size_t>(y1) * size + x1);
+		for (int c = 0; c < 3; ++c)
+		{
+			const float top = t00[c] + (t10[c] - t00[c]) * wx;
+			const float bottom = t01[c] + (t11[c] - t01[c]) * wx;
+			rgb[c] += weight * (top + (bottom - top) * wy);
+		}
+	}
+
+	/**
+	 * Trilinear lookup inside a single face, seams between faces are not filtered.
+	 */
+	void sampleCube(const CubeMapData & cube, int face, float u, float v, float lod, float weight, float * rgb)
+	{
+		lod = std::min(std::max(lod, 0.f), static_cast<float>(cube.levels - 1));
+		const GLuint level = static_cast<GLuint>(lod);
+		const float fraction = lod - level;
+		sampleFace(cube.getFace(level, face), cube.getLevelSize(level), u, v, weight * (1.f - fraction), rgb);
+		if (fraction > 0.f && level + 1 < cube.levels) {
+			sampleFace(cube.getFace(level + 1, face), cube.getLevelSize(level + 1), u, v, weight * fraction, rgb);
+		}
+	}
+
+	void sampleEquirectangular(const float * pixels, int width, int height, float u, float v, float * rgb)
+	{
+		const float fx = u * width - 0.5f;
+		const float fy = std::min(std::max(v * height - 0.5f, 0.f), static_cast<float>(height - 1));
+		const float floor_x = std::floor(fx);
+		const float wx = fx - floor_x;
+		// the longitude wraps around
+		const int x0 = ((static_cast<int>(floor_x) % width) + width) % width;
+		const int x1 = (x0 + 1) % width;
+		const int y0 = static_cast<int>(fy), y1 = std::min(y0 + 1, height - 1);
+		const float wy = fy - y0;
+		const float * t00 = pixels + 3 * (static_cast<size_t>(y0) * width + x0);
+		const float * t10 = pixels + 3 * (static_cast<size_t>(y0) * width + x1);
+		const float * t01 = pixels + 3 * (static_cast<size_t>(y1) * width + x0);
+		const float * t11 = pixels + 3 * (static_cast<size_t>(y1) * width + x1);
+		for (int c = 0; c < 3; ++c)
+		{
+			const float top = t00[c] + (t10[c] - t00[c]) * wx;
+			const float bottom = t01[c] + (t11[c] - t01[c]) * wx;
+			rgb[c] = top + (bottom - top) * wy;
+		}
+	}
+
+	float radicalInverse(std::uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	/**
+	 * The i-th half vector of a Hammersley sequence that is distributed like the GGX lobe around the z-axis.
+	 */
+	void sampleGGX(GLuint i, GLuint count, float alpha, float * h)
+	{
+		const float phi = static_cast<float>(2.0 * PI) * (static_cast<float>(i) / count);
+		const float xi = radicalInverse(i);
+		const float cos_theta = std::sqrt((1.f - xi) / (1.f + (alpha * alpha - 1.f) * xi));
+		const float sin_theta = std::sqrt(std::max(1.f - cos_theta * cos_theta, 0.f));
+		h[0] = sin_theta * std::cos(phi);
+		h[1] = sin_theta * std::sin(phi);
+		h[2] = cos_theta;
+	}
+
+	/**
+	 * Creates the light directions for a lobe with n = v = r and the source level each of them reads from.
+	 * Samples with a low probability cover a large solid angle, so they read from a coarser level (GPU Gems 3, 20.4).
+	 */
+	SampleSet createSampleSet(float roughness, GLuint count, const CubeMapData & cube)
+	{
+		SampleSet set;
+		const float alpha = roughness * roughness;
+		const double texel_solid_angle = 4.0 * PI / (6.0 * cube.size * cube.size);
+		for (GLuint i = 0; i < count; ++i)
+		{
+			float h[3];
+			sampleGGX(i, count, alpha, h);
+			const float n_dot_l = 2.f * h[2] * h[2] - 1.f;
+			if (n_dot_l <= 0.f) continue;
+
+			const double denominator = h[2] * h[2] * (alpha * alpha - 1.0) + 1.0;
+			const double distribution = alpha * alpha / (PI * denominator * denominator);
+			const double pdf = distribution / 4.0;
+			const double sample_solid_angle = 1.0 / (count * pdf + 1e-9);
+			const double lod = 0.5 * std::log2(sample_solid_angle / texel_solid_angle) + 1.0;
+
+			set.x.push_back(2.f * h[2] * h[0]);
+			set.y.push_back(2.f * h[2] * h[1]);
+			set.z.push_back(n_dot_l);
+			set.weight.push_back(n_dot_l);
+			set.lod.push_back(static_cast<float>(std::max(lod, 0.0)));
+		}
+		return set;
+	}
+
+	void createTangentFrame(const float * n, float * t, float * b)
+	{
+		float axis[3] = { 0.f, 0.f, 1.f };
+		if (std::abs(n[2]) > 0.999f) {
+			axis[0] = 1.f;
+			axis[2] = 0.f;
+		}
+		t[0] = axis[1] * n[2] - axis[2] * n[1];
+		t[1] = axis[2] * n[0] - axis[0] * n[2];
+		t[2] = axis[0] * n[1] - axis[1] * n[0];
+		const float inv_length = 1.f / std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+		for (int c = 0; c < 3; ++c) t[c] *= inv_length;
+		b[0] = n[1] * t[2] - n[2] * t[1];
+		b[1] = n[2] * t[0] - n[0] * t[2];
+		b[2] = n[0] * t[1] - n[1] * t[0];
+	}
+
+	void projectSamples(const SampleSet & set, size_t begin, const float * t, const float * b, const float * n,
+		int * faces, float * us, float * vs)
+	{
+		for (size_t i = begin; i < set.x.size(); ++i)
+		{
+			const float x = set.x[i] * t[0] + set.y[i] * b[0] + set.z[i] * n[0];
+			const float y = set.x[i] * t[1] + set.y[i] * b[1] + set.z[i] * n[1];
+			const float z = set.x[i] * t[2] + set.y[i] * b[2] + set.z[i] * n[2];
+			projectDirection(x, y, z, faces[i], us[i], vs[i]);
+		}
+	}
+
+#ifdef GLRF_IBL_X86
+	/**
+	 * Rotates 8 samples at once into the tangent frame of the texel and selects their faces without branches.
+	 */
+	GLRF_IBL_TARGET_AVX2 void projectSamplesAVX2(const SampleSet & set, const float * t, const float * b, const float * n,
+		int * faces, float * us, float * vs)
+	{
+		const size_t count = set.x.size();
+		const __m256 sign = _mm256_set1_ps(-0.f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 t0 = _mm256_set1_ps(t[0]), t1 = _mm256_set1_ps(t[1]), t2 = _mm256_set1_ps(t[2]);
+		const __m256 b0 = _mm256_set1_ps(b[0]), b1 = _mm256_set1_ps(b[1]), b2 = _mm256_set1_ps(b[2]);
+		const __m256 n0 = _mm256_set1_ps(n[0]), n1 = _mm256_set1_ps(n[1]), n2 = _mm256_set1_ps(n[2]);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 sx = _mm256_loadu_ps(set.x.data() + i);
+			const __m256 sy = _mm256_loadu_ps(set.y.data() + i);
+			const __m256 sz = _mm256_loadu_ps(set.z.data() + i);
+			const __m256 x = _mm256_fmadd_ps(sz, n0, _mm256_fmadd_ps(sy, b0, _mm256_mul_ps(sx, t0)));
+			const __m256 y = _mm256_fmadd_ps(sz, n1, _mm256_fmadd_ps(sy, b1, _mm256_mul_ps(sx, t1)));
+			const __m256 z = _mm256_fmadd_ps(sz, n2, _mm256_fmadd_ps(sy, b2, _mm256_mul_ps(sx, t2)));
+			const __m256 ax = _mm256_andnot_ps(sign, x), ay = _mm256_andnot_ps(sign, y), az = _mm256_andnot_ps(sign, z);
+			const __m256 neg_x = _mm256_xor_ps(x, sign), neg_y = _mm256_xor_ps(y, sign), neg_z = _mm256_xor_ps(z, sign);
+			const __m256 x_positive = _mm256_cmp_ps(x, zero, _CMP_GE_OQ);
+			const __m256 y_positive = _mm256_cmp_ps(y, zero, _CMP_GE_OQ);
+			const __m256 z_positive = _mm256_cmp_ps(z, zero, _CMP_GE_OQ);
+			const __m256 x_major = _mm256_and_ps(_mm256_cmp_ps(ax, ay, _CMP_GE_OQ), _mm256_cmp_ps(ax, az, _CMP_GE_OQ));
+			const __m256 y_major = _mm256_andnot_ps(x_major, _mm256_cmp_ps(ay, az, _CMP_GE_OQ));
+
+			// start with the z-major case and overwrite the lanes of the other cases
+			__m256 face = _mm256_blendv_ps(_mm256_set1_ps(5.f), _mm256_set1_ps(4.f), z_positive);
+			__m256 sc = _mm256_blendv_ps(neg_x, x, z_positive);
+			__m256 tc = neg_y;
+			__m256 ma = az;
+
+			face = _mm256_blendv_ps(face, _mm256_blendv_ps(_mm256_set1_ps(3.f), _mm256_set1_ps(2.f), y_positive), y_major);
+			sc = _mm256_blendv_ps(sc, x, y_major);
+			tc = _mm256_blendv_ps(tc, _mm256_blendv_ps(neg_z, z, y_positive), y_major);
+			ma = _mm256_blendv_ps(ma, ay, y_major);
+
+			face = _mm256_blendv_ps(face, _mm256_blendv_ps(_mm256_set1_ps(1.f), zero, x_positive), x_major);
+			sc = _mm256_blendv_ps(sc, _mm256_blendv_ps(z, neg_z, x_positive), x_major);
+			tc = _mm256_blendv_ps(tc, neg_y, x_major);
+			ma = _mm256_blendv_ps(ma, ax, x_major);
+
+			const __m256 scale = _mm256_div_ps(half, ma);
+			_mm256_storeu_ps(us + i, _mm256_fmadd_ps(sc, scale, half));
+			_mm256_storeu_ps(vs + i, _mm256_fmadd_ps(tc, scale, half));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(faces + i), _mm256_cvttps_epi32(face));
+		}
+		projectSamples(set, i, t, b, n, faces, us, vs);
+	}
+#endif
+
+	double areaElement(double x, double y)
+	{
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0));
+	}
+
+	/**
+	 * The exact solid angle that a texel of a cube map face covers.
+	 */
+	double texelSolidAngle(GLsizei x, GLsizei y, GLsizei size)
+	{
+		const double x0 = 2.0 * x / size - 1.0, x1 = 2.0 * (x + 1) / size - 1.0;
+		const double y0 = 2.0 * y / size - 1.0, y1 = 2.0 * (y + 1) / size - 1.0;
+		return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+	}
+
+	void evaluateBasis(const float * d, float * basis)
+	{
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * d[1];
+		basis[2] = 0.488603f * d[2];
+		basis[3] = 0.488603f * d[0];
+		basis[4] = 1.092548f * d[0] * d[1];
+		basis[5] = 1.092548f * d[1] * d[2];
+		basis[6] = 0.315392f * (3.f * d[2] * d[2] - 1.f);
+		basis[7] = 1.092548f * d[0] * d[2];
+		basis[8] = 0.546274f * (d[0] * d[0] - d[1] * d[1]);
+	}
+}
+
+CubeMapData::CubeMapData()
+{
+
+}
+
+CubeMapData::CubeMapData(GLsizei size, GLuint levels)
+{
+	this->size = size;
+	this->levels = levels;
+	this->texels.resize(getOffset(levels, 0));
+}
+
+bool CubeMapData::isEmpty() const
+{
+	return this->texels.empty();
+}
+
+GLsizei CubeMapData::getLevelSize(GLuint level) const
+{
+	return std::max(this->size >> level, 1);
+}
+
+size_t CubeMapData::getOffset(GLuint level, GLuint face) const
+{
+	size_t offset = 0;
+	for (GLuint i = 0; i < level; ++i)
+	{
+		const size_t level_size = static_cast<size_t>(getLevelSize(i));
+		offset += 6 * 3 * level_size * level_size;
+	}
+	const size_t level_size = static_cast<size_t>(getLevelSize(level));
+	return offset + face * 3 * level_size * level_size;
+}
+
+const float * CubeMapData::getFace(GLuint level, GLuint face) const
+{
+	return this->texels.data() + getOffset(level, face);
+}
+
+float * CubeMapData::getFace(GLuint level, GLuint face)
+{
+	return this->texels.data() + getOffset(level, face);
+}
+
+EnvironmentBaker::EnvironmentBaker(GLuint sample_count)
+{
+	this->sample_count = std::max(sample_count, 1u);
+}
+
+CubeMapData EnvironmentBaker::convertEquirectangular(const float * pixels, int width, int height, GLsizei size)
+{
+	CubeMapData cube(size, 1);
+	ThreadPool::getInstance().parallelFor(0, 6 * static_cast<size_t>(size), [&](size_t row) {
+		const GLuint face = static_cast<GLuint>(row / size);
+		const GLsizei y = static_cast<GLsizei>(row % size);
+		float * out = cube.getFace(0, face) + 3 * static_cast<size_t>(y) * size;
+		const float t = 2.f * (y + 0.5f) / size - 1.f;
+		for (GLsizei x = 0; x < size; ++x)
+		{
+			float direction[3];
+			faceDirection(face, 2.f * (x + 0.5f) / size - 1.f, t, direction);
+			const float u = static_cast<float>(std::atan2(direction[2], direction[0]) / (2.0 * PI) + 0.5);
+			const float v = static_cast<float>(std::acos(std::min(std::max(direction[1], -1.f), 1.f)) / PI);
+			sampleEquirectangular(pixels, width, height, u, v, out + 3 * x);
+		}
+	});
+	return cube;
+}
+
+void EnvironmentBaker::generateMips(CubeMapData & cube)
+{
+	GLuint levels = 1;
+	while ((cube.size >> levels) > 0) ++levels;
+	// the layout is level after level, so resizing keeps the existing levels in place
+	cube.levels = levels;
+	cube.texels.resize(cube.getOffset(levels, 0));
+
+	ThreadPool & pool = ThreadPool::getInstance();
+	for (GLuint level = 1; level < levels; ++level)
+	{
+		const GLsizei src_size = cube.getLevelSize(level - 1);
+		const GLsizei dst_size = cube.getLevelSize(level);
+		pool.parallelFor(0, 6 * static_cast<size_t>(dst_size), [&](size_t row) {
+			const GLuint face = static_cast<GLuint>(row / dst_size);
+			const GLsizei y = static_cast<GLsizei>(row % dst_size);
+			const float * src = cube.getFace(level - 1, face);
+			float * out = cube.getFace(level, face) + 3 * static_cast<size_t>(y) * dst_size;
+			const GLsizei y0 = std::min(2 * y, src_size - 1), y1 = std::min(2 * y + 1, src_size - 1);
+			for (GLsizei x = 0; x < dst_size; ++x)
+			{
+				const GLsizei x0 = std::min(2 * x, src_size - 1), x1 = std::min(2 * x + 1, src_size - 1);
+				for (int c = 0; c < 3; ++c)
+				{
+					out[3 * x + c] = 0.25f * (src[3 * (static_cast<size_t>(y0) * src_size + x0) + c]
+						+ src[3 * (static_cast<size_t>(y0) * src_size + x1) + c]
+						+ src[3 * (static_cast<size_t>(y1) * src_size + x0) + c]
+						+ src[3 * (static_cast<size_t>(y1) * src_size + x1) + c]);
+				}
+			}
+		});
+	}
+}
+
+EnvironmentBaker::IrradianceSH EnvironmentBaker::projectIrradiance(const CubeMapData & cube)
+{
+	GLuint level = 0;
+	while (level + 1 < cube.levels && cube.getLevelSize(level) > IRRADIANCE_SIZE) ++level;
+	const GLsizei size = cube.getLevelSize(level);
+
+	// every row sums up separately, the rows are reduced in a fixed order so the result is deterministic
+	const size_t coefficients = 3 * SH_COEFFICIENTS;
+	std::vector<double> rows(6 * static_cast<size_t>(size) * coefficients, 0.0);
+	ThreadPool::getInstance().parallelFor(0, 6 * static_cast<size_t>(size), [&](size_t row) {
+		const GLuint face = static_cast<GLuint>(row / size);
+		const GLsizei y = static_cast<GLsizei>(row % size);
+		const float * texels = cube.getFace(level, face) + 3 * static_cast<size_t>(y) * size;
+		double * sum = rows.data() + row * coefficients;
+		const float t = 2.f * (y + 0.5f) / size - 1.f;
+		for (GLsizei x = 0; x < size; ++x)
+		{
+			float direction[3], basis[SH_COEFFICIENTS];
+			faceDirection(face, 2.f * (x + 0.5f) / size - 1.f, t, direction);
+			evaluateBasis(direction, basis);
+			const double solid_angle = texelSolidAngle(x, y, size);
+			for (GLuint i = 0; i < SH_COEFFICIENTS; ++i)
+			{
+				for (int c = 0; c < 3; ++c) sum[3 * i + c] += texels[3 * x + c] * basis[i] * solid_angle;
+			}
+		}
+	});
+
+	std::array<double, 3 * SH_COEFFICIENTS> radiance = {};
+	for (size_t row = 0; row < 6 * static_cast<size_t>(size); ++row)
+	{
+		for (size_t i = 0; i < coefficients; ++i) radiance[i] += rows[row * coefficients + i];
+	}
+	return convolveIrradiance(radiance);
+}
+
+CubeMapData EnvironmentBaker::prefilterSpecular(const CubeMapData & cube, GLsizei size, GLuint levels)
+{
+	CubeMapData result(size, levels);
+	ThreadPool & pool = ThreadPool::getInstance();
+#ifdef GLRF_IBL_X86
+	const bool avx2 = MipGenerator::usesAVX2();
+#endif
+	for (GLuint level = 0; level < levels; ++level)
+	{
+		const GLsizei level_size = result.getLevelSize(level);
+		const float roughness = getLevelRoughness(level, levels);
+		// a perfect mirror reflects the environment, only the resolution changes
+		const float mirror_lod = std::log2(static_cast<float>(cube.size) / level_size);
+		const SampleSet set = (roughness > 0.f) ? createSampleSet(roughness, this->sample_count, cube) : SampleSet();
+		const size_t count = set.x.size();
+
+		pool.parallelFor(0, 6 * static_cast<size_t>(level_size), [&](size_t row) {
+			const GLuint face = static_cast<GLuint>(row / level_size);
+			const GLsizei y = static_cast<GLsizei>(row % level_size);
+			float * out = result.getFace(level, face) + 3 * static_cast<size_t>(y) * level_size;
+			std::vector<int> faces(count);
+			std::vector<float> us(count), vs(count);
+			const float t_coordinate = 2.f * (y + 0.5f) / level_size - 1.f;
+			for (GLsizei x = 0; x < level_size; ++x)
+			{
+				float n[3], t[3], b[3];
+				faceDirection(face, 2.f * (x + 0.5f) / level_size - 1.f, t_coordinate, n);
+				float rgb[3] = { 0.f, 0.f, 0.f };
+				if (count == 0) {
+					int sample_face;
+					float u, v;
+					projectDirection(n[0], n[1], n[2], sample_face, u, v);
+					sampleCube(cube, sample_face, u, v, mirror_lod, 1.f, rgb);
+					std::copy(rgb, rgb + 3, out + 3 * x);
+					continue;
+				}
+
+				createTangentFrame(n, t, b);
+#ifdef GLRF_IBL_X86
+				if (avx2) projectSamplesAVX2(set, t, b, n, faces.data(), us.data(), vs.data());
+				else projectSamples(set, 0, t, b, n, faces.data(), us.data(), vs.data());
+#else
+				projectSamples(set, 0, t, b, n, faces.data(), us.data(), vs.data());
+#endif
+				float total_weight = 0.f;
+				for (size_t i = 0; i < count; ++i)
+				{
+					sampleCube(cube, faces[i], us[i], vs[i], set.lod[i], set.weight[i], rgb);
+					total_weight += set.weight[i];
+				}
+				for (int c = 0; c < 3; ++c) out[3 * x + c] = rgb[c] / total_weight;
+			}
+		});
+	}
+	return result;
+}
+
+std::vector<float> EnvironmentBaker::integrateBRDF(GLsizei size)
+{
+	std::vector<float> lut(2 * static_cast<size_t>(size) * size);
+	const GLuint count = this->sample_count;
+	ThreadPool::getInstance().parallelFor(0, static_cast<size_t>(size), [&](size_t y) {
+		const float roughness = (y + 0.5f) / size;
+		const float alpha = roughness * roughness;
+		// Schlick-Smith geometry term with the remapping for image based lighting
+		const float k = alpha / 2.f;
+		for (GLsizei x = 0; x < size; ++x)
+		{
+			const float n_dot_v = (x + 0.5f) / size;
+			const float v[3] = { std::sqrt(1.f - n_dot_v * n_dot_v), 0.f, n_dot_v };
+			double scale = 0.0, bias = 0.0;
+			for (GLuint i = 0; i < count; ++i)
+			{
+				float h[3];
+				sampleGGX(i, count, alpha, h);
+				const float v_dot_h = v[0] * h[0] + v[1] * h[1] + v[2] * h[2];
+				const float n_dot_l = 2.f * v_dot_h * h[2] - v[2];
+				if (n_dot_l <= 0.f) continue;
+
+				const float n_dot_h = std::max(h[2], 0.f);
+				const float g = (n_dot_v / (n_dot_v * (1.f - k) + k)) * (n_dot_l / (n_dot_l * (1.f - k) + k));
+				const float g_visibility = g * std::max(v_dot_h, 0.f) / (n_dot_h * n_dot_v);
+				const float fresnel = std::pow(1.f - std::max(v_dot_h, 0.f), 5.f);
+				scale += (1.f - fresnel) * g_visibility;
+				bias += fresnel * g_visibility;
+			}
+			float * texel = lut.data() + 2 * (y * size + x);
+			texel[0] = static_cast<float>(scale / count);
+			texel[1] = static_cast<float>(bias / count);
+		}
+	});
+	return lut;
+}
+
+EnvironmentBaker::IrradianceSH EnvironmentBaker::convolveIrradiance(const std::array<double, 3 * SH_COEFFICIENTS> & radiance)
+{
+	// the clamped cosine lobe scales the bands by pi, 2 pi / 3 and pi / 4, the division by pi is included
+	const double band_factors[SH_COEFFICIENTS] = { 1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25, 0.25, 0.25, 0.25, 0.25 };
+	IrradianceSH sh;
+	for (GLuint i = 0; i < SH_COEFFICIENTS; ++i)
+	{
+		for (int c = 0; c < 3; ++c) sh[3 * i + c] = static_cast<float>(radiance[3 * i + c] * band_factors[i]);
+	}
+	return sh;
+}
+
+void EnvironmentBaker::evaluateIrradiance(const IrradianceSH & sh, const float * direction, float * rgb)
+{
+	float basis[SH_COEFFICIENTS];
+	evaluateBasis(direction, basis);
+	for (int c = 0; c < 3; ++c)
+	{
+		rgb[c] = 0.f;
+		for (GLuint i = 0; i < SH_COEFFICIENTS; ++i) rgb[c] += sh[3 * i + c] * basis[i];
+	}
+}
+
+float EnvironmentBaker::getLevelRoughness(GLuint level, GLuint levels)
+{
+	return (levels > 1) ? static_cast<float>(level) / (levels - 1) : 0.f;
+}
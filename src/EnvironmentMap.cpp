@@ -0,0 +1,655 @@
+#include <GLRF/EnvironmentMap.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include <stb/stb_image.h>
+
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+#include <GLRF/Hash.hpp>
+#include <GLRF/ImageData.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// bump whenever the baked results change, so outdated cache files are ignored
+	const std::uint32_t CACHE_VERSION = 1;
+	const char ENVIRONMENT_MAGIC[8] = { 'G', 'L', 'R', 'F', 'I', 'B', 'L', '\0' };
+	const char BRDF_MAGIC[8] = { 'G', 'L', 'R', 'F', 'B', 'R', 'D', 'F' };
+	const GLsizei IRRADIANCE_SIZE = 64;
+	const GLuint WORKGROUP_SIZE = 8;
+
+	struct EnvironmentCacheHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t cube_size;
+		std::uint32_t specular_size;
+		std::uint32_t specular_levels;
+		float irradiance_sh[3 * EnvironmentBaker::SH_COEFFICIENTS];
+	};
+
+	struct BRDFCacheHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t size;
+	};
+
+	const char * COMPUTE_COMMON = R"(#version 430
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+const float PI = 3.14159265358979;
+vec3 cubeDirection(uint face, vec2 st) {
+	switch (face) {
+	case 0u: return normalize(vec3(1.0, -st.y, -st.x));
+	case 1u: return normalize(vec3(-1.0, -st.y, st.x));
+	case 2u: return normalize(vec3(st.x, 1.0, st.y));
+	case 3u: return normalize(vec3(st.x, -1.0, -st.y));
+	case 4u: return normalize(vec3(st.x, -st.y, 1.0));
+	}
+	return normalize(vec3(-st.x, -st.y, -1.0));
+}
+vec3 sampleGGX(uint i, uint count, float alpha) {
+	float phi = 2.0 * PI * float(i) / float(count);
+	float xi = float(bitfieldReverse(i)) * 2.3283064365386963e-10;
+	float cos_theta = sqrt((1.0 - xi) / (1.0 + (alpha * alpha - 1.0) * xi));
+	float sin_theta = sqrt(max(1.0 - cos_theta * cos_theta, 0.0));
+	return vec3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta);
+}
+)";
+
+	const char * EQUIRECTANGULAR_SOURCE = R"(
+uniform sampler2D equirectangular;
+uniform int size;
+layout(rgba16f, binding = 0) writeonly uniform imageCube target;
+void main() {
+	ivec3 id = ivec3(gl_GlobalInvocationID);
+	if (id.x >= size || id.y >= size) return;
+	vec3 direction = cubeDirection(uint(id.z), (vec2(id.xy) + 0.5) / float(size) * 2.0 - 1.0);
+	vec2 uv = vec2(atan(direction.z, direction.x) / (2.0 * PI) + 0.5, acos(clamp(direction.y, -1.0, 1.0)) / PI);
+	imageStore(target, id, vec4(textureLod(equirectangular, uv, 0.0).rgb, 1.0));
+}
+)";
+
+	const char * IRRADIANCE_SOURCE = R"(
+uniform samplerCube environment;
+uniform float lod;
+uniform int size;
+layout(std430, binding = 0) writeonly buffer IrradianceSums {
+	vec4 sums[];
+};
+shared vec3 partial[64][9];
+float areaElement(float x, float y) {
+	return atan(x * y, sqrt(x * x + y * y + 1.0));
+}
+void main() {
+	ivec3 id = ivec3(gl_GlobalInvocationID);
+	uint local = gl_LocalInvocationIndex;
+	for (int i = 0; i < 9; ++i) partial[local][i] = vec3(0.0);
+	if (id.x < size && id.y < size) {
+		vec3 d = cubeDirection(uint(id.z), (vec2(id.xy) + 0.5) / float(size) * 2.0 - 1.0);
+		vec2 c0 = vec2(id.xy) / float(size) * 2.0 - 1.0;
+		vec2 c1 = vec2(id.xy + 1) / float(size) * 2.0 - 1.0;
+		float solid_angle = areaElement(c0.x, c0.y) - areaElement(c0.x, c1.y) - areaElement(c1.x, c0.y) + areaElement(c1.x, c1.y);
+		vec3 radiance = textureLod(environment, d, lod).rgb * solid_angle;
+		partial[local][0] = radiance * 0.282095;
+		partial[local][1] = radiance * 0.488603 * d.y;
+		partial[local][2] = radiance * 0.488603 * d.z;
+		partial[local][3] = radiance * 0.488603 * d.x;
+		partial[local][4] = radiance * 1.092548 * d.x * d.y;
+		partial[local][5] = radiance * 1.092548 * d.y * d.z;
+		partial[local][6] = radiance * 0.315392 * (3.0 * d.z * d.z - 1.0);
+		partial[local][7] = radiance * 1.092548 * d.x * d.z;
+		partial[local][8] = radiance * 0.546274 * (d.x * d.x - d.y * d.y);
+	}
+	barrier();
+	if (local == 0u) {
+		uint group = gl_WorkGroupID.x + gl_NumWorkGroups.x * (gl_WorkGroupID.y + gl_NumWorkGroups.y * gl_WorkGroupID.z);
+		for (int i = 0; i < 9; ++i) {
+			vec3 sum = vec3(0.0);
+			for (uint j = 0u; j < 64u; ++j) sum += partial[j][i];
+			sums[group * 9u + uint(i)] = vec4(sum, 0.0);
+		}
+	}
+}
+)";
+
+	const char * PREFILTER_SOURCE = R"(
+uniform samplerCube environment;
+uniform float environment_size;
+uniform float roughness;
+uniform int size;
+uniform uint sample_count;
+layout(rgba16f, binding = 0) writeonly uniform imageCube target;
+void main() {
+	ivec3 id = ivec3(gl_GlobalInvocationID);
+	if (id.x >= size || id.y >= size) return;
+	vec3 n = cubeDirection(uint(id.z), (vec2(id.xy) + 0.5) / float(size) * 2.0 - 1.0);
+	if (roughness <= 0.0) {
+		imageStore(target, id, vec4(textureLod(environment, n, log2(environment_size / float(size))).rgb, 1.0));
+		return;
+	}
+	vec3 axis = (abs(n.z) > 0.999) ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0);
+	vec3 t = normalize(cross(axis, n));
+	vec3 b = cross(n, t);
+	float alpha = roughness * roughness;
+	float texel_solid_angle = 4.0 * PI / (6.0 * environment_size * environment_size);
+	vec3 color = vec3(0.0);
+	float total_weight = 0.0;
+	for (uint i = 0u; i < sample_count; ++i) {
+		vec3 h = sampleGGX(i, sample_count, alpha);
+		float n_dot_l = 2.0 * h.z * h.z - 1.0;
+		if (n_dot_l <= 0.0) continue;
+		vec3 l = 2.0 * h.z * (h.x * t + h.y * b + h.z * n) - n;
+		float denominator = h.z * h.z * (alpha * alpha - 1.0) + 1.0;
+		float pdf = alpha * alpha / (PI * denominator * denominator) / 4.0;
+		float lod = max(0.5 * log2(1.0 / (float(sample_count) * pdf + 1e-9) / texel_solid_angle) + 1.0, 0.0);
+		color += textureLod(environment, l, lod).rgb * n_dot_l;
+		total_weight += n_dot_l;
+	}
+	imageStore(target, id, vec4(color / total_weight, 1.0));
+}
+)";
+
+	const char * BRDF_SOURCE = R"(
+uniform int size;
+uniform uint sample_count;
+layout(rg16f, binding = 0) writeonly uniform image2D target;
+void main() {
+	ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+	if (id.x >= size || id.y >= size) return;
+	float n_dot_v = (float(id.x) + 0.5) / float(size);
+	float roughness = (float(id.y) + 0.5) / float(size);
+	float alpha = roughness * roughness;
+	float k = alpha / 2.0;
+	vec3 v = vec3(sqrt(1.0 - n_dot_v * n_dot_v), 0.0, n_dot_v);
+	vec2 result = vec2(0.0);
+	for (uint i = 0u; i < sample_count; ++i) {
+		vec3 h = sampleGGX(i, sample_count, alpha);
+		float v_dot_h = dot(v, h);
+		float n_dot_l = 2.0 * v_dot_h * h.z - v.z;
+		if (n_dot_l <= 0.0) continue;
+		float n_dot_h = max(h.z, 0.0);
+		float g = (n_dot_v / (n_dot_v * (1.0 - k) + k)) * (n_dot_l / (n_dot_l * (1.0 - k) + k));
+		float g_visibility = g * max(v_dot_h, 0.0) / (n_dot_h * n_dot_v);
+		float fresnel = pow(1.0 - max(v_dot_h, 0.0), 5.0);
+		result += vec2((1.0 - fresnel) * g_visibility, fresnel * g_visibility);
+	}
+	imageStore(target, id, vec4(result / float(sample_count), 0.0, 0.0));
+}
+)";
+
+	GLuint createComputeProgram(const char * source, const std::string & name)
+	{
+		const char * sources[2] = { COMPUTE_COMMON, source };
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 2, sources, NULL);
+		glCompileShader(shader);
+
+		int success;
+		char info_log[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 512, NULL, info_log);
+			glDeleteShader(shader);
+			std::cout << "ERROR::SHADER::" << name << "::COMPILATION_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("environment compute shader could not be compiled");
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glDeleteShader(shader);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(program, 512, NULL, info_log);
+			glDeleteProgram(program);
+			std::cout << "ERROR::SHADER::" << name << "::LINKING_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("environment compute shader could not be linked");
+		}
+		return program;
+	}
+
+	GLuint calculateGroupCount(GLsizei size)
+	{
+		return (static_cast<GLuint>(size) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	}
+
+	bool readFile(const std::string & path, std::string & content)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) return false;
+		content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	bool writeFile(const fs::path & file, const std::string & content)
+	{
+		std::error_code error;
+		fs::create_directories(file.parent_path(), error);
+		// written next to the destination and renamed, so a cancelled run never leaves a truncated cache file
+		fs::path temporary = file;
+		temporary += ".tmp";
+		{
+			std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) return false;
+			stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+			if (!stream.good()) return false;
+		}
+		fs::rename(temporary, file, error);
+		return !error;
+	}
+
+	void appendFloats(std::string & content, const float * values, size_t count)
+	{
+		content.append(reinterpret_cast<const char *>(values), count * sizeof(float));
+	}
+}
+
+EnvironmentMap::EnvironmentMap(const std::string & path, EnvironmentConfiguration config)
+{
+	this->config = config;
+	std::string content;
+	if (!readFile(path, content)) {
+		std::cout << "ERROR::ENVIRONMENT_MAP::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+		throw std::runtime_error("environment map could not be read");
+	}
+
+	// the source is hashed instead of its modification time, so copies and renamed files share their cache
+	const std::uint64_t hash = fnv1a64(content, fnv1a64(getParameters()));
+	const fs::path cache_file = this->config.cache_directory / ("environment_" + toHexString(hash) + ".bin");
+	const std::string brdf_parameters = "brdf " + std::to_string(CACHE_VERSION) + " size=" + std::to_string(this->config.brdf_lut_size)
+		+ " samples=" + std::to_string(this->config.sample_count);
+	const fs::path brdf_file = this->config.cache_directory / ("brdf_" + toHexString(fnv1a64(brdf_parameters)) + ".bin");
+
+	GLStateCache::getInstance().setCapability(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+	createTextures();
+	const bool use_compute = this->config.mode == EnvironmentBakeMode::COMPUTE && GLAD_GL_VERSION_4_3;
+
+	CubeMapData environment_data, specular_data;
+	if (loadCache(cache_file, environment_data, specular_data)) {
+		this->cached = true;
+		uploadCube(this->environment, environment_data);
+		uploadCube(this->specular, specular_data);
+	}
+	else
+	{
+		int width, height, channels;
+		float * pixels = stbi_loadf_from_memory(reinterpret_cast<const stbi_uc *>(content.data()), static_cast<int>(content.size()),
+			&width, &height, &channels, 3);
+		if (!pixels) {
+			std::cout << "ERROR::ENVIRONMENT_MAP::DECODING_FAILED: " << path << " (" << stbi_failure_reason() << ")" << std::endl;
+			throw std::runtime_error("environment map could not be decoded");
+		}
+		if (use_compute) {
+			bakeCompute(pixels, width, height, environment_data, specular_data);
+		} else {
+			bakeCPU(pixels, width, height, environment_data, specular_data);
+			uploadCube(this->environment, environment_data);
+			uploadCube(this->specular, specular_data);
+		}
+		stbi_image_free(pixels);
+		saveCache(cache_file, environment_data, specular_data);
+	}
+
+	std::vector<float> lut;
+	if (!loadBRDFCache(brdf_file, lut))
+	{
+		lut = use_compute ? integrateBRDFCompute() : EnvironmentBaker(this->config.sample_count).integrateBRDF(this->config.brdf_lut_size);
+		saveBRDFCache(brdf_file, lut);
+	}
+	GLResources::textureSubImage2D(this->brdf_lut, GL_TEXTURE_2D, 0, 0, 0, this->config.brdf_lut_size, this->config.brdf_lut_size, GL_RG, GL_FLOAT, lut.data());
+}
+
+EnvironmentMap::~EnvironmentMap()
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	if (this->environment != 0) state.deleteTextures(1, &(this->environment));
+	if (this->specular != 0) state.deleteTextures(1, &(this->specular));
+	if (this->brdf_lut != 0) state.deleteTextures(1, &(this->brdf_lut));
+}
+
+std::string EnvironmentMap::getParameters()
+{
+	return "ibl " + std::to_string(CACHE_VERSION) + " cube=" + std::to_string(this->config.cube_size)
+		+ " specular=" + std::to_string(this->config.specular_size) + "x" + std::to_string(this->config.specular_levels)
+		+ " samples=" + std::to_string(this->config.sample_count);
+}
+
+void EnvironmentMap::createTextures()
+{
+	const GLsizei cube_levels = static_cast<GLsizei>(ImageData::calculateMipCount(this->config.cube_size, this->config.cube_size));
+
+	this->environment = GLResources::createTexture(GL_TEXTURE_CUBE_MAP);
+	GLResources::textureStorage2D(this->environment, GL_TEXTURE_CUBE_MAP, cube_levels, GL_RGBA16F, this->config.cube_size, this->config.cube_size);
+
+	this->specular = GLResources::createTexture(GL_TEXTURE_CUBE_MAP);
+	GLResources::textureStorage2D(this->specular, GL_TEXTURE_CUBE_MAP, this->config.specular_levels, GL_RGBA16F,
+		this->config.specular_size, this->config.specular_size);
+
+	for (GLuint texture : { this->environment, this->specular })
+	{
+		GLResources::textureParameteri(texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		GLResources::textureParameteri(texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		GLResources::textureParameteri(texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		GLResources::textureParameteri(texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GLResources::textureParameteri(texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+
+	this->brdf_lut = GLResources::createTexture(GL_TEXTURE_2D);
+	GLResources::textureStorage2D(this->brdf_lut, GL_TEXTURE_2D, 1, GL_RG16F, this->config.brdf_lut_size, this->config.brdf_lut_size);
+	GLResources::textureParameteri(this->brdf_lut, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	GLResources::textureParameteri(this->brdf_lut, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLResources::textureParameteri(this->brdf_lut, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	GLResources::textureParameteri(this->brdf_lut, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void EnvironmentMap::uploadCube(GLuint texture, const CubeMapData & data)
+{
+	for (GLuint level = 0; level < data.levels; ++level)
+	{
+		const GLsizei size = data.getLevelSize(level);
+		for (GLuint face = 0; face < 6; ++face)
+		{
+			GLResources::textureSubImage2D(texture, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, size, size, GL_RGB, GL_FLOAT,
+				data.getFace(level, face));
+		}
+	}
+	// the cache only contains the base level of the environment
+	if (texture == this->environment && data.levels == 1) GLResources::generateMipmap(texture, GL_TEXTURE_CUBE_MAP);
+}
+
+void EnvironmentMap::readCube(GLuint texture, CubeMapData & data)
+{
+	for (GLuint level = 0; level < data.levels; ++level)
+	{
+		const GLsizei size = data.getLevelSize(level);
+		const GLsizei face_bytes = static_cast<GLsizei>(3 * sizeof(float)) * size * size;
+		for (GLuint face = 0; face < 6; ++face)
+		{
+			GLResources::getTextureImage(texture, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, size, size, GL_RGB, GL_FLOAT,
+				face_bytes, data.getFace(level, face));
+		}
+	}
+}
+
+void EnvironmentMap::bakeCPU(const float * pixels, int width, int height, CubeMapData & environment_data, CubeMapData & specular_data)
+{
+	EnvironmentBaker baker(this->config.sample_count);
+	environment_data = baker.convertEquirectangular(pixels, width, height, this->config.cube_size);
+	baker.generateMips(environment_data);
+	this->irradiance_sh = baker.projectIrradiance(environment_data);
+	specular_data = baker.prefilterSpecular(environment_data, this->config.specular_size, this->config.specular_levels);
+}
+
+void EnvironmentMap::bakeCompute(const float * pixels, int width, int height, CubeMapData & environment_data, CubeMapData & specular_data)
+{
+	ShaderManager & shader_manager = ShaderManager::getInstance();
+	GLStateCache & state = GLStateCache::getInstance();
+	const GLsizei cube_size = this->config.cube_size;
+
+	// 1. equirectangular image -> base level of the environment
+	GLuint source = GLResources::createTexture(GL_TEXTURE_2D);
+	GLResources::textureStorage2D(source, GL_TEXTURE_2D, 1, GL_RGB32F, width, height);
+	GLResources::textureSubImage2D(source, GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, pixels);
+	GLResources::textureParameteri(source, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	GLResources::textureParameteri(source, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLResources::textureParameteri(source, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	GLResources::textureParameteri(source, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	state.bindTexture(0, GL_TEXTURE_2D, source);
+	state.bindSampler(0, 0);
+
+	GLuint program = createComputeProgram(EQUIRECTANGULAR_SOURCE, "ENVIRONMENT_EQUIRECTANGULAR");
+	shader_manager.useShader(program);
+	glUniform1i(glGetUniformLocation(program, "equirectangular"), 0);
+	glUniform1i(glGetUniformLocation(program, "size"), cube_size);
+	glBindImageTexture(0, this->environment, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	glDispatchCompute(calculateGroupCount(cube_size), calculateGroupCount(cube_size), 6);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	state.deleteProgram(program);
+	state.deleteTextures(1, &source);
+
+	GLResources::generateMipmap(this->environment, GL_TEXTURE_CUBE_MAP);
+
+	// 2. irradiance, every workgroup sums up its texels and the partial sums are reduced on the CPU
+	GLuint irradiance_level = 0;
+	while ((cube_size >> irradiance_level) > IRRADIANCE_SIZE && (cube_size >> (irradiance_level + 1)) > 0) ++irradiance_level;
+	const GLsizei irradiance_size = cube_size >> irradiance_level;
+	const GLuint groups = calculateGroupCount(irradiance_size);
+	const size_t num_sums = static_cast<size_t>(groups) * groups * 6 * EnvironmentBaker::SH_COEFFICIENTS;
+	GLuint sums_buffer = GLResources::createBuffer();
+	GLResources::bufferData(sums_buffer, num_sums * 4 * sizeof(float), NULL, GL_STREAM_READ);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sums_buffer);
+
+	program = createComputeProgram(IRRADIANCE_SOURCE, "ENVIRONMENT_IRRADIANCE");
+	shader_manager.useShader(program);
+	state.bindTexture(0, GL_TEXTURE_CUBE_MAP, this->environment);
+	glUniform1i(glGetUniformLocation(program, "environment"), 0);
+	glUniform1f(glGetUniformLocation(program, "lod"), static_cast<float>(irradiance_level));
+	glUniform1i(glGetUniformLocation(program, "size"), irradiance_size);
+	glDispatchCompute(groups, groups, 6);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	state.deleteProgram(program);
+
+	std::vector<float> sums(num_sums * 4);
+	GLResources::getBufferSubData(sums_buffer, 0, sums.size() * sizeof(float), sums.data());
+	state.deleteBuffers(1, &sums_buffer);
+	std::array<double, 3 * EnvironmentBaker::SH_COEFFICIENTS> radiance = {};
+	for (size_t i = 0; i < num_sums; ++i)
+	{
+		const size_t coefficient = i % EnvironmentBaker::SH_COEFFICIENTS;
+		for (size_t c = 0; c < 3; ++c) radiance[3 * coefficient + c] += sums[4 * i + c];
+	}
+	this->irradiance_sh = EnvironmentBaker::convolveIrradiance(radiance);
+
+	// 3. specular, one dispatch per roughness level
+	program = createComputeProgram(PREFILTER_SOURCE, "ENVIRONMENT_PREFILTER");
+	shader_manager.useShader(program);
+	glUniform1i(glGetUniformLocation(program, "environment"), 0);
+	glUniform1f(glGetUniformLocation(program, "environment_size"), static_cast<float>(cube_size));
+	glUniform1ui(glGetUniformLocation(program, "sample_count"), this->config.sample_count);
+	for (GLuint level = 0; level < this->config.specular_levels; ++level)
+	{
+		const GLsizei level_size = std::max(this->config.specular_size >> level, 1);
+		glUniform1f(glGetUniformLocation(program, "roughness"), EnvironmentBaker::getLevelRoughness(level, this->config.specular_levels));
+		glUniform1i(glGetUniformLocation(program, "size"), level_size);
+		glBindImageTexture(0, this->specular, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		glDispatchCompute(calculateGroupCount(level_size), calculateGroupCount(level_size), 6);
+	}
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	state.deleteProgram(program);
+	shader_manager.useShader(0);
+
+	// 4. read the results back for the cache
+	environment_data = CubeMapData(cube_size, 1);
+	readCube(this->environment, environment_data);
+	specular_data = CubeMapData(this->config.specular_size, this->config.specular_levels);
+	readCube(this->specular, specular_data);
+}
+
+std::vector<float> EnvironmentMap::integrateBRDFCompute()
+{
+	const GLsizei size = this->config.brdf_lut_size;
+	GLuint program = createComputeProgram(BRDF_SOURCE, "ENVIRONMENT_BRDF");
+	ShaderManager & shader_manager = ShaderManager::getInstance();
+	shader_manager.useShader(program);
+	glUniform1i(glGetUniformLocation(program, "size"), size);
+	glUniform1ui(glGetUniformLocation(program, "sample_count"), this->config.sample_count);
+	glBindImageTexture(0, this->brdf_lut, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+	glDispatchCompute(calculateGroupCount(size), calculateGroupCount(size), 1);
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	GLStateCache::getInstance().deleteProgram(program);
+	shader_manager.useShader(0);
+
+	std::vector<float> lut(2 * static_cast<size_t>(size) * size);
+	GLResources::getTextureImage(this->brdf_lut, GL_TEXTURE_2D, 0, size, size, GL_RG, GL_FLOAT,
+		static_cast<GLsizei>(lut.size() * sizeof(float)), lut.data());
+	return lut;
+}
+
+bool EnvironmentMap::loadCache(const fs::path & file, CubeMapData & environment_data, CubeMapData & specular_data)
+{
+	std::ifstream stream(file, std::ios::binary);
+	if (!stream.is_open()) return false;
+
+	EnvironmentCacheHeader header;
+	stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if (!stream.good() || std::memcmp(header.magic, ENVIRONMENT_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION
+		|| header.cube_size != static_cast<std::uint32_t>(this->config.cube_size)
+		|| header.specular_size != static_cast<std::uint32_t>(this->config.specular_size)
+		|| header.specular_levels != this->config.specular_levels) {
+		return false;
+	}
+
+	environment_data = CubeMapData(this->config.cube_size, 1);
+	specular_data = CubeMapData(this->config.specular_size, this->config.specular_levels);
+	stream.read(reinterpret_cast<char *>(environment_data.texels.data()), environment_data.texels.size() * sizeof(float));
+	stream.read(reinterpret_cast<char *>(specular_data.texels.data()), specular_data.texels.size() * sizeof(float));
+	if (!stream.good()) {
+		std::cout << "The environment cache '" << file.generic_string() << "' is incomplete, baking again." << std::endl;
+		return false;
+	}
+	std::copy(header.irradiance_sh, header.irradiance_sh + this->irradiance_sh.size(), this->irradiance_sh.begin());
+	return true;
+}
+
+void EnvironmentMap::saveCache(const fs::path & file, const CubeMapData & environment_data, const CubeMapData & specular_data)
+{
+	EnvironmentCacheHeader header;
+	std::memcpy(header.magic, ENVIRONMENT_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.cube_size = static_cast<std::uint32_t>(this->config.cube_size);
+	header.specular_size = static_cast<std::uint32_t>(this->config.specular_size);
+	header.specular_levels = this->config.specular_levels;
+	std::copy(this->irradiance_sh.begin(), this->irradiance_sh.end(), header.irradiance_sh);
+
+	// only the base level of the environment is stored, its mip chain is regenerated on upload
+	std::string content(reinterpret_cast<const char *>(&header), sizeof(header));
+	appendFloats(content, environment_data.getFace(0, 0), environment_data.getOffset(1, 0));
+	appendFloats(content, specular_data.texels.data(), specular_data.texels.size());
+	if (!writeFile(file, content)) {
+		std::cout << "Could not write environment cache to '" << file.generic_string() << "'." << std::endl;
+	}
+}
+
+bool EnvironmentMap::loadBRDFCache(const fs::path & file, std::vector<float> & lut)
+{
+	std::ifstream stream(file, std::ios::binary);
+	if (!stream.is_open()) return false;
+
+	BRDFCacheHeader header;
+	stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if (!stream.good() || std::memcmp(header.magic, BRDF_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION
+		|| header.size != static_cast<std::uint32_t>(this->config.brdf_lut_size)) {
+		return false;
+	}
+	lut.resize(2 * static_cast<size_t>(header.size) * header.size);
+	stream.read(reinterpret_cast<char *>(lut.data()), lut.size() * sizeof(float));
+	return stream.good();
+}
+
+void EnvironmentMap::saveBRDFCache(const fs::path & file, const std::vector<float> & lut)
+{
+	BRDFCacheHeader header;
+	std::memcpy(header.magic, BRDF_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.size = static_cast<std::uint32_t>(this->config.brdf_lut_size);
+
+	std::string content(reinterpret_cast<const char *>(&header), sizeof(header));
+	appendFloats(content, lut.data(), lut.size());
+	if (!writeFile(file, content)) {
+		std::cout << "Could not write environment BRDF cache to '" << file.generic_string() << "'." << std::endl;
+	}
+}
+
+void EnvironmentMap::bind(ShaderConfiguration * configuration)
+{
+	const GLuint textures[NUM_TEXTURE_UNITS] = { this->environment, this->specular, this->brdf_lut };
+	const GLenum targets[NUM_TEXTURE_UNITS] = { GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D };
+	const GLuint units_begin = getTextureUnitsBegin();
+	GLStateCache & state = GLStateCache::getInstance();
+	for (GLuint i = 0; i < NUM_TEXTURE_UNITS; ++i)
+	{
+		state.bindTexture(units_begin + i, targets[i], textures[i]);
+		state.bindSampler(units_begin + i, 0);
+	}
+
+	configuration->setBool("environment.use"_uniform, true);
+	configuration->setFloat("environment.specular_levels"_uniform, static_cast<float>(this->config.specular_levels));
+	for (GLuint i = 0; i < EnvironmentBaker::SH_COEFFICIENTS; ++i)
+	{
+		configuration->setVec3("environment.irradiance_sh"_uniform.element(i),
+			glm::vec3(this->irradiance_sh[3 * i], this->irradiance_sh[3 * i + 1], this->irradiance_sh[3 * i + 2]));
+	}
+}
+
+GLuint EnvironmentMap::getTextureUnitsBegin()
+{
+	return MaterialTable::getInstance().getTextureUnitsEnd();
+}
+
+std::string EnvironmentMap::getGLSLInterface()
+{
+	const GLuint units_begin = getTextureUnitsBegin();
+	std::stringstream glsl;
+	glsl << "struct Environment {\n"
+		<< "\tbool use;\n"
+		<< "\tfloat specular_levels;\n"
+		<< "\tvec3 irradiance_sh[" << EnvironmentBaker::SH_COEFFICIENTS << "];\n"
+		<< "};\n"
+		<< "uniform Environment environment;\n"
+		<< "layout(binding = " << units_begin << ") uniform samplerCube environment_radiance;\n"
+		<< "layout(binding = " << units_begin + 1 << ") uniform samplerCube environment_specular;\n"
+		<< "layout(binding = " << units_begin + 2 << ") uniform sampler2D environment_brdf_lut;\n"
+		// diffuse lighting of a white surface, multiply with the albedo
+		<< "vec3 environmentIrradiance(vec3 n) {\n"
+		<< "\treturn max(environment.irradiance_sh[0] * 0.282095\n"
+		<< "\t\t+ environment.irradiance_sh[1] * 0.488603 * n.y\n"
+		<< "\t\t+ environment.irradiance_sh[2] * 0.488603 * n.z\n"
+		<< "\t\t+ environment.irradiance_sh[3] * 0.488603 * n.x\n"
+		<< "\t\t+ environment.irradiance_sh[4] * 1.092548 * n.x * n.y\n"
+		<< "\t\t+ environment.irradiance_sh[5] * 1.092548 * n.y * n.z\n"
+		<< "\t\t+ environment.irradiance_sh[6] * 0.315392 * (3.0 * n.z * n.z - 1.0)\n"
+		<< "\t\t+ environment.irradiance_sh[7] * 1.092548 * n.x * n.z\n"
+		<< "\t\t+ environment.irradiance_sh[8] * 0.546274 * (n.x * n.x - n.y * n.y), vec3(0.0));\n"
+		<< "}\n"
+		// split sum approximation of the specular lighting
+		<< "vec3 environmentSpecular(vec3 r, float roughness, float n_dot_v, vec3 f0) {\n"
+		<< "\tvec3 prefiltered = textureLod(environment_specular, r, roughness * (environment.specular_levels - 1.0)).rgb;\n"
+		<< "\tvec2 brdf = texture(environment_brdf_lut, vec2(n_dot_v, roughness)).rg;\n"
+		<< "\treturn prefiltered * (f0 * brdf.x + brdf.y);\n"
+		<< "}\n";
+	return glsl.str();
+}
+
+GLuint EnvironmentMap::getEnvironmentID()
+{
+	return this->environment;
+}
+
+GLuint EnvironmentMap::getSpecularID()
+{
+	return this->specular;
+}
+
+GLuint EnvironmentMap::getBRDFLookupID()
+{
+	return this->brdf_lut;
+}
+
+const EnvironmentBaker::IrradianceSH & EnvironmentMap::getIrradianceSH()
+{
+	return this->irradiance_sh;
+}
+
+bool EnvironmentMap::isCached()
+{
+	return this->cached;
+}
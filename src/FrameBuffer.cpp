@@ -1,72 +1,123 @@
 #include <GLRF/FrameBuffer.hpp>
 
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+
 using namespace GLRF;
 
-FrameBuffer::FrameBuffer(FrameBufferConfiguration & config, ScreenResolution & screen_res)
+namespace {
+    // immutable storage needs a sized format, the unsized formats of the configuration are sized by their data type
+    GLenum getSizedFormat(GLenum format, GLenum data_type)
+    {
+        const bool is_float = data_type == GL_FLOAT;
+        const bool is_half = data_type == GL_HALF_FLOAT;
+        switch (format)
+        {
+        case GL_RED:    return is_float ? GL_R32F : (is_half ? GL_R16F : GL_R8);
+        case GL_RG:     return is_float ? GL_RG32F : (is_half ? GL_RG16F : GL_RG8);
+        case GL_RGB:    return is_float ? GL_RGB32F : (is_half ? GL_RGB16F : GL_RGB8);
+        case GL_RGBA:   return is_float ? GL_RGBA32F : (is_half ? GL_RGBA16F : GL_RGBA8);
+        default:        return format;
+        }
+    }
+
+    GLsizeiptr getPixelSize(GLenum format, GLenum type)
+    {
+        GLsizeiptr components;
+        switch (format)
+        {
+        case GL_RED:
+        case GL_RED_INTEGER:
+        case GL_DEPTH_COMPONENT:    components = 1; break;
+        case GL_RG:
+        case GL_RG_INTEGER:         components = 2; break;
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:        components = 3; break;
+        default:                    components = 4; break;
+        }
+        switch (type)
+        {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:               return components;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:         return 2 * components;
+        default:                    return 4 * components;
+        }
+    }
+}
+
+FrameBuffer::FrameBuffer(FrameBufferConfiguration & config, ScreenResolution & screen_res) : resolution(screen_res)
 {
-    glGenFramebuffers(1, &(this->ID));
-    glBindFramebuffer(GL_FRAMEBUFFER, this->ID);
+    this->ID = GLResources::createFramebuffer();
 
-    this->texture_color_buffer_IDs.reserve(config.num_color_buffers);
-    for (GLuint i = 0; i < texture_color_buffer_IDs.capacity(); ++i)
+    std::vector<GLenum> color_formats = config.color_formats;
+    if (color_formats.empty()) color_formats.assign(config.num_color_buffers, getSizedFormat(config.color_profile, config.data_type));
+    std::vector<GLenum> attachments;
+    this->texture_color_buffer_IDs.reserve(color_formats.size());
+    for (GLuint i = 0; i < color_formats.size(); ++i)
     {
-        GLuint textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, config.color_profile, screen_res.width, screen_res.height, 0, config.color_type, config.data_type, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textureID, 0);
+        GLuint textureID = GLResources::createTexture(GL_TEXTURE_2D);
+        GLResources::textureStorage2D(textureID, GL_TEXTURE_2D, 1, color_formats[i], screen_res.width, screen_res.height);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GLResources::framebufferTexture(this->ID, GL_COLOR_ATTACHMENT0 + i, textureID, 0);
         this->texture_color_buffer_IDs.push_back(textureID);
+        attachments.push_back(GL_COLOR_ATTACHMENT0 + i);
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    GLuint attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(config.num_color_buffers, attachments);
+    GLResources::framebufferDrawBuffers(this->ID, static_cast<GLsizei>(attachments.size()), attachments.data());
 
-    if (config.use_depth_buffer)
+    if (config.use_depth_buffer && config.sample_depth_buffer)
+    {
+        GLuint textureID = GLResources::createTexture(GL_TEXTURE_2D);
+        GLResources::textureStorage2D(textureID, GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, screen_res.width, screen_res.height);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        GLResources::textureParameteri(textureID, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GLResources::framebufferTexture(this->ID, GL_DEPTH_ATTACHMENT, textureID, 0);
+        this->depth_texture_ID = textureID;
+    }
+    else if (config.use_depth_buffer)
     {
-        GLuint RBO;
-        glGenRenderbuffers(1, &RBO);
+        GLuint RBO = GLResources::createRenderbuffer();
         this->RBO = RBO;
-		glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, screen_res.width, screen_res.height);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
+        GLResources::renderbufferStorage(RBO, GL_DEPTH_COMPONENT24, screen_res.width, screen_res.height);
+        GLResources::framebufferRenderbuffer(this->ID, GL_DEPTH_ATTACHMENT, RBO);
     }
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    if (GLResources::checkFramebufferStatus(this->ID) != GL_FRAMEBUFFER_COMPLETE)
     {
         std::cerr << "ERROR::cannot initialize framebuffer" << std::endl;
         throw std::runtime_error("cannot initialize framebuffer");
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 FrameBuffer::~FrameBuffer()
 {
-    glDeleteFramebuffers(1, &(this->ID));
+    GLStateCache & state = GLStateCache::getInstance();
+    state.deleteFramebuffers(1, &(this->ID));
     for (GLuint i = 0; i < this->texture_color_buffer_IDs.size(); ++i)
     {
-        glDeleteTextures(1, &(this->texture_color_buffer_IDs[i]));
+        state.deleteTextures(1, &(this->texture_color_buffer_IDs[i]));
     }
     this->texture_color_buffer_IDs.clear();
     this->texture_color_buffer_IDs.shrink_to_fit();
     if (this->RBO.has_value()) glDeleteRenderbuffers(1, &(this->RBO.value()));
+    if (this->depth_texture_ID.has_value()) state.deleteTextures(1, &(this->depth_texture_ID.value()));
+    for (ReadbackSlot & slot : this->readback_slots)
+    {
+        if (slot.fence != nullptr) glDeleteSync(slot.fence);
+        if (slot.PBO != 0) state.deleteBuffers(1, &(slot.PBO));
+    }
 }
 
 void FrameBuffer::use()
 {
-    GLint id;
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &id);
-    if (id != this->ID)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, this->ID);
-    }
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &id);
+    GLStateCache::getInstance().bindFramebuffer(this->ID);
 }
 
 GLuint FrameBuffer::getID()
@@ -79,6 +130,16 @@ GLuint FrameBuffer::getColorBufferID(size_t idx)
     return this->texture_color_buffer_IDs[idx];
 }
 
+ScreenResolution FrameBuffer::getResolution()
+{
+    return this->resolution;
+}
+
+std::optional<GLuint> FrameBuffer::getDepthBufferID()
+{
+    return this->depth_texture_ID;
+}
+
 void FrameBuffer::setDebugName(const std::string name)
 {
     this->debug_name = name;
@@ -87,4 +148,70 @@ void FrameBuffer::setDebugName(const std::string name)
 std::string FrameBuffer::getDebugName()
 {
     return this->debug_name;
+}
+
+void FrameBuffer::readColorBufferAsync(size_t idx, GLenum format, GLenum type, ReadbackCallback callback)
+{
+    ReadbackSlot & slot = this->readback_slots[this->next_readback];
+    // all slots are in flight, so the oldest readback has to finish first
+    if (slot.fence != nullptr) completeReadback(slot, true);
+
+    slot.size = static_cast<GLsizeiptr>(this->resolution.width) * this->resolution.height * getPixelSize(format, type);
+    if (slot.PBO == 0) slot.PBO = GLResources::createBuffer();
+    if (slot.capacity < slot.size)
+    {
+        GLResources::bufferData(slot.PBO, slot.size, NULL, GL_STREAM_READ);
+        slot.capacity = slot.size;
+    }
+
+    // with a bound pixel pack buffer the image is written into the buffer instead of client memory
+    GLStateCache & state = GLStateCache::getInstance();
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    GLResources::getTextureImage(this->texture_color_buffer_IDs[idx], GL_TEXTURE_2D, 0, this->resolution.width, this->resolution.height,
+        format, type, static_cast<GLsizei>(slot.size), NULL);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.callback = callback;
+    this->next_readback = (this->next_readback + 1) % READBACK_SLOTS;
+}
+
+void FrameBuffer::pollReadbacks(bool wait)
+{
+    // starting at the oldest readback, since the GPU finishes them in order
+    for (size_t i = 0; i < READBACK_SLOTS; ++i)
+    {
+        ReadbackSlot & slot = this->readback_slots[(this->next_readback + i) % READBACK_SLOTS];
+        if (slot.fence == nullptr) continue;
+        if (!completeReadback(slot, wait)) break;
+    }
+}
+
+bool FrameBuffer::completeReadback(ReadbackSlot & slot, bool wait)
+{
+    const GLuint64 timeout = wait ? 1000000000 : 0;
+    GLenum status;
+    do
+    {
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    } while (wait && status == GL_TIMEOUT_EXPIRED);
+    if (status == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    ReadbackCallback callback = std::move(slot.callback);
+    slot.callback = nullptr;
+    if (status == GL_WAIT_FAILED)
+    {
+        std::cerr << "ERROR::framebuffer readback failed" << std::endl;
+        return true;
+    }
+
+    const void * pixels = GLResources::mapBufferRange(slot.PBO, 0, slot.size, GL_MAP_READ_BIT);
+    if (pixels == nullptr) return true;
+    if (callback) callback(pixels, static_cast<size_t>(slot.size), this->resolution.width, this->resolution.height);
+    GLResources::unmapBuffer(slot.PBO);
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include <GLRF/FrameGraph.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+namespace {
+	bool isDepthFormat(GLenum format)
+	{
+		return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32
+			|| format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH_COMPONENT;
+	}
+
+	bool isDepthStencilFormat(GLenum format)
+	{
+		return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 || format == GL_DEPTH_STENCIL;
+	}
+
+	// the estimated size of a texel in bytes, only used for statistics
+	size_t getTexelSize(GLenum format)
+	{
+		switch (format)
+		{
+		case GL_R8:				return 1;
+		case GL_RG8:
+		case GL_R16F:
+		case GL_DEPTH_COMPONENT16:	return 2;
+		case GL_RGB8:			return 3;
+		case GL_RGBA16F:
+		case GL_RG32F:			return 8;
+		case GL_RGB16F:			return 6;
+		case GL_RGB32F:			return 12;
+		case GL_RGBA32F:		return 16;
+		case GL_DEPTH32F_STENCIL8:	return 8;
+		default:				return 4;
+		}
+	}
+
+	GLbitfield getBarrier(FrameGraphAccess access)
+	{
+		switch (access)
+		{
+		case FrameGraphAccess::SAMPLED:		return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case FrameGraphAccess::STORAGE:		return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case FrameGraphAccess::ATTACHMENT:	return GL_FRAMEBUFFER_BARRIER_BIT;
+		}
+		return 0;
+	}
+}
+
+// === FrameGraphBuilder ===
+
+FrameGraphBuilder::FrameGraphBuilder(FrameGraph & graph, size_t pass) : graph(graph), pass(pass)
+{
+
+}
+
+FrameGraphResource FrameGraphBuilder::create(const std::string & name, const FrameGraphTextureDesc & desc)
+{
+	FrameGraph::Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	FrameGraphResource handle;
+	handle.node = this->graph.addResource(resource);
+	return handle;
+}
+
+FrameGraphResource FrameGraphBuilder::read(FrameGraphResource resource, FrameGraphAccess access)
+{
+	if (!resource.isValid() || resource.node >= this->graph.nodes.size()) {
+		throw std::invalid_argument("frame graph pass reads an unknown resource");
+	}
+	this->graph.passes[this->pass].reads.push_back({ resource.node, access });
+	return resource;
+}
+
+FrameGraphResource FrameGraphBuilder::write(FrameGraphResource resource, FrameGraphAccess access)
+{
+	if (!resource.isValid() || resource.node >= this->graph.nodes.size()) {
+		throw std::invalid_argument("frame graph pass writes an unknown resource");
+	}
+	// the content of the previous version is kept, so its producer must not be culled
+	if (this->graph.nodes[resource.node].producer != SIZE_MAX) read(resource, access);
+
+	FrameGraph::Node node;
+	node.resource = this->graph.nodes[resource.node].resource;
+	node.producer = this->pass;
+	node.access = access;
+	this->graph.nodes.push_back(node);
+
+	FrameGraphResource version;
+	version.node = this->graph.nodes.size() - 1;
+	this->graph.passes[this->pass].writes.push_back({ version.node, access });
+	return version;
+}
+
+void FrameGraphBuilder::setSideEffect()
+{
+	this->graph.passes[this->pass].side_effect = true;
+}
+
+// === FrameGraphPassContext ===
+
+FrameGraphPassContext::FrameGraphPassContext(const FrameGraph & graph, GLuint framebuffer) : graph(graph), framebuffer(framebuffer)
+{
+
+}
+
+GLuint FrameGraphPassContext::getTexture(FrameGraphResource resource) const
+{
+	return this->graph.getObject(resource);
+}
+
+GLuint FrameGraphPassContext::getFramebuffer() const
+{
+	return this->framebuffer;
+}
+
+// === FrameGraph ===
+
+FrameGraph::FrameGraph()
+{
+
+}
+
+FrameGraph::~FrameGraph()
+{
+	releasePool();
+}
+
+size_t FrameGraph::addResource(Resource resource)
+{
+	this->resources.push_back(resource);
+	Node node;
+	node.resource = this->resources.size() - 1;
+	this->nodes.push_back(node);
+	this->compiled = false;
+	return this->nodes.size() - 1;
+}
+
+FrameGraphResource FrameGraph::importTexture(const std::string & name, GLuint texture, const FrameGraphTextureDesc & desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resource.imported = true;
+	resource.imported_texture = texture;
+	FrameGraphResource handle;
+	handle.node = addResource(resource);
+	return handle;
+}
+
+FrameGraphResource FrameGraph::importBackbuffer(const std::string & name, GLsizei width, GLsizei height)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc.width = width;
+	resource.desc.height = height;
+	resource.imported = true;
+	resource.backbuffer = true;
+	FrameGraphResource handle;
+	handle.node = addResource(resource);
+	return handle;
+}
+
+void FrameGraph::addPass(const std::string & name, SetupFunction setup, ExecuteFunction execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+	this->passes.push_back(pass);
+	this->compiled = false;
+
+	FrameGraphBuilder builder(*this, this->passes.size() - 1);
+	setup(builder);
+}
+
+void FrameGraph::compile()
+{
+	// 1. reference counts, a pass is referenced by the versions it writes and a version by the passes that read it
+	for (Node & node : this->nodes) node.ref_count = 0;
+	for (Pass & pass : this->passes)
+	{
+		pass.culled = false;
+		pass.barriers = 0;
+		pass.ref_count = static_cast<unsigned int>(pass.writes.size());
+		for (const Access & access : pass.reads) ++this->nodes[access.node].ref_count;
+		// writing an imported resource is an output of the frame
+		for (const Access & access : pass.writes)
+		{
+			if (this->resources[this->nodes[access.node].resource].imported) pass.side_effect = true;
+		}
+	}
+
+	// 2. cull passes whose results are never read, starting at the unread versions
+	std::vector<size_t> unused;
+	for (size_t i = 0; i < this->nodes.size(); ++i)
+	{
+		if (this->nodes[i].ref_count == 0) unused.push_back(i);
+	}
+	while (!unused.empty())
+	{
+		const Node & node = this->nodes[unused.back()];
+		unused.pop_back();
+		if (node.producer == SIZE_MAX) continue;
+		Pass & producer = this->passes[node.producer];
+		if (producer.side_effect || producer.ref_count == 0 || --producer.ref_count > 0) continue;
+
+		producer.culled = true;
+		for (const Access & access : producer.reads)
+		{
+			if (--this->nodes[access.node].ref_count == 0) unused.push_back(access.node);
+		}
+	}
+
+	// 3. lifetimes of the resources
+	for (Resource & resource : this->resources)
+	{
+		resource.first_pass = SIZE_MAX;
+		resource.last_pass = 0;
+		resource.physical = SIZE_MAX;
+	}
+	for (size_t i = 0; i < this->passes.size(); ++i)
+	{
+		if (this->passes[i].culled) continue;
+		for (const std::vector<Access> * accesses : { &this->passes[i].reads, &this->passes[i].writes })
+		{
+			for (const Access & access : *accesses)
+			{
+				Resource & resource = this->resources[this->nodes[access.node].resource];
+				resource.first_pass = std::min(resource.first_pass, i);
+				resource.last_pass = std::max(resource.last_pass, i);
+			}
+		}
+	}
+
+	// 4. transient resources share a physical resource if their descriptions match and their lifetimes do not overlap
+	this->physical_descs.clear();
+	std::vector<size_t> free_physical;
+	for (size_t i = 0; i < this->passes.size(); ++i)
+	{
+		if (this->passes[i].culled) continue;
+		for (Resource & resource : this->resources)
+		{
+			if (resource.imported || resource.first_pass != i) continue;
+			auto it = std::find_if(free_physical.begin(), free_physical.end(),
+				[&](size_t physical) { return this->physical_descs[physical] == resource.desc; });
+			if (it != free_physical.end()) {
+				resource.physical = *it;
+				free_physical.erase(it);
+			} else {
+				resource.physical = this->physical_descs.size();
+				this->physical_descs.push_back(resource.desc);
+			}
+		}
+		for (const Resource & resource : this->resources)
+		{
+			if (!resource.imported && resource.first_pass != SIZE_MAX && resource.last_pass == i) free_physical.push_back(resource.physical);
+		}
+	}
+
+	// 5. barriers, only the results of image stores have to be made visible explicitly
+	for (Pass & pass : this->passes)
+	{
+		if (pass.culled) continue;
+		for (const Access & access : pass.reads)
+		{
+			const Node & node = this->nodes[access.node];
+			if (node.producer != SIZE_MAX && node.access == FrameGraphAccess::STORAGE) pass.barriers |= getBarrier(access.access);
+		}
+	}
+	this->compiled = true;
+}
+
+void FrameGraph::execute()
+{
+	if (!this->compiled) compile();
+
+	this->physical_objects.clear();
+	for (const FrameGraphTextureDesc & desc : this->physical_descs)
+	{
+		this->physical_objects.push_back(acquire(desc));
+	}
+
+	for (const Pass & pass : this->passes)
+	{
+		if (pass.culled) continue;
+		if (pass.barriers != 0) glMemoryBarrier(pass.barriers);
+
+		GLuint framebuffer = getFramebuffer(pass);
+		FrameGraphPassContext context(*this, framebuffer);
+		pass.execute(context);
+	}
+
+	releaseUnusedPoolObjects();
+}
+
+void FrameGraph::reset()
+{
+	this->resources.clear();
+	this->nodes.clear();
+	this->passes.clear();
+	this->physical_descs.clear();
+	this->physical_objects.clear();
+	this->compiled = false;
+	releaseImportedFramebuffers();
+}
+
+void FrameGraph::releaseImportedFramebuffers()
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	for (auto & pair : this->imported_framebuffers)
+	{
+		state.deleteFramebuffers(1, &(pair.second));
+	}
+	this->imported_framebuffers.clear();
+}
+
+GLuint FrameGraph::acquire(const FrameGraphTextureDesc & desc)
+{
+	for (PooledObject & pooled : this->pool)
+	{
+		if (pooled.in_use || !(pooled.desc == desc)) continue;
+		pooled.in_use = true;
+		pooled.unused_frames = 0;
+		return pooled.object;
+	}
+
+	PooledObject pooled;
+	pooled.desc = desc;
+	pooled.in_use = true;
+	if (desc.renderbuffer) {
+		pooled.object = GLResources::createRenderbuffer();
+		GLResources::renderbufferStorage(pooled.object, desc.internal_format, desc.width, desc.height);
+	} else {
+		pooled.object = GLResources::createTexture(GL_TEXTURE_2D);
+		GLResources::textureStorage2D(pooled.object, GL_TEXTURE_2D, 1, desc.internal_format, desc.width, desc.height);
+		const GLint filter = (isDepthFormat(desc.internal_format) || isDepthStencilFormat(desc.internal_format)) ? GL_NEAREST : GL_LINEAR;
+		GLResources::textureParameteri(pooled.object, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		GLResources::textureParameteri(pooled.object, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		GLResources::textureParameteri(pooled.object, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		GLResources::textureParameteri(pooled.object, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	this->pool.push_back(pooled);
+	return pooled.object;
+}
+
+void FrameGraph::releaseUnusedPoolObjects()
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	for (auto it = this->pool.begin(); it != this->pool.end();)
+	{
+		if (it->in_use) {
+			it->in_use = false;
+			++it;
+			continue;
+		}
+		if (++it->unused_frames <= POOL_RETENTION_FRAMES) {
+			++it;
+			continue;
+		}
+		// framebuffers that attach the object are deleted with it
+		for (auto fb = this->framebuffers.begin(); fb != this->framebuffers.end();)
+		{
+			bool attached = false;
+			for (size_t i = 1; i < fb->first.size(); i += 3)
+			{
+				attached = attached || (fb->first[i] == it->object && (fb->first[i + 1] != 0) == it->desc.renderbuffer);
+			}
+			if (attached) {
+				state.deleteFramebuffers(1, &(fb->second));
+				fb = this->framebuffers.erase(fb);
+			} else {
+				++fb;
+			}
+		}
+		if (it->desc.renderbuffer) {
+			glDeleteRenderbuffers(1, &(it->object));
+		} else {
+			state.deleteTextures(1, &(it->object));
+		}
+		it = this->pool.erase(it);
+	}
+}
+
+void FrameGraph::releasePool()
+{
+	for (PooledObject & pooled : this->pool)
+	{
+		pooled.in_use = false;
+		pooled.unused_frames = POOL_RETENTION_FRAMES;
+	}
+	releaseUnusedPoolObjects();
+	GLStateCache & state = GLStateCache::getInstance();
+	for (auto & pair : this->framebuffers)
+	{
+		state.deleteFramebuffers(1, &(pair.second));
+	}
+	this->framebuffers.clear();
+	releaseImportedFramebuffers();
+}
+
+GLuint FrameGraph::getObject(FrameGraphResource resource) const
+{
+	if (!resource.isValid() || resource.node >= this->nodes.size()) {
+		throw std::invalid_argument("frame graph resource is unknown");
+	}
+	const Resource & r = this->resources[this->nodes[resource.node].resource];
+	if (r.imported) return r.imported_texture;
+	if (r.physical >= this->physical_objects.size()) {
+		throw std::logic_error("frame graph resource '" + r.name + "' is not used by an executed pass");
+	}
+	return this->physical_objects[r.physical];
+}
+
+GLuint FrameGraph::getFramebuffer(const Pass & pass)
+{
+	// the attachments of a pass are all resources that it reads or writes as attachment
+	std::vector<size_t> attachments;
+	for (const std::vector<Access> * accesses : { &pass.reads, &pass.writes })
+	{
+		for (const Access & access : *accesses)
+		{
+			const size_t resource = this->nodes[access.node].resource;
+			if (access.access != FrameGraphAccess::ATTACHMENT) continue;
+			if (std::find(attachments.begin(), attachments.end(), resource) == attachments.end()) attachments.push_back(resource);
+		}
+	}
+	GLStateCache & state = GLStateCache::getInstance();
+	if (attachments.empty()) return state.getFramebuffer().value_or(0);
+
+	const FrameGraphTextureDesc & size = this->resources[attachments.front()].desc;
+	state.setViewport(0, 0, size.width, size.height);
+	for (size_t resource : attachments)
+	{
+		if (!this->resources[resource].backbuffer) continue;
+		if (attachments.size() > 1) {
+			throw std::invalid_argument("frame graph pass '" + pass.name + "' writes the backbuffer together with other attachments");
+		}
+		state.bindFramebuffer(0);
+		return 0;
+	}
+
+	// the key consists of the attachment point, the object and whether it is a renderbuffer
+	std::vector<GLuint> key;
+	std::vector<GLenum> draw_buffers;
+	bool imported = false;
+	for (size_t resource : attachments)
+	{
+		const Resource & r = this->resources[resource];
+		imported = imported || r.imported;
+		GLenum point;
+		if (isDepthStencilFormat(r.desc.internal_format)) {
+			point = GL_DEPTH_STENCIL_ATTACHMENT;
+		} else if (isDepthFormat(r.desc.internal_format)) {
+			point = GL_DEPTH_ATTACHMENT;
+		} else {
+			point = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(draw_buffers.size());
+			draw_buffers.push_back(point);
+		}
+		key.push_back(point);
+		key.push_back(r.imported ? r.imported_texture : this->physical_objects[r.physical]);
+		key.push_back(r.desc.renderbuffer ? 1 : 0);
+	}
+
+	// the pooled objects are only deleted together with their framebuffers, imported ones can vanish at any time
+	std::map<std::vector<GLuint>, GLuint> & framebuffers = imported ? this->imported_framebuffers : this->framebuffers;
+	auto it = framebuffers.find(key);
+	if (it == framebuffers.end()) {
+		GLuint framebuffer = GLResources::createFramebuffer();
+		for (size_t i = 0; i < key.size(); i += 3)
+		{
+			if (key[i + 2] != 0) {
+				GLResources::framebufferRenderbuffer(framebuffer, key[i], key[i + 1]);
+			} else {
+				GLResources::framebufferTexture(framebuffer, key[i], key[i + 1], 0);
+			}
+		}
+		if (draw_buffers.empty()) draw_buffers.push_back(GL_NONE);
+		GLResources::framebufferDrawBuffers(framebuffer, static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+		if (GLResources::checkFramebufferStatus(framebuffer) != GL_FRAMEBUFFER_COMPLETE) {
+			state.deleteFramebuffers(1, &framebuffer);
+			std::cout << "ERROR::FRAME_GRAPH::INCOMPLETE_FRAMEBUFFER: " << pass.name << std::endl;
+			throw std::runtime_error("frame graph pass '" + pass.name + "' has an incomplete framebuffer");
+		}
+		it = framebuffers.emplace(key, framebuffer).first;
+	}
+	state.bindFramebuffer(it->second);
+	return it->second;
+}
+
+bool FrameGraph::isCulled(const std::string & pass_name) const
+{
+	for (const Pass & pass : this->passes)
+	{
+		if (pass.name == pass_name) return pass.culled;
+	}
+	throw std::invalid_argument("frame graph has no pass '" + pass_name + "'");
+}
+
+size_t FrameGraph::getPhysicalResourceCount() const
+{
+	return this->physical_descs.size();
+}
+
+size_t FrameGraph::getTransientResourceCount() const
+{
+	return static_cast<size_t>(std::count_if(this->resources.begin(), this->resources.end(),
+		[](const Resource & resource) { return !resource.imported; }));
+}
+
+size_t FrameGraph::getPooledBytes() const
+{
+	size_t bytes = 0;
+	for (const PooledObject & pooled : this->pool)
+	{
+		bytes += static_cast<size_t>(pooled.desc.width) * pooled.desc.height * getTexelSize(pooled.desc.internal_format);
+	}
+	return bytes;
+}
@@ -0,0 +1,84 @@
+#include <GLRF/FrameUniforms.hpp>
+
+#include <sstream>
+
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+FrameUniformBuffer::FrameUniformBuffer()
+{
+
+}
+
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+
+}
+
+void FrameUniformBuffer::update(const FrameUniforms & uniforms)
+{
+	if (this->UBO == 0) {
+		this->UBO = GLResources::createBuffer();
+		GLResources::bufferStorage(this->UBO, sizeof(FrameUniforms), NULL, GL_DYNAMIC_STORAGE_BIT);
+	}
+	GLResources::bufferSubData(this->UBO, 0, sizeof(FrameUniforms), &uniforms);
+	GLStateCache::getInstance().bindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_BINDING, this->UBO);
+}
+
+std::string FrameUniformBuffer::getGLSLInterface()
+{
+	// the member order has to match FrameUniforms
+	std::stringstream glsl;
+	glsl << "layout(std140, binding = " << UNIFORM_BUFFER_BINDING << ") uniform " << BLOCK_NAME << " {\n"
+		<< "\tmat4 view;\n"
+		<< "\tvec3 camera_position;\n"
+		<< "\tvec3 camera_view_dir;\n"
+		<< "\tvec3 directionalLight_direction;\n"
+		<< "\tfloat directionalLight_power;\n"
+		<< "\tuint pointLight_count;\n"
+		<< "\tbool useDirectionalLight;\n"
+		<< "\tvec3 pointLight_position[" << FrameUniforms::MAX_POINT_LIGHTS << "];\n"
+		<< "\tvec3 pointLight_color[" << FrameUniforms::MAX_POINT_LIGHTS << "];\n"
+		<< "\tfloat pointLight_power[" << FrameUniforms::MAX_POINT_LIGHTS << "];\n"
+		<< "};\n";
+	return glsl.str();
+}
+
+std::string FrameUniformBuffer::getGLSLLighting()
+{
+	return R"(
+const float PI = 3.14159265359;
+
+float distributionGGX(float n_dot_h, float roughness) {
+	float a2 = roughness * roughness * roughness * roughness;
+	float d = n_dot_h * n_dot_h * (a2 - 1.0) + 1.0;
+	return a2 / (PI * d * d);
+}
+
+float geometrySmith(float n_dot_v, float n_dot_l, float roughness) {
+	float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
+	return (n_dot_v / (n_dot_v * (1.0 - k) + k)) * (n_dot_l / (n_dot_l * (1.0 - k) + k));
+}
+
+vec3 shade(vec3 albedo, float roughness, float metallic, vec3 n, vec3 v, vec3 l, vec3 radiance) {
+	float n_dot_l = dot(n, l);
+	if (n_dot_l <= 0.0) return vec3(0.0);
+	vec3 h = normalize(v + l);
+	float n_dot_v = max(dot(n, v), 1e-4);
+	vec3 f0 = mix(vec3(0.04), albedo, metallic);
+	vec3 fresnel = f0 + (1.0 - f0) * pow(1.0 - max(dot(h, v), 0.0), 5.0);
+	vec3 specular = distributionGGX(max(dot(n, h), 0.0), roughness) * geometrySmith(n_dot_v, n_dot_l, roughness) * fresnel
+		/ (4.0 * n_dot_v * n_dot_l + 1e-4);
+	vec3 diffuse = (1.0 - fresnel) * (1.0 - metallic) * albedo / PI;
+	return (diffuse + specular) * radiance * n_dot_l;
+}
+)";
+}
+
+void FrameUniformBuffer::clear()
+{
+	if (this->UBO != 0) GLStateCache::getInstance().deleteBuffers(1, &(this->UBO));
+	this->UBO = 0;
+}
@@ -0,0 +1,75 @@
+#include <GLRF/GLExtensions.hpp>
+
+using namespace GLRF;
+
+GLExtensions::GLExtensions()
+{
+
+}
+
+GLExtensions::~GLExtensions()
+{
+
+}
+
+void GLExtensions::load(GLADloadproc loader)
+{
+	this->extensions.clear();
+	GLint num_extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+	for (GLint i = 0; i < num_extensions; ++i)
+	{
+		const GLubyte * name = glGetStringi(GL_EXTENSIONS, i);
+		if (name) this->extensions.insert(reinterpret_cast<const char *>(name));
+	}
+
+	if (isSupported("GL_ARB_bindless_texture"))
+	{
+		this->getTextureSamplerHandleARB = reinterpret_cast<PFNGLRFGETTEXTURESAMPLERHANDLEARBPROC>(loader("glGetTextureSamplerHandleARB"));
+		this->makeTextureHandleResidentARB = reinterpret_cast<PFNGLRFMAKETEXTUREHANDLERESIDENTARBPROC>(loader("glMakeTextureHandleResidentARB"));
+		this->makeTextureHandleNonResidentARB = reinterpret_cast<PFNGLRFMAKETEXTUREHANDLENONRESIDENTARBPROC>(loader("glMakeTextureHandleNonResidentARB"));
+	}
+	this->bindless_textures = this->getTextureSamplerHandleARB && this->makeTextureHandleResidentARB && this->makeTextureHandleNonResidentARB;
+
+	// the ARB variant has the same token and an entry point with the same signature
+	if (isSupported("GL_KHR_parallel_shader_compile"))
+	{
+		this->maxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLRFMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsKHR"));
+	}
+	else if (isSupported("GL_ARB_parallel_shader_compile"))
+	{
+		this->maxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLRFMAXSHADERCOMPILERTHREADSKHRPROC>(loader("glMaxShaderCompilerThreadsARB"));
+	}
+	this->parallel_shader_compile = this->maxShaderCompilerThreadsKHR != nullptr;
+	// let the driver choose the number of compiler threads
+	if (this->parallel_shader_compile) this->maxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+	// the DSA entry points are part of the core profile loaded by glad
+	this->direct_state_access_supported = GLAD_GL_VERSION_4_5 != 0;
+	this->direct_state_access = this->direct_state_access_supported;
+}
+
+bool GLExtensions::isSupported(const std::string & name)
+{
+	return this->extensions.find(name) != this->extensions.end();
+}
+
+bool GLExtensions::hasBindlessTextures()
+{
+	return this->bindless_textures;
+}
+
+bool GLExtensions::hasParallelShaderCompile()
+{
+	return this->parallel_shader_compile;
+}
+
+bool GLExtensions::hasDirectStateAccess()
+{
+	return this->direct_state_access;
+}
+
+void GLExtensions::setDirectStateAccessEnabled(bool enabled)
+{
+	this->direct_state_access = enabled && this->direct_state_access_supported;
+}
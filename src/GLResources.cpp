@@ -0,0 +1,305 @@
+#include <GLRF/GLResources.hpp>
+
+#include <GLRF/GLExtensions.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// buffers are edited through a binding point that is never used for drawing
+	const GLenum EDIT_BUFFER_TARGET = GL_COPY_WRITE_BUFFER;
+
+	bool isCubeMapFace(GLenum target)
+	{
+		return target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+	}
+
+	// binds a texture for editing, cube map faces are edited through their cube map
+	void bindForEdit(GLuint texture, GLenum target)
+	{
+		GLStateCache::getInstance().bindTexture(isCubeMapFace(target) ? GL_TEXTURE_CUBE_MAP : target, texture);
+	}
+
+	// binds a framebuffer for editing and restores the previous binding afterwards
+	template <typename Edit>
+	void editFramebuffer(GLuint framebuffer, Edit edit)
+	{
+		GLStateCache & state = GLStateCache::getInstance();
+		const GLuint previous = state.getFramebuffer().value_or(0);
+		state.bindFramebuffer(framebuffer);
+		edit();
+		state.bindFramebuffer(previous);
+	}
+}
+
+bool GLResources::usesDirectStateAccess()
+{
+	return GLExtensions::getInstance().hasDirectStateAccess();
+}
+
+GLuint GLResources::createBuffer()
+{
+	GLuint buffer;
+	if (usesDirectStateAccess()) {
+		glCreateBuffers(1, &buffer);
+	} else {
+		glGenBuffers(1, &buffer);
+	}
+	return buffer;
+}
+
+void GLResources::bufferStorage(GLuint buffer, GLsizeiptr size, const void * data, GLbitfield flags)
+{
+	if (usesDirectStateAccess()) {
+		glNamedBufferStorage(buffer, size, data, flags);
+		return;
+	}
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	if (GLAD_GL_VERSION_4_4) {
+		glBufferStorage(EDIT_BUFFER_TARGET, size, data, flags);
+	} else {
+		glBufferData(EDIT_BUFFER_TARGET, size, data, (flags & GL_DYNAMIC_STORAGE_BIT) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	}
+}
+
+void GLResources::bufferData(GLuint buffer, GLsizeiptr size, const void * data, GLenum usage)
+{
+	if (usesDirectStateAccess()) {
+		glNamedBufferData(buffer, size, data, usage);
+		return;
+	}
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	glBufferData(EDIT_BUFFER_TARGET, size, data, usage);
+}
+
+void GLResources::bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void * data)
+{
+	if (usesDirectStateAccess()) {
+		glNamedBufferSubData(buffer, offset, size, data);
+		return;
+	}
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	glBufferSubData(EDIT_BUFFER_TARGET, offset, size, data);
+}
+
+void GLResources::getBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, void * data)
+{
+	if (usesDirectStateAccess()) {
+		glGetNamedBufferSubData(buffer, offset, size, data);
+		return;
+	}
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	glGetBufferSubData(EDIT_BUFFER_TARGET, offset, size, data);
+}
+
+void * GLResources::mapBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	if (usesDirectStateAccess()) return glMapNamedBufferRange(buffer, offset, length, access);
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	return glMapBufferRange(EDIT_BUFFER_TARGET, offset, length, access);
+}
+
+void GLResources::unmapBuffer(GLuint buffer)
+{
+	if (usesDirectStateAccess()) {
+		glUnmapNamedBuffer(buffer);
+		return;
+	}
+	GLStateCache::getInstance().bindBuffer(EDIT_BUFFER_TARGET, buffer);
+	glUnmapBuffer(EDIT_BUFFER_TARGET);
+}
+
+GLuint GLResources::createTexture(GLenum target)
+{
+	GLuint texture;
+	if (usesDirectStateAccess()) {
+		glCreateTextures(target, 1, &texture);
+	} else {
+		glGenTextures(1, &texture);
+	}
+	return texture;
+}
+
+void GLResources::textureStorage2D(GLuint texture, GLenum target, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height)
+{
+	if (usesDirectStateAccess()) {
+		glTextureStorage2D(texture, levels, internal_format, width, height);
+		return;
+	}
+	bindForEdit(texture, target);
+	glTexStorage2D(target, levels, internal_format, width, height);
+}
+
+void GLResources::textureStorage3D(GLuint texture, GLenum target, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height, GLsizei depth)
+{
+	if (usesDirectStateAccess()) {
+		glTextureStorage3D(texture, levels, internal_format, width, height, depth);
+		return;
+	}
+	bindForEdit(texture, target);
+	glTexStorage3D(target, levels, internal_format, width, height, depth);
+}
+
+void GLResources::textureParameteri(GLuint texture, GLenum target, GLenum name, GLint value)
+{
+	if (usesDirectStateAccess()) {
+		glTextureParameteri(texture, name, value);
+		return;
+	}
+	bindForEdit(texture, target);
+	glTexParameteri(target, name, value);
+}
+
+void GLResources::textureParameteriv(GLuint texture, GLenum target, GLenum name, const GLint * values)
+{
+	if (usesDirectStateAccess()) {
+		glTextureParameteriv(texture, name, values);
+		return;
+	}
+	bindForEdit(texture, target);
+	glTexParameteriv(target, name, values);
+}
+
+void GLResources::textureSubImage2D(GLuint texture, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+	GLenum format, GLenum type, const void * pixels)
+{
+	if (usesDirectStateAccess()) {
+		// DSA addresses the faces of a cube map as layers
+		if (isCubeMapFace(target)) {
+			glTextureSubImage3D(texture, level, x, y, target - GL_TEXTURE_CUBE_MAP_POSITIVE_X, width, height, 1, format, type, pixels);
+		} else {
+			glTextureSubImage2D(texture, level, x, y, width, height, format, type, pixels);
+		}
+		return;
+	}
+	bindForEdit(texture, target);
+	glTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+void GLResources::compressedTextureSubImage2D(GLuint texture, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+	GLenum format, GLsizei size, const void * data)
+{
+	if (usesDirectStateAccess()) {
+		glCompressedTextureSubImage2D(texture, level, x, y, width, height, format, size, data);
+		return;
+	}
+	bindForEdit(texture, target);
+	glCompressedTexSubImage2D(target, level, x, y, width, height, format, size, data);
+}
+
+void GLResources::generateMipmap(GLuint texture, GLenum target)
+{
+	if (usesDirectStateAccess()) {
+		glGenerateTextureMipmap(texture);
+		return;
+	}
+	bindForEdit(texture, target);
+	glGenerateMipmap(target);
+}
+
+void GLResources::getTextureImage(GLuint texture, GLenum target, GLint level, GLsizei width, GLsizei height,
+	GLenum format, GLenum type, GLsizei size, void * pixels)
+{
+	if (usesDirectStateAccess()) {
+		const GLint layer = isCubeMapFace(target) ? static_cast<GLint>(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X) : 0;
+		glGetTextureSubImage(texture, level, 0, 0, layer, width, height, 1, format, type, size, pixels);
+		return;
+	}
+	bindForEdit(texture, target);
+	glGetTexImage(target, level, format, type, pixels);
+}
+
+GLuint GLResources::createVertexArray()
+{
+	GLuint vertex_array;
+	if (usesDirectStateAccess()) {
+		glCreateVertexArrays(1, &vertex_array);
+	} else {
+		glGenVertexArrays(1, &vertex_array);
+	}
+	return vertex_array;
+}
+
+GLuint GLResources::createFramebuffer()
+{
+	GLuint framebuffer;
+	if (usesDirectStateAccess()) {
+		glCreateFramebuffers(1, &framebuffer);
+	} else {
+		glGenFramebuffers(1, &framebuffer);
+	}
+	return framebuffer;
+}
+
+void GLResources::framebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
+{
+	if (usesDirectStateAccess()) {
+		glNamedFramebufferTexture(framebuffer, attachment, texture, level);
+		return;
+	}
+	editFramebuffer(framebuffer, [&]() { glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture, level); });
+}
+
+void GLResources::framebufferRenderbuffer(GLuint framebuffer, GLenum attachment, GLuint renderbuffer)
+{
+	if (usesDirectStateAccess()) {
+		glNamedFramebufferRenderbuffer(framebuffer, attachment, GL_RENDERBUFFER, renderbuffer);
+		return;
+	}
+	editFramebuffer(framebuffer, [&]() { glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer); });
+}
+
+void GLResources::framebufferDrawBuffers(GLuint framebuffer, GLsizei count, const GLenum * buffers)
+{
+	if (usesDirectStateAccess()) {
+		glNamedFramebufferDrawBuffers(framebuffer, count, buffers);
+		return;
+	}
+	editFramebuffer(framebuffer, [&]() { glDrawBuffers(count, buffers); });
+}
+
+GLenum GLResources::checkFramebufferStatus(GLuint framebuffer)
+{
+	if (usesDirectStateAccess()) return glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+	GLenum status = GL_FRAMEBUFFER_UNDEFINED;
+	editFramebuffer(framebuffer, [&]() { status = glCheckFramebufferStatus(GL_FRAMEBUFFER); });
+	return status;
+}
+
+void GLResources::blitFramebuffer(GLuint source, GLuint destination, GLint source_x0, GLint source_y0, GLint source_x1, GLint source_y1,
+	GLint destination_x0, GLint destination_y0, GLint destination_x1, GLint destination_y1, GLbitfield mask, GLenum filter)
+{
+	if (usesDirectStateAccess()) {
+		glBlitNamedFramebuffer(source, destination, source_x0, source_y0, source_x1, source_y1,
+			destination_x0, destination_y0, destination_x1, destination_y1, mask, filter);
+		return;
+	}
+	// the cache tracks both bindings as one, so the read binding is restored to the destination afterwards
+	GLStateCache::getInstance().bindFramebuffer(destination);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+	glBlitFramebuffer(source_x0, source_y0, source_x1, source_y1, destination_x0, destination_y0, destination_x1, destination_y1, mask, filter);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, destination);
+}
+
+GLuint GLResources::createRenderbuffer()
+{
+	GLuint renderbuffer;
+	if (usesDirectStateAccess()) {
+		glCreateRenderbuffers(1, &renderbuffer);
+	} else {
+		glGenRenderbuffers(1, &renderbuffer);
+	}
+	return renderbuffer;
+}
+
+void GLResources::renderbufferStorage(GLuint renderbuffer, GLenum internal_format, GLsizei width, GLsizei height)
+{
+	if (usesDirectStateAccess()) {
+		glNamedRenderbufferStorage(renderbuffer, internal_format, width, height);
+		return;
+	}
+	// renderbuffers are not bound for drawing, so their binding is not cached
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, internal_format, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
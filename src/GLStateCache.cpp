@@ -0,0 +1,289 @@
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+namespace {
+	const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+	const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_PIXEL_PACK_BUFFER,
+		GL_PIXEL_UNPACK_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER };
+	const GLenum INDEXED_BUFFER_TARGETS[] = { GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER };
+
+	// returns the index of the target in the list, or -1 if the target is not cached
+	template <size_t N>
+	int findTarget(const GLenum (&targets)[N], GLenum target)
+	{
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (targets[i] == target) return static_cast<int>(i);
+		}
+		return -1;
+	}
+}
+
+GLStateCache::GLStateCache()
+{
+
+}
+
+GLStateCache::~GLStateCache()
+{
+
+}
+
+void GLStateCache::invalidate()
+{
+	this->framebuffer.reset();
+	this->program.reset();
+	this->vertex_array.reset();
+	this->active_texture_unit.reset();
+	for (TextureUnit & unit : this->texture_units)
+	{
+		unit.textures.fill(std::nullopt);
+		unit.sampler.reset();
+	}
+	this->buffers.fill(std::nullopt);
+	for (auto & indices : this->indexed_buffers)
+	{
+		indices.fill(std::nullopt);
+	}
+	this->capabilities.clear();
+	this->blend_func.reset();
+	this->depth_func.reset();
+	this->depth_mask.reset();
+	this->color_mask.reset();
+	this->viewport.reset();
+	this->point_size.reset();
+	this->line_width.reset();
+	this->patch_vertices.reset();
+}
+
+void GLStateCache::bindFramebuffer(GLuint framebuffer)
+{
+	if (change(this->framebuffer, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+	if (change(this->program, program)) glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vertex_array)
+{
+	if (change(this->vertex_array, vertex_array)) glBindVertexArray(vertex_array);
+}
+
+void GLStateCache::activateTextureUnit(GLuint unit)
+{
+	// not counted, it is only a side effect of a texture binding
+	if (this->active_texture_unit == unit) return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	this->active_texture_unit = unit;
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	const int target_index = findTarget(TEXTURE_TARGETS, target);
+	if (unit >= MAX_TEXTURE_UNITS || target_index < 0) {
+		++this->stats.issued;
+		activateTextureUnit(unit);
+		glBindTexture(target, texture);
+		return;
+	}
+	if (change(this->texture_units[unit].textures[target_index], texture)) {
+		activateTextureUnit(unit);
+		glBindTexture(target, texture);
+	}
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+	// an unknown active unit would leave an unknown binding behind
+	if (!this->active_texture_unit.has_value()) activateTextureUnit(0);
+	bindTexture(this->active_texture_unit.value(), target, texture);
+}
+
+void GLStateCache::bindSampler(GLuint unit, GLuint sampler)
+{
+	if (unit >= MAX_TEXTURE_UNITS) {
+		++this->stats.issued;
+		glBindSampler(unit, sampler);
+		return;
+	}
+	if (change(this->texture_units[unit].sampler, sampler)) glBindSampler(unit, sampler);
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+	const int target_index = findTarget(BUFFER_TARGETS, target);
+	if (target_index < 0) {
+		++this->stats.issued;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (change(this->buffers[target_index], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	const int target_index = findTarget(INDEXED_BUFFER_TARGETS, target);
+	if (index >= MAX_BUFFER_INDICES || target_index < 0) {
+		++this->stats.issued;
+		glBindBufferBase(target, index, buffer);
+	} else if (change(this->indexed_buffers[target_index][index], buffer)) {
+		glBindBufferBase(target, index, buffer);
+	} else {
+		return;
+	}
+	// glBindBufferBase binds the generic binding point as well
+	const int generic_index = findTarget(BUFFER_TARGETS, target);
+	if (generic_index >= 0) this->buffers[generic_index] = buffer;
+}
+
+void GLStateCache::setCapability(GLenum capability, bool enabled)
+{
+	auto it = this->capabilities.find(capability);
+	if (it != this->capabilities.end() && it->second == enabled) {
+		++this->stats.skipped;
+		return;
+	}
+	++this->stats.issued;
+	this->capabilities.insert_or_assign(capability, enabled);
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+void GLStateCache::setBlendFunc(GLenum source_factor, GLenum destination_factor)
+{
+	if (change(this->blend_func, std::make_pair(source_factor, destination_factor))) glBlendFunc(source_factor, destination_factor);
+}
+
+void GLStateCache::setDepthFunc(GLenum function)
+{
+	if (change(this->depth_func, function)) glDepthFunc(function);
+}
+
+void GLStateCache::setDepthMask(bool write)
+{
+	if (change(this->depth_mask, write)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::setColorMask(bool write)
+{
+	const GLboolean value = write ? GL_TRUE : GL_FALSE;
+	if (change(this->color_mask, write)) glColorMask(value, value, value, value);
+}
+
+void GLStateCache::setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (change(this->viewport, std::array<GLint, 4>{ x, y, width, height })) glViewport(x, y, width, height);
+}
+
+void GLStateCache::setPointSize(GLfloat size)
+{
+	if (change(this->point_size, size)) glPointSize(size);
+}
+
+void GLStateCache::setLineWidth(GLfloat width)
+{
+	if (change(this->line_width, width)) glLineWidth(width);
+}
+
+void GLStateCache::setPatchVertices(GLint vertices)
+{
+	if (change(this->patch_vertices, vertices)) glPatchParameteri(GL_PATCH_VERTICES, vertices);
+}
+
+// deleted names may be reused by GL, so their cached bindings are forgotten instead of reset to 0
+
+void GLStateCache::deleteFramebuffers(GLsizei count, const GLuint * framebuffers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (this->framebuffer == framebuffers[i]) this->framebuffer.reset();
+	}
+	glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLStateCache::deleteProgram(GLuint program)
+{
+	if (this->program == program) this->program.reset();
+	glDeleteProgram(program);
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint * vertex_arrays)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (this->vertex_array == vertex_arrays[i]) this->vertex_array.reset();
+	}
+	glDeleteVertexArrays(count, vertex_arrays);
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint * textures)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (TextureUnit & unit : this->texture_units)
+		{
+			for (auto & texture : unit.textures)
+			{
+				if (texture == textures[i]) texture.reset();
+			}
+		}
+	}
+	glDeleteTextures(count, textures);
+}
+
+void GLStateCache::deleteSamplers(GLsizei count, const GLuint * samplers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (TextureUnit & unit : this->texture_units)
+		{
+			if (unit.sampler == samplers[i]) unit.sampler.reset();
+		}
+	}
+	glDeleteSamplers(count, samplers);
+}
+
+void GLStateCache::deleteBuffers(GLsizei count, const GLuint * buffers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (auto & buffer : this->buffers)
+		{
+			if (buffer == buffers[i]) buffer.reset();
+		}
+		for (auto & indices : this->indexed_buffers)
+		{
+			for (auto & buffer : indices)
+			{
+				if (buffer == buffers[i]) buffer.reset();
+			}
+		}
+	}
+	glDeleteBuffers(count, buffers);
+}
+
+std::optional<GLuint> GLStateCache::getFramebuffer()
+{
+	return this->framebuffer;
+}
+
+std::optional<GLuint> GLStateCache::getProgram()
+{
+	return this->program;
+}
+
+StateChangeStats GLStateCache::getStats()
+{
+	return this->stats;
+}
+
+void GLStateCache::resetStats()
+{
+	this->stats = StateChangeStats();
+}
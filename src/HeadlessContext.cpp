@@ -0,0 +1,154 @@
+#include <GLRF/HeadlessContext.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+#if defined(GLRF_HEADLESS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#elif defined(GLRF_HEADLESS_OSMESA)
+// glad already defines the OpenGL types, so the GL/gl.h that osmesa.h includes is skipped
+#include <GL/osmesa.h>
+#endif
+
+using namespace GLRF;
+
+namespace {
+	// the newest versions first, compute shaders need at least 4.3
+	const int CONTEXT_VERSIONS[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 } };
+}
+
+#if defined(GLRF_HEADLESS_EGL)
+
+// surfaceless contexts have no buffer that the resolution would size
+HeadlessContext::HeadlessContext(ScreenResolution)
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+	if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		std::cout << "ERROR::HEADLESS::EGL_INITIALIZATION_FAILED: " << eglGetError() << std::endl;
+		throw std::runtime_error("Failed to initialize EGL!");
+	}
+	this->display = display;
+
+	// the surface type defaults to EGL_WINDOW_BIT, but the surfaceless platform of Mesa only exposes pbuffer configurations
+	const EGLint config_attributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, config_attributes, &config, 1, &num_configs) || num_configs == 0) {
+		eglTerminate(display);
+		throw std::runtime_error("EGL has no configuration for desktop OpenGL!");
+	}
+
+	for (const int (&version)[2] : CONTEXT_VERSIONS)
+	{
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, version[0],
+			EGL_CONTEXT_MINOR_VERSION, version[1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+		if (context != EGL_NO_CONTEXT) {
+			this->context = context;
+			break;
+		}
+	}
+	// surfaceless contexts are made current without any surface
+	if (!this->context || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, static_cast<EGLContext>(this->context))) {
+		std::cout << "ERROR::HEADLESS::EGL_CONTEXT_FAILED: " << eglGetError() << std::endl;
+		if (this->context) eglDestroyContext(display, static_cast<EGLContext>(this->context));
+		eglTerminate(display);
+		throw std::runtime_error("Failed to create a surfaceless EGL context!");
+	}
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	EGLDisplay display = static_cast<EGLDisplay>(this->display);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, static_cast<EGLContext>(this->context));
+	eglTerminate(display);
+}
+
+bool HeadlessContext::isAvailable()
+{
+	return true;
+}
+
+GLADloadproc HeadlessContext::getLoader()
+{
+	return (GLADloadproc)eglGetProcAddress;
+}
+
+#elif defined(GLRF_HEADLESS_OSMESA)
+
+HeadlessContext::HeadlessContext(ScreenResolution resolution)
+{
+	OSMesaContext context = NULL;
+	for (const int (&version)[2] : CONTEXT_VERSIONS)
+	{
+		const int attributes[] = {
+			OSMESA_FORMAT, OSMESA_RGBA,
+			OSMESA_DEPTH_BITS, 24,
+			OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+			OSMESA_CONTEXT_MAJOR_VERSION, version[0],
+			OSMESA_CONTEXT_MINOR_VERSION, version[1],
+			0
+		};
+		context = OSMesaCreateContextAttribs(attributes, NULL);
+		if (context) break;
+	}
+	if (!context) throw std::runtime_error("Failed to create an OSMesa context!");
+	this->context = context;
+
+	this->buffer.resize(static_cast<size_t>(resolution.width) * resolution.height * 4);
+	if (!OSMesaMakeCurrent(context, this->buffer.data(), GL_UNSIGNED_BYTE, resolution.width, resolution.height)) {
+		OSMesaDestroyContext(context);
+		throw std::runtime_error("Failed to make the OSMesa context current!");
+	}
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	OSMesaDestroyContext(static_cast<OSMesaContext>(this->context));
+}
+
+bool HeadlessContext::isAvailable()
+{
+	return true;
+}
+
+GLADloadproc HeadlessContext::getLoader()
+{
+	return (GLADloadproc)OSMesaGetProcAddress;
+}
+
+#else
+
+HeadlessContext::HeadlessContext(ScreenResolution)
+{
+	throw std::runtime_error("GLRF was built without a headless backend, configure it with GLRF_HEADLESS_BACKEND=EGL or OSMESA!");
+}
+
+HeadlessContext::~HeadlessContext()
+{
+
+}
+
+bool HeadlessContext::isAvailable()
+{
+	return false;
+}
+
+GLADloadproc HeadlessContext::getLoader()
+{
+	return nullptr;
+}
+
+#endif
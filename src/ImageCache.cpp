@@ -0,0 +1,240 @@
+#include <GLRF/ImageCache.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+#include <GLRF/AssetArchive.hpp>
+#include <GLRF/Hash.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// bump whenever decoded images change (e.g. the mip filters), so outdated entries are not used anymore
+	const std::string CACHE_VERSION = "image cache 1";
+	const std::string ENTRY_NAME = "image";
+	const std::string ENTRY_EXTENSION = ".bin";
+}
+
+ImageCache::ImageCache()
+{
+
+}
+
+ImageCache::~ImageCache()
+{
+
+}
+
+bool ImageCache::createKey(const std::string & path, const std::string & parameters, std::string & key)
+{
+	std::error_code error;
+	const fs::file_time_type modified = fs::last_write_time(path, error);
+	if (error) return false;
+	const std::uintmax_t size = fs::file_size(path, error);
+	if (error) return false;
+
+	const std::string description = CACHE_VERSION + "\n" + fs::absolute(path, error).generic_string() + "\n"
+		+ std::to_string(modified.time_since_epoch().count()) + "\n" + std::to_string(size) + "\n" + parameters;
+	key = toHexString(fnv1a64(description));
+	return true;
+}
+
+fs::path ImageCache::getEntryFile(const std::string & key)
+{
+	return this->directory / (key + ENTRY_EXTENSION);
+}
+
+void ImageCache::scanDirectory()
+{
+	if (this->scanned) return;
+	this->scanned = true;
+
+	std::error_code error;
+	for (auto & file : fs::directory_iterator(this->directory, error))
+	{
+		if (!file.is_regular_file(error)) continue;
+		const fs::path & path = file.path();
+		if (path.extension() != ENTRY_EXTENSION) {
+			// left behind by a run that was cancelled while writing
+			if (path.extension() == ".tmp") fs::remove(path, error);
+			continue;
+		}
+		Entry entry;
+		entry.size = static_cast<size_t>(file.file_size(error));
+		entry.last_access = file.last_write_time(error);
+		this->entries.insert_or_assign(path.stem().string(), entry);
+		this->total_size += entry.size;
+	}
+}
+
+void ImageCache::removeEntry(const std::string & key)
+{
+	auto it = this->entries.find(key);
+	if (it == this->entries.end()) return;
+	std::error_code error;
+	fs::remove(getEntryFile(key), error);
+	this->total_size -= it->second.size;
+	this->entries.erase(it);
+}
+
+void ImageCache::evict(const std::string & keep)
+{
+	while (this->total_size > this->max_size)
+	{
+		auto oldest = this->entries.end();
+		for (auto it = this->entries.begin(); it != this->entries.end(); ++it)
+		{
+			if (it->first == keep) continue;
+			if (oldest == this->entries.end() || it->second.last_access < oldest->second.last_access) oldest = it;
+		}
+		if (oldest == this->entries.end()) break;
+		removeEntry(oldest->first);
+		++(this->stats.evictions);
+	}
+}
+
+ImageData ImageCache::load(const std::string & path, const std::string & parameters, bool srgb)
+{
+	std::string key;
+	fs::path file;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->enabled) return ImageData();
+		scanDirectory();
+		if (!createKey(path, parameters, key) || this->entries.find(key) == this->entries.end()) {
+			++(this->stats.misses);
+			return ImageData();
+		}
+		file = getEntryFile(key);
+	}
+
+	// the entry is mapped outside of the lock, the image keeps the mapping alive until it is uploaded
+	ImageData image;
+	try {
+		image = AssetArchive(file).loadImage(ENTRY_NAME, srgb);
+	}
+	catch (const std::runtime_error & e) {
+		std::cout << e.what() << ", decoding '" << path << "' again." << std::endl;
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (image.isEmpty()) {
+		removeEntry(key);
+		++(this->stats.misses);
+		return image;
+	}
+	auto it = this->entries.find(key);
+	if (it != this->entries.end()) {
+		it->second.last_access = fs::file_time_type::clock::now();
+		// the access order is persisted in the modification time of the file
+		std::error_code error;
+		fs::last_write_time(file, it->second.last_access, error);
+	}
+	++(this->stats.hits);
+	this->stats.bytes_read += image.getStorageSize();
+	return image;
+}
+
+void ImageCache::store(const std::string & path, const std::string & parameters, const ImageData & image)
+{
+	if (image.isEmpty()) return;
+	std::string key;
+	fs::path file;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->enabled || !createKey(path, parameters, key)) return;
+		scanDirectory();
+		// another thread may be writing the same entry already
+		if (this->entries.find(key) != this->entries.end() || !this->pending.insert(key).second) return;
+		file = getEntryFile(key);
+	}
+
+	std::error_code error;
+	fs::create_directories(this->directory, error);
+	AssetArchiveWriter writer;
+	writer.addTexture(ENTRY_NAME, image, fnv1a64(key));
+	const bool written = writer.write(file);
+	const size_t size = written ? static_cast<size_t>(fs::file_size(file, error)) : 0;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->pending.erase(key);
+	if (!written || error) {
+		std::cout << "Could not write image cache entry '" << file.generic_string() << "'." << std::endl;
+		return;
+	}
+	Entry entry;
+	entry.size = size;
+	entry.last_access = fs::file_time_type::clock::now();
+	this->entries.insert_or_assign(key, entry);
+	this->total_size += size;
+	++(this->stats.stores);
+	this->stats.bytes_written += size;
+	evict(key);
+}
+
+void ImageCache::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	scanDirectory();
+	while (!this->entries.empty())
+	{
+		removeEntry(this->entries.begin()->first);
+	}
+}
+
+void ImageCache::setEnabled(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->enabled = enabled;
+}
+
+bool ImageCache::isEnabled()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->enabled;
+}
+
+void ImageCache::setDirectory(fs::path directory)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->directory = directory;
+	this->entries.clear();
+	this->total_size = 0;
+	this->scanned = false;
+}
+
+fs::path ImageCache::getDirectory()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->directory;
+}
+
+void ImageCache::setMaxSize(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->max_size = bytes;
+	scanDirectory();
+	evict("");
+}
+
+size_t ImageCache::getMaxSize()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->max_size;
+}
+
+ImageCacheStats ImageCache::getStats()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	scanDirectory();
+	ImageCacheStats result = this->stats;
+	result.entry_count = this->entries.size();
+	result.total_size = this->total_size;
+	return result;
+}
+
+void ImageCache::resetStats()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->stats = ImageCacheStats();
+}
@@ -0,0 +1,242 @@
+#include <GLRF/ImageData.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+using namespace GLRF;
+
+size_t TextureFormat::getTexelSize() const
+{
+	return static_cast<size_t>(this->channels) * this->bytes_per_channel;
+}
+
+bool TextureFormat::isCompressed() const
+{
+	return this->block_size > 0;
+}
+
+size_t TextureFormat::calculateLevelSize(GLsizei width, GLsizei height) const
+{
+	if (isCompressed()) {
+		return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * this->block_size;
+	}
+	return static_cast<size_t>(width) * static_cast<size_t>(height) * getTexelSize();
+}
+
+size_t TextureFormat::calculateStorageSize(GLsizei width, GLsizei height) const
+{
+	if (isCompressed()) return calculateLevelSize(width, height);
+	return static_cast<size_t>(width) * static_cast<size_t>(height) * getStorageTexelSize();
+}
+
+size_t TextureFormat::getStorageTexelSize() const
+{
+	// floating point images are kept as 32 bit on the CPU, but stored with half precision
+	if (this->internal_format == GL_RGBA16F) return 4 * sizeof(GLhalf);
+	return getTexelSize();
+}
+
+void TextureFormat::getSwizzleMask(GLint * mask) const
+{
+	switch (this->channels)
+	{
+	case 1:
+		mask[0] = GL_RED;	mask[1] = GL_RED;	mask[2] = GL_RED;	mask[3] = GL_ONE;
+		break;
+	case 2:
+		mask[0] = GL_RED;	mask[1] = GL_RED;	mask[2] = GL_RED;	mask[3] = GL_GREEN;
+		break;
+	default:
+		mask[0] = GL_RED;	mask[1] = GL_GREEN;	mask[2] = GL_BLUE;	mask[3] = GL_ALPHA;
+		break;
+	}
+}
+
+TextureFormat TextureFormat::select(TextureSourceType source_type, int source_channels, bool srgb)
+{
+	TextureFormat format;
+	// three channel images are padded to four channels, RGB8 is stored as RGBA8 by most drivers anyway
+	format.channels = (srgb || source_channels >= 3) ? 4 : std::max(source_channels, 1);
+	format.is_srgb = false;
+
+	switch (source_type)
+	{
+	case TextureSourceType::HDR:
+		format.channels = 4;
+		format.bytes_per_channel = sizeof(float);
+		format.data_type = GL_FLOAT;
+		format.pixel_format = GL_RGBA;
+		format.internal_format = GL_RGBA16F;
+		return format;
+	case TextureSourceType::LDR16:
+		format.bytes_per_channel = sizeof(unsigned short);
+		format.data_type = GL_UNSIGNED_SHORT;
+		break;
+	case TextureSourceType::LDR:
+	default:
+		format.bytes_per_channel = sizeof(unsigned char);
+		format.data_type = GL_UNSIGNED_BYTE;
+		break;
+	}
+
+	const bool is_16_bit = source_type == TextureSourceType::LDR16;
+	switch (format.channels)
+	{
+	case 1:
+		format.pixel_format = GL_RED;
+		format.internal_format = is_16_bit ? GL_R16 : GL_R8;
+		break;
+	case 2:
+		format.pixel_format = GL_RG;
+		format.internal_format = is_16_bit ? GL_RG16 : GL_RG8;
+		break;
+	default:
+		format.pixel_format = GL_RGBA;
+		if (srgb && !is_16_bit) {
+			format.internal_format = GL_SRGB8_ALPHA8;
+			format.is_srgb = true;
+		} else {
+			format.internal_format = is_16_bit ? GL_RGBA16 : GL_RGBA8;
+		}
+		break;
+	}
+	return format;
+}
+
+ImageData::ImageData()
+{
+
+}
+
+ImageData::ImageData(GLsizei width, GLsizei height, TextureFormat format, GLuint num_levels)
+{
+	this->format = format;
+	this->levels.reserve(num_levels);
+	size_t offset = 0;
+	GLsizei level_width = width;
+	GLsizei level_height = height;
+	for (GLuint i = 0; i < num_levels; ++i)
+	{
+		ImageLevel level;
+		level.width = level_width;
+		level.height = level_height;
+		level.offset = offset;
+		level.size = format.calculateLevelSize(level_width, level_height);
+		offset += level.size;
+		this->levels.push_back(level);
+		level_width = std::max(level_width / 2, 1);
+		level_height = std::max(level_height / 2, 1);
+	}
+	this->storage_size = offset;
+	this->storage = std::shared_ptr<unsigned char>(new unsigned char[offset], std::default_delete<unsigned char[]>());
+}
+
+ImageData::ImageData(TextureFormat format, std::vector<ImageLevel> levels, std::shared_ptr<unsigned char> storage, size_t storage_size)
+{
+	this->format = format;
+	this->levels = levels;
+	this->storage = storage;
+	this->storage_size = storage_size;
+}
+
+ImageData ImageData::decode(const std::string & path, bool srgb)
+{
+	const char * path_c = path.c_str();
+	TextureSourceType source_type = TextureSourceType::LDR;
+	if (stbi_is_hdr(path_c)) {
+		source_type = TextureSourceType::HDR;
+	} else if (stbi_is_16_bit(path_c)) {
+		source_type = TextureSourceType::LDR16;
+	}
+
+	int width, height, source_channels;
+	if (!stbi_info(path_c, &width, &height, &source_channels)) {
+		return ImageData();
+	}
+	TextureFormat format = TextureFormat::select(source_type, source_channels, srgb);
+	const int requested_channels = static_cast<int>(format.channels);
+
+	void * pixels = nullptr;
+	switch (source_type)
+	{
+	case TextureSourceType::HDR:
+		pixels = stbi_loadf(path_c, &width, &height, &source_channels, requested_channels);
+		break;
+	case TextureSourceType::LDR16:
+		pixels = stbi_load_16(path_c, &width, &height, &source_channels, requested_channels);
+		break;
+	case TextureSourceType::LDR:
+	default:
+		pixels = stbi_load(path_c, &width, &height, &source_channels, requested_channels);
+		break;
+	}
+	if (!pixels) {
+		return ImageData();
+	}
+
+	ImageData image(width, height, format, 1);
+	std::memcpy(image.getLevelData(0), pixels, image.getLevel(0).size);
+	stbi_image_free(pixels);
+	return image;
+}
+
+GLuint ImageData::calculateMipCount(GLsizei width, GLsizei height)
+{
+	GLuint count = 1;
+	GLsizei size = std::max(width, height);
+	while (size > 1)
+	{
+		size /= 2;
+		++count;
+	}
+	return count;
+}
+
+bool ImageData::isEmpty() const
+{
+	return this->levels.empty();
+}
+
+GLsizei ImageData::getWidth() const
+{
+	return this->levels.empty() ? 0 : this->levels[0].width;
+}
+
+GLsizei ImageData::getHeight() const
+{
+	return this->levels.empty() ? 0 : this->levels[0].height;
+}
+
+const TextureFormat & ImageData::getFormat() const
+{
+	return this->format;
+}
+
+GLuint ImageData::getLevelCount() const
+{
+	return static_cast<GLuint>(this->levels.size());
+}
+
+const ImageLevel & ImageData::getLevel(GLuint level) const
+{
+	return this->levels.at(level);
+}
+
+const unsigned char * ImageData::getLevelData(GLuint level) const
+{
+	return this->storage.get() + this->levels.at(level).offset;
+}
+
+unsigned char * ImageData::getLevelData(GLuint level)
+{
+	return this->storage.get() + this->levels.at(level).offset;
+}
+
+size_t ImageData::getStorageSize() const
+{
+	return this->storage_size;
+}
@@ -15,16 +15,18 @@ MaterialProperty<T>::MaterialProperty(T value_default) {
 }
 
 template<typename T>
-void MaterialProperty<T>::loadTexture(std::string library, std::string texture_name, std::string separator, std::string property_name, std::string fileType)
+void MaterialProperty<T>::loadTexture(std::string library, std::string texture_name, std::string separator, std::string property_name, std::string fileType,
+	TextureConfiguration config)
 {
-	auto tmp = std::shared_ptr<Texture>(new Texture(library, texture_name + separator + property_name + period + fileType));
+	auto tmp = std::shared_ptr<Texture>(new Texture(library, texture_name + separator + property_name + period + fileType, config));
 	if (tmp->isSuccessfullyLoaded()) this->texture = tmp;
 }
 
 template<typename T>
-void MaterialProperty<T>::loadTexture(std::string texture_name, std::string separator, std::string property_name, std::string fileType)
+void MaterialProperty<T>::loadTexture(std::string texture_name, std::string separator, std::string property_name, std::string fileType,
+	TextureConfiguration config)
 {
-	auto tmp = std::shared_ptr<Texture>(new Texture(texture_name + separator + property_name + period + fileType));
+	auto tmp = std::shared_ptr<Texture>(new Texture(texture_name + separator + property_name + period + fileType, config));
 	if (tmp->isSuccessfullyLoaded()) this->texture = tmp;
 }
 
@@ -40,26 +42,40 @@ Material::Material() {
 	this->height_scale = 1.0f;
 }
 
-void Material::loadTextures(std::string library, std::string name, std::string separator, std::string fileType)
+void Material::loadTextures(std::string library, std::string name, std::string separator, std::string fileType,
+	MaterialTextureOptions options)
 {
-	this->albedo.loadTexture(library, name, separator, "albedo", fileType);
-	this->normal.loadTexture(library, name, separator, "normal", fileType);
-	this->roughness.loadTexture(library, name, separator, "roughness", fileType);
-	this->metallic.loadTexture(library, name, separator, "metallic", fileType);
-	this->ao.loadTexture(library, name, separator, "ao", fileType);
-	this->height.loadTexture(library, name, separator, "height", fileType);
-	this->opacity.loadTexture(library, name, separator, "opacity", fileType);
+	this->albedo.loadTexture(library, name, separator, "albedo", fileType, getTextureConfiguration("albedo", options));
+	this->normal.loadTexture(library, name, separator, "normal", fileType, getTextureConfiguration("normal", options));
+	this->roughness.loadTexture(library, name, separator, "roughness", fileType, getTextureConfiguration("roughness", options));
+	this->metallic.loadTexture(library, name, separator, "metallic", fileType, getTextureConfiguration("metallic", options));
+	this->ao.loadTexture(library, name, separator, "ao", fileType, getTextureConfiguration("ao", options));
+	this->height.loadTexture(library, name, separator, "height", fileType, getTextureConfiguration("height", options));
+	this->opacity.loadTexture(library, name, separator, "opacity", fileType, getTextureConfiguration("opacity", options));
 }
 
-void Material::loadTextures(std::string name, std::string separator, std::string fileType)
+void Material::loadTextures(std::string name, std::string separator, std::string fileType,
+	MaterialTextureOptions options)
 {
-	this->albedo.loadTexture(name, separator, "albedo", fileType);
-	this->normal.loadTexture(name, separator, "normal", fileType);
-	this->roughness.loadTexture(name, separator, "roughness", fileType);
-	this->metallic.loadTexture(name, separator, "metallic", fileType);
-	this->ao.loadTexture(name, separator, "ao", fileType);
-	this->height.loadTexture(name, separator, "height", fileType);
-	this->opacity.loadTexture(name, separator, "opacity", fileType);
+	this->albedo.loadTexture(name, separator, "albedo", fileType, getTextureConfiguration("albedo", options));
+	this->normal.loadTexture(name, separator, "normal", fileType, getTextureConfiguration("normal", options));
+	this->roughness.loadTexture(name, separator, "roughness", fileType, getTextureConfiguration("roughness", options));
+	this->metallic.loadTexture(name, separator, "metallic", fileType, getTextureConfiguration("metallic", options));
+	this->ao.loadTexture(name, separator, "ao", fileType, getTextureConfiguration("ao", options));
+	this->height.loadTexture(name, separator, "height", fileType, getTextureConfiguration("height", options));
+	this->opacity.loadTexture(name, separator, "opacity", fileType, getTextureConfiguration("opacity", options));
+}
+
+TextureConfiguration Material::getTextureConfiguration(const std::string & property_name, const MaterialTextureOptions & options)
+{
+	TextureConfiguration config;
+	config.streamed = options.streamed;
+	config.async = options.async;
+	config.sampler = options.sampler;
+	config.srgb = property_name == "albedo";
+	config.mips.normal_map = property_name == "normal";
+	if (property_name == "opacity") config.mips.alpha_cutoff = options.alpha_cutoff;
+	return config;
 }
 
 void Material::bindTextures(GLuint textureUnitsBegin)
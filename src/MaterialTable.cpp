@@ -0,0 +1,514 @@
+#include <GLRF/MaterialTable.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+
+#include <GLRF/EnvironmentMap.hpp>
+#include <GLRF/GLExtensions.hpp>
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+MaterialTable::MaterialTable()
+{
+
+}
+
+MaterialTable::~MaterialTable()
+{
+
+}
+
+std::array<Texture *, MaterialTable::NUM_TEXTURE_SLOTS> MaterialTable::getTextures(Material * material)
+{
+	auto get = [](auto & property) -> Texture * {
+		return property.texture.has_value() ? property.texture.value().get() : nullptr;
+	};
+	// the slot order matches the texture units of Material::bindTextures
+	return {
+		get(material->albedo), get(material->normal), get(material->roughness), get(material->metallic),
+		get(material->ao), get(material->height), get(material->opacity)
+	};
+}
+
+std::optional<GLuint> MaterialTable::getIndex(std::shared_ptr<Material> material)
+{
+	if (!material) return std::nullopt;
+
+	auto it = this->indices.find(material);
+	if (it != this->indices.end())
+	{
+		return it->second;
+	}
+
+	Entry entry;
+	if (!buildEntry(material.get(), &entry)) return std::nullopt;
+
+	// the slots of destroyed materials are reused, so the table only grows with the number of live materials
+	GLuint index;
+	if (!this->free_slots.empty()) {
+		index = this->free_slots.back();
+		this->free_slots.pop_back();
+		this->entries[index] = entry;
+	} else {
+		index = static_cast<GLuint>(this->entries.size());
+		this->entries.push_back(entry);
+		this->slots.emplace_back();
+	}
+	Slot & slot = this->slots[index];
+	slot.material = material;
+	slot.textures = getTextures(material.get());
+	slot.used = true;
+	this->indices.insert_or_assign(std::weak_ptr<Material>(material), index);
+	markDirty(index);
+	return index;
+}
+
+void MaterialTable::invalidate(std::shared_ptr<Material> material)
+{
+	auto it = this->indices.find(material);
+	if (it == this->indices.end()) return;
+
+	this->stale_entries.insert(it->second);
+	markDirty(it->second);
+	rebuildStaleEntries();
+}
+
+void MaterialTable::invalidateTexture(Texture * texture)
+{
+	bool referenced = false;
+	auto handle_it = this->texture_handles.find(texture);
+	if (handle_it != this->texture_handles.end())
+	{
+		// the handle has to be released while the texture object still exists
+		GLExtensions::getInstance().makeTextureHandleNonResidentARB(handle_it->second);
+		this->texture_handles.erase(handle_it);
+		referenced = true;
+	}
+	auto location_it = this->texture_locations.find(texture);
+	if (location_it != this->texture_locations.end())
+	{
+		// the layer is reused by the next texture of the same size and format
+		TextureArray & texture_array = this->arrays[location_it->second.first];
+		const GLsizei layer = static_cast<GLsizei>(location_it->second.second);
+		texture_array.layers[layer] = nullptr;
+		texture_array.pending_layers.erase(std::remove(texture_array.pending_layers.begin(), texture_array.pending_layers.end(), layer),
+			texture_array.pending_layers.end());
+		this->texture_locations.erase(location_it);
+		referenced = true;
+	}
+	if (!referenced) return;
+
+	for (size_t i = 0; i < this->slots.size(); ++i)
+	{
+		const Slot & slot = this->slots[i];
+		if (!slot.used || std::find(slot.textures.begin(), slot.textures.end(), texture) == slot.textures.end()) continue;
+		// the entry is rebuilt once the texture has its new storage
+		this->stale_entries.insert(i);
+		markDirty(i);
+	}
+}
+
+void MaterialTable::collectChanges()
+{
+	for (size_t i = 0; i < this->slots.size(); ++i)
+	{
+		Slot & slot = this->slots[i];
+		if (!slot.used) continue;
+		std::shared_ptr<Material> material = slot.material.lock();
+		if (!material) {
+			releaseSlot(i);
+			continue;
+		}
+		// the public properties can be edited directly, so the values and textures are compared instead of relying on invalidate()
+		Entry values;
+		writeValues(material.get(), &values);
+		const size_t values_begin = offsetof(Entry, albedo);
+		const size_t values_end = offsetof(Entry, padding_values);
+		const bool values_changed = std::memcmp(reinterpret_cast<const char *>(&values) + values_begin,
+			reinterpret_cast<const char *>(&(this->entries[i])) + values_begin, values_end - values_begin) != 0;
+		if (values_changed || getTextures(material.get()) != slot.textures) {
+			this->stale_entries.insert(i);
+			markDirty(i);
+		}
+	}
+}
+
+void MaterialTable::rebuildStaleEntries()
+{
+	for (size_t index : this->stale_entries)
+	{
+		Slot & slot = this->slots[index];
+		if (!slot.used) continue;
+		std::shared_ptr<Material> material = slot.material.lock();
+		Entry entry;
+		if (material && buildEntry(material.get(), &entry)) {
+			this->entries[index] = entry;
+			slot.textures = getTextures(material.get());
+		} else {
+			// the material is gone or can no longer be represented, so it falls back to bound textures
+			releaseSlot(index);
+		}
+	}
+	this->stale_entries.clear();
+}
+
+void MaterialTable::releaseSlot(size_t index)
+{
+	this->indices.erase(this->slots[index].material);
+	this->slots[index] = Slot();
+	this->entries[index] = Entry();
+	this->free_slots.push_back(static_cast<GLuint>(index));
+	markDirty(index);
+}
+
+size_t MaterialTable::getMaterialCount()
+{
+	return this->indices.size();
+}
+
+GLuint MaterialTable::getMaxTextureArrays()
+{
+	if (this->max_texture_arrays == 0)
+	{
+		GLint units = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+		const GLint available = units - static_cast<GLint>(TEXTURE_UNITS_BEGIN + EnvironmentMap::NUM_TEXTURE_UNITS);
+		this->max_texture_arrays = static_cast<GLuint>(std::clamp<GLint>(available, 1, static_cast<GLint>(MAX_TEXTURE_ARRAYS)));
+	}
+	return this->max_texture_arrays;
+}
+
+GLuint MaterialTable::getTextureUnitsEnd()
+{
+	return TEXTURE_UNITS_BEGIN + getMaxTextureArrays();
+}
+
+void MaterialTable::markDirty(size_t index)
+{
+	if (!this->is_dirty) {
+		this->dirty_begin = index;
+		this->dirty_end = index + 1;
+	} else {
+		this->dirty_begin = std::min(this->dirty_begin, index);
+		this->dirty_end = std::max(this->dirty_end, index + 1);
+	}
+	this->is_dirty = true;
+}
+
+void MaterialTable::writeValues(Material * material, Entry * entry)
+{
+	entry->albedo[0] = material->albedo.value_default.x;
+	entry->albedo[1] = material->albedo.value_default.y;
+	entry->albedo[2] = material->albedo.value_default.z;
+	entry->albedo[3] = 1.f;
+	entry->normal[0] = material->normal.value_default.x;
+	entry->normal[1] = material->normal.value_default.y;
+	entry->normal[2] = material->normal.value_default.z;
+	entry->normal[3] = 1.f;
+	entry->roughness = material->roughness.value_default;
+	entry->metallic = material->metallic.value_default;
+	entry->ao = material->ao.value_default;
+	entry->height = material->height.value_default;
+	entry->opacity = material->opacity.value_default;
+	entry->height_scale = material->height_scale;
+}
+
+bool MaterialTable::buildEntry(Material * material, Entry * entry)
+{
+	writeValues(material, entry);
+
+	auto textures = getTextures(material);
+	const bool bindless = usesBindlessTextures();
+
+	// validate all slots first, so a rejected material does not leave textures in the arrays
+	size_t new_arrays = 0;
+	std::vector<ArrayKey> new_keys;
+	for (auto & texture : textures)
+	{
+		if (!texture) continue;
+		if (texture->getConfiguration().streamed || !texture->isSuccessfullyLoaded()) return false;
+		if (bindless || this->texture_locations.count(texture) > 0) continue;
+
+		ArrayKey key(texture->getWidth(), texture->getHeight(), texture->getFormat().internal_format, texture->getLevelCount(), texture->getSampler());
+		bool has_array = std::any_of(this->arrays.begin(), this->arrays.end(), [&key](const TextureArray & a) { return a.key == key; })
+			|| std::find(new_keys.begin(), new_keys.end(), key) != new_keys.end();
+		if (!has_array) {
+			new_keys.push_back(key);
+			++new_arrays;
+		}
+	}
+	if (this->arrays.size() + new_arrays > getMaxTextureArrays()) return false;
+
+	for (GLuint slot = 0; slot < NUM_TEXTURE_SLOTS; ++slot)
+	{
+		if (!textures[slot]) continue;
+		std::optional<TextureReference> reference = addTexture(textures[slot]);
+		if (!reference.has_value()) return false;
+		entry->textures[slot] = reference.value();
+		entry->flags |= 1u << slot;
+	}
+	return true;
+}
+
+std::optional<MaterialTable::TextureReference> MaterialTable::addTexture(Texture * texture)
+{
+	TextureReference reference;
+	if (usesBindlessTextures())
+	{
+		GLExtensions & extensions = GLExtensions::getInstance();
+		auto it = this->texture_handles.find(texture);
+		GLuint64 handle;
+		if (it != this->texture_handles.end()) {
+			handle = it->second;
+		} else {
+			handle = extensions.getTextureSamplerHandleARB(texture->getID(), texture->getSampler());
+			if (handle == 0) return std::nullopt;
+			extensions.makeTextureHandleResidentARB(handle);
+			this->texture_handles.insert_or_assign(texture, handle);
+		}
+		reference.x = static_cast<GLuint>(handle & 0xFFFFFFFFull);
+		reference.y = static_cast<GLuint>(handle >> 32);
+		return reference;
+	}
+
+	auto it = this->texture_locations.find(texture);
+	if (it == this->texture_locations.end())
+	{
+		ArrayKey key(texture->getWidth(), texture->getHeight(), texture->getFormat().internal_format, texture->getLevelCount(), texture->getSampler());
+		auto array_it = std::find_if(this->arrays.begin(), this->arrays.end(), [&key](const TextureArray & a) { return a.key == key; });
+		if (array_it == this->arrays.end())
+		{
+			if (this->arrays.size() >= getMaxTextureArrays()) return std::nullopt;
+			TextureArray texture_array;
+			texture_array.key = key;
+			this->arrays.push_back(texture_array);
+			array_it = this->arrays.end() - 1;
+		}
+		GLuint array_index = static_cast<GLuint>(array_it - this->arrays.begin());
+		auto free_it = std::find(array_it->layers.begin(), array_it->layers.end(), nullptr);
+		GLuint layer = static_cast<GLuint>(free_it - array_it->layers.begin());
+		if (free_it == array_it->layers.end()) {
+			array_it->layers.push_back(texture);
+		} else {
+			*free_it = texture;
+		}
+		array_it->pending_layers.push_back(static_cast<GLsizei>(layer));
+		it = this->texture_locations.insert_or_assign(texture, std::pair<GLuint, GLuint>(array_index, layer)).first;
+	}
+	reference.x = it->second.first;
+	reference.y = it->second.second;
+	return reference;
+}
+
+void MaterialTable::uploadArrays()
+{
+	for (TextureArray & texture_array : this->arrays)
+	{
+		if (texture_array.pending_layers.empty()) continue;
+
+		GLsizei num_layers = static_cast<GLsizei>(texture_array.layers.size());
+		const GLsizei width = std::get<0>(texture_array.key);
+		const GLsizei height = std::get<1>(texture_array.key);
+		const GLuint levels = std::get<3>(texture_array.key);
+		if (texture_array.capacity < num_layers)
+		{
+			// grow geometrically, the existing layers are copied on the GPU
+			GLsizei capacity = std::max(texture_array.capacity, 4);
+			while (capacity < num_layers) capacity *= 2;
+
+			GLuint ID = GLResources::createTexture(GL_TEXTURE_2D_ARRAY);
+			GLResources::textureStorage3D(ID, GL_TEXTURE_2D_ARRAY, levels, std::get<2>(texture_array.key), width, height, capacity);
+			GLint swizzle[4];
+			texture_array.layers[texture_array.pending_layers.front()]->getFormat().getSwizzleMask(swizzle);
+			GLResources::textureParameteriv(ID, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+			if (texture_array.ID != 0)
+			{
+				for (GLuint level = 0; level < levels; ++level)
+				{
+					glCopyImageSubData(texture_array.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+						std::max(width >> level, 1), std::max(height >> level, 1), texture_array.capacity);
+				}
+				// the copied textures are views of the old array, they move to the new one before it is deleted
+				for (GLsizei layer = 0; layer < texture_array.capacity && layer < num_layers; ++layer)
+				{
+					if (!texture_array.layers[layer]) continue;
+					if (std::find(texture_array.pending_layers.begin(), texture_array.pending_layers.end(), layer) != texture_array.pending_layers.end()) continue;
+					texture_array.layers[layer]->useArrayLayer(ID, static_cast<GLuint>(layer));
+				}
+				GLStateCache::getInstance().deleteTextures(1, &(texture_array.ID));
+			}
+			texture_array.ID = ID;
+			texture_array.capacity = capacity;
+		}
+
+		for (GLsizei layer : texture_array.pending_layers)
+		{
+			Texture * texture = texture_array.layers[layer];
+			for (GLuint level = 0; level < levels; ++level)
+			{
+				glCopyImageSubData(texture->getID(), GL_TEXTURE_2D, level, 0, 0, 0, texture_array.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+					std::max(width >> level, 1), std::max(height >> level, 1), 1);
+			}
+			// the own storage of the texture is released, it samples the slice from now on
+			texture->useArrayLayer(texture_array.ID, static_cast<GLuint>(layer));
+		}
+		texture_array.pending_layers.clear();
+	}
+}
+
+void MaterialTable::update()
+{
+	if (!this->is_dirty) return;
+
+	rebuildStaleEntries();
+	if (!usesBindlessTextures()) uploadArrays();
+
+	if (this->SSBO == 0) this->SSBO = GLResources::createBuffer();
+	GLsizeiptr size = static_cast<GLsizeiptr>(this->entries.size() * sizeof(Entry));
+	if (size > this->buffer_capacity) {
+		this->buffer_capacity = std::max(size, static_cast<GLsizeiptr>(64 * sizeof(Entry)));
+		while (this->buffer_capacity < size) this->buffer_capacity *= 2;
+		GLResources::bufferData(this->SSBO, this->buffer_capacity, NULL, GL_DYNAMIC_DRAW);
+		// the new storage is empty, so all entries are uploaded
+		this->dirty_begin = 0;
+		this->dirty_end = this->entries.size();
+	}
+	// only the entries of new or invalidated materials are uploaded
+	const size_t end = std::min(this->dirty_end, this->entries.size());
+	if (this->dirty_begin < end) {
+		GLResources::bufferSubData(this->SSBO, static_cast<GLintptr>(this->dirty_begin * sizeof(Entry)),
+			static_cast<GLsizeiptr>((end - this->dirty_begin) * sizeof(Entry)), this->entries.data() + this->dirty_begin);
+	}
+
+	this->is_dirty = false;
+	bindResources();
+}
+
+void MaterialTable::bind()
+{
+	collectChanges();
+	if (this->is_dirty) {
+		update();
+	} else {
+		bindResources();
+	}
+}
+
+void MaterialTable::bindResources()
+{
+	if (this->SSBO == 0) return;
+	GLStateCache & state = GLStateCache::getInstance();
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, SHADER_STORAGE_BINDING, this->SSBO);
+	if (usesBindlessTextures()) return;
+
+	for (GLuint i = 0; i < this->arrays.size(); ++i)
+	{
+		state.bindTexture(TEXTURE_UNITS_BEGIN + i, GL_TEXTURE_2D_ARRAY, this->arrays[i].ID);
+		state.bindSampler(TEXTURE_UNITS_BEGIN + i, std::get<4>(this->arrays[i].key));
+	}
+}
+
+bool MaterialTable::usesBindlessTextures()
+{
+	return GLExtensions::getInstance().hasBindlessTextures();
+}
+
+std::string MaterialTable::getGLSLInterface()
+{
+	const bool bindless = usesBindlessTextures();
+	std::stringstream glsl;
+	if (bindless) glsl << "#extension GL_ARB_bindless_texture : require\n";
+	glsl << "struct MaterialEntry {\n"
+		<< "\tuvec2 textures[" << NUM_TEXTURE_SLOTS << "];\n"
+		<< "\tuint flags;\n"
+		<< "\tuint padding;\n"
+		<< "\tvec4 albedo;\n"
+		<< "\tvec4 normal;\n"
+		<< "\tfloat roughness;\n"
+		<< "\tfloat metallic;\n"
+		<< "\tfloat ao;\n"
+		<< "\tfloat height;\n"
+		<< "\tfloat opacity;\n"
+		<< "\tfloat height_scale;\n"
+		<< "};\n"
+		<< "layout(std430, binding = " << SHADER_STORAGE_BINDING << ") readonly buffer MaterialTextureTable {\n"
+		<< "\tMaterialEntry material_entries[];\n"
+		<< "};\n"
+		<< "bool hasMaterialTexture(uint material_index, uint slot) {\n"
+		<< "\treturn (material_entries[material_index].flags & (1u << slot)) != 0u;\n"
+		<< "}\n"
+		<< "vec4 getMaterialValue(uint material_index, uint slot) {\n"
+		<< "\tswitch (slot) {\n"
+		<< "\tcase 0u: return material_entries[material_index].albedo;\n"
+		<< "\tcase 1u: return material_entries[material_index].normal;\n"
+		<< "\tcase 2u: return vec4(material_entries[material_index].roughness);\n"
+		<< "\tcase 3u: return vec4(material_entries[material_index].metallic);\n"
+		<< "\tcase 4u: return vec4(material_entries[material_index].ao);\n"
+		<< "\tcase 5u: return vec4(material_entries[material_index].height);\n"
+		<< "\t}\n"
+		<< "\treturn vec4(material_entries[material_index].opacity);\n"
+		<< "}\n"
+		<< "float getMaterialHeightScale(uint material_index) {\n"
+		<< "\treturn material_entries[material_index].height_scale;\n"
+		<< "}\n";
+	if (bindless)
+	{
+		glsl << "vec4 sampleMaterialTexture(uint material_index, uint slot, vec2 uv) {\n"
+			<< "\treturn texture(sampler2D(material_entries[material_index].textures[slot]), uv);\n"
+			<< "}\n";
+	}
+	else
+	{
+		// sampler arrays may only be indexed with constant expressions, hence the switch
+		const GLuint max_texture_arrays = getMaxTextureArrays();
+		glsl << "layout(binding = " << TEXTURE_UNITS_BEGIN << ") uniform sampler2DArray material_texture_arrays[" << max_texture_arrays << "];\n"
+			<< "vec4 sampleMaterialTexture(uint material_index, uint slot, vec2 uv) {\n"
+			<< "\tuvec2 reference = material_entries[material_index].textures[slot];\n"
+			<< "\tvec3 coordinates = vec3(uv, float(reference.y));\n"
+			<< "\tswitch (reference.x) {\n";
+		for (GLuint i = 0; i < max_texture_arrays; ++i)
+		{
+			glsl << "\tcase " << i << "u: return texture(material_texture_arrays[" << i << "], coordinates);\n";
+		}
+		glsl << "\t}\n"
+			<< "\treturn vec4(0.0);\n"
+			<< "}\n";
+	}
+	glsl << "vec4 sampleMaterial(uint material_index, uint slot, vec2 uv) {\n"
+		<< "\treturn hasMaterialTexture(material_index, slot) ? sampleMaterialTexture(material_index, slot, uv) : getMaterialValue(material_index, slot);\n"
+		<< "}\n";
+	return glsl.str();
+}
+
+void MaterialTable::clear()
+{
+	GLExtensions & extensions = GLExtensions::getInstance();
+	for (auto & pair : this->texture_handles)
+	{
+		extensions.makeTextureHandleNonResidentARB(pair.second);
+	}
+	for (TextureArray & texture_array : this->arrays)
+	{
+		if (texture_array.ID != 0) GLStateCache::getInstance().deleteTextures(1, &(texture_array.ID));
+	}
+	if (this->SSBO != 0) GLStateCache::getInstance().deleteBuffers(1, &(this->SSBO));
+
+	this->SSBO = 0;
+	this->buffer_capacity = 0;
+	this->texture_handles.clear();
+	this->texture_locations.clear();
+	this->arrays.clear();
+	this->stale_entries.clear();
+	this->indices.clear();
+	this->slots.clear();
+	this->free_slots.clear();
+	this->entries.clear();
+	this->is_dirty = false;
+	this->dirty_begin = 0;
+	this->dirty_end = 0;
+}
@@ -0,0 +1,477 @@
+#include <GLRF/MipGenerator.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <GLRF/ThreadPool.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GLRF_MIP_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function, the instructions are only executed after the CPU check
+#define GLRF_TARGET_AVX2
+#else
+#define GLRF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+using namespace GLRF;
+
+namespace {
+	const GLsizei ROWS_PER_JOB = 8;
+	const size_t ALPHA_HISTOGRAM_SIZE = 4096;
+	const size_t LINEAR_TO_SRGB_SIZE = 16384;
+
+	/**
+	 * A separable downsampling kernel, destination texel x reads the source texels 2 * x + offset + k.
+	 */
+	struct Kernel {
+		std::vector<float> weights;
+		int offset = 0;
+	};
+
+	double besselI0(double x)
+	{
+		// power series, converges quickly for the small arguments of the Kaiser window
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	Kernel createKernel(MipFilter filter)
+	{
+		Kernel kernel;
+		if (filter == MipFilter::BOX) {
+			kernel.weights = { 0.5f, 0.5f };
+			kernel.offset = 0;
+			return kernel;
+		}
+
+		// Kaiser windowed sinc with a support of 3 destination texels on each side
+		const double width = 3.0;
+		const double alpha = 4.0;
+		const double pi = 3.14159265358979323846;
+		const int taps = static_cast<int>(4.0 * width);
+		kernel.offset = -(taps / 2 - 1);
+		double sum = 0.0;
+		std::vector<double> weights(taps);
+		for (int k = 0; k < taps; ++k)
+		{
+			// distance between the source texel center and the destination texel center in destination texels
+			double x = (kernel.offset + k - 0.5) / 2.0;
+			double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(pi * x) / (pi * x);
+			double t = x / width;
+			double window = (std::abs(t) <= 1.0) ? besselI0(alpha * std::sqrt(1.0 - t * t)) / besselI0(alpha) : 0.0;
+			weights[k] = sinc * window;
+			sum += weights[k];
+		}
+		for (double weight : weights) kernel.weights.push_back(static_cast<float>(weight / sum));
+		return kernel;
+	}
+
+	const std::array<float, 256> & getSRGBToLinearTable()
+	{
+		static const std::array<float, 256> table = []() {
+			std::array<float, 256> t;
+			for (int i = 0; i < 256; ++i)
+			{
+				float c = i / 255.f;
+				t[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	const std::vector<unsigned char> & getLinearToSRGBTable()
+	{
+		static const std::vector<unsigned char> table = []() {
+			std::vector<unsigned char> t(LINEAR_TO_SRGB_SIZE);
+			for (size_t i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+			{
+				float c = static_cast<float>(i) / (LINEAR_TO_SRGB_SIZE - 1);
+				float s = (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+				t[i] = static_cast<unsigned char>(std::clamp(s, 0.f, 1.f) * 255.f + 0.5f);
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	/**
+	 * Converts a row of stored texels to linear floating point values.
+	 */
+	void decodeRow(const unsigned char * data, const TextureFormat & format, size_t count, float * out)
+	{
+		const GLuint channels = format.channels;
+		const GLuint color_channels = format.is_srgb ? std::min(channels, 3u) : 0u;
+		switch (format.data_type)
+		{
+		case GL_FLOAT:
+			std::memcpy(out, data, count * sizeof(float));
+			break;
+		case GL_UNSIGNED_SHORT: {
+			const unsigned short * values = reinterpret_cast<const unsigned short *>(data);
+			for (size_t i = 0; i < count; ++i) out[i] = values[i] / 65535.f;
+			break;
+		}
+		case GL_UNSIGNED_BYTE:
+		default: {
+			const std::array<float, 256> & srgb_to_linear = getSRGBToLinearTable();
+			for (size_t i = 0; i < count; ++i)
+			{
+				out[i] = ((i % channels) < color_channels) ? srgb_to_linear[data[i]] : data[i] / 255.f;
+			}
+			break;
+		}
+		}
+	}
+
+	/**
+	 * Converts a row of linear floating point values to the stored representation.
+	 */
+	void encodeRow(const float * values, const TextureFormat & format, size_t count, unsigned char * data)
+	{
+		const GLuint channels = format.channels;
+		const GLuint color_channels = format.is_srgb ? std::min(channels, 3u) : 0u;
+		switch (format.data_type)
+		{
+		case GL_FLOAT: {
+			// the negative lobes of the filter must not produce negative radiance
+			float * out = reinterpret_cast<float *>(data);
+			for (size_t i = 0; i < count; ++i) out[i] = std::max(values[i], 0.f);
+			break;
+		}
+		case GL_UNSIGNED_SHORT: {
+			unsigned short * out = reinterpret_cast<unsigned short *>(data);
+			for (size_t i = 0; i < count; ++i) out[i] = static_cast<unsigned short>(std::clamp(values[i], 0.f, 1.f) * 65535.f + 0.5f);
+			break;
+		}
+		case GL_UNSIGNED_BYTE:
+		default: {
+			const std::vector<unsigned char> & linear_to_srgb = getLinearToSRGBTable();
+			for (size_t i = 0; i < count; ++i)
+			{
+				float value = std::clamp(values[i], 0.f, 1.f);
+				data[i] = ((i % channels) < color_channels)
+					? linear_to_srgb[static_cast<size_t>(value * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)]
+					: static_cast<unsigned char>(value * 255.f + 0.5f);
+			}
+			break;
+		}
+		}
+	}
+
+	/**
+	 * Renormalizes tangent space normals that are stored as unsigned values (n * 0.5 + 0.5).
+	 */
+	void renormalizeRow(float * values, GLuint channels, GLsizei width)
+	{
+		for (GLsizei x = 0; x < width; ++x)
+		{
+			float * texel = values + static_cast<size_t>(x) * channels;
+			float nx = texel[0] * 2.f - 1.f;
+			float ny = texel[1] * 2.f - 1.f;
+			float nz = (channels >= 3) ? texel[2] * 2.f - 1.f : 0.f;
+			float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+			// two channel normal maps reconstruct z, so only vectors that are too long are shortened
+			if (length < 1e-6f || (channels < 3 && length <= 1.f)) continue;
+			texel[0] = nx / length * 0.5f + 0.5f;
+			texel[1] = ny / length * 0.5f + 0.5f;
+			if (channels >= 3) texel[2] = nz / length * 0.5f + 0.5f;
+		}
+	}
+
+	void verticalPass(const float * const * rows, const float * weights, size_t taps, float * out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			float sum = 0.f;
+			for (size_t k = 0; k < taps; ++k) sum += weights[k] * rows[k][i];
+			out[i] = sum;
+		}
+	}
+
+	void horizontalTexel(const float * row, GLsizei src_width, GLuint channels, const Kernel & kernel, GLsizei x, float * out)
+	{
+		for (GLuint c = 0; c < channels; ++c) out[c] = 0.f;
+		for (size_t k = 0; k < kernel.weights.size(); ++k)
+		{
+			GLsizei source_x = std::clamp(2 * x + kernel.offset + static_cast<GLsizei>(k), 0, src_width - 1);
+			const float * texel = row + static_cast<size_t>(source_x) * channels;
+			for (GLuint c = 0; c < channels; ++c) out[c] += kernel.weights[k] * texel[c];
+		}
+	}
+
+	void horizontalPass(const float * row, GLsizei src_width, GLuint channels, const Kernel & kernel, float * out, GLsizei dst_width)
+	{
+		for (GLsizei x = 0; x < dst_width; ++x)
+		{
+			horizontalTexel(row, src_width, channels, kernel, x, out + static_cast<size_t>(x) * channels);
+		}
+	}
+
+#ifdef GLRF_MIP_X86
+	bool detectAVX2()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!fma || !os_saves_ymm || !avx) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	GLRF_TARGET_AVX2 void verticalPassAVX2(const float * const * rows, const float * weights, size_t taps, float * out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sum = _mm256_setzero_ps();
+			for (size_t k = 0; k < taps; ++k)
+			{
+				sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i), sum);
+			}
+			_mm256_storeu_ps(out + i, sum);
+		}
+		for (; i < count; ++i)
+		{
+			float sum = 0.f;
+			for (size_t k = 0; k < taps; ++k) sum += weights[k] * rows[k][i];
+			out[i] = sum;
+		}
+	}
+
+	/**
+	 * Filters two adjacent RGBA destination texels per iteration, one in each 128 bit lane.
+	 */
+	GLRF_TARGET_AVX2 void horizontalPassRGBAAVX2(const float * row, GLsizei src_width, const Kernel & kernel, float * out, GLsizei dst_width)
+	{
+		const GLsizei taps = static_cast<GLsizei>(kernel.weights.size());
+		GLsizei x = 0;
+		while (x < dst_width)
+		{
+			const GLsizei first = 2 * x + kernel.offset;
+			// texel x + 1 reads up to first + 2 + taps - 1, border texels are clamped in the scalar path
+			if (first >= 0 && x + 1 < dst_width && first + 1 + taps < src_width)
+			{
+				__m256 sum = _mm256_setzero_ps();
+				for (GLsizei k = 0; k < taps; ++k)
+				{
+					__m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(row + static_cast<size_t>(first + k) * 4)),
+						_mm_loadu_ps(row + static_cast<size_t>(first + 2 + k) * 4), 1);
+					sum = _mm256_fmadd_ps(_mm256_set1_ps(kernel.weights[k]), texels, sum);
+				}
+				_mm256_storeu_ps(out + static_cast<size_t>(x) * 4, sum);
+				x += 2;
+			}
+			else
+			{
+				horizontalTexel(row, src_width, 4, kernel, x, out + static_cast<size_t>(x) * 4);
+				x += 1;
+			}
+		}
+	}
+#endif
+
+	/**
+	 * Returns the normalized alpha values of a level as a histogram.
+	 */
+	std::vector<size_t> buildAlphaHistogram(const ImageData & chain, GLuint level)
+	{
+		const TextureFormat & format = chain.getFormat();
+		const ImageLevel & image_level = chain.getLevel(level);
+		const GLuint channels = format.channels;
+		// 8 bit alpha gets one bin per value, so the coverage matches the stored values exactly
+		const size_t bins = (format.data_type == GL_UNSIGNED_BYTE) ? 256 : ALPHA_HISTOGRAM_SIZE;
+		std::vector<size_t> histogram(bins, 0);
+		std::vector<float> row(static_cast<size_t>(image_level.width) * channels);
+		const size_t row_size = static_cast<size_t>(image_level.width) * format.getTexelSize();
+		for (GLsizei y = 0; y < image_level.height; ++y)
+		{
+			decodeRow(chain.getLevelData(level) + y * row_size, format, row.size(), row.data());
+			for (GLsizei x = 0; x < image_level.width; ++x)
+			{
+				float alpha = std::clamp(row[static_cast<size_t>(x) * channels + channels - 1], 0.f, 1.f);
+				++histogram[static_cast<size_t>(alpha * (bins - 1) + 0.5f)];
+			}
+		}
+		return histogram;
+	}
+
+	float calculateCoverage(const std::vector<size_t> & histogram, float cutoff, float scale)
+	{
+		size_t passed = 0, total = 0;
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			float alpha = std::min(static_cast<float>(i) / (histogram.size() - 1) * scale, 1.f);
+			if (alpha > cutoff) passed += histogram[i];
+			total += histogram[i];
+		}
+		return (total > 0) ? static_cast<float>(passed) / static_cast<float>(total) : 0.f;
+	}
+
+	bool hasAlphaChannel(const TextureFormat & format)
+	{
+		// two channel images are sampled as (r, r, r, g)
+		return format.channels == 4 || format.channels == 2;
+	}
+}
+
+MipGenerator::MipGenerator(MipConfiguration config)
+{
+	this->config = config;
+}
+
+bool MipGenerator::usesAVX2()
+{
+#ifdef GLRF_MIP_X86
+	static const bool has_avx2 = detectAVX2();
+	return has_avx2;
+#else
+	return false;
+#endif
+}
+
+ImageData MipGenerator::generate(const ImageData & image)
+{
+	const TextureFormat & format = image.getFormat();
+	if (format.isCompressed()) return image;
+
+	ImageData chain(image.getWidth(), image.getHeight(), format, ImageData::calculateMipCount(image.getWidth(), image.getHeight()));
+	std::memcpy(chain.getLevelData(0), image.getLevelData(0), image.getLevel(0).size);
+
+	const bool preserve_coverage = this->config.alpha_cutoff > 0.f && hasAlphaChannel(format) && !this->config.normal_map;
+	const float coverage = preserve_coverage ? calculateAlphaCoverage(chain, 0) : 0.f;
+	for (GLuint i = 1; i < chain.getLevelCount(); ++i)
+	{
+		downsample(chain, i);
+		if (preserve_coverage) preserveAlphaCoverage(chain, i, coverage);
+	}
+	return chain;
+}
+
+void MipGenerator::downsample(ImageData & chain, GLuint level)
+{
+	const TextureFormat & format = chain.getFormat();
+	const ImageLevel & src = chain.getLevel(level - 1);
+	const ImageLevel & dst = chain.getLevel(level);
+	const GLuint channels = format.channels;
+	const size_t texel_size = format.getTexelSize();
+	const size_t src_row_size = static_cast<size_t>(src.width) * texel_size;
+	const size_t dst_row_size = static_cast<size_t>(dst.width) * texel_size;
+	const size_t src_row_values = static_cast<size_t>(src.width) * channels;
+	const size_t dst_row_values = static_cast<size_t>(dst.width) * channels;
+	const unsigned char * src_data = chain.getLevelData(level - 1);
+	unsigned char * dst_data = chain.getLevelData(level);
+
+	// small levels reach across the whole image anyway, so the sharper kernel has no benefit there
+	const Kernel kernel = createKernel((src.width < 8 || src.height < 8) ? MipFilter::BOX : this->config.filter);
+	const size_t taps = kernel.weights.size();
+#ifdef GLRF_MIP_X86
+	const bool avx2 = usesAVX2();
+#endif
+	const bool normal_map = this->config.normal_map && format.data_type != GL_FLOAT;
+
+	const GLsizei num_jobs = (dst.height + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+	ThreadPool::getInstance().parallelFor(0, static_cast<size_t>(num_jobs), [&](size_t job) {
+		const GLsizei first_row = static_cast<GLsizei>(job) * ROWS_PER_JOB;
+		const GLsizei last_row = std::min(first_row + ROWS_PER_JOB, dst.height);
+
+		// decode all source rows that the rows of this job read once
+		const GLsizei first_source = std::max(2 * first_row + kernel.offset, 0);
+		const GLsizei last_source = std::min(2 * (last_row - 1) + kernel.offset + static_cast<GLsizei>(taps) - 1, src.height - 1);
+		std::vector<float> source_rows(static_cast<size_t>(last_source - first_source + 1) * src_row_values);
+		for (GLsizei y = first_source; y <= last_source; ++y)
+		{
+			decodeRow(src_data + y * src_row_size, format, src_row_values, source_rows.data() + (y - first_source) * src_row_values);
+		}
+
+		std::vector<const float *> rows(taps);
+		std::vector<float> vertical(src_row_values);
+		std::vector<float> filtered(dst_row_values);
+		for (GLsizei y = first_row; y < last_row; ++y)
+		{
+			for (size_t k = 0; k < taps; ++k)
+			{
+				GLsizei source_y = std::clamp(2 * y + kernel.offset + static_cast<GLsizei>(k), first_source, last_source);
+				rows[k] = source_rows.data() + (source_y - first_source) * src_row_values;
+			}
+
+#ifdef GLRF_MIP_X86
+			if (avx2) {
+				verticalPassAVX2(rows.data(), kernel.weights.data(), taps, vertical.data(), src_row_values);
+				if (channels == 4) {
+					horizontalPassRGBAAVX2(vertical.data(), src.width, kernel, filtered.data(), dst.width);
+				} else {
+					horizontalPass(vertical.data(), src.width, channels, kernel, filtered.data(), dst.width);
+				}
+			}
+			else
+#endif
+			{
+				verticalPass(rows.data(), kernel.weights.data(), taps, vertical.data(), src_row_values);
+				horizontalPass(vertical.data(), src.width, channels, kernel, filtered.data(), dst.width);
+			}
+
+			if (normal_map && channels >= 2) renormalizeRow(filtered.data(), channels, dst.width);
+			encodeRow(filtered.data(), format, dst_row_values, dst_data + y * dst_row_size);
+		}
+	});
+}
+
+float MipGenerator::calculateAlphaCoverage(const ImageData & chain, GLuint level)
+{
+	return calculateCoverage(buildAlphaHistogram(chain, level), this->config.alpha_cutoff, 1.f);
+}
+
+void MipGenerator::preserveAlphaCoverage(ImageData & chain, GLuint level, float coverage)
+{
+	const std::vector<size_t> histogram = buildAlphaHistogram(chain, level);
+
+	// coverage grows monotonically with the scale, so the matching scale can be found by bisection
+	float low = 0.f, high = 4.f;
+	for (int i = 0; i < 16; ++i)
+	{
+		float middle = 0.5f * (low + high);
+		if (calculateCoverage(histogram, this->config.alpha_cutoff, middle) < coverage) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	const float scale = high;
+	if (std::abs(scale - 1.f) < 1e-3f) return;
+
+	const TextureFormat & format = chain.getFormat();
+	const ImageLevel & image_level = chain.getLevel(level);
+	const GLuint channels = format.channels;
+	const size_t row_values = static_cast<size_t>(image_level.width) * channels;
+	const size_t row_size = static_cast<size_t>(image_level.width) * format.getTexelSize();
+	std::vector<float> row(row_values);
+	for (GLsizei y = 0; y < image_level.height; ++y)
+	{
+		unsigned char * data = chain.getLevelData(level) + y * row_size;
+		decodeRow(data, format, row_values, row.data());
+		for (size_t i = channels - 1; i < row_values; i += channels) row[i] = std::min(row[i] * scale, 1.f);
+		encodeRow(row.data(), format, row_values, data);
+	}
+}
@@ -0,0 +1,162 @@
+#include <GLRF/ProgramBinaryCache.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <GLRF/Hash.hpp>
+
+using namespace GLRF;
+
+namespace {
+	// bump whenever the layout of the cache files changes
+	const std::uint32_t CACHE_VERSION = 1;
+	const char PROGRAM_MAGIC[8] = { 'G', 'L', 'R', 'F', 'P', 'R', 'O', 'G' };
+	const std::string ENTRY_EXTENSION = ".bin";
+
+	struct ProgramCacheHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t format;
+		std::uint64_t driver_hash;
+		std::uint64_t source_hash;
+		std::uint64_t length;
+	};
+
+	std::string getDriverString(GLenum name)
+	{
+		const GLubyte * value = glGetString(name);
+		return value ? std::string(reinterpret_cast<const char *>(value)) : std::string();
+	}
+}
+
+ProgramBinaryCache::ProgramBinaryCache()
+{
+
+}
+
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+
+}
+
+void ProgramBinaryCache::queryDriver()
+{
+	if (this->driver_queried) return;
+	this->driver_queried = true;
+
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	this->binaries_supported = format_count > 0;
+
+	const std::string driver = "program cache " + std::to_string(CACHE_VERSION) + "\n" + getDriverString(GL_VENDOR) + "\n"
+		+ getDriverString(GL_RENDERER) + "\n" + getDriverString(GL_VERSION);
+	this->driver_hash = fnv1a64(driver);
+}
+
+fs::path ProgramBinaryCache::getEntryFile(std::uint64_t source_hash)
+{
+	return this->directory / ("program_" + toHexString(fnv1a64(toHexString(source_hash), this->driver_hash)) + ENTRY_EXTENSION);
+}
+
+bool ProgramBinaryCache::isAvailable()
+{
+	queryDriver();
+	return this->enabled && this->binaries_supported;
+}
+
+bool ProgramBinaryCache::load(GLuint program, std::uint64_t source_hash)
+{
+	if (!isAvailable()) return false;
+
+	const fs::path file = getEntryFile(source_hash);
+	std::ifstream stream(file, std::ios::binary);
+	if (!stream.is_open()) return false;
+
+	ProgramCacheHeader header;
+	stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if (!stream.good() || std::memcmp(header.magic, PROGRAM_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION
+		|| header.driver_hash != this->driver_hash || header.source_hash != source_hash) {
+		return false;
+	}
+	std::vector<char> binary(static_cast<size_t>(header.length));
+	stream.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if (!stream.good()) return false;
+	stream.close();
+
+	glProgramBinary(program, static_cast<GLenum>(header.format), binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		// the driver changed without changing its version, the entry is replaced by the next store
+		std::error_code error;
+		fs::remove(file, error);
+		return false;
+	}
+	return true;
+}
+
+void ProgramBinaryCache::store(GLuint program, std::uint64_t source_hash)
+{
+	if (!isAvailable()) return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	ProgramCacheHeader header;
+	std::memcpy(header.magic, PROGRAM_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.driver_hash = this->driver_hash;
+	header.source_hash = source_hash;
+
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &written, &format, binary.data());
+	if (written <= 0) return;
+	header.format = format;
+	header.length = static_cast<std::uint64_t>(written);
+
+	const fs::path file = getEntryFile(source_hash);
+	std::error_code error;
+	fs::create_directories(file.parent_path(), error);
+	// written next to the destination and renamed, so a cancelled run never leaves a truncated cache file
+	fs::path temporary = file;
+	temporary += ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		stream.write(binary.data(), written);
+		if (!stream.good()) {
+			std::cout << "Could not write program cache entry '" << file.generic_string() << "'." << std::endl;
+			return;
+		}
+	}
+	fs::rename(temporary, file, error);
+}
+
+void ProgramBinaryCache::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+void ProgramBinaryCache::setDirectory(fs::path directory)
+{
+	this->directory = directory;
+}
+
+fs::path ProgramBinaryCache::getDirectory()
+{
+	return this->directory;
+}
+
+void ProgramBinaryCache::clear()
+{
+	std::error_code error;
+	for (auto & file : fs::directory_iterator(this->directory, error))
+	{
+		if (file.path().extension() == ENTRY_EXTENSION) fs::remove(file.path(), error);
+	}
+}
@@ -0,0 +1,51 @@
+#include <GLRF/Sampler.hpp>
+
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+SamplerManager::SamplerManager()
+{
+
+}
+
+SamplerManager::~SamplerManager()
+{
+
+}
+
+GLuint SamplerManager::getSampler(const SamplerConfiguration & configuration)
+{
+	auto it = this->samplers.find(configuration);
+	if (it != this->samplers.end())
+	{
+		return it->second;
+	}
+
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, configuration.wrap_s);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, configuration.wrap_t);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, configuration.min_filter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, configuration.mag_filter);
+	if (configuration.max_anisotropy > 1.f)
+	{
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, configuration.max_anisotropy);
+	}
+	this->samplers.insert_or_assign(configuration, sampler);
+	return sampler;
+}
+
+GLuint SamplerManager::getDefaultSampler()
+{
+	return getSampler(SamplerConfiguration());
+}
+
+void SamplerManager::clear()
+{
+	for (auto & pair : this->samplers)
+	{
+		GLStateCache::getInstance().deleteSamplers(1, &(pair.second));
+	}
+	this->samplers.clear();
+}
@@ -37,54 +37,153 @@ void Scene::setActiveCamera(std::shared_ptr<Camera> camera) {
 	this->activeCamera = camera;
 }
 
+void Scene::setEnvironment(std::shared_ptr<EnvironmentMap> environment) {
+	this->environment = environment;
+}
+
+std::shared_ptr<EnvironmentMap> Scene::getEnvironment() {
+	return this->environment;
+}
+
+const std::vector<std::shared_ptr<SceneNode<SceneObject>>> & Scene::getObjects() {
+	return this->objectNodes;
+}
+
 /**
  * https://computergraphics.stackexchange.com/questions/5323/dynamic-array-in-glsl
  * 设置多个点光源时的疑惑
  * https://github.com/Shane-oo/OpenGL-Course/blob/c776cb704c3ff35a5f5a46044bc91a1ae1c51f15/src/OpenGL-MacApp/Resources/Shaders/shader.frag.glsl
 */
 void Scene::draw(ShaderConfiguration * configuration, std::map<GLuint, FrameBuffer*> & map_shader_fbs) {
+	prepareDraw(configuration);
+	if (!this->depth_pre_pass_shader) {
+		for (auto & pair : map_shader_fbs) {
+			pair.second->use();
+			drawObjects(configuration, pair.first);
+		}
+		return;
+	}
+
+	// the pre-pass of a framebuffer has to contain the objects of all shaders that draw into it
+	std::map<FrameBuffer*, std::vector<GLuint>> map_fb_shaders;
+	for (auto & pair : map_shader_fbs) {
+		map_fb_shaders[pair.second].push_back(pair.first);
+	}
+	for (auto & pair : map_fb_shaders) {
+		pair.first->use();
+		drawDepthPrePass(configuration, pair.second);
+		for (GLuint shader_id : pair.second) {
+			drawObjects(configuration, shader_id);
+		}
+	}
+}
+
+void Scene::setDepthPrePass(Shader * depth_shader) {
+	this->depth_pre_pass_shader = depth_shader;
+}
+
+void Scene::drawDepthPrePass(ShaderConfiguration * configuration, const std::vector<GLuint> & shader_ids) {
+	if (!this->depth_pre_pass_shader) return;
+
+	// front to back, so the depth test rejects as much of the pre-pass itself as possible
+	this->depth_pre_pass_order.clear();
+	for (unsigned int i = 0; i < this->objectNodes.size(); i++) {
+		auto obj = this->objectNodes[i]->getObject();
+		if (std::find(shader_ids.begin(), shader_ids.end(), obj->getShaderID()) == shader_ids.end()) continue;
+		if (!obj->supportsDepthPrePass()) continue;
+		float distance = glm::length(this->objectNodes[i]->getPosition() - this->activeCamera->getPosition());
+		this->depth_pre_pass_order.push_back(std::make_pair(distance, i));
+	}
+	std::sort(this->depth_pre_pass_order.begin(), this->depth_pre_pass_order.end());
+
 	ShaderManager & shader_manager = ShaderManager::getInstance();
-	shader_manager.clearDrawConfigurations();
+	GLStateCache & state = GLStateCache::getInstance();
+	const GLuint depth_shader_id = this->depth_pre_pass_shader->getID();
+	shader_manager.useShader(depth_shader_id);
+	shader_manager.configureShader(configuration, depth_shader_id, false);
+	state.setDepthFunc(GL_LESS);
+	state.setDepthMask(true);
+	state.setColorMask(false);
+	for (auto & entry : this->depth_pre_pass_order) {
+		setObjectConfiguration(entry.second);
+		shader_manager.configureShader(&this->object_configuration, depth_shader_id, true);
+		this->objectNodes[entry.second]->getObject()->drawGeometry();
+	}
+	state.setColorMask(true);
+}
 
-	glm::mat4 view = this->activeCamera->getViewMatrix();
-	configuration->setMat4("view", view);
-	configuration->setVec3("camera_position", this->activeCamera->getPosition());
-	configuration->setVec3("camera_view_dir", - this->activeCamera->getW());
+void Scene::setObjectConfiguration(size_t index) {
+	// the block is reused so it does not allocate
+	this->object_configuration.clear();
+	glm::mat4 modelMat = this->objectNodes[index]->calculateModelMatrix();
+	glm::mat3 modelNormalMat = glm::mat3(glm::transpose(glm::inverse(modelMat)));
+	this->object_configuration.setMat4("model"_uniform, modelMat);
+	this->object_configuration.setMat3("model_normal"_uniform, modelNormalMat);
+}
 
-	for (unsigned int i = 0; i < this->pointLights.size(); i++) {
-		configuration->setVec3("pointLight_position[" + std::to_string(i) + "]", pointLights[i]->getPosition());
-		configuration->setVec3("pointLight_color[" + std::to_string(i) + "]", this->pointLights[i]->getObject()->getColor());
-		configuration->setFloat("pointLight_power[" + std::to_string(i) + "]", this->pointLights[i]->getObject()->getPower());
+void Scene::prepareDraw(ShaderConfiguration * configuration) {
+	ShaderManager & shader_manager = ShaderManager::getInstance();
+	shader_manager.clearDrawConfigurations();
+	TextureStreamer & texture_streamer = TextureStreamer::getInstance();
+	texture_streamer.update();
+	MaterialTable::getInstance().bind();
+
+	// the camera and lights are shared by all shaders through the frame uniform buffer
+	FrameUniforms frame = {};
+	frame.view = this->activeCamera->getViewMatrix();
+	frame.camera_position = this->activeCamera->getPosition();
+	frame.camera_view_dir = - this->activeCamera->getW();
+
+	const GLuint point_light_count = static_cast<GLuint>(std::min<size_t>(this->pointLights.size(), FrameUniforms::MAX_POINT_LIGHTS));
+	for (GLuint i = 0; i < point_light_count; i++) {
+		frame.point_light_position[i].value = this->pointLights[i]->getPosition();
+		frame.point_light_color[i].value = this->pointLights[i]->getObject()->getColor();
+		frame.point_light_power[i].value = this->pointLights[i]->getObject()->getPower();
 	}
-	configuration->setUInt("pointLight_count", static_cast<unsigned int>(this->pointLights.size()));
+	frame.point_light_count = point_light_count;
 
 	if (this->directionalLights.size() > 0) {
-		glm::vec3 light_dir = glm::vec3(this->directionalLights[0]->calculateModelMatrix()
+		frame.directional_light_direction = glm::vec3(this->directionalLights[0]->calculateModelMatrix()
 			* glm::vec4(this->directionalLights[0]->getObject()->getDirection(), 0.f));
-		configuration->setVec3("directionalLight_direction", light_dir);
-		configuration->setFloat("directionalLight_power", this->directionalLights[0]->getObject()->getPower());
-		configuration->setBool("useDirectionalLight", true);
+		frame.directional_light_power = this->directionalLights[0]->getObject()->getPower();
+		frame.use_directional_light = GL_TRUE;
 	} else {
-		configuration->setBool("useDirectionalLight", false);
+		frame.use_directional_light = GL_FALSE;
 	}
+	FrameUniformBuffer::getInstance().update(frame);
 
+	if (this->environment) {
+		this->environment->bind(configuration);
+	} else {
+		configuration->setBool("environment.use"_uniform, false);
+	}
+}
+
+void Scene::drawObjects(ShaderConfiguration * configuration, GLuint shader_id) {
+	TextureStreamer & texture_streamer = TextureStreamer::getInstance();
+	GLStateCache & state = GLStateCache::getInstance();
 	for (unsigned int i = 0; i < this->objectNodes.size(); i++) {
 		auto obj = this->objectNodes[i]->getObject();
-		GLuint shader_id = obj->getShaderID();
-		auto it = map_shader_fbs.find(shader_id);
-		if (it == map_shader_fbs.end()) continue;
+		if (obj->getShaderID() != shader_id) continue;
+
+		// objects of the pre-pass only shade the fragments that are visible, the others are depth tested as usual
+		if (this->depth_pre_pass_shader) {
+			const bool pre_passed = obj->supportsDepthPrePass();
+			state.setDepthFunc(pre_passed ? GL_EQUAL : GL_LESS);
+			state.setDepthMask(!pre_passed);
+		}
 
-		auto fb = it->second;
-		fb->use();
+		// request the mip levels that are needed at the current distance
+		float distance = glm::length(this->objectNodes[i]->getPosition() - this->activeCamera->getPosition());
+		texture_streamer.requestMaterial(obj->getMaterial(), distance, obj->getUVDensity());
 
 		// load object-specific values into the internal shader
-		ShaderConfiguration object_configuration;
-		glm::mat4 modelMat = this->objectNodes[i]->calculateModelMatrix();
-		glm::mat3 modelNormalMat = glm::mat3(glm::transpose(glm::inverse(modelMat)));
-		object_configuration.setMat4("model", modelMat);
-		object_configuration.setMat3("model_normal", modelNormalMat);
-		
-		obj->draw(configuration, &object_configuration);
+		setObjectConfiguration(i);
+		obj->draw(configuration, &this->object_configuration);
+	}
+	if (this->depth_pre_pass_shader) {
+		state.setDepthFunc(GL_LESS);
+		state.setDepthMask(true);
 	}
 }
 
@@ -1,6 +1,19 @@
 #include <GLRF/Shader.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <glm/gtx/string_cast.hpp>
+
+#include <GLRF/DeferredRenderer.hpp>
+#include <GLRF/EnvironmentMap.hpp>
+#include <GLRF/FrameUniforms.hpp>
+#include <GLRF/GLExtensions.hpp>
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+#include <GLRF/ProgramBinaryCache.hpp>
+#include <GLRF/ShaderVariants.hpp>
+
 #define PRINT(text) std::cout << text << std::endl;
 #define PRINT_VAR(text, var) std::cout << text << " = " << var << std::endl;
 
@@ -16,110 +29,234 @@ ShaderConfiguration::ShaderConfiguration()
 
 ShaderConfiguration::~ShaderConfiguration()
 {
-	this->v_bool.clear();
-	this->v_float.clear();
-	this->v_int.clear();
-	this->v_uint.clear();
-	this->v_mat4.clear();
-	this->v_mat3.clear();
-	this->v_vec4.clear();
-	this->v_vec3.clear();
-	this->v_vec2.clear();
-	this->v_material.clear();
+	
 }
 
-void ShaderConfiguration::loadIntoShader(Shader * shader) const
-{
-	for (auto pair : this->v_bool)
-	{
-		shader->setBool(pair.first, pair.second);
+namespace {
+	// the size in bytes of each ShaderConfiguration::ValueType
+	const size_t VALUE_SIZES[] = {
+		sizeof(GLint), sizeof(GLint), sizeof(GLuint), sizeof(float),
+		sizeof(float) * 16, sizeof(float) * 9, sizeof(float) * 4, sizeof(float) * 3, sizeof(float) * 2
+	};
+
+	// with direct state access the uniforms are set without the program being in use
+	void uploadInt(GLuint program, GLint location, GLint value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform1i(program, location, value);
+		} else {
+			glUniform1i(location, value);
+		}
 	}
-	for (auto pair : this->v_int)
-	{
-		shader->setInt(pair.first, pair.second);
+
+	void uploadUInt(GLuint program, GLint location, GLuint value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform1ui(program, location, value);
+		} else {
+			glUniform1ui(location, value);
+		}
 	}
-	for (auto pair : this->v_uint)
-	{
-		shader->setUInt(pair.first, pair.second);
+
+	void uploadFloat(GLuint program, GLint location, float value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform1f(program, location, value);
+		} else {
+			glUniform1f(location, value);
+		}
 	}
-	for (auto pair : this->v_float)
-	{
-		shader->setFloat(pair.first, pair.second);
+
+	void uploadMat4(GLuint program, GLint location, const float * value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, value);
+		} else {
+			glUniformMatrix4fv(location, 1, GL_FALSE, value);
+		}
 	}
-	for (auto pair : this->v_mat4)
-	{
-		shader->setMat4(pair.first, pair.second);
+
+	void uploadMat3(GLuint program, GLint location, const float * value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, value);
+		} else {
+			glUniformMatrix3fv(location, 1, GL_FALSE, value);
+		}
+	}
+
+	void uploadVec4(GLuint program, GLint location, const float * value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform4fv(program, location, 1, value);
+		} else {
+			glUniform4fv(location, 1, value);
+		}
 	}
-	for (auto pair : this->v_mat3)
+
+	void uploadVec3(GLuint program, GLint location, const float * value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform3fv(program, location, 1, value);
+		} else {
+			glUniform3fv(location, 1, value);
+		}
+	}
+
+	void uploadVec2(GLuint program, GLint location, const float * value) {
+		if (GLResources::usesDirectStateAccess()) {
+			glProgramUniform2fv(program, location, 1, value);
+		} else {
+			glUniform2fv(location, 1, value);
+		}
+	}
+}
+
+void ShaderConfiguration::loadIntoShader(Shader * shader) const
+{
+	// resolve the locations of the values that were added since the block was loaded into this shader
+	if (this->bound_shader != shader) {
+		this->bound_shader = shader;
+		this->bound_locations.clear();
+	}
+	for (size_t i = this->bound_locations.size(); i < this->values.size(); i++)
 	{
-		shader->setMat3(pair.first, pair.second);
+		this->bound_locations.push_back(shader->getUniformLocation(UniformName(this->values[i].hash)).value);
 	}
-	for (auto pair : this->v_vec4)
+
+	const GLuint program = shader->getID();
+	const float * components = this->components.data();
+	for (size_t i = 0; i < this->values.size(); i++)
 	{
-		shader->setVec4(pair.first, pair.second);
+		const GLint location = this->bound_locations[i];
+		const float * value = components + this->values[i].offset;
+		if (!shader->updateShadow(location, value, VALUE_SIZES[static_cast<std::uint32_t>(this->values[i].type)])) continue;
+		switch (this->values[i].type)
+		{
+		case ValueType::Bool:
+		case ValueType::Int:
+		{
+			GLint v;
+			std::memcpy(&v, value, sizeof(v));
+			uploadInt(program, location, v);
+			break;
+		}
+		case ValueType::UInt:
+		{
+			GLuint v;
+			std::memcpy(&v, value, sizeof(v));
+			uploadUInt(program, location, v);
+			break;
+		}
+		case ValueType::Float:	uploadFloat(program, location, *value);	break;
+		case ValueType::Mat4:	uploadMat4(program, location, value);	break;
+		case ValueType::Mat3:	uploadMat3(program, location, value);	break;
+		case ValueType::Vec4:	uploadVec4(program, location, value);	break;
+		case ValueType::Vec3:	uploadVec3(program, location, value);	break;
+		case ValueType::Vec2:	uploadVec2(program, location, value);	break;
+		}
 	}
-	for (auto pair : this->v_vec3)
+	for (const MaterialValue & material : this->materials)
 	{
-		shader->setVec3(pair.first, pair.second);
+		shader->setMaterial(material.name, material.material);
 	}
-	for (auto pair : this->v_vec2)
+}
+
+void ShaderConfiguration::clear()
+{
+	this->values.clear();
+	this->components.clear();
+	this->materials.clear();
+	this->bound_locations.clear();
+}
+
+template <typename T>
+void ShaderConfiguration::setValue(UniformName name, ValueType type, const T & value)
+{
+	static_assert(sizeof(T) % sizeof(float) == 0, "uniform values consist of 4 byte components");
+	for (Value & v : this->values)
 	{
-		shader->setVec2(pair.first, pair.second);
+		if (v.hash != name.hash) continue;
+		if (v.type == type) {
+			std::memcpy(this->components.data() + v.offset, &value, sizeof(T));
+			return;
+		}
+		// the type changed, the new value is appended to the components
+		v.type = type;
+		v.offset = static_cast<std::uint32_t>(this->components.size());
+		this->components.resize(this->components.size() + sizeof(T) / sizeof(float));
+		std::memcpy(this->components.data() + v.offset, &value, sizeof(T));
+		return;
 	}
-	for (auto pair : this->v_material)
+	Value v;
+	v.hash = name.hash;
+	v.type = type;
+	v.offset = static_cast<std::uint32_t>(this->components.size());
+	this->values.push_back(v);
+	this->components.resize(this->components.size() + sizeof(T) / sizeof(float));
+	std::memcpy(this->components.data() + v.offset, &value, sizeof(T));
+}
+
+template <typename T>
+T ShaderConfiguration::getValue(UniformName name, ValueType type, T fallback)
+{
+	for (const Value & v : this->values)
 	{
-		shader->setMaterial(pair.first, pair.second);
+		if (v.hash != name.hash || v.type != type) continue;
+		T value;
+		std::memcpy(static_cast<void *>(&value), this->components.data() + v.offset, sizeof(T));
+		return value;
 	}
+	return fallback;
 }
 
-void ShaderConfiguration::setBool(const std::string& name, bool value)
+void ShaderConfiguration::setBool(UniformName name, bool value)
 {
-	this->v_bool.insert_or_assign(name, value);
+	setValue(name, ValueType::Bool, static_cast<GLint>(value));
 }
 
-void ShaderConfiguration::setInt(const std::string& name, GLint value)
+void ShaderConfiguration::setInt(UniformName name, GLint value)
 {
-	this->v_int.insert_or_assign(name, value);
+	setValue(name, ValueType::Int, value);
 }
 
-void ShaderConfiguration::setUInt(const std::string & name, GLuint value)
+void ShaderConfiguration::setUInt(UniformName name, GLuint value)
 {
-	this->v_uint.insert_or_assign(name, value);
+	setValue(name, ValueType::UInt, value);
 }
 
-void ShaderConfiguration::setFloat(const std::string & name, float value)
+void ShaderConfiguration::setFloat(UniformName name, float value)
 {
-	this->v_float.insert_or_assign(name, value);
+	setValue(name, ValueType::Float, value);
 }
 
-void ShaderConfiguration::setMat4(const std::string & name, glm::mat4 value)
+void ShaderConfiguration::setMat4(UniformName name, const glm::mat4 & value)
 {
-	this->v_mat4.insert_or_assign(name, value);
+	setValue(name, ValueType::Mat4, value);
 }
 
-void ShaderConfiguration::setMat3(const std::string & name, glm::mat3 value)
+void ShaderConfiguration::setMat3(UniformName name, const glm::mat3 & value)
 {
-	this->v_mat3.insert_or_assign(name, value);
+	setValue(name, ValueType::Mat3, value);
 }
 
-void ShaderConfiguration::setVec4(const std::string & name, glm::vec4 value)
+void ShaderConfiguration::setVec4(UniformName name, const glm::vec4 & value)
 {
-	this->v_vec4.insert_or_assign(name, value);
+	setValue(name, ValueType::Vec4, value);
 }
 
-void ShaderConfiguration::setVec3(const std::string & name, glm::vec3 value)
+void ShaderConfiguration::setVec3(UniformName name, const glm::vec3 & value)
 {
-	this->v_vec3.insert_or_assign(name, value);
+	setValue(name, ValueType::Vec3, value);
 }
 
-void ShaderConfiguration::setVec2(const std::string & name, glm::vec2 value)
+void ShaderConfiguration::setVec2(UniformName name, const glm::vec2 & value)
 {
-	this->v_vec2.insert_or_assign(name, value);
+	setValue(name, ValueType::Vec2, value);
 }
 
 void ShaderConfiguration::setMaterial(const std::string & name, std::shared_ptr<Material> material)
 {
-	this->v_material.insert_or_assign(name, material);
+	for (MaterialValue & v : this->materials)
+	{
+		if (v.name != name) continue;
+		v.material = material;
+		return;
+	}
+	this->materials.push_back({ name, material });
 }
 
 void ShaderConfiguration::setPatchVertices(GLint patchVertices)
@@ -127,65 +264,58 @@ void ShaderConfiguration::setPatchVertices(GLint patchVertices)
 	this->v_patchVertices = patchVertices;
 }
 
-bool ShaderConfiguration::getBool(const std::string& name)
+bool ShaderConfiguration::getBool(UniformName name)
 {
-	auto it = this->v_bool.find(name);
-	return (it == this->v_bool.end()) ? false : it->second;
+	return getValue(name, ValueType::Bool, static_cast<GLint>(0)) != 0;
 }
 
-GLint ShaderConfiguration::getInt(const std::string& name)
+GLint ShaderConfiguration::getInt(UniformName name)
 {
-	auto it = this->v_int.find(name);
-	return (it == this->v_int.end()) ? 0 : it->second;
+	return getValue(name, ValueType::Int, static_cast<GLint>(0));
 }
 
-GLuint ShaderConfiguration::getUInt(const std::string& name)
+GLuint ShaderConfiguration::getUInt(UniformName name)
 {
-	auto it = this->v_uint.find(name);
-	return (it == this->v_uint.end()) ? 0 : it->second;
+	return getValue(name, ValueType::UInt, static_cast<GLuint>(0));
 }
 
-float ShaderConfiguration::getFloat(const std::string& name)
+float ShaderConfiguration::getFloat(UniformName name)
 {
-	auto it = this->v_float.find(name);
-	return (it == this->v_float.end()) ? 0.f : it->second;
+	return getValue(name, ValueType::Float, 0.f);
 }
 
-
-glm::mat4 ShaderConfiguration::getMat4(const std::string& name)
+glm::mat4 ShaderConfiguration::getMat4(UniformName name)
 {
-	auto it = this->v_mat4.find(name);
-	return (it == this->v_mat4.end()) ? glm::mat4(1.f) : it->second;
+	return getValue(name, ValueType::Mat4, glm::mat4(1.f));
 }
 
-glm::mat3 ShaderConfiguration::getMat3(const std::string& name)
+glm::mat3 ShaderConfiguration::getMat3(UniformName name)
 {
-	auto it = this->v_mat3.find(name);
-	return (it == this->v_mat3.end()) ? glm::mat3(1.f) : it->second;
+	return getValue(name, ValueType::Mat3, glm::mat3(1.f));
 }
 
-glm::vec4 ShaderConfiguration::getVec4(const std::string& name)
+glm::vec4 ShaderConfiguration::getVec4(UniformName name)
 {
-	auto it = this->v_vec4.find(name);
-	return (it == this->v_vec4.end()) ? glm::vec4(0.f) : it->second;
+	return getValue(name, ValueType::Vec4, glm::vec4(0.f));
 }
 
-glm::vec3 ShaderConfiguration::getVec3(const std::string& name)
+glm::vec3 ShaderConfiguration::getVec3(UniformName name)
 {
-	auto it = this->v_vec3.find(name);
-	return (it == this->v_vec3.end()) ? glm::vec3(0.f) : it->second;
+	return getValue(name, ValueType::Vec3, glm::vec3(0.f));
 }
 
-glm::vec2 ShaderConfiguration::getVec2(const std::string& name)
+glm::vec2 ShaderConfiguration::getVec2(UniformName name)
 {
-	auto it = this->v_vec2.find(name);
-	return (it == this->v_vec2.end()) ? glm::vec2(0.f) : it->second;
+	return getValue(name, ValueType::Vec2, glm::vec2(0.f));
 }
 
 std::shared_ptr<Material> ShaderConfiguration::getMaterial(const std::string& name)
 {
-	auto it = this->v_material.find(name);
-	return (it == this->v_material.end()) ? nullptr : it->second;
+	for (const MaterialValue & v : this->materials)
+	{
+		if (v.name == name) return v.material;
+	}
+	return nullptr;
 }
 
 GLint ShaderConfiguration::getPatchVertices()
@@ -197,8 +327,29 @@ Shader::Shader(const std::string shader_lib, const std::string vertex_path,
 	std::optional<const std::string> tessellation_control_path,
 	std::optional<const std::string> tessellation_evaluation_path,
 	std::optional<const std::string> geometry_path,
-	const std::string fragment_path, enum ShaderRenderingMode mode) : shader_render_mode(mode)
-{
+	const std::string fragment_path, enum ShaderRenderingMode mode, ShaderCompileMode compile_mode,
+	const std::vector<std::string> & defines) : shader_render_mode(mode)
+{
+	ShaderPreprocessor preprocessor;
+	preprocessor.addIncludeDirectory(shader_lib);
+	preprocessor.addVirtualFile("glrf/frame_uniforms.glsl", FrameUniformBuffer::getGLSLInterface());
+	preprocessor.addVirtualFile("glrf/lighting.glsl", FrameUniformBuffer::getGLSLLighting());
+	preprocessor.addVirtualFile("glrf/material_table.glsl", MaterialTable::getInstance().getGLSLInterface());
+	preprocessor.addVirtualFile("glrf/environment.glsl", EnvironmentMap::getGLSLInterface());
+	preprocessor.addVirtualFile("glrf/gbuffer.glsl", DeferredRenderer::getGLSLInterface());
+	preprocessor.addVirtualFile("glrf/material.glsl", ShaderVariants::getGLSLInterface());
+	static const char * RENDERING_MODE_DEFINES[] = { "GLRF_RENDERING_MODE_NONE", "GLRF_RENDERING_MODE_PHONG", "GLRF_RENDERING_MODE_PBR" };
+	if (mode < ShaderRenderingMode::Total) preprocessor.setDefine(RENDERING_MODE_DEFINES[static_cast<std::uint32_t>(mode)]);
+	for (const std::string & define : defines)
+	{
+		const size_t separator = define.find(' ');
+		if (separator == std::string::npos) {
+			preprocessor.setDefine(define);
+		} else {
+			preprocessor.setDefine(define.substr(0, separator), define.substr(separator + 1));
+		}
+	}
+
 	const bool has_tessellation_control_shader = tessellation_control_path.has_value();
 	const bool has_tessellation_evaluation_shader = tessellation_evaluation_path.has_value();
 	const bool has_geometry_shader = geometry_path.has_value();
@@ -206,7 +357,7 @@ Shader::Shader(const std::string shader_lib, const std::string vertex_path,
 	// 1. retrieve the GLSL source code from paths
 	std::string vertex_lib_path = shader_lib + vertex_path;
 	std::string vertex_code_str;
-	loadShaderFile(vertex_lib_path, &vertex_code_str);
+	loadShaderFile(preprocessor, vertex_lib_path, &vertex_code_str);
 	const char* vertex_code = vertex_code_str.c_str();
 
 	std::string tessellation_control_lib_path;
@@ -215,7 +366,7 @@ Shader::Shader(const std::string shader_lib, const std::string vertex_path,
 	if (has_tessellation_control_shader)
 	{
 		tessellation_control_lib_path = shader_lib + tessellation_control_path.value();
-		loadShaderFile(tessellation_control_lib_path, &tessellation_control_code_str);
+		loadShaderFile(preprocessor, tessellation_control_lib_path, &tessellation_control_code_str);
 		tessellation_control_code = tessellation_control_code_str.c_str();
 	}
 	std::string tessellation_evaluation_lib_path;
@@ -224,7 +375,7 @@ Shader::Shader(const std::string shader_lib, const std::string vertex_path,
 	if (has_tessellation_evaluation_shader)
 	{
 		tessellation_evaluation_lib_path = shader_lib + tessellation_evaluation_path.value();
-		loadShaderFile(tessellation_evaluation_lib_path, &tessellation_evaluation_code_str);
+		loadShaderFile(preprocessor, tessellation_evaluation_lib_path, &tessellation_evaluation_code_str);
 		tessellation_evaluation_code = tessellation_evaluation_code_str.c_str();
 	}
 	std::string geometry_lib_path;
@@ -233,169 +384,388 @@ Shader::Shader(const std::string shader_lib, const std::string vertex_path,
 	if (has_geometry_shader)
 	{
 		geometry_lib_path = shader_lib + geometry_path.value();
-		loadShaderFile(geometry_lib_path, &geometry_code_str);
+		loadShaderFile(preprocessor, geometry_lib_path, &geometry_code_str);
 		geometry_code = geometry_code_str.c_str();
 	}
 
 	std::string fragment_lib_path = shader_lib + fragment_path;
 	std::string fragment_code_str;
-	loadShaderFile(fragment_lib_path, &fragment_code_str);
+	loadShaderFile(preprocessor, fragment_lib_path, &fragment_code_str);
 	const char* fragment_code = fragment_code_str.c_str();
 
-	// 2. compile shaders
-	GLuint vertex_id, tess_control_id, tess_eval_id, geometry_id, fragment_id;
-	int success;
-	char infoLog[512];
-
-	vertex_id = createShader(GL_VERTEX_SHADER, vertex_code, "VERTEX");
-	if (has_tessellation_control_shader) tess_control_id = createShader(GL_TESS_CONTROL_SHADER, tessellation_control_code, "TESS_CONTROL");
-	if (has_tessellation_evaluation_shader) tess_eval_id = createShader(GL_TESS_EVALUATION_SHADER, tessellation_evaluation_code, "TESS_EVALUATION");
-	if (has_geometry_shader) geometry_id = createShader(GL_GEOMETRY_SHADER, geometry_code, "GEOMETRY");
-	fragment_id = createShader(GL_FRAGMENT_SHADER, fragment_code, "FRAGMENT");
+	// 2. load the linked program from the cache
+	this->source_hash = hashStageSource("vertex", vertex_code_str);
+	if (has_tessellation_control_shader) this->source_hash = hashStageSource("tess_control", tessellation_control_code_str, this->source_hash);
+	if (has_tessellation_evaluation_shader) this->source_hash = hashStageSource("tess_evaluation", tessellation_evaluation_code_str, this->source_hash);
+	if (has_geometry_shader) this->source_hash = hashStageSource("geometry", geometry_code_str, this->source_hash);
+	this->source_hash = hashStageSource("fragment", fragment_code_str, this->source_hash);
 
-	// shader Program
 	ID = glCreateProgram();
-	glAttachShader(ID, vertex_id);
-	if (has_tessellation_control_shader) glAttachShader(ID, tess_control_id);
-	if (has_tessellation_evaluation_shader) glAttachShader(ID, tess_eval_id);
-	if (has_geometry_shader) glAttachShader(ID, geometry_id);
-	glAttachShader(ID, fragment_id);
-	glLinkProgram(ID);
-
-	// print linking errors if any
-	glGetProgramiv(ID, GL_LINK_STATUS, &success);
-	if (!success)
+	if (ProgramBinaryCache::getInstance().load(ID, this->source_hash))
 	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-		exit(1);
+		introspectUniforms();
+		this->ready = true;
 	}
+	else
+	{
+		// 3. issue the compilation of all stages and the linking, the results are only queried when the program is needed,
+		// so the driver can compile in the background
+		this->pending_stages.emplace_back(createShader(GL_VERTEX_SHADER, vertex_code), "VERTEX");
+		if (has_tessellation_control_shader) this->pending_stages.emplace_back(createShader(GL_TESS_CONTROL_SHADER, tessellation_control_code), "TESS_CONTROL");
+		if (has_tessellation_evaluation_shader) this->pending_stages.emplace_back(createShader(GL_TESS_EVALUATION_SHADER, tessellation_evaluation_code), "TESS_EVALUATION");
+		if (has_geometry_shader) this->pending_stages.emplace_back(createShader(GL_GEOMETRY_SHADER, geometry_code), "GEOMETRY");
+		this->pending_stages.emplace_back(createShader(GL_FRAGMENT_SHADER, fragment_code), "FRAGMENT");
+
+		// shader Program
+		for (auto & stage : this->pending_stages)
+		{
+			glAttachShader(ID, stage.first);
+		}
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(ID);
 
-	// delete the shaders as they're linked into our program now and no longer necessery
-	glDeleteShader(vertex_id);	
-	if (has_tessellation_control_shader) glDeleteShader(tess_control_id);
-	if (has_tessellation_evaluation_shader) glDeleteShader(tess_eval_id);
-	if (has_geometry_shader) glDeleteShader(geometry_id);
-	glDeleteShader(fragment_id);
+		if (compile_mode == ShaderCompileMode::SYNCHRONOUS)
+		{
+			try
+			{
+				finish();
+			}
+			catch (const std::runtime_error &)
+			{
+				glDeleteProgram(ID);
+				throw;
+			}
+		}
+	}
 
 	// ======= REGISTER SHADER ======= //
 	ShaderManager::getInstance().registerShader(this);
 }
 
-void Shader::loadShaderFile(const std::string shader_path, std::string* out)
+Shader::~Shader()
 {
-	std::ifstream file;
-	// ensure ifstream objects can throw exceptions:
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try
+	ShaderManager::getInstance().unregisterShader(this);
+	for (auto & stage : this->pending_stages)
 	{
-		// open file
-		file.open(shader_path);
-		std::stringstream stream;
-		// read file's buffer contents into streams
-		stream << file.rdbuf();
-		// close file handlers
-		file.close();
-		// convert stream into string
-		*out = stream.str();
-	}
-	catch (std::ifstream::failure e)
+		glDeleteShader(stage.first);
+	}
+	GLStateCache::getInstance().deleteProgram(ID);
+}
+
+std::uint64_t Shader::hashStageSource(const std::string & stage, const std::string & source, std::uint64_t hash)
+{
+	return fnv1a64(source, fnv1a64(stage + "\n", hash));
+}
+
+bool Shader::isReady()
+{
+	if (this->ready) return true;
+	if (GLExtensions::getInstance().hasParallelShaderCompile())
 	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		GLint completed = GL_FALSE;
+		glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+		if (!completed) return false;
 	}
+	completeLinking();
+	return true;
+}
+
+void Shader::finish()
+{
+	if (!this->ready) completeLinking();
+}
+
+void Shader::completeLinking()
+{
+	// print compilation errors if any
+	auto getLog = [](GLint length, auto get) {
+		std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+		get(static_cast<GLsizei>(log.size()), log.data());
+		return std::string(log.c_str());
+	};
+	std::string error;
+	for (auto & stage : this->pending_stages)
+	{
+		GLint success = GL_FALSE;
+		glGetShaderiv(stage.first, GL_COMPILE_STATUS, &success);
+		if (success || !error.empty()) continue;
+		GLint length = 0;
+		glGetShaderiv(stage.first, GL_INFO_LOG_LENGTH, &length);
+		error = "ERROR::SHADER::" + stage.second + "::COMPILATION_FAILED\n"
+			+ getLog(length, [&](GLsizei size, GLchar * log) { glGetShaderInfoLog(stage.first, size, NULL, log); });
+	}
+
+	// print linking errors if any
+	if (error.empty())
+	{
+		GLint success = GL_FALSE;
+		glGetProgramiv(ID, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			GLint length = 0;
+			glGetProgramiv(ID, GL_INFO_LOG_LENGTH, &length);
+			error = "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+				+ getLog(length, [&](GLsizei size, GLchar * log) { glGetProgramInfoLog(ID, size, NULL, log); });
+		}
+	}
+
+	// delete the shaders as they're linked into our program now and no longer necessery
+	for (auto & stage : this->pending_stages)
+	{
+		glDeleteShader(stage.first);
+	}
+	this->pending_stages.clear();
+
+	if (!error.empty())
+	{
+		std::cout << error << std::endl;
+		throw std::runtime_error(error);
+	}
+
+	introspectUniforms();
+	ProgramBinaryCache::getInstance().store(ID, this->source_hash);
+	this->ready = true;
+}
+
+void Shader::loadShaderFile(ShaderPreprocessor & preprocessor, const std::string shader_path, std::string* out)
+{
+	// resolves the includes and injects the defines, throws if a file can not be read
+	*out = preprocessor.process(shader_path);
 }
 
 unsigned int Shader::getID() {
 	return this->ID;
 }
 
+void Shader::introspectUniforms() {
+	this->uniform_locations.clear();
+	this->material_locations.clear();
+
+	// shaders that declare the frame uniforms without a binding qualifier still read the shared buffer
+	GLuint frame_block = glGetUniformBlockIndex(this->ID, FrameUniformBuffer::BLOCK_NAME);
+	if (frame_block != GL_INVALID_INDEX) {
+		glUniformBlockBinding(this->ID, frame_block, FrameUniformBuffer::UNIFORM_BUFFER_BINDING);
+	}
+
+	GLint count = 0, max_name_length = 0;
+	glGetProgramInterfaceiv(this->ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	glGetProgramInterfaceiv(this->ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+	std::vector<GLchar> name_buffer(static_cast<size_t>(max_name_length) + 1);
+	GLint max_location = -1;
+	const GLenum properties[2] = { GL_LOCATION, GL_ARRAY_SIZE };
+	for (GLint i = 0; i < count; ++i) {
+		GLint values[2];
+		glGetProgramResourceiv(this->ID, GL_UNIFORM, i, 2, properties, 2, NULL, values);
+		// members of uniform blocks have no location
+		if (values[0] < 0) continue;
+		glGetProgramResourceName(this->ID, GL_UNIFORM, i, static_cast<GLsizei>(name_buffer.size()), NULL, name_buffer.data());
+		std::string name(name_buffer.data());
+		this->uniform_locations.insert_or_assign(fnv1a64(name), values[0]);
+		max_location = std::max(max_location, values[0] + std::max(values[1], 1) - 1);
+
+		// arrays are reported as 'name[0]', but their elements are set as 'name' or 'name[i]'
+		const std::string first_element = "[0]";
+		if (name.size() > first_element.size() && name.compare(name.size() - first_element.size(), first_element.size(), first_element) == 0) {
+			std::string base_name = name.substr(0, name.size() - first_element.size());
+			this->uniform_locations.insert_or_assign(fnv1a64(base_name), values[0]);
+			for (GLint element = 1; element < values[1]; ++element) {
+				this->uniform_locations.insert_or_assign(fnv1a64(base_name + "[" + std::to_string(element) + "]"), values[0] + element);
+			}
+		}
+	}
+
+	// the values a newly linked program holds are unknown, so the first upload of every uniform is never skipped
+	this->uniform_shadows.assign(static_cast<size_t>(max_location + 1), UniformShadow());
+}
+
+bool Shader::updateShadow(GLint location, const void * value, size_t size) const {
+	if (location < 0) return false;
+	if (static_cast<size_t>(location) < this->uniform_shadows.size()) {
+		UniformShadow & shadow = this->uniform_shadows[location];
+		if (shadow.valid && shadow.size == size && std::memcmp(shadow.data, value, size) == 0) {
+			++(this->upload_stats.skipped);
+			return false;
+		}
+		if (size <= sizeof(shadow.data)) {
+			std::memcpy(shadow.data, value, size);
+			shadow.size = static_cast<std::uint32_t>(size);
+			shadow.valid = true;
+		}
+	}
+	++(this->upload_stats.uploads);
+	return true;
+}
+
+UniformUploadStats Shader::getUploadStats() const {
+	return this->upload_stats;
+}
+
+void Shader::resetUploadStats() {
+	this->upload_stats = UniformUploadStats();
+}
+
+UniformLocation Shader::getUniformLocation(UniformName name) const {
+	UniformLocation location;
+	auto it = this->uniform_locations.find(name.hash);
+	if (it != this->uniform_locations.end()) location.value = it->second;
+	return location;
+}
+
 void Shader::setBool(const std::string & name, bool value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	setBool(getUniformLocation(name), value);
 }
 
 void Shader::setInt(const std::string & name, GLint value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	setInt(getUniformLocation(name), value);
 }
 
 void Shader::setUInt(const std::string & name, GLuint value) const {
-	glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+	setUInt(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string & name, float value) const {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	setFloat(getUniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string & name, glm::mat4 value) const {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	setMat4(getUniformLocation(name), value);
 }
 
 void Shader::setMat3(const std::string & name, glm::mat3 value) const {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	setMat3(getUniformLocation(name), value);
 }
 
 void Shader::setVec4(const std::string & name, glm::vec4 value) const {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	setVec4(getUniformLocation(name), value);
 }
 
 void Shader::setVec3(const std::string & name, glm::vec3 value) const {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	setVec3(getUniformLocation(name), value);
 }
 
 void Shader::setVec2(const std::string& name, glm::vec2 value) const {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	setVec2(getUniformLocation(name), value);
+}
+
+void Shader::setBool(UniformLocation location, bool value) const {
+	const GLint v = (int)value;
+	if (updateShadow(location.value, &v, sizeof(v))) uploadInt(this->ID, location.value, v);
 }
 
-void Shader::setMaterialProperty(const std::string& name, MaterialProperty<glm::vec4> material_property, GLuint texture_unit) {
-	setVec4(name + period + value_default,	material_property.value_default);
-	setMaterialPropertyCommons(name, material_property, texture_unit);
+void Shader::setInt(UniformLocation location, GLint value) const {
+	if (updateShadow(location.value, &value, sizeof(value))) uploadInt(this->ID, location.value, value);
 }
 
-void Shader::setMaterialProperty(const std::string& name, MaterialProperty<glm::vec3> material_property, GLuint texture_unit) {
-	setVec3(name + period + value_default,	material_property.value_default);
-	setMaterialPropertyCommons(name, material_property, texture_unit);
+void Shader::setUInt(UniformLocation location, GLuint value) const {
+	if (updateShadow(location.value, &value, sizeof(value))) uploadUInt(this->ID, location.value, value);
 }
 
-void Shader::setMaterialProperty(const std::string& name, MaterialProperty<glm::vec2> material_property, GLuint texture_unit) {
-	setVec2(name + period + value_default,	material_property.value_default);
-	setMaterialPropertyCommons(name, material_property, texture_unit);
+void Shader::setFloat(UniformLocation location, float value) const {
+	if (updateShadow(location.value, &value, sizeof(value))) uploadFloat(this->ID, location.value, value);
 }
 
-void Shader::setMaterialProperty(const std::string& name, MaterialProperty<float> material_property, GLuint texture_unit) {
-	setFloat(name + period + value_default, material_property.value_default);
-	setMaterialPropertyCommons(name, material_property, texture_unit);
+void Shader::setMat4(UniformLocation location, const glm::mat4 & value) const {
+	if (updateShadow(location.value, glm::value_ptr(value), sizeof(value))) uploadMat4(this->ID, location.value, glm::value_ptr(value));
+}
+
+void Shader::setMat3(UniformLocation location, const glm::mat3 & value) const {
+	if (updateShadow(location.value, glm::value_ptr(value), sizeof(value))) uploadMat3(this->ID, location.value, glm::value_ptr(value));
+}
+
+void Shader::setVec4(UniformLocation location, const glm::vec4 & value) const {
+	if (updateShadow(location.value, glm::value_ptr(value), sizeof(value))) uploadVec4(this->ID, location.value, glm::value_ptr(value));
+}
+
+void Shader::setVec3(UniformLocation location, const glm::vec3 & value) const {
+	if (updateShadow(location.value, glm::value_ptr(value), sizeof(value))) uploadVec3(this->ID, location.value, glm::value_ptr(value));
+}
+
+void Shader::setVec2(UniformLocation location, const glm::vec2 & value) const {
+	if (updateShadow(location.value, glm::value_ptr(value), sizeof(value))) uploadVec2(this->ID, location.value, glm::value_ptr(value));
+}
+
+Shader::MaterialPropertyLocations Shader::getMaterialPropertyLocations(const std::string & name) const {
+	MaterialPropertyLocations locations;
+	locations.value_default = getUniformLocation(name + period + value_default);
+	locations.use_texture = getUniformLocation(name + period + use_texture);
+	locations.texture = getUniformLocation(name + period + texture);
+	return locations;
+}
+
+const Shader::MaterialLocations & Shader::getMaterialLocations(const std::string & name) {
+	auto it = this->material_locations.find(name);
+	if (it != this->material_locations.end()) return it->second;
+
+	// the uniform names of a material are only built once per material name
+	MaterialLocations locations;
+	locations.albedo = getMaterialPropertyLocations(name + period + "albedo");
+	locations.normal = getMaterialPropertyLocations(name + period + "normal");
+	locations.roughness = getMaterialPropertyLocations(name + period + "roughness");
+	locations.metallic = getMaterialPropertyLocations(name + period + "metallic");
+	locations.ao = getMaterialPropertyLocations(name + period + "ao");
+	locations.height = getMaterialPropertyLocations(name + period + "height");
+	locations.opacity = getMaterialPropertyLocations(name + period + "opacity");
+	locations.height_scale = getUniformLocation(name + period + "height_scale");
+	locations.use_table = getUniformLocation(name + period + "use_table");
+	locations.index = getUniformLocation(name + period + "index");
+	return this->material_locations.emplace(name, locations).first->second;
+}
+
+void Shader::setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec4> & material_property, GLuint texture_unit) {
+	setVec4(locations.value_default, material_property.value_default);
+	setMaterialPropertyCommons(locations, material_property, texture_unit);
+}
+
+void Shader::setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec3> & material_property, GLuint texture_unit) {
+	setVec3(locations.value_default, material_property.value_default);
+	setMaterialPropertyCommons(locations, material_property, texture_unit);
+}
+
+void Shader::setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<glm::vec2> & material_property, GLuint texture_unit) {
+	setVec2(locations.value_default, material_property.value_default);
+	setMaterialPropertyCommons(locations, material_property, texture_unit);
+}
+
+void Shader::setMaterialProperty(const MaterialPropertyLocations & locations, const MaterialProperty<float> & material_property, GLuint texture_unit) {
+	setFloat(locations.value_default, material_property.value_default);
+	setMaterialPropertyCommons(locations, material_property, texture_unit);
 }
 
 void Shader::setMaterial(const std::string & name, std::shared_ptr<Material> material) {
+	const MaterialLocations & locations = getMaterialLocations(name);
+	std::optional<GLuint> table_index = std::nullopt;
+	if (this->use_material_table) {
+		MaterialTable & material_table = MaterialTable::getInstance();
+		table_index = material_table.getIndex(material);
+		material_table.update();
+		setBool(locations.use_table, table_index.has_value());
+		// the textures and values are read from the table, so the index is all that is set per draw
+		if (table_index.has_value()) {
+			setUInt(locations.index, table_index.value());
+			return;
+		}
+	}
 	material->bindTextures(0);
 	if (shader_render_mode == ShaderRenderingMode::PBR) {
-		setMaterialProperty(name + period + "albedo",		material->albedo,		0);
-		setMaterialProperty(name + period + "normal",		material->normal,		1);
-		setMaterialProperty(name + period + "roughness",	material->roughness,	2);
-		setMaterialProperty(name + period + "metallic",		material->metallic,		3);
-		setMaterialProperty(name + period + "ao",			material->ao,			4);
-		setMaterialProperty(name + period + "height",		material->height,		5);
-		setMaterialProperty(name + period + "opacity",		material->opacity,		6);
-
-		setFloat(name + period + "height_scale", material->height_scale);
+		setMaterialProperty(locations.albedo,		material->albedo,		0);
+		setMaterialProperty(locations.normal,		material->normal,		1);
+		setMaterialProperty(locations.roughness,	material->roughness,	2);
+		setMaterialProperty(locations.metallic,		material->metallic,		3);
+		setMaterialProperty(locations.ao,			material->ao,			4);
+		setMaterialProperty(locations.height,		material->height,		5);
+		setMaterialProperty(locations.opacity,		material->opacity,		6);
+
+		setFloat(locations.height_scale, material->height_scale);
 	}
 }
 
-unsigned int Shader::createShader(GLenum shader_type, const GLchar * shader_source, std::string shader_name) {
+unsigned int Shader::createShader(GLenum shader_type, const GLchar * shader_source) {
+	// the compile status is checked in completeLinking (which reports errors with the stage name), checking it here would wait for the driver
 	unsigned int shader;
 	shader = glCreateShader(shader_type);
 	glShaderSource(shader, 1, &shader_source, NULL);
 	glCompileShader(shader);
 
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(shader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::" << shader_name << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-		exit(1);
-	}
-
 	return shader;
 }
 
@@ -414,28 +784,73 @@ void ShaderManager::registerShader(Shader * shader)
 	this->registered_shaders.insert_or_assign(shader->getID(), shader);
 }
 
+void ShaderManager::unregisterShader(Shader * shader)
+{
+	auto it = this->registered_shaders.find(shader->getID());
+	if (it != this->registered_shaders.end() && it->second == shader) this->registered_shaders.erase(it);
+	this->configured_shaders.erase(shader->getID());
+	if (this->fallback_shader == shader) this->fallback_shader = nullptr;
+}
+
 void ShaderManager::useShader(GLuint ID)
 {
-	if (this->activeShaderID != ID)
+	// programs that are not registered (e.g. compute programs) are used directly
+	auto it = this->registered_shaders.find(ID);
+	if (it != this->registered_shaders.end()) ID = resolveShader(ID)->getID();
+
+	GLStateCache::getInstance().useProgram(ID);
+}
+
+void ShaderManager::configureShader(const ShaderConfiguration * configuration, GLuint ID, bool force)
+{
+	auto it = this->registered_shaders.find(ID);
+	if (it == this->registered_shaders.end())
+	{
+		throw std::invalid_argument("shader was used but never registered");
+	}
+	// several shaders may share the fallback shader, so the configured shaders are tracked by the resolved shader
+	Shader * shader = resolveShader(ID);
+	if (force || this->configured_shaders.find(shader->getID()) == this->configured_shaders.end())
 	{
-		glUseProgram(ID);
-		this->activeShaderID = ID;
+		configuration->loadIntoShader(shader);
 	}
 }
 
-void ShaderManager::configureShader(const ShaderConfiguration * configuration, GLuint ID, bool force)
+void ShaderManager::setFallbackShader(Shader * shader)
 {
-	if (force || this->configured_shaders.find(ID) == this->configured_shaders.end())
+	if (shader) shader->finish();
+	this->fallback_shader = shader;
+}
+
+UniformUploadStats ShaderManager::getUploadStats()
+{
+	UniformUploadStats stats;
+	for (auto & pair : this->registered_shaders)
 	{
-		auto it = this->registered_shaders.find(ID);
-		if (it == this->registered_shaders.end())
-		{
-			throw std::invalid_argument("shader was used but never registered");
-		}
-		configuration->loadIntoShader(it->second);
+		UniformUploadStats shader_stats = pair.second->getUploadStats();
+		stats.uploads += shader_stats.uploads;
+		stats.skipped += shader_stats.skipped;
+	}
+	return stats;
+}
+
+void ShaderManager::resetUploadStats()
+{
+	for (auto & pair : this->registered_shaders)
+	{
+		pair.second->resetUploadStats();
 	}
 }
 
+Shader * ShaderManager::resolveShader(GLuint ID)
+{
+	Shader * shader = getShader(ID);
+	if (shader->isReady()) return shader;
+	if (this->fallback_shader) return this->fallback_shader;
+	shader->finish();
+	return shader;
+}
+
 void ShaderManager::clearDrawConfigurations()
 {
 	this->configured_shaders.clear();
@@ -446,6 +861,11 @@ Shader * ShaderManager::getShader(GLuint ID)
 	return this->registered_shaders.find(ID)->second;
 }
 
+void Shader::setUseMaterialTable(bool use_material_table)
+{
+	this->use_material_table = use_material_table;
+}
+
 void Shader::setDebugName(const std::string name)
 {
 	this->debug_name = name;
@@ -0,0 +1,189 @@
+#include <GLRF/ShaderPreprocessor.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace GLRF;
+
+namespace {
+	bool readFile(const fs::path & path, std::string & content)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream.is_open()) return false;
+		std::stringstream buffer;
+		buffer << stream.rdbuf();
+		content = buffer.str();
+		return !stream.bad();
+	}
+
+	// returns the directive of a line (e.g. 'include') and the rest of the line behind it
+	bool parseDirective(const std::string & line, std::string & directive, std::string & argument)
+	{
+		size_t begin = line.find_first_not_of(" \t");
+		if (begin == std::string::npos || line[begin] != '#') return false;
+		begin = line.find_first_not_of(" \t", begin + 1);
+		if (begin == std::string::npos) return false;
+		size_t end = line.find_first_of(" \t\r", begin);
+		directive = line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+		argument = end == std::string::npos ? std::string() : line.substr(end);
+		return true;
+	}
+
+	bool parseIncludeName(const std::string & argument, std::string & name)
+	{
+		size_t begin = argument.find_first_of("\"<");
+		if (begin == std::string::npos) return false;
+		const char closing = argument[begin] == '"' ? '"' : '>';
+		size_t end = argument.find(closing, begin + 1);
+		if (end == std::string::npos) return false;
+		name = argument.substr(begin + 1, end - begin - 1);
+		return !name.empty();
+	}
+}
+
+ShaderPreprocessor::ShaderPreprocessor()
+{
+
+}
+
+ShaderPreprocessor::~ShaderPreprocessor()
+{
+
+}
+
+void ShaderPreprocessor::addIncludeDirectory(const fs::path & directory)
+{
+	this->include_directories.push_back(directory);
+}
+
+void ShaderPreprocessor::addVirtualFile(const std::string & name, const std::string & source)
+{
+	this->virtual_files.insert_or_assign(name, source);
+}
+
+void ShaderPreprocessor::setDefine(const std::string & name, const std::string & value)
+{
+	auto it = std::find_if(this->defines.begin(), this->defines.end(), [&](auto & define) { return define.first == name; });
+	if (it != this->defines.end()) {
+		it->second = value;
+	} else {
+		this->defines.emplace_back(name, value);
+	}
+}
+
+std::string ShaderPreprocessor::process(const fs::path & path)
+{
+	std::string source;
+	if (!readFile(path, source)) {
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path.generic_string() << std::endl;
+		throw std::runtime_error("shader file could not be read: " + path.generic_string());
+	}
+	this->included_files.clear();
+	this->included_files.push_back(fs::weakly_canonical(path).generic_string());
+	std::string out;
+	processFile(source, path.parent_path(), true, out);
+	return out;
+}
+
+std::string ShaderPreprocessor::processSource(const std::string & source, const fs::path & directory)
+{
+	this->included_files.clear();
+	this->included_files.push_back("<source>");
+	std::string out;
+	processFile(source, directory, true, out);
+	return out;
+}
+
+const std::vector<std::string> & ShaderPreprocessor::getIncludedFiles()
+{
+	return this->included_files;
+}
+
+bool ShaderPreprocessor::findInclude(const std::string & name, const fs::path & directory, std::string & key, std::string & source)
+{
+	auto it = this->virtual_files.find(name);
+	if (it != this->virtual_files.end()) {
+		key = name;
+		source = it->second;
+		return true;
+	}
+
+	std::vector<fs::path> candidates;
+	candidates.push_back(directory / name);
+	for (const fs::path & include_directory : this->include_directories)
+	{
+		candidates.push_back(include_directory / name);
+	}
+	std::error_code error;
+	for (const fs::path & candidate : candidates)
+	{
+		if (!fs::is_regular_file(candidate, error)) continue;
+		if (!readFile(candidate, source)) return false;
+		key = fs::weakly_canonical(candidate, error).generic_string();
+		return true;
+	}
+	return false;
+}
+
+void ShaderPreprocessor::processFile(const std::string & source, const fs::path & directory, bool is_root, std::string & out)
+{
+	const size_t source_index = this->included_files.size() - 1;
+	std::istringstream lines(source);
+	std::string line;
+	size_t line_number = 0;
+	bool defines_written = false;
+	auto writeDefines = [&]() {
+		for (auto & define : this->defines)
+		{
+			out += "#define " + define.first + (define.second.empty() ? "" : " " + define.second) + "\n";
+		}
+		defines_written = true;
+	};
+
+	while (std::getline(lines, line))
+	{
+		++line_number;
+		std::string directive, argument;
+		const bool is_directive = parseDirective(line, directive, argument);
+
+		if (is_directive && directive == "version") {
+			// only the #version of the root file is kept, the defines have to follow it directly
+			if (is_root && !defines_written) {
+				out += line + "\n";
+				writeDefines();
+				out += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source_index) + "\n";
+			}
+			continue;
+		}
+		// sources without a #version directive receive the defines before their first statement
+		const size_t first = line.find_first_not_of(" \t\r");
+		const bool is_blank = first == std::string::npos || line.compare(first, 2, "//") == 0;
+		if (is_root && !defines_written && !this->defines.empty() && !is_blank) {
+			writeDefines();
+			out += "#line " + std::to_string(line_number) + " " + std::to_string(source_index) + "\n";
+		}
+
+		if (is_directive && directive == "include") {
+			std::string name, key, include_source;
+			if (!parseIncludeName(argument, name)) {
+				throw std::runtime_error("invalid #include directive in line " + std::to_string(line_number) + ": " + line);
+			}
+			if (!findInclude(name, directory, key, include_source)) {
+				std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << name << std::endl;
+				throw std::runtime_error("shader include could not be found: " + name);
+			}
+			if (std::find(this->included_files.begin(), this->included_files.end(), key) == this->included_files.end()) {
+				this->included_files.push_back(key);
+				out += "#line 1 " + std::to_string(this->included_files.size() - 1) + "\n";
+				const fs::path include_directory = this->virtual_files.count(name) ? directory : fs::path(key).parent_path();
+				processFile(include_source, include_directory, false, out);
+				out += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source_index) + "\n";
+			}
+			continue;
+		}
+		out += line + "\n";
+	}
+}
@@ -0,0 +1,136 @@
+#include <GLRF/ShaderVariants.hpp>
+
+#include <sstream>
+
+using namespace GLRF;
+
+namespace {
+	const char * FEATURE_DEFINES[] = {
+		"GLRF_ALBEDO_TEXTURE", "GLRF_NORMAL_TEXTURE", "GLRF_ROUGHNESS_TEXTURE", "GLRF_METALLIC_TEXTURE",
+		"GLRF_AO_TEXTURE", "GLRF_HEIGHT_TEXTURE", "GLRF_OPACITY_TEXTURE",
+		"GLRF_POINT_LIGHTS", "GLRF_DIRECTIONAL_LIGHT", "GLRF_TESSELLATION", "GLRF_INSTANCING"
+	};
+	const std::uint32_t FEATURE_COUNT = sizeof(FEATURE_DEFINES) / sizeof(FEATURE_DEFINES[0]);
+
+	struct MaterialAccessor {
+		const char * function;
+		const char * property;
+		const char * type;
+		const char * swizzle;
+		// the index of the feature in FEATURE_DEFINES
+		std::uint32_t feature;
+	};
+
+	const MaterialAccessor MATERIAL_ACCESSORS[] = {
+		{ "getMaterialAlbedo",		"albedo",		"vec3",		".rgb",	0 },
+		{ "getMaterialNormal",		"normal",		"vec3",		".rgb",	1 },
+		{ "getMaterialRoughness",	"roughness",	"float",	".r",	2 },
+		{ "getMaterialMetallic",	"metallic",		"float",	".r",	3 },
+		{ "getMaterialAO",			"ao",			"float",	".r",	4 },
+		{ "getMaterialHeight",		"height",		"float",	".r",	5 },
+		{ "getMaterialOpacity",		"opacity",		"float",	".r",	6 }
+	};
+}
+
+ShaderVariants::ShaderVariants(const std::string shader_lib, const std::string vertex_path,
+	std::optional<const std::string> tessellation_control_path,
+	std::optional<const std::string> tessellation_evaluation_path,
+	std::optional<const std::string> geometry_path,
+	const std::string fragment_path,
+	ShaderRenderingMode mode, ShaderCompileMode compile_mode)
+	: shader_lib(shader_lib), vertex_path(vertex_path), fragment_path(fragment_path), mode(mode), compile_mode(compile_mode)
+{
+	if (tessellation_control_path.has_value()) this->tessellation_control_path = tessellation_control_path.value();
+	if (tessellation_evaluation_path.has_value()) this->tessellation_evaluation_path = tessellation_evaluation_path.value();
+	if (geometry_path.has_value()) this->geometry_path = geometry_path.value();
+}
+
+ShaderVariants::~ShaderVariants()
+{
+
+}
+
+Shader * ShaderVariants::getVariant(ShaderFeatures features)
+{
+	auto it = this->variants.find(features);
+	if (it != this->variants.end()) return it->second.get();
+
+	const bool tessellation = (features & SHADER_FEATURE_TESSELLATION) != 0;
+	std::optional<const std::string> tessellation_control_path, tessellation_evaluation_path, geometry_path;
+	if (tessellation && this->tessellation_control_path.has_value()) tessellation_control_path.emplace(this->tessellation_control_path.value());
+	if (tessellation && this->tessellation_evaluation_path.has_value()) tessellation_evaluation_path.emplace(this->tessellation_evaluation_path.value());
+	if (this->geometry_path.has_value()) geometry_path.emplace(this->geometry_path.value());
+
+	std::unique_ptr<Shader> shader(new Shader(this->shader_lib, this->vertex_path,
+		tessellation_control_path, tessellation_evaluation_path, geometry_path, this->fragment_path,
+		this->mode, this->compile_mode, getDefines(features)));
+	Shader * variant = shader.get();
+	this->variants.emplace(features, std::move(shader));
+	return variant;
+}
+
+size_t ShaderVariants::getVariantCount()
+{
+	return this->variants.size();
+}
+
+std::vector<std::string> ShaderVariants::getDefines(ShaderFeatures features)
+{
+	std::vector<std::string> defines;
+	for (std::uint32_t i = 0; i < FEATURE_COUNT; ++i)
+	{
+		if (features & (1u << i)) defines.push_back(FEATURE_DEFINES[i]);
+	}
+	return defines;
+}
+
+ShaderFeatures ShaderVariants::getMaterialFeatures(const Material & material)
+{
+	ShaderFeatures features = 0;
+	if (material.albedo.texture.has_value())	features |= SHADER_FEATURE_ALBEDO_TEXTURE;
+	if (material.normal.texture.has_value())	features |= SHADER_FEATURE_NORMAL_TEXTURE;
+	if (material.roughness.texture.has_value())	features |= SHADER_FEATURE_ROUGHNESS_TEXTURE;
+	if (material.metallic.texture.has_value())	features |= SHADER_FEATURE_METALLIC_TEXTURE;
+	if (material.ao.texture.has_value())		features |= SHADER_FEATURE_AO_TEXTURE;
+	if (material.height.texture.has_value())	features |= SHADER_FEATURE_HEIGHT_TEXTURE;
+	if (material.opacity.texture.has_value())	features |= SHADER_FEATURE_OPACITY_TEXTURE;
+	return features;
+}
+
+std::string ShaderVariants::getGLSLInterface()
+{
+	// the names match the uniforms that Shader::setMaterial() sets
+	std::stringstream glsl;
+	glsl << "struct MaterialPropertyVec3 {\n"
+		<< "\tvec3 value_default;\n"
+		<< "\tbool use_texture;\n"
+		<< "\tsampler2D texture;\n"
+		<< "};\n"
+		<< "struct MaterialPropertyFloat {\n"
+		<< "\tfloat value_default;\n"
+		<< "\tbool use_texture;\n"
+		<< "\tsampler2D texture;\n"
+		<< "};\n"
+		<< "struct Material {\n"
+		<< "\tMaterialPropertyVec3 albedo;\n"
+		<< "\tMaterialPropertyVec3 normal;\n"
+		<< "\tMaterialPropertyFloat roughness;\n"
+		<< "\tMaterialPropertyFloat metallic;\n"
+		<< "\tMaterialPropertyFloat ao;\n"
+		<< "\tMaterialPropertyFloat height;\n"
+		<< "\tMaterialPropertyFloat opacity;\n"
+		<< "\tfloat height_scale;\n"
+		<< "};\n"
+		<< "uniform Material material;\n";
+	for (const MaterialAccessor & accessor : MATERIAL_ACCESSORS)
+	{
+		glsl << accessor.type << " " << accessor.function << "(vec2 uv) {\n"
+			<< "#ifdef " << FEATURE_DEFINES[accessor.feature] << "\n"
+			<< "\treturn texture(material." << accessor.property << ".texture, uv)" << accessor.swizzle << ";\n"
+			<< "#else\n"
+			<< "\treturn material." << accessor.property << ".value_default;\n"
+			<< "#endif\n"
+			<< "}\n";
+	}
+	return glsl.str();
+}
@@ -1,58 +1,278 @@
 #include <GLRF/Texture.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+#include <GLRF/ImageCache.hpp>
+#include <GLRF/MaterialTable.hpp>
+#include <GLRF/MipGenerator.hpp>
+#include <GLRF/TextureManager.hpp>
+#include <GLRF/TextureStreamer.hpp>
+#include <GLRF/ThreadPool.hpp>
 
 using namespace GLRF;
 
-Texture::Texture(std::string library, std::string relativePath) {
-	create(library, relativePath);
+namespace {
+	// every option that changes the decoded mip chain has to be part of the image cache key
+	std::string describeImageParameters(const TextureConfiguration & config) {
+		return "srgb=" + std::to_string(config.srgb) + " filter=" + std::to_string(static_cast<int>(config.mips.filter))
+			+ " normal=" + std::to_string(config.mips.normal_map) + " cutoff=" + std::to_string(config.mips.alpha_cutoff);
+	}
 }
 
-Texture::Texture(std::string relativePath) {
-	create(defaultLibrary, relativePath);
+Texture::Texture(std::string library, std::string relativePath, TextureConfiguration config) {
+	create(library, relativePath, config);
+}
+
+Texture::Texture(std::string relativePath, TextureConfiguration config) {
+	create(defaultLibrary, relativePath, config);
 }
 
 Texture::Texture() {
-	create(defaultLibrary, defaultRelativePath);
+	create(defaultLibrary, defaultRelativePath, TextureConfiguration());
 }
 
-void Texture::create(std::string library, std::string relativePath) {
+Texture::~Texture() {
+	if (this->config.async) TextureStreamer::getInstance().cancelLoad(this);
+	if (this->config.streamed) TextureStreamer::getInstance().unregisterTexture(this);
+	if (this->ID != 0) {
+		MaterialTable::getInstance().invalidateTexture(this);
+		GLStateCache::getInstance().deleteTextures(1, &(this->ID));
+	}
+}
+
+void Texture::create(std::string library, std::string relativePath, TextureConfiguration config) {
 	this->library = library;
 	this->relativePath = relativePath;
-	glGenTextures(1, &(this->ID));
-	glBindTexture(GL_TEXTURE_2D, this->ID);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	this->config = config;
+	this->sampler = SamplerManager::getInstance().getSampler(config.sampler);
 
 	load();
 }
 
 void Texture::load() {
-	std::string fullPath_string = this->library + this->relativePath;
-	const char * fullPath = (fullPath_string).data();
-	this->data = stbi_load(fullPath, &(this->width), &(this->height), &(this->nrChannels), STBI_rgb_alpha);
+	std::shared_ptr<AssetArchive> archive = TextureManager::getInstance().findArchive(this->relativePath);
+	if (this->config.async) {
+		std::string path = getPath();
+		std::string name = this->relativePath;
+		TextureConfiguration config = this->config;
+		TextureStreamer::getInstance().loadAsync(this, ThreadPool::getInstance().submit([path, name, archive, config]() {
+			return readImage(path, name, archive, config);
+		}));
+		return;
+	}
+	finishLoad(readImage(getPath(), this->relativePath, archive, this->config));
+}
 
-	if (data) {
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->width, this->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, this->data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+void Texture::finishLoad(const ImageData & image) {
+	if (!image.isEmpty()) {
+		TextureStreamer & streamer = TextureStreamer::getInstance();
+		if (this->config.streamed) {
+			// only the coarse mip tail is kept, finer levels are streamed in on demand
+			upload(image, streamer.calculateTailLevel(image.getWidth(), image.getHeight()));
+			streamer.registerTexture(this);
+		} else {
+			upload(image);
+		}
 		this->successfullyLoaded = true;
 	} else {
-		std::cout << "Failed to load texture \"" << fullPath_string << "\"" << std::endl;
+		std::cout << "Failed to load texture \"" << getPath() << "\"" << std::endl;
 		this->successfullyLoaded = false;
 	}
+}
+
+ImageData Texture::readImage(const std::string & path, const std::string & name, std::shared_ptr<AssetArchive> archive, const TextureConfiguration & config) {
+	// baked archives already contain the compressed mip chain, source files are only decoded as a fallback
+	if (archive) {
+		ImageData baked = archive->loadImage(name, config.srgb);
+		if (!baked.isEmpty()) return baked;
+	}
+	// decoded source files are cached on disk, warm starts only map the cached mip chain
+	ImageCache & cache = ImageCache::getInstance();
+	const std::string parameters = describeImageParameters(config);
+	ImageData cached = cache.load(path, parameters, config.srgb);
+	if (!cached.isEmpty()) return cached;
+
+	ImageData image = ImageData::decode(path, config.srgb);
+	if (image.isEmpty()) return image;
+	image = MipGenerator(config.mips).generate(image);
+	cache.store(path, parameters, image);
+	return image;
+}
+
+GLuint Texture::createStorage(GLuint storage_level) {
+	GLuint id = GLResources::createTexture(GL_TEXTURE_2D);
+	GLResources::textureStorage2D(id, GL_TEXTURE_2D, this->levels - storage_level, this->format.internal_format,
+		std::max(this->width >> storage_level, 1), std::max(this->height >> storage_level, 1));
+
+	GLint swizzle[4];
+	this->format.getSwizzleMask(swizzle);
+	GLResources::textureParameteriv(id, GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+	return id;
+}
+
+void Texture::updateBaseLevel() {
+	GLResources::textureParameteri(this->ID, GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, this->resident_level - this->storage_level);
+}
+
+void Texture::upload(const ImageData & image, GLuint first_level) {
+	this->width = image.getWidth();
+	this->height = image.getHeight();
+	this->levels = ImageData::calculateMipCount(this->width, this->height);
+	this->format = image.getFormat();
+	first_level = std::min(first_level, this->levels - 1);
+
+	// immutable storage can not be resized, so a new texture object is needed for every allocation
+	if (this->ID != 0) {
+		MaterialTable::getInstance().invalidateTexture(this);
+		GLStateCache::getInstance().deleteTextures(1, &(this->ID));
+	}
+	this->ID = createStorage(first_level);
+	this->storage_level = first_level;
+	this->resident_level = first_level;
+
+	// levels below the base level can only be derived from the base level on the CPU
+	const ImageData & chain = (first_level > 0 && image.getLevelCount() <= first_level) ? MipGenerator(this->config.mips).generate(image) : image;
+
+	// rows of single and two channel images are not necessarily 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	const GLuint provided_levels = std::min(chain.getLevelCount(), this->levels);
+	for (GLuint i = first_level; i < provided_levels; ++i)
+	{
+		uploadImageLevel(i - first_level, chain, i);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// compressed formats can not be rendered to, so their chains must be complete
+	if (provided_levels < this->levels && !this->format.isCompressed()) {
+		GLResources::generateMipmap(this->ID, GL_TEXTURE_2D);
+	}
+}
+
+void Texture::uploadImageLevel(GLuint target_level, const ImageData & image, GLuint level) {
+	const ImageLevel & image_level = image.getLevel(level);
+	if (this->format.isCompressed()) {
+		GLResources::compressedTextureSubImage2D(this->ID, GL_TEXTURE_2D, target_level, 0, 0, image_level.width, image_level.height,
+			this->format.internal_format, static_cast<GLsizei>(image_level.size), image.getLevelData(level));
+	} else {
+		GLResources::textureSubImage2D(this->ID, GL_TEXTURE_2D, target_level, 0, 0, image_level.width, image_level.height,
+			this->format.pixel_format, this->format.data_type, image.getLevelData(level));
+	}
+}
+
+void Texture::reallocateStorage(GLuint storage_level) {
+	storage_level = std::min(storage_level, this->levels - 1);
+	if (storage_level == this->storage_level) return;
+
+	GLuint new_ID = createStorage(storage_level);
+	const GLuint first_valid_level = std::max(this->resident_level, storage_level);
+	for (GLuint i = first_valid_level; i < this->levels; ++i)
+	{
+		glCopyImageSubData(this->ID, GL_TEXTURE_2D, i - this->storage_level, 0, 0, 0,
+			new_ID, GL_TEXTURE_2D, i - storage_level, 0, 0, 0,
+			std::max(this->width >> i, 1), std::max(this->height >> i, 1), 1);
+	}
+	MaterialTable::getInstance().invalidateTexture(this);
+	GLStateCache::getInstance().deleteTextures(1, &(this->ID));
 
-	stbi_image_free(this->data);
+	this->ID = new_ID;
+	this->storage_level = storage_level;
+	this->resident_level = first_valid_level;
+	// levels between the storage level and the resident level are still undefined
+	updateBaseLevel();
+}
+
+void Texture::useArrayLayer(GLuint array, GLuint layer) {
+	// views need a name that was never bound, so it is generated instead of created
+	GLuint view;
+	glGenTextures(1, &view);
+	glTextureView(view, GL_TEXTURE_2D, array, this->format.internal_format, 0, this->levels - this->storage_level, layer, 1);
+
+	GLint swizzle[4];
+	this->format.getSwizzleMask(swizzle);
+	GLResources::textureParameteriv(view, GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+	if (this->ID != 0) GLStateCache::getInstance().deleteTextures(1, &(this->ID));
+	this->ID = view;
+}
+
+void Texture::uploadLevel(GLuint level, const ImageData & chain) {
+	if (level + 1 != this->resident_level || level < this->storage_level) {
+		throw std::invalid_argument("mip levels must be uploaded from coarse to fine into allocated storage");
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	uploadImageLevel(level - this->storage_level, chain, level);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	this->resident_level = level;
+	updateBaseLevel();
 }
 
 void Texture::bind(GLenum textureUnit) {
-	glActiveTexture(textureUnit);
-	glBindTexture(GL_TEXTURE_2D, this->ID);
+	GLStateCache & state = GLStateCache::getInstance();
+	state.bindTexture(textureUnit - GL_TEXTURE0, GL_TEXTURE_2D, this->ID);
+	state.bindSampler(textureUnit - GL_TEXTURE0, this->sampler);
 }
 
 bool Texture::isSuccessfullyLoaded() {
 	return this->successfullyLoaded;
 }
+
+GLuint Texture::getID() {
+	return this->ID;
+}
+
+GLuint Texture::getSampler() {
+	return this->sampler;
+}
+
+GLsizei Texture::getWidth() {
+	return this->width;
+}
+
+GLsizei Texture::getHeight() {
+	return this->height;
+}
+
+GLuint Texture::getLevelCount() {
+	return this->levels;
+}
+
+const TextureFormat & Texture::getFormat() {
+	return this->format;
+}
+
+const TextureConfiguration & Texture::getConfiguration() {
+	return this->config;
+}
+
+std::string Texture::getPath() {
+	return this->library + this->relativePath;
+}
+
+std::string Texture::getRelativePath() {
+	return this->relativePath;
+}
+
+GLuint Texture::getResidentLevel() {
+	return this->resident_level;
+}
+
+GLuint Texture::getStorageLevel() {
+	return this->storage_level;
+}
+
+size_t Texture::getLevelSize(GLuint level) {
+	return this->format.calculateStorageSize(std::max(this->width >> level, 1), std::max(this->height >> level, 1));
+}
+
+size_t Texture::getAllocatedSize() {
+	size_t size = 0;
+	for (GLuint i = this->storage_level; i < this->levels; ++i)
+	{
+		size += getLevelSize(i);
+	}
+	return size;
+}
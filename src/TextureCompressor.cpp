@@ -0,0 +1,240 @@
+#include <GLRF/TextureCompressor.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace GLRF;
+
+namespace {
+	std::uint16_t packRGB565(const float * color)
+	{
+		int r = std::clamp(static_cast<int>(color[0] * 31.f / 255.f + 0.5f), 0, 31);
+		int g = std::clamp(static_cast<int>(color[1] * 63.f / 255.f + 0.5f), 0, 63);
+		int b = std::clamp(static_cast<int>(color[2] * 31.f / 255.f + 0.5f), 0, 31);
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackRGB565(std::uint16_t packed, int * color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	 * Copies a 4x4 block of texels, clamping at the image border.
+	 */
+	void fetchBlock(const unsigned char * data, GLsizei width, GLsizei height, GLuint channels, GLsizei block_x, GLsizei block_y, unsigned char * block)
+	{
+		for (GLsizei y = 0; y < 4; ++y)
+		{
+			GLsizei source_y = std::min(block_y * 4 + y, height - 1);
+			for (GLsizei x = 0; x < 4; ++x)
+			{
+				GLsizei source_x = std::min(block_x * 4 + x, width - 1);
+				std::memcpy(block + (y * 4 + x) * channels, data + (static_cast<size_t>(source_y) * width + source_x) * channels, channels);
+			}
+		}
+	}
+}
+
+bool TextureCompressor::isSupported(const TextureFormat & format)
+{
+	return !format.isCompressed() && format.data_type == GL_UNSIGNED_BYTE;
+}
+
+void TextureCompressor::encodeBC1(const unsigned char * rgba, unsigned char * block)
+{
+	// find the principal axis of the colors through power iteration on the covariance matrix
+	float mean[3] = { 0.f, 0.f, 0.f };
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 3; ++c) mean[c] += rgba[i * 4 + c];
+	}
+	for (int c = 0; c < 3; ++c) mean[c] /= 16.f;
+
+	float covariance[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+	for (int i = 0; i < 16; ++i)
+	{
+		float r = rgba[i * 4] - mean[0], g = rgba[i * 4 + 1] - mean[1], b = rgba[i * 4 + 2] - mean[2];
+		covariance[0] += r * r;	covariance[1] += r * g;	covariance[2] += r * b;
+		covariance[3] += g * g;	covariance[4] += g * b;	covariance[5] += b * b;
+	}
+	float axis[3] = { 1.f, 1.f, 1.f };
+	for (int iteration = 0; iteration < 4; ++iteration)
+	{
+		float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		float length = std::max(std::max(std::abs(x), std::abs(y)), std::abs(z));
+		if (length < 1e-6f) break;
+		axis[0] = x / length;	axis[1] = y / length;	axis[2] = z / length;
+	}
+
+	float min_projection = 1e30f, max_projection = -1e30f;
+	for (int i = 0; i < 16; ++i)
+	{
+		float projection = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+		min_projection = std::min(min_projection, projection);
+		max_projection = std::max(max_projection, projection);
+	}
+	float axis_length_squared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float endpoint_max[3], endpoint_min[3];
+	for (int c = 0; c < 3; ++c)
+	{
+		endpoint_max[c] = std::clamp(mean[c] + axis[c] * max_projection / axis_length_squared, 0.f, 255.f);
+		endpoint_min[c] = std::clamp(mean[c] + axis[c] * min_projection / axis_length_squared, 0.f, 255.f);
+	}
+
+	std::uint16_t color0 = packRGB565(endpoint_max);
+	std::uint16_t color1 = packRGB565(endpoint_min);
+	// color0 > color1 selects the four color mode
+	if (color0 < color1) std::swap(color0, color1);
+
+	std::uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			int best_index = 0;
+			int best_distance = 1 << 30;
+			for (int p = 0; p < 4; ++p)
+			{
+				int dr = rgba[i * 4] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best_index = p;
+				}
+			}
+			indices |= static_cast<std::uint32_t>(best_index) << (2 * i);
+		}
+	}
+
+	block[0] = color0 & 0xFF;	block[1] = color0 >> 8;
+	block[2] = color1 & 0xFF;	block[3] = color1 >> 8;
+	for (int i = 0; i < 4; ++i) block[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+void TextureCompressor::encodeBC4(const unsigned char * values, size_t stride, unsigned char * block)
+{
+	int max_value = 0, min_value = 255;
+	for (int i = 0; i < 16; ++i)
+	{
+		max_value = std::max(max_value, static_cast<int>(values[i * stride]));
+		min_value = std::min(min_value, static_cast<int>(values[i * stride]));
+	}
+
+	std::uint64_t indices = 0;
+	if (max_value != min_value)
+	{
+		// eight value mode (value0 > value1): index 0 is value0, index 1 is value1 and 2..7 interpolate between them
+		for (int i = 0; i < 16; ++i)
+		{
+			float t = static_cast<float>(values[i * stride] - min_value) / static_cast<float>(max_value - min_value);
+			int step = static_cast<int>(t * 7.f + 0.5f);
+			std::uint64_t index = (step == 7) ? 0 : (step == 0) ? 1 : static_cast<std::uint64_t>(8 - step);
+			indices |= index << (3 * i);
+		}
+	}
+
+	block[0] = static_cast<unsigned char>(max_value);
+	block[1] = static_cast<unsigned char>(min_value);
+	for (int i = 0; i < 6; ++i) block[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+ImageData TextureCompressor::compress(const ImageData & image)
+{
+	const TextureFormat & source_format = image.getFormat();
+	if (image.isEmpty() || !isSupported(source_format)) return image;
+
+	const GLuint channels = source_format.channels;
+	bool has_alpha = false;
+	if (channels == 4)
+	{
+		const unsigned char * base = image.getLevelData(0);
+		const ImageLevel & level = image.getLevel(0);
+		for (size_t i = 3; i < level.size; i += 4)
+		{
+			if (base[i] != 255)
+			{
+				has_alpha = true;
+				break;
+			}
+		}
+	}
+
+	TextureFormat format = source_format;
+	switch (channels)
+	{
+	case 1:
+		format.internal_format = GL_COMPRESSED_RED_RGTC1;
+		format.block_size = 8;
+		break;
+	case 2:
+		format.internal_format = GL_COMPRESSED_RG_RGTC2;
+		format.block_size = 16;
+		break;
+	default:
+		if (has_alpha) {
+			format.internal_format = format.is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			format.block_size = 16;
+		} else {
+			format.internal_format = format.is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			format.block_size = 8;
+		}
+		break;
+	}
+
+	ImageData compressed(image.getWidth(), image.getHeight(), format, image.getLevelCount());
+	unsigned char texels[16 * 4];
+	for (GLuint l = 0; l < image.getLevelCount(); ++l)
+	{
+		const ImageLevel & level = image.getLevel(l);
+		const unsigned char * source = image.getLevelData(l);
+		unsigned char * target = compressed.getLevelData(l);
+		const GLsizei blocks_x = (level.width + 3) / 4;
+		const GLsizei blocks_y = (level.height + 3) / 4;
+		for (GLsizei by = 0; by < blocks_y; ++by)
+		{
+			for (GLsizei bx = 0; bx < blocks_x; ++bx)
+			{
+				fetchBlock(source, level.width, level.height, channels, bx, by, texels);
+				unsigned char * block = target + (static_cast<size_t>(by) * blocks_x + bx) * format.block_size;
+				switch (channels)
+				{
+				case 1:
+					encodeBC4(texels, 1, block);
+					break;
+				case 2:
+					encodeBC4(texels, 2, block);
+					encodeBC4(texels + 1, 2, block + 8);
+					break;
+				default:
+					if (has_alpha) {
+						encodeBC4(texels + 3, 4, block);
+						encodeBC1(texels, block + 8);
+					} else {
+						encodeBC1(texels, block);
+					}
+					break;
+				}
+			}
+		}
+	}
+	return compressed;
+}
@@ -1,61 +1,229 @@
 #include <GLRF/TextureManager.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <GLRF/Hash.hpp>
+
+static const std::string INDEX_HEADER = "GLRF_ASSET_INDEX 1";
+
+TextureManager::TextureManager() {
+    this->next_texture_id = 0;
+}
+
+TextureManager::~TextureManager() {
+
+}
+
 void TextureManager::registerSource(fs::path path) {
-    if (fs::exists(path)) {
-        this->registered_paths.insert(path);
+    if (!fs::exists(path)) {
+        std::cout << "The specified path '" << path.generic_string() << "' does not exist." << std::endl;
+        return;
+    }
+    for (const AssetSource & source : this->sources) {
+        std::error_code error;
+        if (fs::equivalent(source.root, path, error)) return;
+    }
+
+    AssetSource source;
+    source.root = path;
+    if (loadIndex(source)) {
+        // only directories that changed since the index was written are scanned again
+        if (refreshSource(source)) saveIndex(source);
     }
     else {
-        std::cout << "The specified path '" << path.generic_string() << "' does not exist." << std::endl;
+        scanDirectory(source, fs::path());
+        saveIndex(source);
     }
+    this->sources.push_back(source);
+    rebuildLookup();
 }
 
 fs::path TextureManager::findTexturePath(std::string filename) {
-    fs::path file = fs::path(filename);
-    // use cached path if possible to reduce search time
     auto it = this->cached_paths.find(filename);
     if (it != this->cached_paths.end()) {
         return it->second;
     }
-    else {
-        // path was not cached
-        // search registered paths
-        fs::path target;
-        for (fs::path path : this->registered_paths)
-        {
-            fs::directory_entry dir(path);
-            if (!dir.exists()) {
-                // remove directories that no longer exist
-                this->registered_paths.erase(path);
-                continue;
-            }
-            // registered path may be target
-            if (findPathLocally(dir, filename, &target)) {
-                break;
-            }
-            bool is_found = false;
-            for (auto& subdir : fs::directory_iterator(path))
-            {
-                // registered path may contain target
-                if (findPathLocally(subdir, filename, &target)) {
-                    is_found = true;
-                    break;
-                }
-            }
-            if (is_found) {
-                break;
+
+    // the name may have been added since the last scan, but do not stat all directories on every miss
+    auto now = std::chrono::steady_clock::now();
+    if (now - this->last_refresh > std::chrono::seconds(1)) {
+        refresh();
+        it = this->cached_paths.find(filename);
+        if (it != this->cached_paths.end()) {
+            return it->second;
+        }
+    }
+    return fs::path();
+}
+
+void TextureManager::refresh() {
+    this->last_refresh = std::chrono::steady_clock::now();
+    bool is_changed = false;
+    for (auto it = this->sources.begin(); it != this->sources.end();) {
+        std::error_code error;
+        if (!fs::is_directory(it->root, error)) {
+            // remove sources that no longer exist
+            it = this->sources.erase(it);
+            is_changed = true;
+            continue;
+        }
+        if (refreshSource(*it)) {
+            saveIndex(*it);
+            is_changed = true;
+        }
+        ++it;
+    }
+    if (is_changed) rebuildLookup();
+}
+
+void TextureManager::setIndexDirectory(fs::path path) {
+    this->index_directory = path;
+}
+
+void TextureManager::scanDirectory(AssetSource & source, const fs::path & relative_dir) {
+    fs::path dir = relative_dir.empty() ? source.root : source.root / relative_dir;
+    std::error_code error;
+    source.directories[relative_dir] = fs::last_write_time(dir, error).time_since_epoch().count();
+
+    std::vector<std::string> names;
+    std::vector<fs::path> subdirs;
+    for (auto & entry : fs::directory_iterator(dir, error)) {
+        std::string name = entry.path().filename().generic_string();
+        names.push_back(name);
+        if (entry.is_directory(error)) {
+            subdirs.push_back(relative_dir / name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    source.entries[relative_dir] = names;
+
+    // known subdirectories are validated through their own modification time
+    for (const fs::path & subdir : subdirs) {
+        if (source.directories.find(subdir) == source.directories.end()) {
+            scanDirectory(source, subdir);
+        }
+    }
+}
+
+bool TextureManager::refreshSource(AssetSource & source) {
+    std::vector<fs::path> removed, modified;
+    for (auto & pair : source.directories) {
+        fs::path dir = pair.first.empty() ? source.root : source.root / pair.first;
+        std::error_code error;
+        if (!fs::is_directory(dir, error)) {
+            removed.push_back(pair.first);
+        }
+        else if (fs::last_write_time(dir, error).time_since_epoch().count() != pair.second) {
+            modified.push_back(pair.first);
+        }
+    }
+    for (const fs::path & dir : removed) {
+        source.directories.erase(dir);
+        source.entries.erase(dir);
+    }
+    for (const fs::path & dir : modified) {
+        if (source.directories.find(dir) != source.directories.end()) scanDirectory(source, dir);
+    }
+    return !removed.empty() || !modified.empty();
+}
+
+void TextureManager::rebuildLookup() {
+    this->cached_paths.clear();
+    for (const AssetSource & source : this->sources) {
+        // a registered path may be the target itself
+        fs::path root = source.root.lexically_normal();
+        if (!root.has_filename()) root = root.parent_path();
+        this->cached_paths.emplace(root.filename().generic_string(), source.root);
+
+        // entries are ordered, so the first match of earlier sources and directories wins
+        for (auto & pair : source.entries) {
+            fs::path dir = pair.first.empty() ? source.root : source.root / pair.first;
+            for (const std::string & name : pair.second) {
+                this->cached_paths.emplace(name, dir / name);
             }
         }
-        return target;
     }
 }
 
-bool TextureManager::findPathLocally(fs::directory_entry dir, std::string filename, fs::path * target) {
-    fs::path path = dir.path();
-    if (dir.is_directory() && path.filename().generic_string() == filename) {
-        // registered path is target
-        this->cached_paths.insert(std::pair<std::string, fs::path>(filename, path));
-        *target = path;
-        return true;
+fs::path TextureManager::getIndexFile(const AssetSource & source) {
+    std::error_code error;
+    std::string root = fs::absolute(source.root, error).lexically_normal().generic_string();
+    return this->index_directory / ("index_" + GLRF::toHexString(GLRF::fnv1a64(root)) + ".txt");
+}
+
+bool TextureManager::loadIndex(AssetSource & source) {
+    std::ifstream file(getIndexFile(source));
+    if (!file.is_open()) return false;
+
+    std::error_code error;
+    std::string root = fs::absolute(source.root, error).lexically_normal().generic_string();
+    std::string line;
+    if (!std::getline(file, line) || line != INDEX_HEADER) return false;
+    if (!std::getline(file, line) || line != "root " + root) return false;
+
+    std::vector<std::string> * names = nullptr;
+    while (std::getline(file, line)) {
+        if (line.size() < 2) continue;
+        if (line[0] == 'd') {
+            // d <mtime> <relative directory>
+            std::istringstream stream(line.substr(2));
+            long long mtime;
+            stream >> mtime;
+            std::string relative;
+            std::getline(stream >> std::ws, relative);
+            fs::path dir = (relative == ".") ? fs::path() : fs::path(relative);
+            source.directories[dir] = mtime;
+            names = &source.entries[dir];
+        }
+        else if (line[0] == 'e' && names) {
+            // e <name>
+            names->push_back(line.substr(2));
+        }
+    }
+    return !source.directories.empty();
+}
+
+void TextureManager::saveIndex(const AssetSource & source) {
+    std::error_code error;
+    fs::create_directories(this->index_directory, error);
+    std::ofstream file(getIndexFile(source), std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "Could not write asset index to '" << this->index_directory.generic_string() << "'." << std::endl;
+        return;
+    }
+
+    file << INDEX_HEADER << "\n";
+    file << "root " << fs::absolute(source.root, error).lexically_normal().generic_string() << "\n";
+    for (auto & pair : source.directories) {
+        file << "d " << pair.second << " " << (pair.first.empty() ? std::string(".") : pair.first.generic_string()) << "\n";
+        auto it = source.entries.find(pair.first);
+        if (it == source.entries.end()) continue;
+        for (const std::string & name : it->second) {
+            file << "e " << name << "\n";
+        }
+    }
+}
+
+bool TextureManager::registerArchive(fs::path path) {
+    for (auto & archive : this->archives) {
+        std::error_code error;
+        if (fs::equivalent(archive->getPath(), path, error)) return true;
+    }
+    try {
+        this->archives.push_back(std::make_shared<GLRF::AssetArchive>(path));
+    }
+    catch (const std::runtime_error & e) {
+        std::cout << e.what() << std::endl;
+        return false;
     }
-    return false;
-}
\ No newline at end of file
+    return true;
+}
+
+std::shared_ptr<GLRF::AssetArchive> TextureManager::findArchive(const std::string & name) {
+    for (auto & archive : this->archives) {
+        if (archive->findEntry(name)) return archive;
+    }
+    return nullptr;
+}
@@ -0,0 +1,285 @@
+#include <GLRF/TextureStreamer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <GLRF/Material.hpp>
+#include <GLRF/Texture.hpp>
+#include <GLRF/TextureManager.hpp>
+#include <GLRF/ThreadPool.hpp>
+
+using namespace GLRF;
+
+TextureStreamer::TextureStreamer()
+{
+
+}
+
+TextureStreamer::~TextureStreamer()
+{
+
+}
+
+void TextureStreamer::registerTexture(Texture * texture)
+{
+	StreamingState state;
+	state.requested_level = texture->getResidentLevel();
+	state.last_request_frame = this->frame;
+	this->textures.insert_or_assign(texture, std::move(state));
+}
+
+void TextureStreamer::unregisterTexture(Texture * texture)
+{
+	// a pending job only holds the decoded image, so it can finish without the texture
+	this->textures.erase(texture);
+}
+
+void TextureStreamer::loadAsync(Texture * texture, std::future<ImageData> image)
+{
+	this->loads.insert_or_assign(texture, std::move(image));
+}
+
+void TextureStreamer::cancelLoad(Texture * texture)
+{
+	// the job keeps running, but its result is dropped with the future
+	this->loads.erase(texture);
+}
+
+bool TextureStreamer::isLoading(Texture * texture)
+{
+	return this->loads.find(texture) != this->loads.end();
+}
+
+void TextureStreamer::setMemoryBudget(size_t bytes)
+{
+	this->memory_budget = bytes;
+}
+
+size_t TextureStreamer::getMemoryBudget()
+{
+	return this->memory_budget;
+}
+
+size_t TextureStreamer::getAllocatedMemory()
+{
+	size_t size = 0;
+	for (auto & pair : this->textures)
+	{
+		size += pair.first->getAllocatedSize();
+	}
+	return size;
+}
+
+void TextureStreamer::setUploadBudget(size_t bytes)
+{
+	this->upload_budget = bytes;
+}
+
+void TextureStreamer::setTailSize(GLsizei size)
+{
+	this->tail_size = std::max(size, 1);
+}
+
+void TextureStreamer::setViewportHeight(float height)
+{
+	this->viewport_height = height;
+}
+
+void TextureStreamer::setFieldOfView(float fov_y)
+{
+	this->fov_y = fov_y;
+}
+
+GLuint TextureStreamer::calculateTailLevel(GLsizei width, GLsizei height)
+{
+	GLuint level = 0;
+	GLsizei size = std::max(width, height);
+	while (size > this->tail_size)
+	{
+		size /= 2;
+		++level;
+	}
+	return level;
+}
+
+float TextureStreamer::calculateRequiredLevel(Texture * texture, float distance, float uv_density)
+{
+	distance = std::max(distance, 0.001f);
+	const float texels_per_world_unit = static_cast<float>(std::max(texture->getWidth(), texture->getHeight())) * uv_density;
+	const float pixels_per_world_unit = this->viewport_height / (2.f * distance * std::tan(0.5f * this->fov_y));
+	return std::log2(std::max(texels_per_world_unit / pixels_per_world_unit, 1.f));
+}
+
+void TextureStreamer::requestLevel(Texture * texture, float level)
+{
+	auto it = this->textures.find(texture);
+	if (it == this->textures.end()) return;
+
+	const GLuint tail_level = calculateTailLevel(texture->getWidth(), texture->getHeight());
+	const GLuint requested_level = std::min(static_cast<GLuint>(std::max(std::floor(level), 0.f)), tail_level);
+	StreamingState & state = it->second;
+	if (state.last_request_frame != this->frame) {
+		state.requested_level = requested_level;
+		state.last_request_frame = this->frame;
+	} else {
+		state.requested_level = std::min(state.requested_level, requested_level);
+	}
+}
+
+void TextureStreamer::requestMaterial(std::shared_ptr<Material> material, float distance, float uv_density)
+{
+	if (!material || uv_density <= 0.f) return;
+
+	auto request = [this, distance, uv_density](auto & property) {
+		if (!property.texture.has_value()) return;
+		Texture * texture = property.texture.value().get();
+		if (!texture->getConfiguration().streamed) return;
+		requestLevel(texture, calculateRequiredLevel(texture, distance, uv_density));
+	};
+	request(material->albedo);
+	request(material->normal);
+	request(material->roughness);
+	request(material->metallic);
+	request(material->ao);
+	request(material->height);
+	request(material->opacity);
+}
+
+void TextureStreamer::update()
+{
+	// textures that were not requested last frame fall back to their mip tail
+	for (auto & pair : this->textures)
+	{
+		if (pair.second.last_request_frame != this->frame) {
+			pair.second.requested_level = calculateTailLevel(pair.first->getWidth(), pair.first->getHeight());
+		}
+	}
+
+	finishLoads();
+	uploadPendingLevels();
+	evict();
+	scheduleLoads();
+	++this->frame;
+}
+
+void TextureStreamer::finishLoads()
+{
+	size_t uploaded = 0;
+	for (auto it = this->loads.begin(); it != this->loads.end() && uploaded < this->upload_budget;)
+	{
+		if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+		Texture * texture = it->first;
+		ImageData image = it->second.get();
+		it = this->loads.erase(it);
+		// streamed textures register themselves here, so this must not run while iterating over them
+		texture->finishLoad(image);
+		uploaded += image.getStorageSize();
+	}
+}
+
+void TextureStreamer::uploadPendingLevels()
+{
+	size_t uploaded = 0;
+	bool uploaded_any = false;
+	for (auto & pair : this->textures)
+	{
+		Texture * texture = pair.first;
+		StreamingState & state = pair.second;
+
+		if (state.pending.has_value()
+			&& state.pending.value().wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			ImageData chain = state.pending.value().get();
+			state.pending.reset();
+			if (!chain.isEmpty() && chain.getFormat() == texture->getFormat()) state.chain = chain;
+		}
+		if (!state.chain.has_value()) continue;
+
+		// the storage is only grown once the data is available, so waiting loads do not occupy memory
+		if (state.requested_level < texture->getStorageLevel()) {
+			texture->reallocateStorage(state.requested_level);
+		}
+		while (texture->getResidentLevel() > texture->getStorageLevel()
+			&& (!uploaded_any || uploaded < this->upload_budget))
+		{
+			GLuint level = texture->getResidentLevel() - 1;
+			texture->uploadLevel(level, state.chain.value());
+			uploaded += texture->getLevelSize(level);
+			uploaded_any = true;
+		}
+		if (texture->getResidentLevel() == texture->getStorageLevel()) {
+			state.chain.reset();
+		}
+	}
+}
+
+void TextureStreamer::scheduleLoads()
+{
+	size_t allocated = getAllocatedMemory();
+	for (auto & pair : this->textures)
+	{
+		Texture * texture = pair.first;
+		StreamingState & state = pair.second;
+		if (state.pending.has_value() || state.chain.has_value()) continue;
+		if (state.requested_level >= texture->getResidentLevel()) continue;
+
+		// only stream in as many levels as the budget allows
+		GLuint target_level = texture->getStorageLevel();
+		size_t additional = 0;
+		while (target_level > state.requested_level
+			&& allocated + additional + texture->getLevelSize(target_level - 1) <= this->memory_budget)
+		{
+			--target_level;
+			additional += texture->getLevelSize(target_level);
+		}
+		if (target_level >= texture->getResidentLevel()) continue;
+		state.requested_level = target_level;
+		allocated += additional;
+
+		std::string path = texture->getPath();
+		std::string name = texture->getRelativePath();
+		TextureConfiguration config = texture->getConfiguration();
+		std::shared_ptr<AssetArchive> archive = TextureManager::getInstance().findArchive(name);
+		state.pending = ThreadPool::getInstance().submit([path, name, archive, config]() {
+			return Texture::readImage(path, name, archive, config);
+		});
+	}
+}
+
+void TextureStreamer::evict()
+{
+	size_t allocated = getAllocatedMemory();
+	while (allocated > this->memory_budget)
+	{
+		// prefer textures that hold finer levels than requested, then those that were requested least recently
+		Texture * victim = nullptr;
+		GLuint victim_excess = 0;
+		unsigned long long victim_frame = std::numeric_limits<unsigned long long>::max();
+		for (auto & pair : this->textures)
+		{
+			Texture * texture = pair.first;
+			const StreamingState & state = pair.second;
+			if (texture->getStorageLevel() >= calculateTailLevel(texture->getWidth(), texture->getHeight())) continue;
+
+			GLuint excess = state.requested_level > texture->getStorageLevel() ? state.requested_level - texture->getStorageLevel() : 0;
+			if (excess > victim_excess || (excess == victim_excess && state.last_request_frame < victim_frame))
+			{
+				victim = texture;
+				victim_excess = excess;
+				victim_frame = state.last_request_frame;
+			}
+		}
+		if (!victim) break;
+
+		const GLuint evicted_level = victim->getStorageLevel();
+		allocated -= victim->getLevelSize(evicted_level);
+		victim->reallocateStorage(evicted_level + 1);
+		StreamingState & state = this->textures.at(victim);
+		state.requested_level = std::max(state.requested_level, evicted_level + 1);
+	}
+}
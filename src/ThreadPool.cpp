@@ -0,0 +1,100 @@
+#include <GLRF/ThreadPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+using namespace GLRF;
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+{
+	if (num_threads == 0)
+	{
+		unsigned int hardware_threads = std::thread::hardware_concurrency();
+		num_threads = std::max(hardware_threads, 2u) - 1;
+	}
+	this->workers.reserve(num_threads);
+	for (unsigned int i = 0; i < num_threads; ++i)
+	{
+		this->workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->condition.notify_all();
+	for (auto & worker : this->workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->condition.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+			if (this->stopping && this->jobs.empty()) return;
+			job = std::move(this->jobs.front());
+			this->jobs.pop();
+		}
+		job();
+	}
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t)> & function)
+{
+	if (begin >= end) return;
+
+	// indices are handed out one by one, so uneven workloads are balanced automatically
+	auto next = std::make_shared<std::atomic<size_t>>(begin);
+	auto run = [next, end, &function]() {
+		for (size_t i = (*next)++; i < end; i = (*next)++)
+		{
+			function(i);
+		}
+	};
+
+	size_t num_helpers = std::min(static_cast<size_t>(this->workers.size()), end - begin - 1);
+	std::vector<std::future<void>> helpers;
+	helpers.reserve(num_helpers);
+	for (size_t i = 0; i < num_helpers; ++i)
+	{
+		helpers.push_back(submit(run));
+	}
+	run();
+	for (auto & helper : helpers)
+	{
+		// help out while waiting, so nested calls from worker threads can not starve the pool
+		while (helper.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!runPendingJob()) helper.wait_for(std::chrono::microseconds(100));
+		}
+		helper.get();
+	}
+}
+
+bool ThreadPool::runPendingJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->jobs.empty()) return false;
+		job = std::move(this->jobs.front());
+		this->jobs.pop();
+	}
+	job();
+	return true;
+}
+
+unsigned int ThreadPool::getThreadCount()
+{
+	return static_cast<unsigned int>(this->workers.size());
+}
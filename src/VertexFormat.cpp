@@ -24,4 +24,17 @@ void VertexFormat::registerFormat()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), (void*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(3);
 	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), (void*)(8 * sizeof(GLfloat)));
+}
+
+void VertexFormat::registerFormat(GLuint vertex_array, GLuint vertex_buffer)
+{
+	glVertexArrayVertexBuffer(vertex_array, 0, vertex_buffer, 0, sizeof(VertexFormat));
+	const GLint sizes[] = { 3, 3, 2, 3 };
+	const GLuint offsets[] = { 0, 3 * sizeof(GLfloat), 6 * sizeof(GLfloat), 8 * sizeof(GLfloat) };
+	for (GLuint i = 0; i < 4; ++i)
+	{
+		glEnableVertexArrayAttrib(vertex_array, i);
+		glVertexArrayAttribFormat(vertex_array, i, sizes[i], GL_FLOAT, GL_FALSE, offsets[i]);
+		glVertexArrayAttribBinding(vertex_array, i, 0);
+	}
 }
\ No newline at end of file
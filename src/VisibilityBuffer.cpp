@@ -0,0 +1,362 @@
+#include <GLRF/VisibilityBuffer.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <GLRF/FrameUniforms.hpp>
+#include <GLRF/GLResources.hpp>
+#include <GLRF/GLStateCache.hpp>
+#include <GLRF/MaterialTable.hpp>
+
+using namespace GLRF;
+
+namespace {
+	const GLuint VISIBILITY_TEXTURE_UNIT = 0;
+
+	static_assert(sizeof(VertexFormat) == 11 * sizeof(GLfloat), "the vertices are pulled as 11 floats");
+
+	const char * VISIBILITY_VERTEX_SOURCE = R"(
+layout(location = 0) in vec3 position;
+uniform mat4 model;
+uniform mat4 projection;
+
+void main() {
+	gl_Position = projection * view * model * vec4(position, 1.0);
+}
+)";
+
+	const char * VISIBILITY_FRAGMENT_SOURCE = R"(
+uniform uint instance;
+layout(location = 0) out uint visibility;
+
+void main() {
+	visibility = (instance << TRIANGLE_BITS) | uint(gl_PrimitiveID);
+}
+)";
+
+	// a single triangle that covers the screen
+	const char * RESOLVE_VERTEX_SOURCE = R"(
+void main() {
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+	const char * RESOLVE_FRAGMENT_SOURCE = R"(
+struct Instance {
+	mat4 model;
+	mat4 normal_matrix;
+	uint first_index;
+	uint base_vertex;
+	uint material_index;
+	uint padding;
+};
+
+layout(binding = VISIBILITY_TEXTURE_UNIT) uniform usampler2D visibility;
+layout(std430, binding = VERTEX_STORAGE_BINDING) readonly buffer Vertices { float vertex_data[]; };
+layout(std430, binding = INDEX_STORAGE_BINDING) readonly buffer Indices { uint index_data[]; };
+layout(std430, binding = INSTANCE_STORAGE_BINDING) readonly buffer Instances { Instance instances[]; };
+uniform mat4 projection;
+layout(location = 0) out vec4 color;
+
+vec3 loadVec3(uint vertex, uint offset) {
+	uint i = vertex * 11u + offset;
+	return vec3(vertex_data[i], vertex_data[i + 1u], vertex_data[i + 2u]);
+}
+
+void main() {
+	uint id = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).r;
+	if (id == EMPTY) discard;
+	Instance instance = instances[id >> TRIANGLE_BITS];
+	uint first = instance.first_index + 3u * (id & ((1u << TRIANGLE_BITS) - 1u));
+	uint v[3] = uint[3](instance.base_vertex + index_data[first], instance.base_vertex + index_data[first + 1u],
+		instance.base_vertex + index_data[first + 2u]);
+
+	vec3 world[3];
+	vec2 ndc[3];
+	vec3 inverse_w;
+	for (int i = 0; i < 3; ++i) {
+		world[i] = (instance.model * vec4(loadVec3(v[i], 0u), 1.0)).xyz;
+		vec4 clip = projection * view * vec4(world[i], 1.0);
+		inverse_w[i] = 1.0 / clip.w;
+		ndc[i] = clip.xy * inverse_w[i];
+	}
+
+	// barycentrics in screen space, corrected for the perspective division
+	vec2 pixel = gl_FragCoord.xy / vec2(textureSize(visibility, 0)) * 2.0 - 1.0;
+	vec2 e1 = ndc[1] - ndc[0];
+	vec2 e2 = ndc[2] - ndc[0];
+	vec2 d = pixel - ndc[0];
+	float determinant = e1.x * e2.y - e1.y * e2.x;
+	float b1 = (d.x * e2.y - d.y * e2.x) / determinant;
+	float b2 = (e1.x * d.y - e1.y * d.x) / determinant;
+	vec3 b = vec3(1.0 - b1 - b2, b1, b2) * inverse_w;
+	b /= b.x + b.y + b.z;
+
+	vec3 position = b.x * world[0] + b.y * world[1] + b.z * world[2];
+	vec3 normal = b.x * loadVec3(v[0], 3u) + b.y * loadVec3(v[1], 3u) + b.z * loadVec3(v[2], 3u);
+	vec2 uv = b.x * loadVec3(v[0], 6u).xy + b.y * loadVec3(v[1], 6u).xy + b.z * loadVec3(v[2], 6u).xy;
+	vec3 n = normalize(mat3(instance.normal_matrix) * normal);
+
+	uint material = instance.material_index;
+	vec3 albedo = sampleMaterial(material, 0u, uv).rgb;
+	float roughness = max(sampleMaterial(material, 2u, uv).r, 0.04);
+	float metallic = sampleMaterial(material, 3u, uv).r;
+	float ao = sampleMaterial(material, 4u, uv).r;
+	vec3 view_dir = normalize(camera_position - position);
+
+	vec3 radiance = 0.03 * albedo * ao;
+	for (uint i = 0u; i < min(pointLight_count, uint(MAX_POINT_LIGHTS)); ++i) {
+		vec3 to_light = pointLight_position[i] - position;
+		float distance_squared = max(dot(to_light, to_light), 1e-4);
+		radiance += shade(albedo, roughness, metallic, n, view_dir, to_light * inversesqrt(distance_squared),
+			pointLight_color[i] * pointLight_power[i] / distance_squared);
+	}
+	if (useDirectionalLight) {
+		radiance += shade(albedo, roughness, metallic, n, view_dir, normalize(-directionalLight_direction), vec3(directionalLight_power));
+	}
+	color = vec4(radiance, 1.0);
+}
+)";
+
+	GLuint compileStage(GLenum type, const std::string & source, const std::string & name)
+	{
+		const char * source_pointer = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source_pointer, NULL);
+		glCompileShader(shader);
+
+		int success;
+		char info_log[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 512, NULL, info_log);
+			glDeleteShader(shader);
+			std::cout << "ERROR::SHADER::" << name << "::COMPILATION_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("visibility buffer shader could not be compiled");
+		}
+		return shader;
+	}
+
+	GLuint createProgram(const std::string & vertex_source, const std::string & fragment_source, const std::string & name)
+	{
+		GLuint vertex_shader = compileStage(GL_VERTEX_SHADER, vertex_source, name);
+		GLuint fragment_shader = compileStage(GL_FRAGMENT_SHADER, fragment_source, name);
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertex_shader);
+		glAttachShader(program, fragment_shader);
+		glLinkProgram(program);
+		glDeleteShader(vertex_shader);
+		glDeleteShader(fragment_shader);
+
+		int success;
+		char info_log[512];
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(program, 512, NULL, info_log);
+			glDeleteProgram(program);
+			std::cout << "ERROR::SHADER::" << name << "::LINKING_FAILED\n" << info_log << std::endl;
+			throw std::runtime_error("visibility buffer shader could not be linked");
+		}
+		return program;
+	}
+
+	std::string getDefines()
+	{
+		std::stringstream defines;
+		defines << "#define TRIANGLE_BITS " << VisibilityBuffer::TRIANGLE_BITS << "u\n"
+			<< "#define EMPTY " << VisibilityBuffer::EMPTY << "u\n"
+			<< "#define MAX_POINT_LIGHTS " << FrameUniforms::MAX_POINT_LIGHTS << "\n"
+			<< "#define VISIBILITY_TEXTURE_UNIT " << VISIBILITY_TEXTURE_UNIT << "\n"
+			<< "#define VERTEX_STORAGE_BINDING " << VisibilityBuffer::VERTEX_STORAGE_BINDING << "\n"
+			<< "#define INDEX_STORAGE_BINDING " << VisibilityBuffer::INDEX_STORAGE_BINDING << "\n"
+			<< "#define INSTANCE_STORAGE_BINDING " << VisibilityBuffer::INSTANCE_STORAGE_BINDING << "\n";
+		return defines.str();
+	}
+}
+
+VisibilityBuffer::VisibilityBuffer(ScreenResolution resolution) : resolution(resolution)
+{
+	FrameBufferConfiguration visibility_config;
+	visibility_config.color_formats = { GL_R32UI };
+	this->visibility_target = std::make_unique<FrameBuffer>(visibility_config, resolution);
+	this->visibility_target->setDebugName("visibility buffer");
+	// integer textures are incomplete with linear filtering
+	const GLuint visibility_texture = this->visibility_target->getColorBufferID(0);
+	GLResources::textureParameteri(visibility_texture, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	GLResources::textureParameteri(visibility_texture, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	FrameBufferConfiguration output_config;
+	output_config.color_formats = { GL_RGBA16F };
+	output_config.use_depth_buffer = false;
+	this->output = std::make_unique<FrameBuffer>(output_config, resolution);
+	this->output->setDebugName("visibility buffer output");
+
+	// the material table may start with an #extension directive, so it directly follows the version
+	const std::string header = "#version 430\n";
+	const std::string common = getDefines() + FrameUniformBuffer::getGLSLInterface();
+	this->visibility_program = createProgram(header + common + VISIBILITY_VERTEX_SOURCE,
+		header + common + VISIBILITY_FRAGMENT_SOURCE, "VISIBILITY");
+	this->resolve_program = createProgram(header + RESOLVE_VERTEX_SOURCE,
+		header + MaterialTable::getInstance().getGLSLInterface() + common + FrameUniformBuffer::getGLSLLighting() + RESOLVE_FRAGMENT_SOURCE,
+		"VISIBILITY_RESOLVE");
+	this->visibility_projection_location = glGetUniformLocation(this->visibility_program, "projection");
+	this->visibility_model_location = glGetUniformLocation(this->visibility_program, "model");
+	this->visibility_instance_location = glGetUniformLocation(this->visibility_program, "instance");
+	this->resolve_projection_location = glGetUniformLocation(this->resolve_program, "projection");
+	this->empty_vertex_array = GLResources::createVertexArray();
+}
+
+VisibilityBuffer::~VisibilityBuffer()
+{
+	GLStateCache & state = GLStateCache::getInstance();
+	state.deleteProgram(this->visibility_program);
+	state.deleteProgram(this->resolve_program);
+	state.deleteVertexArrays(1, &(this->empty_vertex_array));
+	for (GLuint * buffer : { &this->vertex_buffer, &this->index_buffer, &this->instance_buffer })
+	{
+		if (*buffer != 0) state.deleteBuffers(1, buffer);
+	}
+}
+
+GLuint VisibilityBuffer::encode(GLuint instance, GLuint triangle)
+{
+	return (instance << TRIANGLE_BITS) | triangle;
+}
+
+GLuint VisibilityBuffer::getInstanceIndex(GLuint id)
+{
+	return id >> TRIANGLE_BITS;
+}
+
+GLuint VisibilityBuffer::getTriangleIndex(GLuint id)
+{
+	return id & (MAX_TRIANGLES - 1);
+}
+
+void VisibilityBuffer::invalidateGeometry()
+{
+	this->geometry.clear();
+	this->vertices.clear();
+	this->indices.clear();
+	this->geometry_dirty = true;
+}
+
+void VisibilityBuffer::updateGeometry(Scene & scene)
+{
+	for (auto & node : scene.getObjects())
+	{
+		SceneObject * object = node->getObject().get();
+		if (this->geometry.count(object) > 0) continue;
+
+		GeometryRange range;
+		range.first_index = static_cast<GLuint>(this->indices.size());
+		range.base_vertex = static_cast<GLuint>(this->vertices.size());
+		if (object->supportsDepthPrePass() && object->appendTriangles(this->vertices, this->indices)) {
+			range.supported = (this->indices.size() - range.first_index) / 3 <= MAX_TRIANGLES;
+			if (!range.supported) {
+				std::cout << "WARNING::VISIBILITY_BUFFER::TOO_MANY_TRIANGLES: " << object->getDebugName() << std::endl;
+				this->vertices.erase(this->vertices.begin() + range.base_vertex, this->vertices.end());
+				this->indices.resize(range.first_index);
+			}
+			this->geometry_dirty = true;
+		}
+		this->geometry.emplace(object, range);
+	}
+	if (!this->geometry_dirty) return;
+
+	if (this->vertex_buffer == 0) this->vertex_buffer = GLResources::createBuffer();
+	if (this->index_buffer == 0) this->index_buffer = GLResources::createBuffer();
+	GLResources::bufferData(this->vertex_buffer, sizeof(VertexFormat) * this->vertices.size(), this->vertices.data(), GL_STATIC_DRAW);
+	GLResources::bufferData(this->index_buffer, sizeof(GLuint) * this->indices.size(), this->indices.data(), GL_STATIC_DRAW);
+	this->geometry_dirty = false;
+}
+
+void VisibilityBuffer::updateInstances(Scene & scene)
+{
+	MaterialTable & material_table = MaterialTable::getInstance();
+	this->instances.clear();
+	this->instance_objects.clear();
+	for (auto & node : scene.getObjects())
+	{
+		SceneObject * object = node->getObject().get();
+		const GeometryRange & range = this->geometry[object];
+		if (!range.supported) continue;
+		std::optional<GLuint> material_index = material_table.getIndex(node->getObject()->getMaterial());
+		if (!material_index.has_value()) continue;
+		if (this->instances.size() == MAX_INSTANCES) {
+			std::cout << "WARNING::VISIBILITY_BUFFER::TOO_MANY_INSTANCES" << std::endl;
+			break;
+		}
+
+		InstanceEntry entry;
+		entry.model = node->calculateModelMatrix();
+		entry.normal_matrix = glm::mat4(glm::mat3(glm::transpose(glm::inverse(entry.model))));
+		entry.first_index = range.first_index;
+		entry.base_vertex = range.base_vertex;
+		entry.material_index = material_index.value();
+		entry.padding = 0;
+		this->instances.push_back(entry);
+		this->instance_objects.push_back(object);
+	}
+	// new materials were added to the table
+	material_table.update();
+
+	if (this->instance_buffer == 0) this->instance_buffer = GLResources::createBuffer();
+	GLResources::bufferData(this->instance_buffer, sizeof(InstanceEntry) * this->instances.size(), this->instances.data(), GL_STREAM_DRAW);
+}
+
+void VisibilityBuffer::draw(Scene & scene, const glm::mat4 & projection)
+{
+	updateGeometry(scene);
+	updateInstances(scene);
+
+	GLStateCache & state = GLStateCache::getInstance();
+	this->visibility_target->use();
+	state.setViewport(0, 0, this->resolution.width, this->resolution.height);
+	state.setDepthMask(true);
+	state.setColorMask(true);
+	state.setCapability(GL_DEPTH_TEST, true);
+	state.setDepthFunc(GL_LESS);
+	const GLuint empty = EMPTY;
+	const GLfloat far_depth = 1.f;
+	glClearBufferuiv(GL_COLOR, 0, &empty);
+	glClearBufferfv(GL_DEPTH, 0, &far_depth);
+
+	state.useProgram(this->visibility_program);
+	glUniformMatrix4fv(this->visibility_projection_location, 1, GL_FALSE, glm::value_ptr(projection));
+	for (GLuint i = 0; i < this->instances.size(); ++i)
+	{
+		glUniformMatrix4fv(this->visibility_model_location, 1, GL_FALSE, glm::value_ptr(this->instances[i].model));
+		glUniform1ui(this->visibility_instance_location, i);
+		this->instance_objects[i]->drawGeometry();
+	}
+
+	// every pixel is shaded once, with the triangle that is visible in it
+	this->output->use();
+	state.setCapability(GL_DEPTH_TEST, false);
+	state.useProgram(this->resolve_program);
+	glUniformMatrix4fv(this->resolve_projection_location, 1, GL_FALSE, glm::value_ptr(projection));
+	state.bindTexture(VISIBILITY_TEXTURE_UNIT, GL_TEXTURE_2D, this->visibility_target->getColorBufferID(0));
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTEX_STORAGE_BINDING, this->vertex_buffer);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDEX_STORAGE_BINDING, this->index_buffer);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_STORAGE_BINDING, this->instance_buffer);
+	state.bindVertexArray(this->empty_vertex_array);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	state.setCapability(GL_DEPTH_TEST, true);
+}
+
+FrameBuffer & VisibilityBuffer::getVisibilityTarget()
+{
+	return *this->visibility_target;
+}
+
+FrameBuffer & VisibilityBuffer::getOutput()
+{
+	return *this->output;
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <cstring>
+
+#include <GLRF/AssetArchive.hpp>
+#include <GLRF/TextureCompressor.hpp>
+
+using namespace GLRF;
+
+class AssetArchiveTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / "glrf_asset_archive_test";
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+};
+
+TEST_F(AssetArchiveTest, RoundTripsTexturesAndMeshes) {
+    TextureFormat format;
+    format.is_srgb = true;
+    ImageData image(8, 4, format, 2);
+    for (size_t i = 0; i < image.getStorageSize(); ++i) image.getLevelData(0)[i] = static_cast<unsigned char>(i);
+    ImageData compressed = TextureCompressor().compress(image);
+    ASSERT_TRUE(compressed.getFormat().isCompressed());
+
+    MeshData<VertexFormat> mesh;
+    for (int i = 0; i < 3; ++i) mesh.vertices.push_back(VertexFormat(glm::vec3(i, 0, 0), glm::vec3(0, 0, 1), glm::vec2(i, 1), glm::vec3(1, 0, 0)));
+    mesh.indices = std::vector<GLuint>{ 0, 1, 2 };
+
+    AssetArchiveWriter writer;
+    writer.addTexture("stone/albedo.png", compressed, 42);
+    writer.addMesh("meshes/triangle.obj", mesh, 7);
+    ASSERT_TRUE(writer.write(root / "level.pak"));
+
+    AssetArchive archive(root / "level.pak");
+    ASSERT_EQ(archive.getEntries().size(), 2u);
+    ASSERT_EQ(archive.findEntry("stone/../stone/albedo.png")->content_hash, 42u);
+    ASSERT_TRUE(archive.loadImage("stone/missing.png", true).isEmpty());
+    ImageData linear = archive.loadImage("stone/albedo.png", false);
+    ASSERT_FALSE(linear.getFormat().is_srgb);
+    ASSERT_EQ(linear.getFormat().internal_format, static_cast<GLenum>(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT));
+
+    ImageData loaded = archive.loadImage("stone/albedo.png", true);
+    ASSERT_EQ(loaded.getFormat(), compressed.getFormat());
+    ASSERT_EQ(loaded.getLevelCount(), compressed.getLevelCount());
+    for (GLuint l = 0; l < loaded.getLevelCount(); ++l) {
+        ASSERT_EQ(loaded.getLevel(l).size, compressed.getLevel(l).size);
+        ASSERT_EQ(std::memcmp(loaded.getLevelData(l), compressed.getLevelData(l), loaded.getLevel(l).size), 0);
+    }
+
+    auto loaded_mesh = archive.loadMesh("meshes/triangle.obj");
+    ASSERT_TRUE(loaded_mesh);
+    ASSERT_EQ(loaded_mesh->vertices.size(), 3u);
+    ASSERT_EQ(loaded_mesh->vertices[2].position.x, 2.f);
+    ASSERT_EQ(loaded_mesh->indices.value(), mesh.indices.value());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,22 @@
+#include <gtest/gtest.h>
+
+#include <GLRF/DynamicResolution.hpp>
+
+using namespace GLRF;
+
+TEST(DynamicResolutionTest, KeepsScaleNearTarget) {
+    ASSERT_FLOAT_EQ(DynamicResolution::computeScale(0.8f, 16.3f, 16.0f, 0.5f), 0.8f);
+    ASSERT_FLOAT_EQ(DynamicResolution::computeScale(0.8f, 0.0f, 16.0f, 0.5f), 0.8f);
+}
+
+TEST(DynamicResolutionTest, ScalesByTheSquareRootOfTheFrameTime) {
+    // a frame that takes 1.21 times the target needs 1 / 1.1 of the width and height
+    ASSERT_NEAR(DynamicResolution::computeScale(1.0f, 16.0f * 1.21f, 16.0f, 0.5f), 1.0f / 1.1f, 1e-5f);
+    ASSERT_NEAR(DynamicResolution::computeScale(0.8f, 16.0f / 1.21f, 16.0f, 0.5f), 0.88f, 1e-5f);
+}
+
+TEST(DynamicResolutionTest, LimitsStepsAndRange) {
+    ASSERT_FLOAT_EQ(DynamicResolution::computeScale(1.0f, 64.0f, 16.0f, 0.5f), 0.9f);
+    ASSERT_FLOAT_EQ(DynamicResolution::computeScale(0.52f, 64.0f, 16.0f, 0.5f), 0.5f);
+    ASSERT_FLOAT_EQ(DynamicResolution::computeScale(0.95f, 4.0f, 16.0f, 0.5f), 1.0f);
+}
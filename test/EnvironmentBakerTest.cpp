@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include <GLRF/EnvironmentBaker.hpp>
+
+using namespace GLRF;
+
+namespace {
+    CubeMapData createUniformCube(GLsizei size, float value) {
+        CubeMapData cube(size, 1);
+        for (float & texel : cube.texels) texel = value;
+        return cube;
+    }
+}
+
+TEST(EnvironmentBakerTest, ConvertsEquirectangularImages) {
+    // the upper half of the image is red, the lower half is blue
+    const int width = 64, height = 32;
+    std::vector<float> pixels(3 * width * height, 0.f);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) pixels[3 * (y * width + x) + ((y < height / 2) ? 0 : 2)] = 1.f;
+    }
+    CubeMapData cube = EnvironmentBaker().convertEquirectangular(pixels.data(), width, height, 16);
+    ASSERT_EQ(cube.levels, 1u);
+    const GLsizei center = 3 * (8 * 16 + 8);
+    // +Y looks up, -Y looks down
+    ASSERT_NEAR(cube.getFace(0, 2)[center], 1.f, 1e-4f);
+    ASSERT_NEAR(cube.getFace(0, 2)[center + 2], 0.f, 1e-4f);
+    ASSERT_NEAR(cube.getFace(0, 3)[center], 0.f, 1e-4f);
+    ASSERT_NEAR(cube.getFace(0, 3)[center + 2], 1.f, 1e-4f);
+}
+
+TEST(EnvironmentBakerTest, ProjectsUniformIrradiance) {
+    EnvironmentBaker baker;
+    CubeMapData cube = createUniformCube(32, 2.f);
+    baker.generateMips(cube);
+    ASSERT_EQ(cube.levels, 6u);
+    EnvironmentBaker::IrradianceSH sh = baker.projectIrradiance(cube);
+    // a constant radiance L results in the irradiance pi * L from every direction
+    const float directions[3][3] = { { 1.f, 0.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.577350f, 0.577350f, 0.577350f } };
+    for (const float * direction : directions) {
+        float rgb[3];
+        EnvironmentBaker::evaluateIrradiance(sh, direction, rgb);
+        for (float value : rgb) ASSERT_NEAR(value, 2.f, 1e-3f);
+    }
+}
+
+TEST(EnvironmentBakerTest, ProjectsDirectionalIrradiance) {
+    EnvironmentBaker baker;
+    CubeMapData cube = createUniformCube(32, 0.f);
+    // only the +Y face emits light
+    for (GLsizei i = 0; i < 32 * 32 * 3; ++i) cube.getFace(0, 2)[i] = 1.f;
+    baker.generateMips(cube);
+    EnvironmentBaker::IrradianceSH sh = baker.projectIrradiance(cube);
+    const float up[3] = { 0.f, 1.f, 0.f }, down[3] = { 0.f, -1.f, 0.f };
+    float rgb_up[3], rgb_down[3];
+    EnvironmentBaker::evaluateIrradiance(sh, up, rgb_up);
+    EnvironmentBaker::evaluateIrradiance(sh, down, rgb_down);
+    ASSERT_GT(rgb_up[0], 0.3f);
+    ASSERT_LT(std::abs(rgb_down[0]), 0.1f);
+}
+
+TEST(EnvironmentBakerTest, PrefilteringPreservesUniformEnvironments) {
+    EnvironmentBaker baker(64);
+    CubeMapData cube = createUniformCube(32, 0.5f);
+    baker.generateMips(cube);
+    CubeMapData specular = baker.prefilterSpecular(cube, 16, 5);
+    ASSERT_EQ(specular.levels, 5u);
+    ASSERT_EQ(specular.getLevelSize(4), 1);
+    for (float texel : specular.texels) ASSERT_NEAR(texel, 0.5f, 1e-4f);
+}
+
+TEST(EnvironmentBakerTest, IntegratesEnvironmentBRDF) {
+    const GLsizei size = 16;
+    std::vector<float> lut = EnvironmentBaker(256).integrateBRDF(size);
+    ASSERT_EQ(lut.size(), static_cast<size_t>(2 * size * size));
+    for (float value : lut) {
+        ASSERT_GE(value, 0.f);
+        ASSERT_LE(value, 1.f);
+    }
+    // smooth surfaces seen head-on reflect almost exactly F0
+    const float * smooth = lut.data() + 2 * (size - 1);
+    ASSERT_NEAR(smooth[0] + smooth[1], 1.f, 0.05f);
+    // rough surfaces reflect less than smooth surfaces
+    const float * rough = lut.data() + 2 * ((size - 1) * size + size - 1);
+    ASSERT_LT(rough[0] + rough[1], smooth[0] + smooth[1]);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <GLRF/FrameGraph.hpp>
+
+using namespace GLRF;
+
+// compile() does not call OpenGL, so the graphs are tested without a context
+namespace {
+    FrameGraphTextureDesc createDesc(GLenum internal_format) {
+        FrameGraphTextureDesc desc;
+        desc.width = 64;
+        desc.height = 32;
+        desc.internal_format = internal_format;
+        return desc;
+    }
+
+    void noExecute(const FrameGraphPassContext &) {}
+}
+
+TEST(FrameGraphTest, CullsPassesWithUnusedResults) {
+    FrameGraph graph;
+    FrameGraphResource backbuffer = graph.importBackbuffer("backbuffer", 64, 32);
+    FrameGraphResource color, unused;
+
+    graph.addPass("scene", [&](FrameGraphBuilder & builder) {
+        color = builder.write(builder.create("color", createDesc(GL_RGBA16F)));
+    }, noExecute);
+    graph.addPass("debug", [&](FrameGraphBuilder & builder) {
+        unused = builder.write(builder.create("debug", createDesc(GL_RGBA8)));
+    }, noExecute);
+    graph.addPass("depends on debug", [&](FrameGraphBuilder & builder) {
+        builder.read(unused);
+        builder.write(builder.create("unread", createDesc(GL_RGBA8)));
+    }, noExecute);
+    graph.addPass("tonemap", [&](FrameGraphBuilder & builder) {
+        builder.read(color);
+        builder.write(backbuffer);
+    }, noExecute);
+    graph.compile();
+
+    ASSERT_FALSE(graph.isCulled("scene"));
+    ASSERT_TRUE(graph.isCulled("debug"));
+    ASSERT_TRUE(graph.isCulled("depends on debug"));
+    ASSERT_FALSE(graph.isCulled("tonemap"));
+    ASSERT_EQ(graph.getPhysicalResourceCount(), 1u);
+}
+
+TEST(FrameGraphTest, AliasesResourcesWithDisjointLifetimes) {
+    FrameGraph graph;
+    FrameGraphResource backbuffer = graph.importBackbuffer("backbuffer", 64, 32);
+    FrameGraphResource a, b, c;
+
+    graph.addPass("a", [&](FrameGraphBuilder & builder) {
+        a = builder.write(builder.create("a", createDesc(GL_RGBA16F)));
+    }, noExecute);
+    graph.addPass("b", [&](FrameGraphBuilder & builder) {
+        builder.read(a);
+        b = builder.write(builder.create("b", createDesc(GL_RGBA16F)));
+    }, noExecute);
+    // a is no longer used, so c can take its texture
+    graph.addPass("c", [&](FrameGraphBuilder & builder) {
+        builder.read(b);
+        c = builder.write(builder.create("c", createDesc(GL_RGBA16F)));
+    }, noExecute);
+    graph.addPass("present", [&](FrameGraphBuilder & builder) {
+        builder.read(c);
+        builder.write(backbuffer);
+    }, noExecute);
+    graph.compile();
+
+    ASSERT_EQ(graph.getTransientResourceCount(), 3u);
+    ASSERT_EQ(graph.getPhysicalResourceCount(), 2u);
+}
+
+TEST(FrameGraphTest, DoesNotAliasDifferentDescriptions) {
+    FrameGraph graph;
+    FrameGraphResource a, b;
+
+    graph.addPass("a", [&](FrameGraphBuilder & builder) {
+        a = builder.write(builder.create("a", createDesc(GL_RGBA16F)));
+    }, noExecute);
+    graph.addPass("b", [&](FrameGraphBuilder & builder) {
+        builder.read(a);
+        b = builder.write(builder.create("b", createDesc(GL_RGBA8)));
+    }, noExecute);
+    graph.addPass("readback", [&](FrameGraphBuilder & builder) {
+        builder.read(b);
+        builder.write(builder.create("c", createDesc(GL_RGBA16F)));
+        builder.setSideEffect();
+    }, noExecute);
+    graph.compile();
+
+    ASSERT_FALSE(graph.isCulled("a"));
+    ASSERT_EQ(graph.getPhysicalResourceCount(), 2u);
+}
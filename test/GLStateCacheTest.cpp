@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <GLRF/GLStateCache.hpp>
+
+using namespace GLRF;
+
+// the cache is tested without a context, the glad entry points are replaced by counters
+namespace {
+    int bind_framebuffer_calls = 0;
+    int active_texture_calls = 0;
+    int bind_texture_calls = 0;
+
+    void APIENTRY countBindFramebuffer(GLenum, GLuint) { ++bind_framebuffer_calls; }
+    void APIENTRY countActiveTexture(GLenum) { ++active_texture_calls; }
+    void APIENTRY countBindTexture(GLenum, GLuint) { ++bind_texture_calls; }
+    void APIENTRY ignoreDeleteTextures(GLsizei, const GLuint *) {}
+
+    class GLStateCacheTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            glad_glBindFramebuffer = &countBindFramebuffer;
+            glad_glActiveTexture = &countActiveTexture;
+            glad_glBindTexture = &countBindTexture;
+            glad_glDeleteTextures = &ignoreDeleteTextures;
+            bind_framebuffer_calls = active_texture_calls = bind_texture_calls = 0;
+            GLStateCache::getInstance().invalidate();
+            GLStateCache::getInstance().resetStats();
+        }
+    };
+}
+
+TEST_F(GLStateCacheTest, FiltersRedundantBindings) {
+    GLStateCache & state = GLStateCache::getInstance();
+    state.bindFramebuffer(3);
+    state.bindFramebuffer(3);
+    state.bindFramebuffer(0);
+    ASSERT_EQ(bind_framebuffer_calls, 2);
+    ASSERT_EQ(state.getStats().issued, 2u);
+    ASSERT_EQ(state.getStats().skipped, 1u);
+
+    state.invalidate();
+    state.bindFramebuffer(0);
+    ASSERT_EQ(bind_framebuffer_calls, 3);
+}
+
+TEST_F(GLStateCacheTest, ActivatesTextureUnitsOnlyForChangedBindings) {
+    GLStateCache & state = GLStateCache::getInstance();
+    state.bindTexture(2, GL_TEXTURE_2D, 7);
+    state.bindTexture(2, GL_TEXTURE_2D, 7);
+    state.bindTexture(2, GL_TEXTURE_CUBE_MAP, 8);
+    ASSERT_EQ(active_texture_calls, 1);
+    ASSERT_EQ(bind_texture_calls, 2);
+
+    // binding on the active unit for an update keeps the binding of unit 2 known
+    state.bindTexture(GL_TEXTURE_2D, 9);
+    state.bindTexture(2, GL_TEXTURE_2D, 9);
+    ASSERT_EQ(active_texture_calls, 1);
+    ASSERT_EQ(bind_texture_calls, 3);
+}
+
+TEST_F(GLStateCacheTest, ForgetsDeletedTextures) {
+    GLStateCache & state = GLStateCache::getInstance();
+    const GLuint texture = 5;
+    state.bindTexture(0, GL_TEXTURE_2D, texture);
+    state.deleteTextures(1, &texture);
+    // the name may have been reused by a new texture
+    state.bindTexture(0, GL_TEXTURE_2D, texture);
+    ASSERT_EQ(bind_texture_calls, 2);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include <GLRF/ImageCache.hpp>
+
+using namespace GLRF;
+
+class ImageCacheTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / "glrf_image_cache_test";
+        fs::remove_all(root);
+        fs::create_directories(root / "sources");
+        ImageCache & cache = ImageCache::getInstance();
+        cache.setDirectory(root / "cache");
+        cache.setMaxSize(static_cast<size_t>(1) << 30);
+        cache.resetStats();
+    }
+
+    void TearDown() override {
+        ImageCache::getInstance().setDirectory(fs::path(".glrf_cache") / "images");
+        fs::remove_all(root);
+    }
+
+    std::string createSource(const std::string & name, const std::string & content) {
+        fs::path path = root / "sources" / name;
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+        return path.generic_string();
+    }
+
+    ImageData createImage(unsigned char value) {
+        ImageData image(16, 16, TextureFormat(), 5);
+        std::memset(image.getLevelData(0), value, image.getStorageSize());
+        return image;
+    }
+};
+
+TEST_F(ImageCacheTest, ReturnsStoredImages) {
+    ImageCache & cache = ImageCache::getInstance();
+    std::string source = createSource("albedo.png", "png");
+    ASSERT_TRUE(cache.load(source, "srgb=0", false).isEmpty());
+
+    cache.store(source, "srgb=0", createImage(7));
+    ImageData loaded = cache.load(source, "srgb=0", false);
+    ASSERT_FALSE(loaded.isEmpty());
+    ASSERT_EQ(loaded.getLevelCount(), 5u);
+    ASSERT_EQ(loaded.getLevelData(4)[0], 7);
+
+    // different load parameters are separate entries
+    ASSERT_TRUE(cache.load(source, "srgb=1", true).isEmpty());
+
+    ImageCacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.stores, 1u);
+    ASSERT_EQ(stats.entry_count, 1u);
+    ASSERT_GT(stats.total_size, loaded.getStorageSize());
+}
+
+TEST_F(ImageCacheTest, IgnoresModifiedSources) {
+    ImageCache & cache = ImageCache::getInstance();
+    std::string source = createSource("albedo.png", "png");
+    cache.store(source, "", createImage(1));
+    fs::last_write_time(source, fs::last_write_time(source) + std::chrono::seconds(10));
+    ASSERT_TRUE(cache.load(source, "", false).isEmpty());
+}
+
+TEST_F(ImageCacheTest, EvictsLeastRecentlyUsedEntries) {
+    ImageCache & cache = ImageCache::getInstance();
+    std::string first = createSource("first.png", "1");
+    std::string second = createSource("second.png", "2");
+    std::string third = createSource("third.png", "3");
+    cache.store(first, "", createImage(1));
+    cache.store(second, "", createImage(2));
+    const size_t entry_size = cache.getStats().total_size / 2;
+
+    // the first entry is used again, so the second one is the least recently used
+    ASSERT_FALSE(cache.load(first, "", false).isEmpty());
+    cache.setMaxSize(2 * entry_size);
+    cache.store(third, "", createImage(3));
+
+    ImageCacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.evictions, 1u);
+    ASSERT_EQ(stats.entry_count, 2u);
+    ASSERT_FALSE(cache.load(first, "", false).isEmpty());
+    ASSERT_TRUE(cache.load(second, "", false).isEmpty());
+    ASSERT_FALSE(cache.load(third, "", false).isEmpty());
+}
+
+TEST_F(ImageCacheTest, PersistsEntriesAcrossRuns) {
+    ImageCache & cache = ImageCache::getInstance();
+    std::string source = createSource("albedo.png", "png");
+    cache.store(source, "", createImage(9));
+
+    // switching the directory forgets the in-memory index, it is rebuilt from the files
+    cache.setDirectory(root / "other");
+    ASSERT_TRUE(cache.load(source, "", false).isEmpty());
+    cache.setDirectory(root / "cache");
+    ASSERT_EQ(cache.getStats().entry_count, 1u);
+    ASSERT_EQ(cache.load(source, "", false).getLevelData(0)[0], 9);
+
+    cache.clear();
+    ASSERT_EQ(cache.getStats().entry_count, 0u);
+    ASSERT_TRUE(cache.load(source, "", false).isEmpty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include <GLRF/MipGenerator.hpp>
+
+using namespace GLRF;
+
+namespace {
+    ImageData createImage(GLsizei width, GLsizei height, bool srgb) {
+        TextureFormat format;
+        format.internal_format = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        format.is_srgb = srgb;
+        return ImageData(width, height, format);
+    }
+}
+
+TEST(MipGeneratorTest, CreatesCompleteChain) {
+    ImageData chain = MipGenerator().generate(createImage(37, 20, false));
+    ASSERT_EQ(chain.getLevelCount(), 6u);
+    ASSERT_EQ(chain.getLevel(5).width, 1);
+    ASSERT_EQ(chain.getLevel(5).height, 1);
+}
+
+TEST(MipGeneratorTest, FiltersSRGBInLinearSpace) {
+    ImageData image = createImage(16, 16, true);
+    unsigned char * texels = image.getLevelData(0);
+    for (int i = 0; i < 16 * 16; ++i) {
+        unsigned char value = ((i + i / 16) % 2 == 0) ? 255 : 0;
+        texels[i * 4] = texels[i * 4 + 1] = texels[i * 4 + 2] = value;
+        texels[i * 4 + 3] = 255;
+    }
+    MipConfiguration config;
+    config.filter = MipFilter::BOX;
+    ImageData chain = MipGenerator(config).generate(image);
+    // a black and white checkerboard averages to 50% linear intensity, which is 188 in sRGB (not 128)
+    ASSERT_NEAR(chain.getLevelData(1)[0], 188, 1);
+    ASSERT_EQ(chain.getLevelData(1)[3], 255);
+}
+
+TEST(MipGeneratorTest, RenormalizesNormals) {
+    ImageData image = createImage(16, 16, false);
+    unsigned char * texels = image.getLevelData(0);
+    for (int i = 0; i < 16 * 16; ++i) {
+        // normals alternate between (0.6, 0, 0.8) and (-0.6, 0, 0.8), their average is too short
+        texels[i * 4] = (i % 2 == 0) ? 204 : 51;
+        texels[i * 4 + 1] = 128;
+        texels[i * 4 + 2] = 230;
+        texels[i * 4 + 3] = 255;
+    }
+    MipConfiguration config;
+    config.normal_map = true;
+    ImageData chain = MipGenerator(config).generate(image);
+    const unsigned char * texel = chain.getLevelData(1);
+    float x = texel[0] / 127.5f - 1.f, y = texel[1] / 127.5f - 1.f, z = texel[2] / 127.5f - 1.f;
+    ASSERT_NEAR(std::sqrt(x * x + y * y + z * z), 1.f, 0.02f);
+}
+
+TEST(MipGeneratorTest, PreservesAlphaCoverage) {
+    ImageData image = createImage(64, 64, false);
+    unsigned char * texels = image.getLevelData(0);
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            // thin opaque lines on every fourth column, like blades of grass
+            texels[(y * 64 + x) * 4 + 3] = (x % 4 == 0) ? 255 : 0;
+        }
+    }
+    MipConfiguration config;
+    config.alpha_cutoff = 0.5f;
+    ImageData chain = MipGenerator(config).generate(image);
+    const ImageLevel & level = chain.getLevel(1);
+    int passed = 0;
+    for (int i = 0; i < level.width * level.height; ++i) {
+        if (chain.getLevelData(1)[i * 4 + 3] > 127) ++passed;
+    }
+    ASSERT_GT(passed, 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <GLRF/Shader.hpp>
+
+using namespace GLRF;
+
+static_assert("model"_uniform.hash == fnv1a64Bytes("model", 5), "literal names are hashed at compile time");
+
+TEST(ShaderConfigurationTest, HashesNamesConsistently) {
+    ASSERT_EQ("camera_position"_uniform.hash, UniformName(std::string("camera_position")).hash);
+    ASSERT_EQ("pointLight_color"_uniform.element(0).hash, UniformName("pointLight_color[0]").hash);
+    ASSERT_EQ("pointLight_color"_uniform.element(12).hash, UniformName("pointLight_color[12]").hash);
+    ASSERT_NE("pointLight_color"_uniform.element(1).hash, "pointLight_color"_uniform.element(2).hash);
+}
+
+TEST(ShaderConfigurationTest, StoresValuesByName) {
+    ShaderConfiguration configuration;
+    configuration.setBool("useDirectionalLight"_uniform, true);
+    configuration.setInt("mode"_uniform, -3);
+    configuration.setUInt("pointLight_count"_uniform, 4u);
+    configuration.setFloat("pointLight_power"_uniform.element(2), 2.5f);
+
+    ASSERT_TRUE(configuration.getBool("useDirectionalLight"));
+    ASSERT_EQ(configuration.getInt("mode"), -3);
+    ASSERT_EQ(configuration.getUInt("pointLight_count"), 4u);
+    ASSERT_FLOAT_EQ(configuration.getFloat("pointLight_power[2]"), 2.5f);
+
+    // missing values and values of another type return the defaults
+    ASSERT_FALSE(configuration.getBool("mode"));
+    ASSERT_EQ(configuration.getUInt("missing"), 0u);
+}
+
+TEST(ShaderConfigurationTest, OverwritesAndClearsValues) {
+    ShaderConfiguration configuration;
+    configuration.setFloat("height_scale"_uniform, 1.f);
+    configuration.setFloat("height_scale"_uniform, 2.f);
+    ASSERT_FLOAT_EQ(configuration.getFloat("height_scale"_uniform), 2.f);
+
+    configuration.setInt("height_scale"_uniform, 7);
+    ASSERT_EQ(configuration.getInt("height_scale"_uniform), 7);
+    ASSERT_FLOAT_EQ(configuration.getFloat("height_scale"_uniform), 0.f);
+
+    configuration.clear();
+    ASSERT_EQ(configuration.getInt("height_scale"_uniform), 0);
+    ASSERT_EQ(configuration.getMaterial("material"), nullptr);
+}
+
+TEST(ShaderConfigurationTest, HashesStageSources) {
+    const std::string vertex_source = "#version 430 core\nvoid main() { gl_Position = vec4(0.0); }\n";
+    const std::string fragment_source = "#version 430 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+    const std::uint64_t hash = Shader::hashStageSource("fragment", fragment_source, Shader::hashStageSource("vertex", vertex_source));
+    // FNV-1a continues over the concatenation of the tagged stages
+    ASSERT_EQ(hash, fnv1a64("vertex\n" + vertex_source + "fragment\n" + fragment_source));
+    ASSERT_EQ(hash, Shader::hashStageSource("fragment", fragment_source, Shader::hashStageSource("vertex", vertex_source)));
+
+    // the same sources in other stages are different programs
+    ASSERT_NE(hash, Shader::hashStageSource("vertex", fragment_source, Shader::hashStageSource("fragment", vertex_source)));
+    ASSERT_NE(hash, Shader::hashStageSource("fragment", vertex_source, Shader::hashStageSource("vertex", fragment_source)));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <fstream>
+
+#include <GLRF/ShaderPreprocessor.hpp>
+
+using namespace GLRF;
+
+class ShaderPreprocessorTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / "glrf_shader_preprocessor_test";
+        fs::remove_all(root);
+        fs::create_directories(root / "shaders" / "common");
+        fs::create_directories(root / "library");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    void createFile(const fs::path & path, const std::string & content) {
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+    }
+
+    size_t count(const std::string & text, const std::string & pattern) {
+        size_t result = 0;
+        for (size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1)) ++result;
+        return result;
+    }
+};
+
+TEST_F(ShaderPreprocessorTest, InjectsDefinesAfterVersion) {
+    ShaderPreprocessor preprocessor;
+    preprocessor.setDefine("GLRF_ALBEDO_TEXTURE");
+    preprocessor.setDefine("MAX_LIGHTS", "4");
+    std::string source = preprocessor.processSource("// header\n#version 430 core\nvoid main() {}\n", root);
+
+    ASSERT_EQ(source, "// header\n#version 430 core\n#define GLRF_ALBEDO_TEXTURE\n#define MAX_LIGHTS 4\n#line 3 0\nvoid main() {}\n");
+}
+
+TEST_F(ShaderPreprocessorTest, ResolvesIncludesOnce) {
+    createFile(root / "shaders" / "common" / "lighting.glsl", "#include \"math.glsl\"\nfloat lighting;\n");
+    createFile(root / "shaders" / "common" / "math.glsl", "#include \"lighting.glsl\"\nfloat math;\n");
+    createFile(root / "library" / "brdf.glsl", "float brdf;\n");
+    createFile(root / "shaders" / "main.frag",
+        "#version 430\n#include \"common/lighting.glsl\"\n#include <brdf.glsl>\n#include \"common/math.glsl\"\n#include <glrf/generated.glsl>\nvoid main() {}\n");
+
+    ShaderPreprocessor preprocessor;
+    preprocessor.addIncludeDirectory(root / "library");
+    preprocessor.addVirtualFile("glrf/generated.glsl", "float generated;\n");
+    std::string source = preprocessor.process(root / "shaders" / "main.frag");
+
+    ASSERT_EQ(count(source, "float math;"), 1u);
+    ASSERT_EQ(count(source, "float lighting;"), 1u);
+    ASSERT_EQ(count(source, "float brdf;"), 1u);
+    ASSERT_EQ(count(source, "float generated;"), 1u);
+    ASSERT_EQ(count(source, "#include"), 0u);
+    // nested files are included before the rest of the including file
+    ASSERT_LT(source.find("float math;"), source.find("float lighting;"));
+    ASSERT_EQ(preprocessor.getIncludedFiles().size(), 5u);
+    // the line of the including file continues after an include
+    ASSERT_NE(source.find("#line 6 0\nvoid main() {}"), std::string::npos);
+}
+
+TEST_F(ShaderPreprocessorTest, ThrowsOnMissingFiles) {
+    ShaderPreprocessor preprocessor;
+    ASSERT_THROW(preprocessor.process(root / "missing.vert"), std::runtime_error);
+    ASSERT_THROW(preprocessor.processSource("#include \"missing.glsl\"\n", root), std::runtime_error);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <fstream>
+
+#include <GLRF/TextureManager.hpp>
+
+class TextureManagerTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / "glrf_texture_manager_test";
+        fs::remove_all(root);
+        fs::create_directories(root / "assets" / "stone" / "marble");
+        std::ofstream(root / "assets" / "brick_albedo.png") << "x";
+        std::ofstream(root / "assets" / "stone" / "marble" / "marble_albedo.png") << "x";
+        TextureManager::getInstance().setIndexDirectory(root / "index");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+};
+
+TEST_F(TextureManagerTest, FindsNestedFilesAndDirectories) {
+    TextureManager & manager = TextureManager::getInstance();
+    manager.registerSource(root / "assets");
+    ASSERT_EQ(manager.findTexturePath("brick_albedo.png"), root / "assets" / "brick_albedo.png");
+    ASSERT_EQ(manager.findTexturePath("marble_albedo.png"), root / "assets" / "stone" / "marble" / "marble_albedo.png");
+    ASSERT_EQ(manager.findTexturePath("marble"), root / "assets" / "stone" / "marble");
+    ASSERT_TRUE(manager.findTexturePath("does_not_exist.png").empty());
+    ASSERT_FALSE(fs::is_empty(root / "index"));
+}
+
+TEST_F(TextureManagerTest, PicksUpNewFilesOnRefresh) {
+    TextureManager & manager = TextureManager::getInstance();
+    manager.registerSource(root / "assets");
+    fs::create_directories(root / "assets" / "wood");
+    std::ofstream(root / "assets" / "wood" / "oak_albedo.png") << "x";
+    manager.refresh();
+    ASSERT_EQ(manager.findTexturePath("oak_albedo.png"), root / "assets" / "wood" / "oak_albedo.png");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
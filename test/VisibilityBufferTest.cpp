@@ -0,0 +1,16 @@
+#include <gtest/gtest.h>
+
+#include <GLRF/VisibilityBuffer.hpp>
+
+using namespace GLRF;
+
+TEST(VisibilityBufferTest, EncodesInstanceAndTriangle) {
+    const GLuint id = VisibilityBuffer::encode(5, 123456);
+    ASSERT_EQ(VisibilityBuffer::getInstanceIndex(id), 5u);
+    ASSERT_EQ(VisibilityBuffer::getTriangleIndex(id), 123456u);
+
+    const GLuint last = VisibilityBuffer::encode(VisibilityBuffer::MAX_INSTANCES - 1, VisibilityBuffer::MAX_TRIANGLES - 1);
+    ASSERT_EQ(VisibilityBuffer::getInstanceIndex(last), VisibilityBuffer::MAX_INSTANCES - 1);
+    ASSERT_EQ(VisibilityBuffer::getTriangleIndex(last), VisibilityBuffer::MAX_TRIANGLES - 1);
+    ASSERT_NE(last, static_cast<GLuint>(VisibilityBuffer::EMPTY));
+}
@@ -0,0 +1,193 @@
+#include "Baker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+#include <GLRF/AssetArchive.hpp>
+#include <GLRF/Hash.hpp>
+#include <GLRF/ImageData.hpp>
+#include <GLRF/MipGenerator.hpp>
+#include <GLRF/TextureCompressor.hpp>
+#include <GLRF/ThreadPool.hpp>
+
+#include "MeshOptimizer.hpp"
+
+using namespace GLRF;
+
+namespace {
+	// bump whenever the output of a bake step changes, so cached entries are rebuilt
+	const std::string BAKE_VERSION = "glrf-bake 2";
+
+	struct BakeJob {
+		fs::path source;
+		std::string name;
+		AssetType type;
+		bool srgb = false;
+		MipConfiguration mips;
+		std::uint64_t content_hash = 0;
+		const AssetArchiveEntry * cached = nullptr;
+		ImageData image;
+		std::shared_ptr<MeshData<VertexFormat>> mesh;
+		bool failed = false;
+	};
+
+	std::string toLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	}
+
+	bool readFile(const fs::path & path, std::string & content)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) return false;
+		content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+}
+
+Baker::Baker(BakeOptions options)
+{
+	this->options = options;
+}
+
+bool Baker::matches(const std::string & name, const std::vector<std::string> & patterns) const
+{
+	std::string lower_name = toLower(name);
+	for (const std::string & pattern : patterns)
+	{
+		if (lower_name.find(toLower(pattern)) != std::string::npos) return true;
+	}
+	return false;
+}
+
+bool Baker::run()
+{
+	std::error_code error;
+	if (!fs::is_directory(this->options.input_directory, error)) {
+		std::cout << "The input directory '" << this->options.input_directory.generic_string() << "' does not exist." << std::endl;
+		return false;
+	}
+
+	std::vector<BakeJob> jobs;
+	for (auto & entry : fs::recursive_directory_iterator(this->options.input_directory, error))
+	{
+		if (!entry.is_regular_file(error)) continue;
+		std::string extension = toLower(entry.path().extension().generic_string());
+		BakeJob job;
+		if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp" || extension == ".hdr") {
+			job.type = AssetType::TEXTURE;
+		} else if (extension == ".obj") {
+			job.type = AssetType::MESH;
+		} else {
+			continue;
+		}
+		job.source = entry.path();
+		job.name = AssetArchive::normalizeName(fs::relative(entry.path(), this->options.input_directory, error).generic_string());
+		if (job.type == AssetType::TEXTURE) {
+			job.srgb = matches(job.name, this->options.srgb_patterns);
+			job.mips.normal_map = matches(job.name, this->options.normal_patterns);
+			if (matches(job.name, this->options.alpha_test_patterns)) job.mips.alpha_cutoff = this->options.alpha_cutoff;
+		}
+		jobs.push_back(job);
+	}
+	// a stable order keeps archives reproducible
+	std::sort(jobs.begin(), jobs.end(), [](const BakeJob & a, const BakeJob & b) { return a.name < b.name; });
+
+	std::unique_ptr<AssetArchive> previous;
+	if (fs::exists(this->options.output_file, error))
+	{
+		try {
+			previous = std::make_unique<AssetArchive>(this->options.output_file);
+		}
+		catch (const std::runtime_error & e) {
+			std::cout << e.what() << ", baking all inputs." << std::endl;
+		}
+	}
+
+	ThreadPool pool(this->options.num_threads);
+	std::atomic<size_t> num_cached(0);
+	pool.parallelFor(0, jobs.size(), [&](size_t i) {
+		BakeJob & job = jobs[i];
+		std::string content;
+		if (!readFile(job.source, content)) {
+			std::cout << "Could not read '" << job.source.generic_string() << "'." << std::endl;
+			job.failed = true;
+			return;
+		}
+
+		// the hash covers the source and every parameter that changes the baked result
+		std::string parameters = BAKE_VERSION + (job.srgb ? " srgb" : "") + (this->options.compress ? " compress" : "")
+			+ (job.mips.normal_map ? " normal" : "") + " cutoff=" + std::to_string(job.mips.alpha_cutoff);
+		job.content_hash = fnv1a64(content, fnv1a64(parameters));
+		if (previous)
+		{
+			const AssetArchiveEntry * entry = previous->findEntry(job.name);
+			if (entry && entry->type == job.type && entry->content_hash == job.content_hash) {
+				job.cached = entry;
+				++num_cached;
+				return;
+			}
+		}
+
+		if (this->options.verbose) std::cout << "Baking '" << job.name << "'" << std::endl;
+		if (job.type == AssetType::TEXTURE)
+		{
+			ImageData image = ImageData::decode(job.source.generic_string(), job.srgb);
+			if (image.isEmpty()) {
+				job.failed = true;
+				return;
+			}
+			image = MipGenerator(job.mips).generate(image);
+			if (this->options.compress && TextureCompressor::isSupported(image.getFormat())) {
+				image = TextureCompressor().compress(image);
+			}
+			job.image = image;
+		}
+		else
+		{
+			job.mesh = MeshOptimizer::loadOBJ(job.source.generic_string());
+			if (!job.mesh) {
+				job.failed = true;
+				return;
+			}
+			MeshOptimizer::optimizeVertexCache(job.mesh->indices.value(), job.mesh->vertices.size());
+			MeshOptimizer::optimizeVertexFetch(*job.mesh);
+		}
+	});
+
+	AssetArchiveWriter writer;
+	bool success = true;
+	for (BakeJob & job : jobs)
+	{
+		if (job.failed) {
+			std::cout << "Failed to bake '" << job.name << "'." << std::endl;
+			success = false;
+		}
+		else if (job.cached) {
+			writer.addBlob(job.name, job.type, job.content_hash, previous->getData(*job.cached), static_cast<size_t>(job.cached->size));
+		}
+		else if (job.type == AssetType::TEXTURE) {
+			writer.addTexture(job.name, job.image, job.content_hash);
+		}
+		else {
+			writer.addMesh(job.name, *job.mesh, job.content_hash);
+		}
+		// release the baked data early, the writer holds its own copy
+		job.image = ImageData();
+		job.mesh.reset();
+	}
+
+	// the previous archive is still mapped while its entries are copied, and has to be closed before it is replaced
+	previous.reset();
+	if (!writer.write(this->options.output_file)) return false;
+
+	std::cout << "Baked " << (jobs.size() - num_cached.load()) << " of " << jobs.size() << " assets ("
+		<< num_cached.load() << " unchanged) into '" << this->options.output_file.generic_string() << "'." << std::endl;
+	return success;
+}
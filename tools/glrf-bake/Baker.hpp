@@ -0,0 +1,49 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The settings of a bake run.
+ *
+ */
+struct BakeOptions {
+	fs::path input_directory;
+	fs::path output_file;
+	// textures whose relative path contains one of these substrings are baked in sRGB space
+	std::vector<std::string> srgb_patterns = { "albedo", "diffuse", "basecolor", "color" };
+	// textures whose relative path contains one of these substrings are renormalized while filtering
+	std::vector<std::string> normal_patterns = { "normal" };
+	// textures whose relative path contains one of these substrings keep their alpha test coverage
+	std::vector<std::string> alpha_test_patterns;
+	float alpha_cutoff = 0.5f;
+	bool compress = true;
+	unsigned int num_threads = 0;
+	bool verbose = false;
+};
+
+/**
+ * @brief Converts all source assets inside a directory into a single packed archive.
+ *
+ * Textures (png, jpg, tga, bmp, hdr) receive a gamma-correct mip chain and are block compressed where possible,
+ * meshes (obj) are indexed and reordered for the vertex cache.
+ * Inputs are processed in parallel. Entries of the previous archive whose content hash matches are copied
+ * instead of being baked again.
+ */
+class Baker {
+public:
+	Baker(BakeOptions options);
+
+	/**
+	 * @brief Bakes all inputs and writes the archive.
+	 *
+	 * @return bool whether the archive was written without errors
+	 */
+	bool run();
+private:
+	BakeOptions options;
+
+	bool matches(const std::string & name, const std::vector<std::string> & patterns) const;
+};
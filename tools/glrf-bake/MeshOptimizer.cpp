@@ -0,0 +1,269 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+using namespace GLRF;
+
+namespace {
+	/**
+	 * Resolves a (possibly negative, relative) OBJ index, returns -1 if it is missing or invalid.
+	 */
+	long resolveIndex(const std::string & token, size_t count)
+	{
+		if (token.empty()) return -1;
+		long index = std::stol(token);
+		if (index < 0) index += static_cast<long>(count);
+		else index -= 1;
+		return (index >= 0 && index < static_cast<long>(count)) ? index : -1;
+	}
+}
+
+std::shared_ptr<MeshData<VertexFormat>> MeshOptimizer::loadOBJ(const std::string & path)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		std::cout << "Could not open mesh '" << path << "'." << std::endl;
+		return nullptr;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	// (position, uv, normal) -> vertex index
+	std::map<std::tuple<long, long, long>, GLuint> vertex_indices;
+	auto mesh = std::make_shared<MeshData<VertexFormat>>();
+	std::vector<GLuint> indices;
+	bool has_missing_normals = false;
+
+	std::string line;
+	try {
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string keyword;
+			stream >> keyword;
+			if (keyword == "v") {
+				glm::vec3 position;
+				stream >> position.x >> position.y >> position.z;
+				positions.push_back(position);
+			}
+			else if (keyword == "vn") {
+				glm::vec3 normal;
+				stream >> normal.x >> normal.y >> normal.z;
+				normals.push_back(normal);
+			}
+			else if (keyword == "vt") {
+				glm::vec2 uv;
+				stream >> uv.x >> uv.y;
+				uvs.push_back(uv);
+			}
+			else if (keyword == "f") {
+				std::vector<GLuint> polygon;
+				std::string corner;
+				while (stream >> corner)
+				{
+					std::string tokens[3];
+					size_t component = 0;
+					for (char c : corner)
+					{
+						if (c == '/') {
+							if (++component > 2) break;
+						} else {
+							tokens[component] += c;
+						}
+					}
+					long p = resolveIndex(tokens[0], positions.size());
+					long t = resolveIndex(tokens[1], uvs.size());
+					long n = resolveIndex(tokens[2], normals.size());
+					if (p < 0) throw std::invalid_argument("invalid position index '" + corner + "'");
+
+					auto key = std::make_tuple(p, t, n);
+					auto it = vertex_indices.find(key);
+					if (it == vertex_indices.end())
+					{
+						if (n < 0) has_missing_normals = true;
+						mesh->vertices.push_back(VertexFormat(
+							positions[p],
+							(n >= 0) ? normals[n] : glm::vec3(0.f),
+							(t >= 0) ? uvs[t] : glm::vec2(0.f),
+							glm::vec3(0.f)));
+						it = vertex_indices.emplace(key, static_cast<GLuint>(mesh->vertices.size() - 1)).first;
+					}
+					polygon.push_back(it->second);
+				}
+				for (size_t i = 1; i + 1 < polygon.size(); ++i)
+				{
+					indices.push_back(polygon[0]);
+					indices.push_back(polygon[i]);
+					indices.push_back(polygon[i + 1]);
+				}
+			}
+		}
+	}
+	catch (const std::exception & e) {
+		std::cout << "Could not parse mesh '" << path << "': " << e.what() << std::endl;
+		return nullptr;
+	}
+
+	if (has_missing_normals)
+	{
+		// area weighted face normals, only applied to vertices without a normal inside the file
+		std::vector<glm::vec3> face_normals(mesh->vertices.size(), glm::vec3(0.f));
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3 & p0 = mesh->vertices[indices[i]].position;
+			glm::vec3 normal = glm::cross(mesh->vertices[indices[i + 1]].position - p0, mesh->vertices[indices[i + 2]].position - p0);
+			for (size_t c = 0; c < 3; ++c) face_normals[indices[i + c]] += normal;
+		}
+		for (size_t v = 0; v < mesh->vertices.size(); ++v)
+		{
+			VertexFormat & vertex = mesh->vertices[v];
+			if (glm::length(vertex.normal) == 0.f && glm::length(face_normals[v]) > 0.f) {
+				vertex.normal = glm::normalize(face_normals[v]);
+			}
+		}
+	}
+
+	mesh->indices = indices;
+	calculateTangents(*mesh);
+	return mesh;
+}
+
+void MeshOptimizer::calculateTangents(MeshData<VertexFormat> & mesh)
+{
+	if (!mesh.indices.has_value()) return;
+	const std::vector<GLuint> & indices = mesh.indices.value();
+
+	std::vector<glm::vec3> tangents(mesh.vertices.size(), glm::vec3(0.f));
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const VertexFormat & v0 = mesh.vertices[indices[i]];
+		const VertexFormat & v1 = mesh.vertices[indices[i + 1]];
+		const VertexFormat & v2 = mesh.vertices[indices[i + 2]];
+		glm::vec3 e1 = v1.position - v0.position;
+		glm::vec3 e2 = v2.position - v0.position;
+		glm::vec2 d1 = v1.uv - v0.uv;
+		glm::vec2 d2 = v2.uv - v0.uv;
+		float determinant = d1.x * d2.y - d2.x * d1.y;
+		if (std::abs(determinant) < 1e-12f) continue;
+		glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) / determinant;
+		for (size_t c = 0; c < 3; ++c) tangents[indices[i + c]] += tangent;
+	}
+
+	for (size_t v = 0; v < mesh.vertices.size(); ++v)
+	{
+		VertexFormat & vertex = mesh.vertices[v];
+		// Gram-Schmidt, so the tangent is perpendicular to the normal
+		glm::vec3 tangent = tangents[v] - vertex.normal * glm::dot(vertex.normal, tangents[v]);
+		if (glm::length(tangent) < 1e-6f) {
+			glm::vec3 axis = (std::abs(vertex.normal.x) < 0.9f) ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+			tangent = glm::cross(vertex.normal, axis);
+		}
+		vertex.tangent = (glm::length(tangent) > 0.f) ? glm::normalize(tangent) : glm::vec3(1.f, 0.f, 0.f);
+	}
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<GLuint> & indices, size_t vertex_count, size_t cache_size)
+{
+	const size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0 || vertex_count == 0) return;
+
+	// vertex -> adjacent triangles
+	std::vector<size_t> adjacency_offsets(vertex_count + 1, 0);
+	for (GLuint index : indices) ++adjacency_offsets[index + 1];
+	for (size_t v = 0; v < vertex_count; ++v) adjacency_offsets[v + 1] += adjacency_offsets[v];
+	std::vector<size_t> adjacency(indices.size());
+	std::vector<size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<size_t> live_triangles(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v) live_triangles[v] = adjacency_offsets[v + 1] - adjacency_offsets[v];
+	std::vector<size_t> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<GLuint> dead_end;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+
+	size_t time = cache_size + 1;
+	size_t cursor = 0;
+	long fanning = 0;
+	while (fanning >= 0)
+	{
+		std::vector<GLuint> candidates;
+		for (size_t a = adjacency_offsets[fanning]; a < adjacency_offsets[fanning + 1]; ++a)
+		{
+			size_t triangle = adjacency[a];
+			if (emitted[triangle]) continue;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				GLuint v = indices[triangle * 3 + c];
+				output.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live_triangles[v];
+				if (time - cache_time[v] > cache_size) {
+					cache_time[v] = time;
+					++time;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// prefer the candidate that is still inside the cache and has the fewest remaining triangles
+		long next = -1;
+		long best_priority = -1;
+		for (GLuint v : candidates)
+		{
+			if (live_triangles[v] == 0) continue;
+			long priority = 0;
+			if (time - cache_time[v] + 2 * live_triangles[v] <= cache_size) priority = static_cast<long>(time - cache_time[v]);
+			if (priority > best_priority) {
+				best_priority = priority;
+				next = static_cast<long>(v);
+			}
+		}
+		if (next < 0)
+		{
+			while (!dead_end.empty() && next < 0)
+			{
+				GLuint v = dead_end.back();
+				dead_end.pop_back();
+				if (live_triangles[v] > 0) next = static_cast<long>(v);
+			}
+			while (next < 0 && cursor < vertex_count)
+			{
+				if (live_triangles[cursor] > 0) next = static_cast<long>(cursor);
+				++cursor;
+			}
+		}
+		fanning = next;
+	}
+	indices = output;
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData<VertexFormat> & mesh)
+{
+	if (!mesh.indices.has_value()) return;
+	std::vector<GLuint> & indices = mesh.indices.value();
+
+	const GLuint unused = static_cast<GLuint>(-1);
+	std::vector<GLuint> remap(mesh.vertices.size(), unused);
+	std::vector<VertexFormat> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (GLuint & index : indices)
+	{
+		if (remap[index] == unused) {
+			remap[index] = static_cast<GLuint>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	// unreferenced vertices are dropped
+	mesh.vertices = vertices;
+}
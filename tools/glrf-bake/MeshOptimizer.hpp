@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GLRF/SceneObject.hpp>
+#include <GLRF/VertexFormat.hpp>
+
+/**
+ * @brief Loads source meshes and reorders them for the post-transform vertex cache.
+ *
+ */
+class MeshOptimizer {
+public:
+	/**
+	 * @brief Loads a Wavefront OBJ file as an indexed triangle mesh.
+	 *
+	 * @param path the path to the OBJ file
+	 * @return std::shared_ptr<GLRF::MeshData<GLRF::VertexFormat>> the mesh, nullptr if the file could not be parsed
+	 *
+	 * Polygons are triangulated as fans, identical position/uv/normal combinations share a vertex.
+	 * Missing normals are calculated from the faces, tangents are always calculated.
+	 */
+	static std::shared_ptr<GLRF::MeshData<GLRF::VertexFormat>> loadOBJ(const std::string & path);
+
+	/**
+	 * @brief Reorders triangles to improve the hit rate of the post-transform vertex cache (Tipsify).
+	 *
+	 * @param indices the triangle list
+	 * @param vertex_count the number of vertices referenced by the list
+	 * @param cache_size the assumed size of the vertex cache
+	 */
+	static void optimizeVertexCache(std::vector<GLuint> & indices, size_t vertex_count, size_t cache_size = 16);
+
+	/**
+	 * @brief Reorders the vertices in the order of their first use, so vertex fetches become sequential.
+	 *
+	 */
+	static void optimizeVertexFetch(GLRF::MeshData<GLRF::VertexFormat> & mesh);
+
+	/**
+	 * @brief Calculates per-vertex tangents from the uv layout.
+	 *
+	 */
+	static void calculateTangents(GLRF::MeshData<GLRF::VertexFormat> & mesh);
+};
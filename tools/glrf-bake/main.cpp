@@ -0,0 +1,64 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Baker.hpp"
+
+namespace {
+	void printUsage()
+	{
+		std::cout << "Usage: glrf-bake <input directory> <output archive> [options]\n"
+			<< "Options:\n"
+			<< "  --srgb <pattern>    bake textures whose path contains the pattern in sRGB space (repeatable)\n"
+			<< "  --no-default-srgb   do not use the default sRGB patterns (albedo, diffuse, basecolor, color)\n"
+			<< "  --normal <pattern>  treat textures whose path contains the pattern as normal maps (repeatable)\n"
+			<< "  --alpha-test <pattern>  preserve the alpha test coverage of matching textures (repeatable)\n"
+			<< "  --alpha-cutoff <v>  the alpha test threshold (default: 0.5)\n"
+			<< "  --no-compress       keep textures uncompressed\n"
+			<< "  --threads <n>       the number of worker threads (default: all cores)\n"
+			<< "  --verbose           print every baked asset\n";
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc < 3) {
+		printUsage();
+		return 1;
+	}
+
+	BakeOptions options;
+	options.input_directory = argv[1];
+	options.output_file = argv[2];
+	std::vector<std::string> patterns;
+	bool use_default_patterns = true;
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--srgb" && i + 1 < argc) {
+			patterns.push_back(argv[++i]);
+		} else if (argument == "--normal" && i + 1 < argc) {
+			options.normal_patterns.push_back(argv[++i]);
+		} else if (argument == "--alpha-test" && i + 1 < argc) {
+			options.alpha_test_patterns.push_back(argv[++i]);
+		} else if (argument == "--alpha-cutoff" && i + 1 < argc) {
+			options.alpha_cutoff = std::stof(argv[++i]);
+		} else if (argument == "--no-default-srgb") {
+			use_default_patterns = false;
+		} else if (argument == "--no-compress") {
+			options.compress = false;
+		} else if (argument == "--threads" && i + 1 < argc) {
+			options.num_threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+		} else if (argument == "--verbose") {
+			options.verbose = true;
+		} else {
+			std::cout << "Unknown option '" << argument << "'." << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+	if (!use_default_patterns) options.srgb_patterns.clear();
+	options.srgb_patterns.insert(options.srgb_patterns.end(), patterns.begin(), patterns.end());
+
+	return Baker(options).run() ? 0 : 1;
+}